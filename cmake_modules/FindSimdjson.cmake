@@ -0,0 +1,26 @@
+# - Find simdjson
+# Find the simdjson headers and library.
+#
+# SIMDJSON_INCLUDE_DIRS - where to find simdjson.h
+# SIMDJSON_LIBRARIES - List of libraries when using simdjson.
+# SIMDJSON_FOUND - True if simdjson found.
+
+find_path(SIMDJSON_INCLUDE_DIR NAMES simdjson.h)
+
+find_library(SIMDJSON_LIBRARY NAMES simdjson)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Simdjson
+                                  DEFAULT_MSG
+                                  SIMDJSON_LIBRARY
+                                  SIMDJSON_INCLUDE_DIR)
+
+if(SIMDJSON_FOUND)
+  set(SIMDJSON_LIBRARIES ${SIMDJSON_LIBRARY})
+  set(SIMDJSON_INCLUDE_DIRS ${SIMDJSON_INCLUDE_DIR})
+else()
+  set(SIMDJSON_LIBRARIES)
+  set(SIMDJSON_INCLUDE_DIRS)
+endif()
+
+mark_as_advanced(SIMDJSON_INCLUDE_DIRS SIMDJSON_LIBRARIES)
@@ -16,9 +16,11 @@
 #include "cmd.h"
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <algorithm>
 #include <regex>
+#include <vector>
 
 static const std::string cxx_include = "<%inc";
 static const std::string cxx_end = "%>";
@@ -29,9 +31,22 @@ static const std::string cxx_val_start = "[[";
 static const std::string cxx_val_end = "]]";
 static const std::string sub_view_start = "<%view";
 static const std::string sub_view_end = "%>";
+static const std::string cache_start = "<%cache";
+static const std::string cache_end = "<%endcache";
+static const std::string flush_tag = "<%flush";
 
 using namespace drogon_ctl;
 
+// The literal text which has not been written yet, so the adjacent literals
+// are written to the buffer of a view by one call.
+static std::string pendingText;
+// The view data keys of the [[ ]] expressions, every key is resolved once at
+// the beginning of the genText() method.
+static std::vector<std::string> viewDataKeys;
+static std::string viewClassName;
+// The number of the <%cache %> directives which are not closed
+static int cacheDepth = 0;
+
 static std::string &replace_all(std::string &str,
                                 const std::string &old_value,
                                 const std::string &new_value)
@@ -52,44 +67,78 @@ static std::string &replace_all(std::string &str,
     }
     return str;
 }
-static void parseCxxLine(std::ofstream &oSrcFile,
+static void outputText(std::ostream &oSrcFile, const std::string &streamName)
+{
+    if (pendingText.empty())
+        return;
+    oSrcFile << "\t" << streamName << ".write(\"";
+    for (size_t i = 0; i < pendingText.length(); ++i)
+    {
+        switch (pendingText[i])
+        {
+            case '\\':
+                oSrcFile << "\\\\";
+                break;
+            case '"':
+                oSrcFile << "\\\"";
+                break;
+            case '\r':
+                oSrcFile << "\\r";
+                break;
+            case '\n':
+                oSrcFile << "\\n";
+                // One line of the view in one line of the source
+                if (i + 1 < pendingText.length())
+                    oSrcFile << "\"\n\t\t\"";
+                break;
+            default:
+                oSrcFile << pendingText[i];
+                break;
+        }
+    }
+    oSrcFile << "\", " << pendingText.length() << ");\n";
+    pendingText.clear();
+}
+static void parseCxxLine(std::ostream &oSrcFile,
                          const std::string &line,
                          const std::string &streamName,
                          const std::string &viewDataName)
 {
     if (line.length() > 0)
     {
+        outputText(oSrcFile, streamName);
         std::string tmp = line;
         replace_all(tmp, cxx_output, streamName);
         replace_all(tmp, cxx_view_data, viewDataName);
         oSrcFile << tmp << "\n";
     }
 }
-static void outputVal(std::ofstream &oSrcFile,
+static std::string viewDataValueName(const std::string &viewDataName,
+                                     const std::string &keyName)
+{
+    size_t index =
+        std::find(viewDataKeys.begin(), viewDataKeys.end(), keyName) -
+        viewDataKeys.begin();
+    if (index == viewDataKeys.size())
+        viewDataKeys.push_back(keyName);
+    return viewDataName + "_" + std::to_string(index);
+}
+static void outputVal(std::ostream &oSrcFile,
                       const std::string &streamName,
                       const std::string &viewDataName,
                       const std::string &keyName)
 {
-    oSrcFile << "{\n";
-    oSrcFile << "    auto & val=" << viewDataName << "[\"" << keyName
-             << "\"];\n";
-    oSrcFile << "    if(val.type()==typeid(const char *)){\n";
-    oSrcFile << "        " << streamName
-             << "<<*any_cast<const char *>(&val);\n";
-    oSrcFile << "    }else "
-                "if(val.type()==typeid(std::string)||val.type()==typeid(const "
-                "std::string)){\n";
-    oSrcFile << "        " << streamName
-             << "<<*any_cast<const std::string>(&val);\n";
-    oSrcFile << "    }\n";
-    oSrcFile << "}\n";
+    outputText(oSrcFile, streamName);
+    oSrcFile << "\t" << streamName << " << "
+             << viewDataValueName(viewDataName, keyName) << ";\n";
 }
 
-static void outputSubView(std::ofstream &oSrcFile,
+static void outputSubView(std::ostream &oSrcFile,
                           const std::string &streamName,
                           const std::string &viewDataName,
                           const std::string &keyName)
 {
+    outputText(oSrcFile, streamName);
     oSrcFile << "{\n";
     oSrcFile << "    auto templ=DrTemplateBase::newTemplate(\"" << keyName
              << "\");\n";
@@ -100,7 +149,76 @@ static void outputSubView(std::ofstream &oSrcFile,
     oSrcFile << "}\n";
 }
 
-static void parseLine(std::ofstream &oSrcFile,
+static void outputCacheStart(std::ostream &oSrcFile,
+                             const std::string &streamName,
+                             const std::string &viewDataName,
+                             const std::string &directive)
+{
+    // <%cache key expression, ttl %>
+    auto pos = directive.rfind(',');
+    if (pos == std::string::npos)
+    {
+        std::cerr << "The <%cache %> directive needs a key and a ttl: "
+                  << directive << std::endl;
+        exit(1);
+    }
+    std::string key = directive.substr(0, pos);
+    std::string ttl = directive.substr(pos + 1);
+    replace_all(key, cxx_view_data, viewDataName);
+    replace_all(ttl, cxx_view_data, viewDataName);
+    outputText(oSrcFile, streamName);
+    ++cacheDepth;
+    auto suffix = "_" + std::to_string(cacheDepth);
+    auto keyName = viewClassName + "_fragment_key" + suffix;
+    auto fragmentName = viewClassName + "_fragment" + suffix;
+    oSrcFile << "{\n";
+    oSrcFile << "\tconst double " << viewClassName << "_fragment_ttl" << suffix
+             << " = (" << ttl << ");\n";
+    oSrcFile << "\tdrogon::OStringStream " << keyName << ";\n";
+    oSrcFile << "\t" << keyName << " << \"" << viewClassName << ":\" << ("
+             << key << ");\n";
+    oSrcFile << "\tauto " << fragmentName
+             << " = drogon::FragmentCache::find(" << keyName << ".str());\n";
+    oSrcFile << "\tif (" << fragmentName << ")\n\t{\n";
+    oSrcFile << "\t\t" << streamName << " << *" << fragmentName << ";\n";
+    oSrcFile << "\t}\n\telse\n\t{\n";
+    oSrcFile << "\tauto " << viewClassName << "_fragment_start" << suffix
+             << " = " << streamName << ".length();\n";
+}
+
+static void outputCacheEnd(std::ostream &oSrcFile,
+                           const std::string &streamName)
+{
+    if (cacheDepth == 0)
+    {
+        std::cerr << "<%endcache%> without <%cache %>" << std::endl;
+        exit(1);
+    }
+    outputText(oSrcFile, streamName);
+    auto suffix = "_" + std::to_string(cacheDepth);
+    --cacheDepth;
+    oSrcFile << "\tdrogon::FragmentCache::insert(" << viewClassName
+             << "_fragment_key" << suffix << ".str(), " << streamName
+             << ".str().substr(" << viewClassName << "_fragment_start"
+             << suffix << "), " << viewClassName << "_fragment_ttl" << suffix
+             << ");\n";
+    oSrcFile << "\t}\n}\n";
+}
+
+static void outputFlush(std::ostream &oSrcFile, const std::string &streamName)
+{
+    // The fragments are cut from the buffer by their offsets.
+    if (cacheDepth > 0)
+    {
+        std::cerr << "<%flush%> can't be used in a <%cache %> directive"
+                  << std::endl;
+        exit(1);
+    }
+    outputText(oSrcFile, streamName);
+    oSrcFile << "\t" << streamName << ".flush();\n";
+}
+
+static void parseLine(std::ostream &oSrcFile,
                       std::string &line,
                       const std::string &streamName,
                       const std::string &viewDataName,
@@ -114,7 +232,7 @@ static void parseLine(std::ofstream &oSrcFile,
         // std::cout<<"blank line!"<<std::endl;
         // std::cout<<streamName<<"<<\"\\n\";\n";
         if (returnFlag)
-            oSrcFile << streamName << "<<\"\\n\";\n";
+            pendingText.push_back('\n');
         return;
     }
     if (cxx_flag == 0)
@@ -203,18 +321,86 @@ static void parseLine(std::ofstream &oSrcFile,
                     exit(1);
                 }
             }
-            else
+            else if ((pos = line.find(cache_start)) != std::string::npos)
             {
-                if (line.length() > 0)
+                std::string oldLine = line.substr(0, pos);
+                parseLine(
+                    oSrcFile, oldLine, streamName, viewDataName, cxx_flag, 0);
+                std::string newLine = line.substr(pos + cache_start.length());
+                if ((pos = newLine.find(cxx_end)) != std::string::npos)
                 {
-                    replace_all(line, "\\", "\\\\");
-                    replace_all(line, "\"", "\\\"");
-                    oSrcFile << "\t" << streamName << " << \"" << line;
+                    outputCacheStart(oSrcFile,
+                                     streamName,
+                                     viewDataName,
+                                     newLine.substr(0, pos));
+                    std::string tailLine =
+                        newLine.substr(pos + cxx_end.length());
+                    parseLine(oSrcFile,
+                              tailLine,
+                              streamName,
+                              viewDataName,
+                              cxx_flag,
+                              returnFlag);
+                }
+                else
+                {
+                    std::cerr << "format err!" << std::endl;
+                    exit(1);
+                }
+            }
+            else if ((pos = line.find(flush_tag)) != std::string::npos)
+            {
+                std::string oldLine = line.substr(0, pos);
+                parseLine(
+                    oSrcFile, oldLine, streamName, viewDataName, cxx_flag, 0);
+                std::string newLine = line.substr(pos + flush_tag.length());
+                if ((pos = newLine.find(cxx_end)) != std::string::npos)
+                {
+                    outputFlush(oSrcFile, streamName);
+                    std::string tailLine =
+                        newLine.substr(pos + cxx_end.length());
+                    parseLine(oSrcFile,
+                              tailLine,
+                              streamName,
+                              viewDataName,
+                              cxx_flag,
+                              returnFlag);
+                }
+                else
+                {
+                    std::cerr << "format err!" << std::endl;
+                    exit(1);
+                }
+            }
+            else if ((pos = line.find(cache_end)) != std::string::npos)
+            {
+                std::string oldLine = line.substr(0, pos);
+                parseLine(
+                    oSrcFile, oldLine, streamName, viewDataName, cxx_flag, 0);
+                std::string newLine = line.substr(pos + cache_end.length());
+                if ((pos = newLine.find(cxx_end)) != std::string::npos)
+                {
+                    outputCacheEnd(oSrcFile, streamName);
+                    std::string tailLine =
+                        newLine.substr(pos + cxx_end.length());
+                    parseLine(oSrcFile,
+                              tailLine,
+                              streamName,
+                              viewDataName,
+                              cxx_flag,
+                              returnFlag);
                 }
-                if (returnFlag)
-                    oSrcFile << "\\n\";\n";
                 else
-                    oSrcFile << "\";\n";
+                {
+                    std::cerr << "format err!" << std::endl;
+                    exit(1);
+                }
+            }
+            else
+            {
+                pendingText.append(line);
+                if (returnFlag)
+                    pendingText.push_back('\n');
             }
         }
     }
@@ -315,12 +501,18 @@ void create_view::newViewHeaderFile(std::ofstream &file,
     file << "//this file is generated by program automatically,don't modify "
             "it!\n";
     file << "#include <drogon/DrTemplate.h>\n";
+    file << "#include <drogon/utils/OStringStream.h>\n";
     file << "using namespace drogon;\n";
     file << "class " << className << ":public DrTemplate<" << className
          << ">\n";
     file << "{\npublic:\n\t" << className << "(){};\n\tvirtual ~" << className
          << "(){};\n\t"
-            "virtual std::string genText(const DrTemplateData &) override;\n};";
+            "virtual std::string genText(const DrTemplateData &) override;\n\t"
+            "virtual void streamText(const DrTemplateData &, "
+            "const ResponseStreamPtr &) override;\n"
+            "private:\n\t"
+            "void renderText(drogon::OStringStream &, "
+            "const DrTemplateData &);\n};";
 }
 
 void create_view::newViewSourceFile(std::ofstream &file,
@@ -330,6 +522,8 @@ void create_view::newViewSourceFile(std::ofstream &file,
     file << "//this file is generated by program(drogon_ctl) "
             "automatically,don't modify it!\n";
     file << "#include \"" << className << ".h\"\n";
+    file << "#include <drogon/FragmentCache.h>\n";
+    file << "#include <drogon/utils/OStringStream.h>\n";
     file << "#include <string>\n";
     file << "#include <sstream>\n";
     file << "#include <map>\n";
@@ -409,14 +603,15 @@ void create_view::newViewSourceFile(std::ofstream &file,
     // std::cout<<"file pos:"<<infile.tellg()<<std::endl;
 
     std::string viewDataName = className + "_view_data";
-    // virtual std::string genText(const DrTemplateData &)
-    file << "std::string " << className << "::genText(const DrTemplateData& "
-         << viewDataName << ")\n{\n";
-    // std::string bodyName=className+"_bodystr";
     std::string streamName = className + "_tmp_stream";
+    std::string sizeHintName = className + "_size_hint";
+    pendingText.clear();
+    viewDataKeys.clear();
+    viewClassName = className;
+    cacheDepth = 0;
 
-    // oSrcFile <<"\tstd::string "<<bodyName<<";\n";
-    file << "\tstd::stringstream " << streamName << ";\n";
+    // The body is generated first to collect the view data keys.
+    std::ostringstream body;
     int cxx_flag = 0;
     while (infile.getline(line, sizeof(line)))
     {
@@ -426,8 +621,50 @@ void create_view::newViewSourceFile(std::ofstream &file,
             std::regex re("\\{%[ \\t]*(((?!%\\}).)*[^ \\t])[ \\t]*%\\}");
             buffer = std::regex_replace(buffer, re, "<%c++$$$$<<$1;%>");
         }
-        parseLine(file, buffer, streamName, viewDataName, cxx_flag);
+        parseLine(body, buffer, streamName, viewDataName, cxx_flag);
     }
+    outputText(body, streamName);
+    if (cacheDepth != 0)
+    {
+        std::cerr << "<%cache %> without <%endcache%>" << std::endl;
+        exit(1);
+    }
+
+    // The text of both genText() and streamText() is written by renderText()
+    file << "void " << className << "::renderText(drogon::OStringStream& "
+         << streamName << ", const DrTemplateData& " << viewDataName
+         << ")\n{\n";
+    for (size_t i = 0; i < viewDataKeys.size(); ++i)
+    {
+        file << "\tauto " << viewDataName << "_" << i << " = " << viewDataName
+             << ".getStringView(\"" << viewDataKeys[i] << "\");\n";
+    }
+    file << body.str();
+    file << "}\n";
+
+    // virtual std::string genText(const DrTemplateData &)
+    file << "std::string " << className << "::genText(const DrTemplateData& "
+         << viewDataName << ")\n{\n";
+    // The text is written into a buffer reserved by the length of the last
+    // text generated in the thread, and the buffer is returned without copy.
+    file << "\tstatic thread_local size_t " << sizeHintName << " = 0;\n";
+    file << "\tdrogon::OStringStream " << streamName << "(" << sizeHintName
+         << ");\n";
+    file << "\trenderText(" << streamName << ", " << viewDataName << ");\n";
+    file << "\t" << sizeHintName << " = " << streamName << ".length() + "
+         << streamName << ".length() / 8;\n";
+    file << "\treturn std::move(" << streamName << ".str());\n}\n";
 
-    file << "return " << streamName << ".str();\n}\n";
+    // virtual void streamText(const DrTemplateData &,
+    //                         const ResponseStreamPtr &)
+    std::string responseStreamName = className + "_response_stream";
+    file << "void " << className << "::streamText(const DrTemplateData& "
+         << viewDataName << ", const ResponseStreamPtr& " << responseStreamName
+         << ")\n{\n";
+    file << "\tdrogon::OStringStream " << streamName << ";\n";
+    file << "\t" << streamName << ".setFlushCallback([&" << responseStreamName
+         << "](const std::string &text) {\n";
+    file << "\t\t" << responseStreamName << "->send(text);\n\t});\n";
+    file << "\trenderText(" << streamName << ", " << viewDataName << ");\n";
+    file << "\t" << streamName << ".flush();\n}\n";
 }
@@ -5,6 +5,11 @@ void JsonCtrl::asyncHandleHttpRequest(
 {
     Json::Value ret;
     ret["message"] = "Hello, World!";
+    // POST a JSON body (Content-Type: application/json) to measure parsing
+    // besides serializing, the body is echoed in the response.
+    auto json = req->getJsonObject();
+    if (json)
+        ret["echo"] = *json;
     auto resp = HttpResponse::newHttpJsonResponse(ret);
     callback(resp);
-}
\ No newline at end of file
+}
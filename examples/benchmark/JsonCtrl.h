@@ -9,6 +9,6 @@ class JsonCtrl : public drogon::HttpSimpleController<JsonCtrl>
         std::function<void(const HttpResponsePtr &)> &&callback) override;
     PATH_LIST_BEGIN
     // list path definitions here;
-    PATH_ADD("/json", Get);
+    PATH_ADD("/json", Get, Post);
     PATH_LIST_END
 };
@@ -8,18 +8,15 @@
 
 using namespace drogon;
 
-void CustomHeaderFilter::doFilter(const HttpRequestPtr &req,
-                                  FilterCallback &&fcb,
-                                  FilterChainCallback &&fccb)
+HttpResponsePtr CustomHeaderFilter::doSyncFilter(const HttpRequestPtr &req)
 {
     if (req->getHeader(_field) == _value)
     {
         // Passed
-        fccb();
-        return;
+        return nullptr;
     }
     // Check failed
     auto res = drogon::HttpResponse::newHttpResponse();
     res->setStatusCode(k500InternalServerError);
-    fcb(res);
+    return res;
 }
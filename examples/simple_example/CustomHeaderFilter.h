@@ -9,16 +9,14 @@
 #include <drogon/HttpFilter.h>
 using namespace drogon;
 
-class CustomHeaderFilter : public HttpFilter<CustomHeaderFilter, false>
+class CustomHeaderFilter : public HttpSyncFilter<CustomHeaderFilter, false>
 {
   public:
     CustomHeaderFilter(const std::string &field, const std::string &value)
         : _field(field), _value(value)
     {
     }
-    virtual void doFilter(const HttpRequestPtr &req,
-                          FilterCallback &&fcb,
-                          FilterChainCallback &&fccb) override;
+    virtual HttpResponsePtr doSyncFilter(const HttpRequestPtr &req) override;
 
   private:
     std::string _field;
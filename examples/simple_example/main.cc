@@ -5,6 +5,7 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <thread>
 
 using namespace drogon;
 using namespace std::chrono_literals;
@@ -169,6 +170,23 @@ int main()
         func = std::bind(&A::handle, &tmp, _1, _2, _3, _4, _5, _6);
     app().registerHandler("/api/v1/handle4/{4}/{3}/{1}", func);
 
+    // Streaming response example
+    app().registerHandler(
+        "/api/v1/stream",
+        [](const HttpRequestPtr &req,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            auto resp = HttpResponse::newStreamResponse(
+                [](const ResponseStreamPtr &stream) {
+                    stream->send("<p>Hello, ");
+                    // The stream can be used in any thread
+                    std::thread([stream]() {
+                        stream->send("world!</p>");
+                        stream->close();
+                    }).detach();
+                });
+            callback(resp);
+        });
+
     app().setDocumentRoot("./");
     app().enableSession(60);
 
@@ -1021,6 +1021,70 @@ int main(int argc, char *argv[])
         }
         auto f1 = pro1.get_future();
         f1.get();
+        // Send requests on the connections of a pool
+        std::promise<int> pro3;
+        auto pool = HttpClient::newHttpClientPool("http://127.0.0.1:8848",
+                                                  2,
+                                                  60.0,
+                                                  loop[0].getLoop());
+        auto counter = std::make_shared<std::atomic<int>>(0);
+        for (int i = 0; i < 8; ++i)
+        {
+            auto req = HttpRequest::newHttpRequest();
+            req->setMethod(drogon::Get);
+            req->setPath("/");
+            pool->sendRequest(
+                req,
+                [req, counter, &pro3](ReqResult result,
+                                      const HttpResponsePtr &resp) {
+                    if (result == ReqResult::Ok &&
+                        resp->getBody() == "<p>Hello, world!</p>")
+                    {
+                        outputGood(req, false);
+                        if (++(*counter) == 8)
+                            pro3.set_value(1);
+                    }
+                    else
+                    {
+                        LOG_ERROR << "Error!";
+                        exit(1);
+                    }
+                },
+                10.0);
+        }
+        pro3.get_future().get();
+        // Receive the body of a streaming response in parts
+        std::promise<int> pro4;
+        auto body = std::make_shared<std::string>();
+        auto streamReq = HttpRequest::newHttpRequest();
+        streamReq->setMethod(drogon::Get);
+        streamReq->setPath("/api/v1/stream");
+        pool->sendStreamRequest(
+            streamReq,
+            [](ReqResult result, const HttpResponsePtr &resp) {
+                if (result != ReqResult::Ok || resp->statusCode() != k200OK)
+                {
+                    LOG_ERROR << "Error!";
+                    exit(1);
+                }
+            },
+            [body](const char *data, size_t length) {
+                body->append(data, length);
+                return true;
+            },
+            [streamReq, body, &pro4](ReqResult result) {
+                if (result == ReqResult::Ok && *body == "<p>Hello, world!</p>")
+                {
+                    outputGood(streamReq, false);
+                    pro4.set_value(1);
+                }
+                else
+                {
+                    LOG_ERROR << "Error!";
+                    exit(1);
+                }
+            });
+        pro4.get_future().get();
         // LOG_DEBUG << sslClient.use_count();
     } while (ever);
     // getchar();
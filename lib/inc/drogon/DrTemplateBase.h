@@ -16,6 +16,7 @@
 
 #include <drogon/DrObject.h>
 #include <drogon/HttpViewData.h>
+#include <drogon/ResponseStream.h>
 #include <memory>
 #include <string>
 
@@ -50,6 +51,17 @@ class DrTemplateBase : public virtual DrObjectBase
     virtual std::string genText(
         const DrTemplateData &data = DrTemplateData()) = 0;
 
+    /// Generate the text into a stream
+    /**
+     * The text is sent through the stream in parts at the <%flush%>
+     * directives of the template file, so the client receives the first part
+     * of a page while the rest is being rendered. The stream is not closed.
+     * The views generated by old versions of drogon_ctl send the whole text
+     * at once.
+     */
+    virtual void streamText(const DrTemplateData &data,
+                            const ResponseStreamPtr &stream);
+
     virtual ~DrTemplateBase(){};
     DrTemplateBase(){};
 };
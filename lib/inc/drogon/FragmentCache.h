@@ -0,0 +1,58 @@
+/**
+ *
+ *  FragmentCache.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <string>
+
+namespace drogon
+{
+/// The cache of the view fragments rendered in the current thread
+/**
+ * The fragments are written by the <%cache %> directive of the views, e.g.
+ * @code
+   <%cache "sidebar_" + @@.get<std::string>("lang"), 3600 %>
+   <div class="sidebar">...</div>
+   <%endcache%>
+   @endcode
+ * The text between the two tags is rendered once in every IO loop for every
+ * value of the key expression and is reused for 3600 seconds. The key is
+ * written to a stream, so any expression with an operator<< works. There is
+ * a separate cache in every thread, so no lock is needed. When a thread has
+ * cached the maximum number of fragments, the expired ones are removed and,
+ * if it's still full, a tenth of the others.
+ */
+class FragmentCache
+{
+  public:
+    /// Find a fragment which is not expired, return nullptr if there is none.
+    /**
+     * The pointer is valid until the next insertion in the thread.
+     */
+    static const std::string *find(const std::string &key);
+
+    /// Cache a fragment, it never expires if the ttl is 0.
+    static void insert(const std::string &key,
+                       std::string &&fragment,
+                       double ttl);
+
+    /// Set the maximum number of fragments cached in every thread, 10000 by
+    /// default.
+    static void setMaxSize(size_t size);
+
+    /// Remove all fragments of the current thread.
+    static void clear();
+};
+
+}  // namespace drogon
@@ -834,6 +834,19 @@ class HttpAppFramework : public trantor::NonCopyable
      */
     virtual HttpAppFramework &setClientMaxMemoryBodySize(size_t maxSize) = 0;
 
+    /// Compute the MD5 of the uploaded files while they are received.
+    /**
+     * The files of a multipart/form-data request whose body exceeds the
+     * maximum body size in memory are written to temporary files in the
+     * upload path as they arrive. If this option is true, their MD5 strings
+     * are computed at the same time, so HttpFile::getMd5() doesn't read the
+     * files again. The default value is false.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &enableUploadMd5(bool enable) = 0;
+
     /// Set the max size of messages sent by WebSocket client.
     /**
      * The default value is 128K.
@@ -843,6 +856,46 @@ class HttpAppFramework : public trantor::NonCopyable
     virtual HttpAppFramework &setClientMaxWebSocketMessageSize(
         size_t maxSize) = 0;
 
+    /// Enable the permessage-deflate extension of WebSocket (RFC 7692).
+    /**
+     * @param enable Messages are compressed when the client offers the
+     * extension in the handshake. The default value is false.
+     * @param threshold Messages shorter than the threshold are sent
+     * uncompressed.
+     * @param contextTakeover If false (the default), both endpoints reset
+     * their compression context after every message, so all connections in
+     * an IO loop share one context and use little memory. If true, every
+     * connection keeps its own contexts, which compresses similar messages
+     * better but costs hundreds of kilobytes per connection.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &enableWebSocketCompression(
+        bool enable = true,
+        size_t threshold = 128,
+        bool contextTakeover = false) = 0;
+
+    /// Limit the messages waiting to be sent on WebSocket connections.
+    /**
+     * @param highWaterMark When the output buffer of a connection reaches
+     * this number of bytes, new messages are held in a send queue until the
+     * buffer is drained. 0 (the default) disables the send queue.
+     * @param maxQueueSize The maximum number of bytes in the send queue, 0
+     * means no limit.
+     * @param policy What to do with a message which doesn't fit in the send
+     * queue.
+     *
+     * @note
+     * A WebSocketController can change these defaults for its connections.
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setWebSocketSendQueueLimits(
+        size_t highWaterMark,
+        size_t maxQueueSize = 0,
+        WebSocketSendQueuePolicy policy =
+            WebSocketSendQueuePolicy::DropOldest) = 0;
+
     // Set the HTML file of the home page, the default value is "index.html"
     /**
      * If there isn't any handler registered to the path "/", the home page file
@@ -899,6 +952,86 @@ class HttpAppFramework : public trantor::NonCopyable
         const std::string &name = "default",
         const bool isFast = false) = 0;
 
+    /// Add a read replica to the database client with the given name
+    /**
+     * Once a client has replicas, its read-only statements and read-only
+     * transactions are executed on the replica with the least outstanding
+     * queries, and everything else is executed on the primary server
+     * configured by createDbClient().
+     *
+     * @param name The name of a client created by createDbClient().
+     * @param connectionNum The number of connections to the replica. If the
+     * client is a fast client, it is the number of connections per IO thread.
+     *
+     * @note
+     * This operation can be performed by the 'replicas' option of a client in
+     * the configuration file.
+     */
+    virtual HttpAppFramework &addDbClientReplica(
+        const std::string &name,
+        const std::string &host,
+        const u_short port,
+        const std::string &databaseName,
+        const std::string &userName,
+        const std::string &password,
+        const size_t connectionNum = 1) = 0;
+
+    /// Set the read-your-writes window of a database client with replicas.
+    /**
+     * After a write through a client returned by DbClient::sessionClient(),
+     * reads of the same session are sent to the primary server for the given
+     * number of seconds. The default value is 0, which disables the feature.
+     *
+     * @note
+     * This operation can be performed by the 'sticky_window' option of a
+     * client in the configuration file.
+     */
+    virtual HttpAppFramework &setDbClientStickyWindow(const std::string &name,
+                                                      double seconds) = 0;
+
+    /// Enable the query cache of a database client
+    /**
+     * The results of read-only statements executed in IO loops are cached
+     * per IO loop and expire after the timeout or when Mapper<T> writes to
+     * a table they read (see drogon::orm::QueryCache). Writes made with raw
+     * SQL should be followed by a DbClient::invalidateQueryCache() call.
+     *
+     * @param name The name of a client created by createDbClient().
+     * @param timeout The number of seconds a result stays in the cache, 0
+     * (the default) disables the cache.
+     * @param maxEntries The maximum number of results cached in an IO loop.
+     *
+     * @note
+     * This operation can be performed by the 'query_cache_timeout' and
+     * 'query_cache_max_entries' options of a client in the configuration
+     * file.
+     */
+    virtual HttpAppFramework &setDbClientQueryCache(
+        const std::string &name,
+        double timeout,
+        size_t maxEntries = 10000) = 0;
+
+    /// Set the sizing and timeout options of the pool of a database client
+    /**
+     * The pool grows up to the maximum number of connections when statements
+     * wait for a connection and shrinks back to the connection number of the
+     * client when the extra connections are idle. Statements which time out
+     * fail with the drogon::orm::TimeoutError exception. See
+     * drogon::orm::DbPoolOptions for details.
+     *
+     * @param name The name of a client created by createDbClient().
+     *
+     * @note
+     * Only clients in normal mode (not fast mode) have a connection pool.
+     * This operation can be performed by the 'max_connection_number',
+     * 'idle_timeout', 'queue_timeout', 'query_timeout',
+     * 'health_check_interval' and 'max_queue_size' options of a client in
+     * the configuration file.
+     */
+    virtual HttpAppFramework &setDbClientPoolOptions(
+        const std::string &name,
+        const orm::DbPoolOptions &options) = 0;
+
     /// Get the DNS resolver
     /**
      * @note
@@ -907,6 +1040,19 @@ class HttpAppFramework : public trantor::NonCopyable
      */
     virtual const std::shared_ptr<trantor::Resolver> &getResolver() const = 0;
 
+    /// Set the TTLs of the host names resolved by HTTP and WebSocket clients.
+    /**
+     * @param ttl The seconds for which the addresses of a host are cached,
+     * the default value is 60.
+     * @param negativeTtl The seconds for which a host that can't be resolved
+     * is cached, the default value is 5.
+     *
+     * @note
+     * This operation can be performed by an option in the configuration file.
+     */
+    virtual HttpAppFramework &setDnsCacheTtl(double ttl,
+                                             double negativeTtl) = 0;
+
     /// Return true is drogon supports SSL(https)
     virtual bool supportSSL() const = 0;
 
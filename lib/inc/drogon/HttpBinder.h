@@ -19,11 +19,13 @@
 
 #include <drogon/DrClassMap.h>
 #include <drogon/DrObject.h>
+#include <drogon/HttpResponse.h>
+#include <drogon/utils/ArgumentConverter.h>
 #include <drogon/utils/FunctionTraits.h>
-#include <list>
+#include <drogon/utils/string_view.h>
 #include <memory>
-#include <sstream>
 #include <string>
+#include <vector>
 
 namespace drogon
 {
@@ -65,8 +67,10 @@ struct BinderArgTypeTraits<const T &>
 class HttpBinderBase
 {
   public:
+    /// The path arguments must be kept in the request, because the
+    /// string_view arguments of the handler refer to them.
     virtual void handleHttpRequest(
-        std::list<std::string> &pathArguments,
+        std::vector<std::string> &pathArguments,
         const HttpRequestPtr &req,
         std::function<void(const HttpResponsePtr &)> &&callback) = 0;
     virtual size_t paramCount() = 0;
@@ -94,7 +98,7 @@ class HttpBinder : public HttpBinderBase
   public:
     typedef FUNCTION FunctionType;
     virtual void handleHttpRequest(
-        std::list<std::string> &pathArguments,
+        std::vector<std::string> &pathArguments,
         const HttpRequestPtr &req,
         std::function<void(const HttpResponsePtr &)> &&callback) override
     {
@@ -129,64 +133,28 @@ class HttpBinder : public HttpBinderBase
 
     static const size_t argument_count = traits::arity;
     std::string _handlerName;
+    // The conversion is chosen at compile time by the argument type.
     template <typename T>
-    void getHandlerArgumentValue(T &value, std::string &&p)
+    bool getHandlerArgumentValue(T &value, std::string &p)
     {
-        if (!p.empty())
-        {
-            std::stringstream ss(std::move(p));
-            ss >> value;
-        }
+        return ArgumentConverter<T>::convert(p, value);
     }
 
-    void getHandlerArgumentValue(std::string &value, std::string &&p)
+    bool getHandlerArgumentValue(std::string &value, std::string &p)
     {
         value = std::move(p);
+        return true;
     }
 
-    void getHandlerArgumentValue(int &value, std::string &&p)
-    {
-        value = std::stoi(p);
-    }
-
-    void getHandlerArgumentValue(long &value, std::string &&p)
-    {
-        value = std::stol(p);
-    }
-
-    void getHandlerArgumentValue(long long &value, std::string &&p)
-    {
-        value = std::stoll(p);
-    }
-
-    void getHandlerArgumentValue(unsigned long &value, std::string &&p)
-    {
-        value = std::stoul(p);
-    }
-
-    void getHandlerArgumentValue(unsigned long long &value, std::string &&p)
-    {
-        value = std::stoull(p);
-    }
-
-    void getHandlerArgumentValue(float &value, std::string &&p)
-    {
-        value = std::stof(p);
-    }
-
-    void getHandlerArgumentValue(double &value, std::string &&p)
-    {
-        value = std::stod(p);
-    }
-
-    void getHandlerArgumentValue(long double &value, std::string &&p)
+    bool getHandlerArgumentValue(string_view &value, std::string &p)
     {
-        value = std::stold(p);
+        value = string_view(p.data(), p.length());
+        return true;
     }
 
     template <typename... Values, std::size_t Boundary = argument_count>
     typename std::enable_if<(sizeof...(Values) < Boundary), void>::type run(
-        std::list<std::string> &pathArguments,
+        std::vector<std::string> &pathArguments,
         const HttpRequestPtr &req,
         std::function<void(const HttpResponsePtr &)> &&callback,
         Values &&... values)
@@ -200,15 +168,19 @@ class HttpBinder : public HttpBinderBase
         typedef typename std::remove_cv<typename std::remove_reference<
             nth_argument_type<sizeof...(Values)>>::type>::type ValueType;
         ValueType value = ValueType();
-        if (!pathArguments.empty())
+        if (sizeof...(Values) < pathArguments.size() &&
+            !pathArguments[sizeof...(Values)].empty())
         {
-            std::string v = std::move(pathArguments.front());
-            pathArguments.pop_front();
+            auto &v = pathArguments[sizeof...(Values)];
+            bool converted = false;
             try
             {
-                getHandlerArgumentValue(value, std::move(v));
+                converted = getHandlerArgumentValue(value, v);
             }
             catch (...)
+            {
+            }
+            if (!converted)
             {
                 LOG_ERROR << "Error converting string \"" << v << "\" to the "
                           << sizeof...(Values) + 1 << "th argument";
@@ -221,46 +193,87 @@ class HttpBinder : public HttpBinderBase
             std::forward<Values>(values)...,
             std::move(value));
     }
-    template <typename... Values, std::size_t Boundary = argument_count>
-    typename std::enable_if<(sizeof...(Values) == Boundary), void>::type run(
-        std::list<std::string> &pathArguments,
+    template <typename... Values,
+              std::size_t Boundary = argument_count,
+              bool isCoroutine = traits::isCoroutine>
+    typename std::enable_if<(sizeof...(Values) == Boundary) && !isCoroutine,
+                            void>::type
+    run(std::vector<std::string> &pathArguments,
         const HttpRequestPtr &req,
         std::function<void(const HttpResponsePtr &)> &&callback,
         Values &&... values)
     {
         callFunction(req, std::move(callback), std::move(values)...);
     }
+#ifdef DROGON_HAS_COROUTINE
+    template <typename... Values,
+              std::size_t Boundary = argument_count,
+              bool isCoroutine = traits::isCoroutine>
+    typename std::enable_if<(sizeof...(Values) == Boundary) && isCoroutine,
+                            void>::type
+    run(std::vector<std::string> &pathArguments,
+        const HttpRequestPtr &req,
+        std::function<void(const HttpResponsePtr &)> &&callback,
+        Values &&... values)
+    {
+        runCoroutine(req, std::move(callback), std::move(values)...);
+    }
+    // The arguments are kept in the frame until the handler returns.
+    template <typename... Values>
+    AsyncTask runCoroutine(
+        HttpRequestPtr req,
+        std::function<void(const HttpResponsePtr &)> callback,
+        Values... values)
+    {
+        HttpResponsePtr resp;
+        try
+        {
+            resp = co_await callFunction(req, std::move(values)...);
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR << "Unhandled exception in " << _handlerName << ": "
+                      << e.what();
+            resp = HttpResponse::newHttpResponse();
+            resp->setStatusCode(k500InternalServerError);
+        }
+        catch (...)
+        {
+            LOG_ERROR << "Unhandled exception in " << _handlerName;
+            resp = HttpResponse::newHttpResponse();
+            resp->setStatusCode(k500InternalServerError);
+        }
+        callback(resp);
+    }
+#endif
     template <typename... Values,
               bool isClassFunction = traits::isClassFunction,
               bool isDrObjectClass = traits::isDrObjectClass>
-    typename std::enable_if<isClassFunction && !isDrObjectClass, void>::type
-    callFunction(const HttpRequestPtr &req,
-                 std::function<void(const HttpResponsePtr &)> &&callback,
-                 Values &&... values)
+    typename std::enable_if<isClassFunction && !isDrObjectClass,
+                            typename traits::result_type>::type
+    callFunction(Values &&... values)
     {
         static auto &obj = getControllerObj<typename traits::class_type>();
-        (obj.*_func)(req, std::move(callback), std::move(values)...);
+        return (obj.*_func)(std::forward<Values>(values)...);
     }
     template <typename... Values,
               bool isClassFunction = traits::isClassFunction,
               bool isDrObjectClass = traits::isDrObjectClass>
-    typename std::enable_if<isClassFunction && isDrObjectClass, void>::type
-    callFunction(const HttpRequestPtr &req,
-                 std::function<void(const HttpResponsePtr &)> &&callback,
-                 Values &&... values)
+    typename std::enable_if<isClassFunction && isDrObjectClass,
+                            typename traits::result_type>::type
+    callFunction(Values &&... values)
     {
         static auto objPtr =
             DrClassMap::getSingleInstance<typename traits::class_type>();
-        (*objPtr.*_func)(req, std::move(callback), std::move(values)...);
+        return (*objPtr.*_func)(std::forward<Values>(values)...);
     }
     template <typename... Values,
               bool isClassFunction = traits::isClassFunction>
-    typename std::enable_if<!isClassFunction, void>::type callFunction(
-        const HttpRequestPtr &req,
-        std::function<void(const HttpResponsePtr &)> &&callback,
-        Values &&... values)
+    typename std::enable_if<!isClassFunction,
+                            typename traits::result_type>::type
+    callFunction(Values &&... values)
     {
-        _func(req, std::move(callback), std::move(values)...);
+        return _func(std::forward<Values>(values)...);
     }
 };
 
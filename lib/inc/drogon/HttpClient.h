@@ -18,14 +18,25 @@
 #include <drogon/drogon_callbacks.h>
 #include <drogon/HttpResponse.h>
 #include <drogon/HttpRequest.h>
+#include <drogon/utils/coroutine.h>
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/EventLoop.h>
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <stdexcept>
 namespace drogon
 {
 class HttpClient;
 typedef std::shared_ptr<HttpClient> HttpClientPtr;
+/// Receive a part of the body of a response, return false to abort it.
+typedef std::function<bool(const char *data, size_t length)> HttpBodyCallback;
+#ifdef DROGON_HAS_COROUTINE
+namespace internal
+{
+class HttpRespAwaiter;
+}
+#endif
 
 /// Asynchronous http client
 /**
@@ -72,6 +83,131 @@ class HttpClient : public trantor::NonCopyable
     virtual void sendRequest(const HttpRequestPtr &req,
                              HttpReqCallback &&callback) = 0;
 
+    /**
+     * @brief Send a request asynchronously to the server with a timeout
+     *
+     * @param req The request sent to the server.
+     * @param callback The callback is called when the response is received from
+     * the server, or with ReqResult::Timeout if no response is received in
+     * time.
+     * @param timeout The timeout in seconds, 0 means no timeout.
+     * @note
+     * The request may still be processed by the server after the timeout.
+     * The connection it was sent on is closed, so the requests pipelined
+     * behind it are sent again on a new connection.
+     * The default implementation arms a timer in the loop of the client and
+     * only discards the response.
+     */
+    virtual void sendRequest(const HttpRequestPtr &req,
+                             const HttpReqCallback &callback,
+                             double timeout)
+    {
+        if (timeout <= 0)
+        {
+            sendRequest(req, callback);
+            return;
+        }
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        auto loop = getLoop();
+        auto timerId = loop->runAfter(timeout, [done, callback]() {
+            if (done->exchange(true))
+                return;
+            callback(ReqResult::Timeout, nullptr);
+        });
+        sendRequest(req,
+                    [done, callback, loop, timerId](
+                        ReqResult result, const HttpResponsePtr &response) {
+                        if (done->exchange(true))
+                            return;
+                        loop->invalidateTimer(timerId);
+                        callback(result, response);
+                    });
+    }
+
+#ifdef DROGON_HAS_COROUTINE
+    /**
+     * @brief Send a request to the server in a coroutine
+     *
+     * The coroutine is resumed with the response in the event loop where it's
+     * suspended. If no response is received, a HttpReqException with the
+     * reason is thrown in it.
+     * @code
+       auto resp = co_await client->sendRequestCoro(req);
+       @endcode
+     * @param timeout The timeout in seconds, 0 means no timeout.
+     */
+    internal::HttpRespAwaiter sendRequestCoro(const HttpRequestPtr &req,
+                                              double timeout = 0);
+#endif
+
+    /**
+     * @brief Send a request and receive the body of its response in parts as
+     * they arrive, so that large bodies are never kept in memory.
+     *
+     * @param req The request sent to the server.
+     * @param headersCallback is called when the headers of the response are
+     * received, the response passed to it has no body. If the result is not
+     * ReqResult::Ok, the other callbacks are never called.
+     * @param bodyCallback is called with every part of the body. If it
+     * returns false, the connection is closed, the rest of the body is
+     * discarded and the completionCallback is not called.
+     * @param completionCallback is called when the whole body is received
+     * with ReqResult::Ok, or with the reason why the body is incomplete.
+     * @param decompress If true, a body encoded with gzip is decompressed
+     * before it is passed to the bodyCallback and the Content-Encoding
+     * header is removed from the response.
+     * @param timeout The time in seconds to wait for the headers, 0 means no
+     * timeout. On timeout, the headersCallback is called with
+     * ReqResult::Timeout and the response is discarded when it arrives.
+     * @note
+     * The callbacks are called in the event loop of the client, one part of
+     * the body is passed as soon as it is read from the socket. The server is
+     * slowed down by TCP flow control only when the event loop of the client
+     * is busy, so a slow consumer should return false rather than buffer
+     * without limit.
+     */
+    virtual void sendStreamRequest(
+        const HttpRequestPtr &req,
+        const HttpReqCallback &headersCallback,
+        const HttpBodyCallback &bodyCallback,
+        const std::function<void(ReqResult)> &completionCallback,
+        bool decompress = true,
+        double timeout = 0) = 0;
+
+    /**
+     * @brief Send a request and forward its response as a streaming response.
+     *
+     * The callback is called once the headers of the response are received,
+     * with a response carrying the status code, the headers and the cookies
+     * of the response from the server. Its body is passed on without
+     * decompression as it arrives, so the response can be returned to a
+     * client of the application immediately, e.g.
+     * @code
+       client->forwardRequest(req, [callback](ReqResult result,
+                                              const HttpResponsePtr &resp) {
+           if (result == ReqResult::Ok)
+               callback(resp);
+           else
+               callback(HttpResponse::newNotFoundResponse());
+       });
+       @endcode
+     * If the connection to the server fails in the middle of the body, the
+     * connection to the client is closed; if the client goes away, the
+     * request to the server is aborted. Hop-by-hop headers and the Date and
+     * Server headers, which are added by the framework, are not forwarded.
+     *
+     * @param completionCallback is called after the callback when the body
+     * has been received from the server, or with the reason why the request
+     * failed.
+     * @param timeout The time in seconds to wait for the headers, 0 means no
+     * timeout.
+     */
+    void forwardRequest(
+        const HttpRequestPtr &req,
+        const HttpReqCallback &callback,
+        const std::function<void(ReqResult)> &completionCallback = nullptr,
+        double timeout = 0);
+
     /// Set the pipelining depth, which is the number of requests that are not
     /// responding.
     /**
@@ -162,6 +298,32 @@ class HttpClient : public trantor::NonCopyable
     static HttpClientPtr newHttpClient(const std::string &hostString,
                                        trantor::EventLoop *loop = nullptr);
 
+    /// Create a pool of Http clients using the hostString to connect to server
+    /**
+     * The pool keeps up to connectionsPerLoop keep-alive connections in every
+     * event loop from which requests are sent, so a request sent in an IO loop
+     * of the framework never leaves that loop. Requests sent from other
+     * threads use the loop identified by the loop parameter, or the
+     * HttpAppFramework's event loop if it is nullptr.
+     *
+     * A request is sent on the connection with the fewest requests in flight.
+     * A connection which has been idle for idleTimeout seconds is closed, 0
+     * means never. Idempotent requests (GET, HEAD, PUT, DELETE and OPTIONS) in
+     * flight on a keep-alive connection closed by the server are sent again on
+     * a new connection.
+     *
+     * @param hostString The same as the one of the newHttpClient() method.
+     *
+     * @note
+     * The pipelining depth and the cookies should be set before sending
+     * requests. Cookies set by the server are only carried by the requests
+     * sent on the same connection.
+     */
+    static HttpClientPtr newHttpClientPool(const std::string &hostString,
+                                           size_t connectionsPerLoop = 4,
+                                           double idleTimeout = 60.0,
+                                           trantor::EventLoop *loop = nullptr);
+
     virtual ~HttpClient()
     {
     }
@@ -170,4 +332,81 @@ class HttpClient : public trantor::NonCopyable
     HttpClient() = default;
 };
 
+#ifdef DROGON_HAS_COROUTINE
+/// The exception thrown in a coroutine if no response is received
+class HttpReqException : public std::runtime_error
+{
+  public:
+    explicit HttpReqException(ReqResult result)
+        : std::runtime_error(resultString(result)), _result(result)
+    {
+    }
+    ReqResult result() const
+    {
+        return _result;
+    }
+
+  private:
+    static const char *resultString(ReqResult result)
+    {
+        switch (result)
+        {
+            case ReqResult::BadResponse:
+                return "Bad response";
+            case ReqResult::NetworkFailure:
+                return "Network failure";
+            case ReqResult::BadServerAddress:
+                return "Bad server address";
+            case ReqResult::Timeout:
+                return "Timeout";
+            default:
+                return "Unknown error";
+        }
+    }
+    ReqResult _result;
+};
+
+namespace internal
+{
+class HttpRespAwaiter : public CallbackAwaiter<HttpResponsePtr>
+{
+  public:
+    HttpRespAwaiter(HttpClient &client,
+                    const HttpRequestPtr &req,
+                    double timeout)
+        : _client(client), _req(req), _timeout(timeout)
+    {
+    }
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        setHandle(handle);
+        auto callback = [this](ReqResult result,
+                               const HttpResponsePtr &resp) {
+            if (result == ReqResult::Ok)
+                setValue(resp);
+            else
+                setException(std::make_exception_ptr(HttpReqException(result)));
+        };
+        if (_timeout > 0)
+            _client.sendRequest(_req, callback, _timeout);
+        else
+            _client.sendRequest(_req, std::move(callback));
+        return suspend();
+    }
+
+  private:
+    HttpClient &_client;
+    HttpRequestPtr _req;
+    double _timeout;
+};
+}  // namespace internal
+
+inline internal::HttpRespAwaiter HttpClient::sendRequestCoro(
+    const HttpRequestPtr &req,
+    double timeout)
+{
+    return internal::HttpRespAwaiter(*this, req, timeout);
+}
+#endif
+
 }  // namespace drogon
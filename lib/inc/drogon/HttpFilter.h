@@ -43,9 +43,23 @@ class HttpFilterBase : public virtual DrObjectBase
     virtual void doFilter(const HttpRequestPtr &req,
                           FilterCallback &&fcb,
                           FilterChainCallback &&fccb) = 0;
+
+    /// Return true if the filter is a HttpSyncFilter.
+    bool isSynchronous() const
+    {
+        return _isSynchronous;
+    }
+    /// The synchronous interface of the filter, see HttpSyncFilter.
+    virtual HttpResponsePtr doSyncFilter(const HttpRequestPtr &)
+    {
+        return nullptr;
+    }
     virtual ~HttpFilterBase()
     {
     }
+
+  protected:
+    bool _isSynchronous = false;
 };
 
 /**
@@ -64,4 +78,45 @@ class HttpFilter : public DrObject<T>, public HttpFilterBase
     {
     }
 };
+
+/**
+ * @brief The reflection base class template for synchronous filters
+ *
+ * A synchronous filter returns the response for the request which doesn't
+ * pass it, or nullptr for the request which passes it, so the framework runs
+ * it without creating callbacks for it. Filters which don't wait for other
+ * services (e.g. checking the peer address or a header) should derive from
+ * this class.
+ */
+template <typename T, bool AutoCreation = true>
+class HttpSyncFilter : public HttpFilter<T, AutoCreation>
+{
+  public:
+    HttpSyncFilter()
+    {
+        this->_isSynchronous = true;
+    }
+    /// This virtual function should be overridden in subclasses.
+    /**
+     * @return the response sent to the client if the request doesn't pass
+     * the filter, otherwise nullptr.
+     */
+    virtual HttpResponsePtr doSyncFilter(
+        const HttpRequestPtr &req) override = 0;
+
+    /// Call doSyncFilter(), it's not called by the framework.
+    virtual void doFilter(const HttpRequestPtr &req,
+                          FilterCallback &&fcb,
+                          FilterChainCallback &&fccb) override
+    {
+        auto resp = doSyncFilter(req);
+        if (resp)
+            fcb(resp);
+        else
+            fccb();
+    }
+    virtual ~HttpSyncFilter()
+    {
+    }
+};
 }  // namespace drogon
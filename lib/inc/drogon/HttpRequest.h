@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <drogon/utils/Arena.h>
 #include <drogon/utils/string_view.h>
 #include <drogon/HttpTypes.h>
 #include <drogon/Session.h>
@@ -115,6 +116,29 @@ class HttpRequest
     virtual const char *bodyData() const = 0;
     virtual size_t bodyLength() const = 0;
 
+    /// Save the body to a file, return 0 on success.
+    /**
+     * A body larger than the max body size in memory has been written to a
+     * temporary file while it was received, the file is linked to the path
+     * instead of being copied when they are in the same file system.
+     * @param filename if the parameter isn't prefixed with "/", "./" or
+     * "../", the full path is app().getUploadPath()+"/"+filename, otherwise
+     * the file is saved as the filename.
+     * The default implementation writes bodyData() to the file.
+     */
+    virtual int saveBodyAs(const std::string &filename) const;
+
+    /// Return the descriptor of the temporary file holding the body, or -1 if
+    /// the body is in memory.
+    /**
+     * The file belongs to the request, so it should be read with pread() or
+     * through a dup() of the descriptor.
+     */
+    virtual int bodyFileDescriptor() const
+    {
+        return -1;
+    }
+
     /// Set the content string of the request.
     virtual void setBody(const std::string &body) = 0;
 
@@ -222,6 +246,15 @@ class HttpRequest
         return contentType();
     }
 
+    /// Get the memory arena of the request
+    /**
+     * The memory allocated from the arena is released when the request is
+     * destroyed or returned to the pool of its connection, so a handler can
+     * allocate the temporary data of the request from it, e.g. with
+     * ArenaAllocator. See Arena for details.
+     */
+    virtual Arena &arena() = 0;
+
     /// Set the Http method
     virtual void setMethod(const HttpMethod method) = 0;
 
@@ -17,7 +17,9 @@
 #include <drogon/Cookie.h>
 #include <drogon/HttpTypes.h>
 #include <drogon/HttpViewData.h>
+#include <drogon/ResponseStream.h>
 #include <json/json.h>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -236,6 +238,19 @@ class HttpResponse
         const std::string &viewName,
         const HttpViewData &data = HttpViewData());
 
+    /// Create a response that streams a page rendered by a view.
+    /**
+     * The page is sent with the chunked transfer coding, a part is sent to
+     * the client whenever the view reaches a <%flush%> directive, so the head
+     * of a large page is received before the rest is rendered. The view is
+     * rendered in the IO loop of the connection after the headers are sent.
+     * @param viewName The name of the view
+     * @param data is the data displayed on the page, it's copied.
+     */
+    static HttpResponsePtr newStreamViewResponse(
+        const std::string &viewName,
+        const HttpViewData &data = HttpViewData());
+
     /// Create a response that returns a 302 Found page, redirecting to another
     /// page located in the location parameter.
     static HttpResponsePtr newRedirectionResponse(const std::string &location);
@@ -253,6 +268,18 @@ class HttpResponse
         const std::string &attachmentFileName = "",
         ContentType type = CT_NONE);
 
+    /// Create a response whose body is produced after the headers are sent.
+    /**
+     * @param callback is called in the IO loop of the connection once the
+     * headers are sent, the body is sent through the stream with the chunked
+     * transfer coding, or delimited by closing the connection for HTTP/1.0
+     * clients. The callback is not called for HEAD requests.
+     * @note Responses to the requests pipelined after this one are held until
+     * the stream is finished.
+     */
+    static HttpResponsePtr newStreamResponse(
+        const std::function<void(const ResponseStreamPtr &)> &callback);
+
     virtual ~HttpResponse()
     {
     }
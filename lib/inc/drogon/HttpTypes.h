@@ -128,4 +128,16 @@ enum class WebSocketMessageType
     Unknown
 };
 
+/// What a WebSocket connection does with a message which would make its send
+/// queue exceed the limit
+enum class WebSocketSendQueuePolicy
+{
+    DropOldest,
+    DropNewest,
+    // Close the connection with the status code 1008
+    CloseWithPolicyViolation,
+    // Close the connection with the status code 1013
+    CloseWithTryAgainLater
+};
+
 }  // namespace drogon
@@ -129,6 +129,31 @@ class HttpViewData
         return _viewData[key];
     }
 
+    /// Get the string identified by the key parameter without copying it.
+    /**
+     * An empty string is returned if there is no such item or the item is
+     * neither a std::string nor a const char *. The views generated by
+     * drogon_ctl resolve the [[ key ]] expressions with it.
+     */
+    string_view getStringView(const std::string &key) const
+    {
+        auto it = _viewData.find(key);
+        if (it == _viewData.end())
+            return string_view();
+        auto &val = it->second;
+        if (val.type() == typeid(const char *))
+        {
+            auto str = *any_cast<const char *>(&val);
+            return str ? string_view(str) : string_view();
+        }
+        if (val.type() == typeid(std::string))
+        {
+            auto &str = *any_cast<std::string>(&val);
+            return string_view(str.data(), str.length());
+        }
+        return string_view();
+    }
+
     /// Translate some special characters to HTML format
     /**
      * such as:
@@ -21,14 +21,12 @@ namespace drogon
 /**
  * @brief A filter that prohibit access from external networks
  */
-class IntranetIpFilter : public HttpFilter<IntranetIpFilter>
+class IntranetIpFilter : public HttpSyncFilter<IntranetIpFilter>
 {
   public:
     IntranetIpFilter()
     {
     }
-    virtual void doFilter(const HttpRequestPtr &req,
-                          FilterCallback &&fcb,
-                          FilterChainCallback &&fccb) override;
+    virtual HttpResponsePtr doSyncFilter(const HttpRequestPtr &req) override;
 };
 }  // namespace drogon
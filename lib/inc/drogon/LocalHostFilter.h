@@ -21,14 +21,12 @@ namespace drogon
 /**
  * @brief A filter that prohibit access from other hosts.
  */
-class LocalHostFilter : public HttpFilter<LocalHostFilter>
+class LocalHostFilter : public HttpSyncFilter<LocalHostFilter>
 {
   public:
     LocalHostFilter()
     {
     }
-    virtual void doFilter(const HttpRequestPtr &req,
-                          FilterCallback &&fcb,
-                          FilterChainCallback &&fccb) override;
+    virtual HttpResponsePtr doSyncFilter(const HttpRequestPtr &req) override;
 };
 }  // namespace drogon
@@ -15,11 +15,13 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace drogon
 {
+class CacheFile;
 class HttpFile
 {
   public:
@@ -39,10 +41,14 @@ class HttpFile
     void setFile(const std::string &file)
     {
         _fileContent = file;
+        _cacheFilePtr.reset();
+        _md5.clear();
     };
     void setFile(std::string &&file)
     {
         _fileContent = std::move(file);
+        _cacheFilePtr.reset();
+        _md5.clear();
     }
 
     /// Save the file to the file system.
@@ -72,6 +78,8 @@ class HttpFile
     /// Return the file length.
     int64_t fileLength() const
     {
+        if (_cacheFilePtr)
+            return _fileLength;
         return _fileContent.length();
     };
 
@@ -79,9 +87,16 @@ class HttpFile
     const std::string getMd5() const;
 
   protected:
+    friend class MultiPartStreamParser;
     int saveTo(const std::string &pathAndFilename) const;
     std::string _fileName;
     std::string _fileContent;
+    // The temporary file holding the contents of a file uploaded in a large
+    // request body instead of _fileContent, it is removed with the last copy
+    // of the HttpFile.
+    std::shared_ptr<CacheFile> _cacheFilePtr;
+    int64_t _fileLength = 0;
+    std::string _md5;
 };
 
 /// A parser class which help the user to get the files and the parameters in
@@ -0,0 +1,59 @@
+/**
+ *
+ *  ResponseStream.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/NonCopyable.h>
+#include <memory>
+#include <string>
+
+namespace drogon
+{
+/// The body of a streaming response
+/**
+ * The body is sent to the client with the chunked transfer coding as it is
+ * produced, or as it is until the connection is closed if the client speaks
+ * HTTP/1.0. The methods can be called in any thread. The response is
+ * finished when the close() method is called or the last reference to the
+ * stream is released.
+ */
+class ResponseStream : public trantor::NonCopyable
+{
+  public:
+    /// Send a part of the body.
+    /**
+     * Return false if the connection is closed or the stream is finished,
+     * then the rest of the body should not be produced.
+     */
+    virtual bool send(const char *data, size_t length) = 0;
+    bool send(const std::string &data)
+    {
+        return send(data.data(), data.length());
+    }
+
+    /// Finish the response, the next responses on the connection are sent
+    /// after it.
+    virtual void close() = 0;
+
+    /// Close the connection without finishing the response, so that the
+    /// client knows the body is incomplete.
+    virtual void abort() = 0;
+
+    virtual ~ResponseStream()
+    {
+    }
+};
+typedef std::shared_ptr<ResponseStream> ResponseStreamPtr;
+
+}  // namespace drogon
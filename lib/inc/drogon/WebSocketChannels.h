@@ -0,0 +1,92 @@
+/**
+ *
+ *  WebSocketChannels.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/WebSocketConnection.h>
+#include <trantor/utils/NonCopyable.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace trantor
+{
+class EventLoop;
+}
+
+namespace drogon
+{
+/**
+ * @brief Publish messages to the WebSocket connections subscribed to channels.
+ *
+ * A published message is encoded into a frame once and the same buffer is
+ * sent to every subscribed server connection. The subscriptions are kept in
+ * the IO loop of each connection, so publishing a message queues one task
+ * into each IO loop and never locks the subscriptions of other loops.
+ *
+ * For example:
+ * @code
+   // In the handleNewConnection() method of a WebSocketController
+   channels.subscribe("prices", wsConnPtr);
+   // Anywhere
+   channels.publish("prices", "{\"symbol\":\"ABC\",\"price\":10}");
+   @endcode
+ */
+class WebSocketChannels : public trantor::NonCopyable
+{
+  public:
+    WebSocketChannels();
+    ~WebSocketChannels();
+
+    /**
+     * @brief Subscribe a connection to a channel.
+     *
+     * @note
+     * A closed connection is unsubscribed from all channels automatically
+     * when the next message is published.
+     */
+    void subscribe(const std::string &channel,
+                   const WebSocketConnectionPtr &connection);
+
+    /// Unsubscribe a connection from a channel.
+    void unsubscribe(const std::string &channel,
+                     const WebSocketConnectionPtr &connection);
+
+    /**
+     * @brief Send a message to all connections subscribed to a channel.
+     *
+     * @param channel The channel name.
+     * @param message The message to be sent.
+     * @param type The message type, Text or Binary.
+     */
+    void publish(
+        const std::string &channel,
+        const std::string &message,
+        const WebSocketMessageType &type = WebSocketMessageType::Text);
+
+  private:
+    struct LoopChannels;
+    typedef std::vector<
+        std::pair<trantor::EventLoop *, std::shared_ptr<LoopChannels>>>
+        LoopList;
+    std::shared_ptr<LoopChannels> loopChannels(trantor::EventLoop *loop);
+
+    std::mutex _mutex;
+    /// Copied on write, so publishing messages doesn't need the mutex.
+    std::shared_ptr<const LoopList> _loops;
+};
+
+}  // namespace drogon
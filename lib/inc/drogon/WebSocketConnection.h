@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <drogon/HttpTypes.h>
@@ -21,6 +22,30 @@
 #include <trantor/utils/NonCopyable.h>
 namespace drogon
 {
+/**
+ * @brief The limits of the messages waiting to be sent on a WebSocket
+ * connection.
+ *
+ * When the output buffer of the connection reaches the high water mark, new
+ * data messages are held in a send queue until the buffer is drained. The
+ * queue never grows beyond maxQueueSize bytes, messages which don't fit are
+ * handled by the policy. Control frames bypass the queue.
+ */
+struct WebSocketSendQueueOptions
+{
+    /// The size of the output buffer in bytes from which messages are queued,
+    /// 0 (the default) disables the send queue.
+    size_t _highWaterMark = 0;
+    /// The maximum number of bytes in the send queue, 0 means no limit.
+    size_t _maxQueueSize = 0;
+    WebSocketSendQueuePolicy _policy = WebSocketSendQueuePolicy::DropOldest;
+};
+
+class WebSocketConnection;
+typedef std::function<void(const std::shared_ptr<WebSocketConnection> &,
+                           size_t)>
+    WebSocketHighWaterMarkCallback;
+
 /**
  * @brief The WebSocket connection abstract class.
  *
@@ -129,6 +154,31 @@ class WebSocketConnection
         const std::string &message,
         const std::chrono::duration<long double> &interval) = 0;
 
+    /**
+     * @brief Limit the messages waiting to be sent to the peer.
+     *
+     * @note
+     * This method should be called before sending any message, the defaults
+     * of the connections of a WebSocketController are set by the application
+     * and the controller.
+     */
+    virtual void setSendQueueOptions(
+        const WebSocketSendQueueOptions &options) = 0;
+
+    /**
+     * @brief Set the callback called in the IO loop of the connection when
+     * its output buffer reaches the high water mark.
+     *
+     * The callback is given the size of the output buffer. It only works when
+     * the high water mark is set by setSendQueueOptions().
+     */
+    virtual void setHighWaterMarkCallback(
+        const WebSocketHighWaterMarkCallback &callback) = 0;
+
+    /// Return the number of bytes in the send queue, which are not yet
+    /// written to the output buffer.
+    virtual size_t sendQueueSize() const = 0;
+
   private:
     std::shared_ptr<void> _contextPtr;
 };
@@ -58,6 +58,13 @@ class WebSocketControllerBase : public virtual DrObjectBase
     // This function is called after a WebSocket connection is closed
     virtual void handleConnectionClosed(const WebSocketConnectionPtr &) = 0;
 
+    // This function is called before handleNewConnection() with the send
+    // queue limits of the application, override it to change them for the
+    // connections of the controller.
+    virtual void setupSendQueue(WebSocketSendQueueOptions &options) const
+    {
+    }
+
     virtual ~WebSocketControllerBase()
     {
     }
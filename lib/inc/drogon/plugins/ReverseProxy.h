@@ -0,0 +1,106 @@
+/**
+ *
+ *  ReverseProxy.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/plugins/Plugin.h>
+#include <drogon/HttpRequest.h>
+#include <drogon/drogon_callbacks.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon
+{
+namespace plugin
+{
+/**
+ * @brief Forward the requests of some paths to groups of upstream servers.
+ *
+ * The requests are sent on keep-alive connections pooled in every IO loop,
+ * and the bodies of the responses are passed to the clients as they arrive.
+ * A backend is skipped for fail_timeout seconds after max_fails consecutive
+ * requests to it fail to get a response; a request which couldn't connect to
+ * a backend is sent to the next one. If a backend doesn't send the headers of
+ * a response within timeout seconds, the client is answered with 504. The
+ * plugin is configured in the configuration file, e.g.
+ * @code
+   {
+       "name": "drogon::plugin::ReverseProxy",
+       "config": {
+           "upstreams": {
+               "api": {
+                   "backends": ["http://10.0.0.1:8080", "http://10.0.0.2:8080"],
+                   // round_robin (default), least_connections or
+                   // consistent_hash
+                   "balance": "round_robin",
+                   // The key of consistent hashing: ip (default), path or
+                   // header:<name>
+                   "hash_key": "ip",
+                   "connections_per_loop": 8,
+                   "idle_timeout": 60,
+                   "max_fails": 3,
+                   "fail_timeout": 10,
+                   "timeout": 60
+               }
+           },
+           "routes": [{
+               "path_prefix": "/api/",
+               "upstream": "api",
+               // Replace the path prefix before forwarding, optional
+               "rewrite_prefix": "/",
+               "set_request_headers": {"X-Gateway": "drogon"},
+               "remove_request_headers": ["cookie"],
+               "set_response_headers": {"X-Served-By": "gateway"},
+               "remove_response_headers": ["x-powered-by"]
+           }],
+           // Add the X-Forwarded-For and X-Forwarded-Host headers
+           "x_forwarded_for": true
+       }
+   }
+   @endcode
+ * The routes are matched in order before any handler of the application, a
+ * path_prefix matches the paths equal to it or below it, e.g. "/api" matches
+ * "/api" and "/api/users" but not "/apiary".
+ */
+class ReverseProxy : public drogon::Plugin<ReverseProxy>
+{
+  public:
+    ReverseProxy();
+    ~ReverseProxy();
+    virtual void initAndStart(const Json::Value &config) override;
+    virtual void shutdown() override;
+
+  private:
+    struct Backend;
+    struct ActiveRequest;
+    struct Upstream;
+    struct Route;
+    void proxy(const HttpRequestPtr &req,
+               const Route &route,
+               AdviceCallback &&callback);
+    void sendToBackend(const HttpRequestPtr &req,
+                       const HttpRequestPtr &upstreamReq,
+                       const Route &route,
+                       const std::shared_ptr<AdviceCallback> &callback,
+                       std::vector<Backend *> &&triedBackends);
+
+    std::unordered_map<std::string, std::shared_ptr<Upstream>> _upstreams;
+    std::vector<Route> _routes;
+    bool _xForwardedFor = true;
+};
+
+}  // namespace plugin
+}  // namespace drogon
@@ -0,0 +1,160 @@
+/**
+ *
+ *  Arena.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/utils/string_view.h>
+#include <trantor/utils/NonCopyable.h>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <string.h>
+
+namespace drogon
+{
+/// A memory arena for the data which live as long as a request
+/**
+ * Memory is allocated from blocks by bumping a pointer and is never freed
+ * piece by piece, it is all released by reset(). The first block is kept by
+ * reset(), so reset() takes constant time unless more blocks or objects with
+ * destructors are used, and a pooled request allocates its block only once.
+ * If a request needs more blocks, the first block is enlarged (up to 64K) for
+ * the next requests.
+ *
+ * Every request has an arena which is reset when the request is finished,
+ * see HttpRequest::arena(). An arena is used in one thread at a time.
+ */
+class Arena : public trantor::NonCopyable
+{
+  public:
+    explicit Arena(size_t blockSize = 4096) : _blockSize(blockSize)
+    {
+    }
+    ~Arena();
+
+    /// Allocate memory which is valid until reset() is called.
+    void *allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+    {
+        auto p = (reinterpret_cast<size_t>(_ptr) + alignment - 1) &
+                 ~(alignment - 1);
+        if (_ptr && p + size <= reinterpret_cast<size_t>(_end))
+        {
+            _ptr = reinterpret_cast<char *>(p + size);
+            return reinterpret_cast<void *>(p);
+        }
+        return allocateSlow(size, alignment);
+    }
+
+    /// Create an object in the arena, it's destroyed by reset().
+    template <typename T, typename... Args>
+    T *create(Args &&... args)
+    {
+        auto p = new (allocate(sizeof(T), alignof(T)))
+            T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value)
+            addDestructor(p, [](void *obj) { static_cast<T *>(obj)->~T(); });
+        return p;
+    }
+
+    /// Copy a string to the arena.
+    string_view copy(const string_view &str)
+    {
+        if (str.empty())
+            return string_view();
+        auto p = static_cast<char *>(allocate(str.length(), 1));
+        memcpy(p, str.data(), str.length());
+        return string_view(p, str.length());
+    }
+
+    /// Destroy the objects created in the arena and release its memory.
+    void reset()
+    {
+        if (_destructors || _extraBlocks)
+            releaseSlow();
+        _ptr = _firstBlock;
+        _end = _firstBlock ? _firstBlock + _firstBlockSize : nullptr;
+    }
+
+  private:
+    struct Block
+    {
+        Block *_next;
+    };
+    struct Destructor
+    {
+        void (*_destroy)(void *);
+        void *_object;
+        Destructor *_next;
+    };
+    void *allocateSlow(size_t size, size_t alignment);
+    void addDestructor(void *object, void (*destroy)(void *));
+    void releaseSlow();
+
+    const size_t _blockSize;
+    char *_firstBlock = nullptr;
+    size_t _firstBlockSize = 0;
+    // The blocks allocated after the first one, and their total size
+    Block *_extraBlocks = nullptr;
+    size_t _extraSize = 0;
+    Destructor *_destructors = nullptr;
+    char *_ptr = nullptr;
+    char *_end = nullptr;
+};
+
+/// A standard allocator allocating from an arena, e.g.
+/// std::vector<int, ArenaAllocator<int>> v(ArenaAllocator<int>(req->arena()));
+template <typename T>
+class ArenaAllocator
+{
+  public:
+    typedef T value_type;
+
+    explicit ArenaAllocator(Arena &arena) noexcept : _arena(&arena)
+    {
+    }
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &that) noexcept
+        : _arena(that.arena())
+    {
+    }
+
+    T *allocate(size_t n)
+    {
+        return static_cast<T *>(_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *, size_t) noexcept
+    {
+    }
+
+    Arena *arena() const noexcept
+    {
+        return _arena;
+    }
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &that) const noexcept
+    {
+        return _arena == that.arena();
+    }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &that) const noexcept
+    {
+        return _arena != that.arena();
+    }
+
+  private:
+    Arena *_arena;
+};
+
+}  // namespace drogon
@@ -0,0 +1,210 @@
+/**
+ *
+ *  ArgumentConverter.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#define DROGON_HAS_INTEGER_FROM_CHARS
+// Only defined when the floating point types are supported too
+#ifdef __cpp_lib_to_chars
+#define DROGON_HAS_FLOAT_FROM_CHARS
+#endif
+#endif
+#endif
+
+namespace drogon
+{
+namespace internal
+{
+template <typename T>
+struct IsCharType
+{
+    static const bool value = std::is_same<T, char>::value ||
+                              std::is_same<T, signed char>::value ||
+                              std::is_same<T, unsigned char>::value;
+};
+
+template <typename T>
+bool parseInteger(const std::string &str, T &value)
+{
+#ifdef DROGON_HAS_INTEGER_FROM_CHARS
+    const char *begin = str.data();
+    const char *end = begin + str.length();
+    // Accepted by std::stol() which was used before, but not by
+    // std::from_chars()
+    if (begin != end && *begin == '+')
+        ++begin;
+    return std::from_chars(begin, end, value).ec == std::errc();
+#else
+    const char *begin = str.c_str();
+    char *end;
+    errno = 0;
+    if (std::is_signed<T>::value)
+    {
+        auto result = std::strtoll(begin, &end, 10);
+        if (end == begin || errno == ERANGE ||
+            result < (long long)std::numeric_limits<T>::min() ||
+            result > (long long)std::numeric_limits<T>::max())
+            return false;
+        value = static_cast<T>(result);
+    }
+    else
+    {
+        // std::strtoull() negates negative numbers instead of failing
+        if (str.find('-') != std::string::npos)
+            return false;
+        auto result = std::strtoull(begin, &end, 10);
+        if (end == begin || errno == ERANGE ||
+            result > (unsigned long long)std::numeric_limits<T>::max())
+            return false;
+        value = static_cast<T>(result);
+    }
+    return true;
+#endif
+}
+
+#ifdef DROGON_HAS_FLOAT_FROM_CHARS
+template <typename T>
+bool parseFloatingPoint(const std::string &str, T &value)
+{
+    const char *begin = str.data();
+    const char *end = begin + str.length();
+    if (begin != end && *begin == '+')
+        ++begin;
+    return std::from_chars(begin, end, value).ec == std::errc();
+}
+#else
+inline void strToFloatingPoint(const char *str, char **end, float &value)
+{
+    value = std::strtof(str, end);
+}
+inline void strToFloatingPoint(const char *str, char **end, double &value)
+{
+    value = std::strtod(str, end);
+}
+inline void strToFloatingPoint(const char *str,
+                               char **end,
+                               long double &value)
+{
+    value = std::strtold(str, end);
+}
+template <typename T>
+bool parseFloatingPoint(const std::string &str, T &value)
+{
+    const char *begin = str.c_str();
+    char *end;
+    T result;
+    errno = 0;
+    strToFloatingPoint(begin, &end, result);
+    if (end == begin || errno == ERANGE)
+        return false;
+    value = result;
+    return true;
+}
+#endif
+}  // namespace internal
+
+/**
+ * @brief Convert a path or query parameter to an argument of a handler.
+ *
+ * The arithmetic types are parsed without constructing any stream or
+ * allocating memory, the other types are read from a std::istringstream
+ * with their operator>>. Specialize the template to convert the parameters
+ * to a user type in another way, e.g.
+ * @code
+   namespace drogon
+   {
+   template <>
+   struct ArgumentConverter<UserId>
+   {
+       // Return false if the parameter is not valid.
+       static bool convert(const std::string &str, UserId &value)
+       {
+           return value.parse(str);
+       }
+   };
+   }  // namespace drogon
+   @endcode
+ * The std::string and string_view arguments are not converted, a string_view
+ * argument refers to the parameter kept in the request.
+ */
+template <typename T, typename Enable = void>
+struct ArgumentConverter
+{
+    static bool convert(const std::string &str, T &value)
+    {
+        std::istringstream ss(str);
+        ss >> value;
+        return !ss.fail();
+    }
+};
+
+/// The character types are still read as characters rather than numbers.
+template <typename T>
+struct ArgumentConverter<
+    T,
+    typename std::enable_if<std::is_integral<T>::value &&
+                            !std::is_same<T, bool>::value &&
+                            !internal::IsCharType<T>::value>::type>
+{
+    static bool convert(const std::string &str, T &value)
+    {
+        return internal::parseInteger(str, value);
+    }
+};
+
+template <typename T>
+struct ArgumentConverter<
+    T,
+    typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+    static bool convert(const std::string &str, T &value)
+    {
+        return internal::parseFloatingPoint(str, value);
+    }
+};
+
+/// "true" and "false" are accepted besides the numbers.
+template <>
+struct ArgumentConverter<bool>
+{
+    static bool convert(const std::string &str, bool &value)
+    {
+        if (str == "true")
+        {
+            value = true;
+            return true;
+        }
+        if (str == "false")
+        {
+            value = false;
+            return true;
+        }
+        long long number;
+        if (!internal::parseInteger(str, number))
+            return false;
+        value = (number != 0);
+        return true;
+    }
+};
+
+}  // namespace drogon
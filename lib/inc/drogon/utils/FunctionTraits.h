@@ -15,6 +15,7 @@
 #pragma once
 
 #include <drogon/DrObject.h>
+#include <drogon/utils/coroutine.h>
 #include <functional>
 #include <memory>
 #include <tuple>
@@ -87,6 +88,19 @@ struct FunctionTraits<
     typedef void class_type;
 };
 
+#ifdef DROGON_HAS_COROUTINE
+// coroutine for HTTP handling
+template <typename... Arguments>
+struct FunctionTraits<Task<HttpResponsePtr> (*)(HttpRequestPtr req,
+                                                Arguments...)>
+    : FunctionTraits<Task<HttpResponsePtr> (*)(Arguments...)>
+{
+    static const bool isHTTPFunction = true;
+    static const bool isCoroutine = true;
+    typedef void class_type;
+};
+#endif
+
 // normal function
 template <typename ReturnType, typename... Arguments>
 struct FunctionTraits<ReturnType (*)(Arguments...)>
@@ -100,6 +114,7 @@ struct FunctionTraits<ReturnType (*)(Arguments...)>
     static const std::size_t arity = sizeof...(Arguments);
     typedef void class_type;
     static const bool isHTTPFunction = false;
+    static const bool isCoroutine = false;
     static const bool isClassFunction = false;
     static const bool isDrObjectClass = false;
     static const std::string name()
@@ -0,0 +1,292 @@
+/**
+ *
+ *  OStringStream.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/utils/string_view.h>
+#include <functional>
+#include <ios>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <stdio.h>
+
+namespace drogon
+{
+/// A string builder with the output operators of std::ostringstream
+/**
+ * It appends strings and numbers to a std::string directly, with the same
+ * format as a std::ostream with the default flags, so no locale-aware stream
+ * is constructed for them. The other types and the manipulators (e.g.
+ * std::hex, std::setw) are written to a std::ostringstream created the first
+ * time one is used, and while that stream has a format other than the
+ * default one, the strings and numbers are written to it as well. It is
+ * converted to the std::ostream & of that stream, so it can be passed to the
+ * functions writing to a std::ostream. The views generated by drogon_ctl
+ * write their text with it.
+ */
+class OStringStream
+{
+  public:
+    OStringStream()
+    {
+    }
+    explicit OStringStream(size_t reservedSize)
+    {
+        _buffer.reserve(reservedSize);
+    }
+
+    void reserve(size_t size)
+    {
+        _buffer.reserve(size);
+    }
+
+    /// Set the callback which takes the text written so far when flush() is
+    /// called, the text is cleared after it returns. A view is streamed to
+    /// the client in this way.
+    void setFlushCallback(
+        const std::function<void(const std::string &)> &flushCallback)
+    {
+        _flushCallback = flushCallback;
+    }
+    void flush()
+    {
+        sync();
+        if (_flushCallback && !_buffer.empty())
+        {
+            _flushCallback(_buffer);
+            _buffer.clear();
+        }
+    }
+
+    /// The stream the manipulators and the other types are written to
+    std::ostream &stream()
+    {
+        if (!_stream)
+            _stream = std::make_unique<std::ostringstream>();
+        _streamWritten = true;
+        return *_stream;
+    }
+    operator std::ostream &()
+    {
+        return stream();
+    }
+
+    OStringStream &write(const char *data, size_t length)
+    {
+        sync();
+        _buffer.append(data, length);
+        return *this;
+    }
+
+    OStringStream &operator<<(const char *str)
+    {
+        if (!str)
+            return *this;
+        if (!formatted())
+            _buffer.append(str);
+        else
+            stream() << str;
+        return *this;
+    }
+    OStringStream &operator<<(const std::string &str)
+    {
+        if (!formatted())
+            _buffer.append(str);
+        else
+            stream() << str;
+        return *this;
+    }
+    OStringStream &operator<<(const string_view &str)
+    {
+        if (!formatted())
+            _buffer.append(str.data(), str.length());
+        else
+            stream().write(str.data(), str.length());
+        return *this;
+    }
+    OStringStream &operator<<(char c)
+    {
+        if (!formatted())
+            _buffer.push_back(c);
+        else
+            stream() << c;
+        return *this;
+    }
+    OStringStream &operator<<(signed char c)
+    {
+        return *this << (char)c;
+    }
+    OStringStream &operator<<(unsigned char c)
+    {
+        return *this << (char)c;
+    }
+    OStringStream &operator<<(bool value)
+    {
+        if (!formatted())
+            _buffer.push_back(value ? '1' : '0');
+        else
+            stream() << value;
+        return *this;
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value &&
+                                std::is_signed<T>::value,
+                            OStringStream &>::type
+    operator<<(T value)
+    {
+        if (formatted())
+            stream() << value;
+        else if (value < 0)
+        {
+            _buffer.push_back('-');
+            appendUnsigned(0 - (unsigned long long)value);
+        }
+        else
+        {
+            appendUnsigned((unsigned long long)value);
+        }
+        return *this;
+    }
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value &&
+                                std::is_unsigned<T>::value,
+                            OStringStream &>::type
+    operator<<(T value)
+    {
+        if (formatted())
+            stream() << value;
+        else
+            appendUnsigned(value);
+        return *this;
+    }
+
+    OStringStream &operator<<(float value)
+    {
+        return *this << (double)value;
+    }
+    OStringStream &operator<<(double value)
+    {
+        if (formatted())
+        {
+            stream() << value;
+            return *this;
+        }
+        char buf[32];
+        auto len = snprintf(buf, sizeof(buf), "%g", value);
+        _buffer.append(buf, len);
+        return *this;
+    }
+    OStringStream &operator<<(long double value)
+    {
+        if (formatted())
+        {
+            stream() << value;
+            return *this;
+        }
+        char buf[64];
+        auto len = snprintf(buf, sizeof(buf), "%Lg", value);
+        _buffer.append(buf, len);
+        return *this;
+    }
+
+    /// Such as std::endl
+    OStringStream &operator<<(std::ostream &(*manipulator)(std::ostream &))
+    {
+        stream() << manipulator;
+        return *this;
+    }
+    /// Such as std::hex
+    OStringStream &operator<<(std::ios_base &(*manipulator)(std::ios_base &))
+    {
+        stream() << manipulator;
+        return *this;
+    }
+
+    template <typename T>
+    typename std::enable_if<!std::is_arithmetic<T>::value &&
+                                !std::is_convertible<const T &,
+                                                     string_view>::value,
+                            OStringStream &>::type
+    operator<<(const T &value)
+    {
+        stream() << value;
+        return *this;
+    }
+
+    size_t length() const
+    {
+        sync();
+        return _buffer.length();
+    }
+    std::string &str()
+    {
+        sync();
+        return _buffer;
+    }
+    const std::string &str() const
+    {
+        sync();
+        return _buffer;
+    }
+
+  private:
+    /// Return true if the stream has a format other than the default one, the
+    /// text written to the stream is moved to the buffer otherwise.
+    bool formatted()
+    {
+        if (!_stream)
+            return false;
+        if (_stream->flags() != (std::ios_base::skipws | std::ios_base::dec) ||
+            _stream->width() != 0 || _stream->precision() != 6 ||
+            _stream->fill() != ' ')
+            return true;
+        sync();
+        return false;
+    }
+    /// Move the text written to the stream to the buffer
+    void sync() const
+    {
+        if (_streamWritten)
+        {
+            _buffer.append(_stream->str());
+            _stream->str(std::string());
+            _streamWritten = false;
+        }
+    }
+
+    void appendUnsigned(unsigned long long value)
+    {
+        char buf[24];
+        char *end = buf + sizeof(buf);
+        char *p = end;
+        do
+        {
+            *--p = (char)('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        _buffer.append(p, end);
+    }
+
+    // The text of the stream is moved to the buffer when it's read
+    mutable std::string _buffer;
+    std::unique_ptr<std::ostringstream> _stream;
+    mutable bool _streamWritten = false;
+    std::function<void(const std::string &)> _flushCallback;
+};
+
+}  // namespace drogon
@@ -0,0 +1,338 @@
+/**
+ *
+ *  coroutine.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+// The coroutine interfaces are header only, they are available to the
+// applications compiled with C++20 even if drogon is compiled with C++17.
+#if __cplusplus >= 202002L && defined(__cpp_impl_coroutine)
+#if __has_include(<coroutine>)
+#define DROGON_HAS_COROUTINE 1
+#endif
+#endif
+
+#ifdef DROGON_HAS_COROUTINE
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/Logger.h>
+#include <assert.h>
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+namespace drogon
+{
+template <typename T = void>
+class Task;
+
+namespace internal
+{
+struct TaskFinalAwaiter
+{
+    bool await_ready() noexcept
+    {
+        return false;
+    }
+    // Resume the coroutine awaiting the task
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> handle) noexcept
+    {
+        auto continuation = handle.promise()._continuation;
+        if (continuation)
+            return continuation;
+        return std::noop_coroutine();
+    }
+    void await_resume() noexcept
+    {
+    }
+};
+
+struct TaskPromiseBase
+{
+    std::suspend_always initial_suspend() noexcept
+    {
+        return {};
+    }
+    TaskFinalAwaiter final_suspend() noexcept
+    {
+        return {};
+    }
+    void unhandled_exception()
+    {
+        _exception = std::current_exception();
+    }
+
+    std::coroutine_handle<> _continuation;
+    std::exception_ptr _exception;
+};
+
+template <typename T>
+struct TaskPromise : public TaskPromiseBase
+{
+    Task<T> get_return_object();
+    template <typename U>
+    void return_value(U &&value)
+    {
+        _value.emplace(std::forward<U>(value));
+    }
+    T result()
+    {
+        if (_exception)
+            std::rethrow_exception(_exception);
+        return std::move(*_value);
+    }
+
+    std::optional<T> _value;
+};
+
+template <>
+struct TaskPromise<void> : public TaskPromiseBase
+{
+    Task<void> get_return_object();
+    void return_void()
+    {
+    }
+    void result()
+    {
+        if (_exception)
+            std::rethrow_exception(_exception);
+    }
+};
+}  // namespace internal
+
+/// The result of a coroutine which returns a value of T when it's awaited
+/**
+ * The coroutine starts when the task is awaited, and the awaiting coroutine
+ * is resumed when it returns. An exception thrown by the coroutine is
+ * rethrown to the awaiting coroutine. A handler of a HttpController can be a
+ * coroutine returning Task<HttpResponsePtr>, for example:
+ * @code
+   Task<HttpResponsePtr> UserCtrl::getUser(HttpRequestPtr req, int userId)
+   {
+       auto result = co_await _dbClient->execSqlCoro(
+           "select * from users where id=$1", userId);
+       auto resp = HttpResponse::newHttpResponse();
+       ...
+       co_return resp;
+   }
+   @endcode
+ * The request must be taken by value since the coroutine may run after the
+ * caller returns. A moved-from task must not be awaited.
+ */
+template <typename T>
+class Task
+{
+  public:
+    typedef internal::TaskPromise<T> promise_type;
+
+    explicit Task(std::coroutine_handle<promise_type> handle)
+        : _handle(handle)
+    {
+    }
+    Task(Task &&that) noexcept : _handle(std::exchange(that._handle, nullptr))
+    {
+    }
+    Task &operator=(Task &&that) noexcept
+    {
+        if (this != &that)
+        {
+            if (_handle)
+                _handle.destroy();
+            _handle = std::exchange(that._handle, nullptr);
+        }
+        return *this;
+    }
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+    ~Task()
+    {
+        if (_handle)
+            _handle.destroy();
+    }
+
+    bool await_ready() const noexcept
+    {
+        assert(_handle);
+        return _handle.done();
+    }
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<> continuation) noexcept
+    {
+        _handle.promise()._continuation = continuation;
+        return _handle;
+    }
+    T await_resume()
+    {
+        assert(_handle);
+        return _handle.promise().result();
+    }
+
+  private:
+    std::coroutine_handle<promise_type> _handle;
+};
+
+template <typename T>
+inline Task<T> internal::TaskPromise<T>::get_return_object()
+{
+    return Task<T>(
+        std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> internal::TaskPromise<void>::get_return_object()
+{
+    return Task<void>(
+        std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+/// The result of a coroutine which runs by itself
+/**
+ * The coroutine starts immediately and nothing waits for it, an exception
+ * thrown by it is logged. Use it to start coroutines in callbacks, see
+ * async_run().
+ */
+struct AsyncTask
+{
+    struct promise_type
+    {
+        AsyncTask get_return_object() noexcept
+        {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_void() noexcept
+        {
+        }
+        void unhandled_exception()
+        {
+            try
+            {
+                std::rethrow_exception(std::current_exception());
+            }
+            catch (const std::exception &e)
+            {
+                LOG_ERROR << "Unhandled exception in a coroutine: "
+                          << e.what();
+            }
+            catch (...)
+            {
+                LOG_ERROR << "Unhandled exception in a coroutine";
+            }
+        }
+    };
+};
+
+/// Run a callable which returns a Task, e.g. a lambda coroutine.
+/**
+ * The callable is kept until the task returns, so a lambda may capture
+ * variables safely.
+ */
+template <typename Coro>
+AsyncTask async_run(Coro coro)
+{
+    co_await coro();
+}
+
+/// The base class of the awaiters which wait for a callback
+/**
+ * The subclass starts an asynchronous operation in its await_suspend()
+ * method and returns suspend(), its callbacks call setValue() or
+ * setException() to resume the coroutine. If the coroutine is suspended in an
+ * event loop, it's resumed in the same loop, so it never moves to the thread
+ * which calls the callbacks. A callback called before suspend() doesn't
+ * resume the coroutine, suspend() returns false instead and the coroutine
+ * goes on without being suspended, so operations completing synchronously
+ * don't nest resumptions on the stack. The callbacks only capture the pointer
+ * to the awaiter, which is kept in the frame of the coroutine until it's
+ * resumed.
+ */
+template <typename T>
+class CallbackAwaiter
+{
+  public:
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+    T await_resume()
+    {
+        if (_exception)
+            std::rethrow_exception(_exception);
+        return std::move(*_value);
+    }
+
+  protected:
+    /// Called at the beginning of await_suspend() of the subclass.
+    void setHandle(std::coroutine_handle<> handle)
+    {
+        _handle = handle;
+        _loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    }
+    /// Returned by await_suspend() of the subclass after the operation is
+    /// started, false if the operation has completed.
+    bool suspend()
+    {
+        return !_completedOrSuspended.exchange(true, std::memory_order_acq_rel);
+    }
+    /// The awaiter may have been destroyed after the two methods are called.
+    template <typename U>
+    void setValue(U &&value)
+    {
+        _value.emplace(std::forward<U>(value));
+        resume();
+    }
+    void setException(const std::exception_ptr &exception)
+    {
+        _exception = exception;
+        resume();
+    }
+
+  private:
+    void resume()
+    {
+        // The operation has completed before suspend(), it doesn't suspend
+        // the coroutine
+        if (!_completedOrSuspended.exchange(true, std::memory_order_acq_rel))
+            return;
+        if (_loop && !_loop->isInLoopThread())
+        {
+            auto handle = _handle;
+            _loop->queueInLoop([handle]() { handle.resume(); });
+        }
+        else
+        {
+            _handle.resume();
+        }
+    }
+
+    std::coroutine_handle<> _handle;
+    trantor::EventLoop *_loop = nullptr;
+    std::optional<T> _value;
+    std::exception_ptr _exception;
+    // Set by the first of suspend() and the callback
+    std::atomic<bool> _completedOrSuspended{false};
+};
+
+}  // namespace drogon
+
+#endif
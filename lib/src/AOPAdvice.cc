@@ -18,76 +18,31 @@
 
 namespace drogon
 {
-void doAdvicesChain(
-    const std::vector<std::function<void(const HttpRequestPtr &,
-                                         AdviceCallback &&,
-                                         AdviceChainCallback &&)>> &advices,
-    size_t index,
-    const HttpRequestImplPtr &req,
-    const std::shared_ptr<const std::function<void(const HttpResponsePtr &)>>
-        &callbackPtr,
-    std::function<void()> &&missCallback)
+typedef std::function<void(const HttpRequestPtr &,
+                           AdviceCallback &&,
+                           AdviceChainCallback &&)>
+    Advice;
+
+static bool runAdvice(ChainState *state, size_t index)
 {
-    if (index < advices.size())
-    {
-        auto &advice = advices[index];
-        advice(
-            req,
-            [callbackPtr](const HttpResponsePtr &resp) {
-                (*callbackPtr)(resp);
-            },
-            [index,
-             req,
-             callbackPtr,
-             &advices,
-             missCallback = std::move(missCallback)]() mutable {
-                doAdvicesChain(advices,
-                               index + 1,
-                               req,
-                               callbackPtr,
-                               std::move(missCallback));
-            });
-    }
-    else
-    {
-        missCallback();
-    }
+    auto &advice = static_cast<const Advice *>(state->steps())[index];
+    advice(state->request(), state->respondCallback(), state->nextCallback());
+    return false;
 }
 
-void doAdvicesChain(
-    const std::deque<std::function<void(const HttpRequestPtr &,
-                                        AdviceCallback &&,
-                                        AdviceChainCallback &&)>> &advices,
-    size_t index,
-    const HttpRequestImplPtr &req,
-    const std::shared_ptr<const std::function<void(const HttpResponsePtr &)>>
-        &callbackPtr,
-    std::function<void()> &&missCallback)
+void doAdvicesChain(const std::vector<Advice> &advices,
+                    const HttpRequestImplPtr &req,
+                    std::function<void(const HttpResponsePtr &)> &&callback,
+                    ChainPassCallback &&passCallback,
+                    bool callCallback)
 {
-    if (index < advices.size())
-    {
-        auto &advice = advices[index];
-        advice(
-            req,
-            [callbackPtr](const HttpResponsePtr &resp) {
-                (*callbackPtr)(resp);
-            },
-            [index,
-             req,
-             callbackPtr,
-             &advices,
-             missCallback = std::move(missCallback)]() mutable {
-                doAdvicesChain(advices,
-                               index + 1,
-                               req,
-                               callbackPtr,
-                               std::move(missCallback));
-            });
-    }
-    else
-    {
-        missCallback();
-    }
+    ChainState::run(advices.data(),
+                    advices.size(),
+                    runAdvice,
+                    req,
+                    std::move(callback),
+                    std::move(passCallback),
+                    callCallback);
 }
 
 }  // namespace drogon
\ No newline at end of file
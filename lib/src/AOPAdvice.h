@@ -14,30 +14,26 @@
 
 #pragma once
 #include "impl_forwards.h"
+#include "ChainState.h"
 #include <drogon/drogon_callbacks.h>
-#include <deque>
 #include <functional>
 #include <vector>
 #include <memory>
 
 namespace drogon
 {
+/// Run the advices for the request, passCallback is called with the callback
+/// if the request passes all of them.
+/**
+ * @param callCallback If true, the responses of the advices are sent by
+ * HttpAppFrameworkImpl::callCallback(), otherwise by the callback directly.
+ */
 void doAdvicesChain(
     const std::vector<std::function<void(const HttpRequestPtr &,
                                          AdviceCallback &&,
                                          AdviceChainCallback &&)>> &advices,
-    size_t index,
-    const HttpRequestImplPtr &req,
-    const std::shared_ptr<const std::function<void(const HttpResponsePtr &)>>
-        &callbackPtr,
-    std::function<void()> &&missCallback);
-void doAdvicesChain(
-    const std::deque<std::function<void(const HttpRequestPtr &,
-                                        AdviceCallback &&,
-                                        AdviceChainCallback &&)>> &advices,
-    size_t index,
     const HttpRequestImplPtr &req,
-    const std::shared_ptr<const std::function<void(const HttpResponsePtr &)>>
-        &callbackPtr,
-    std::function<void()> &&missCallback);
+    std::function<void(const HttpResponsePtr &)> &&callback,
+    ChainPassCallback &&passCallback,
+    bool callCallback);
 }  // namespace drogon
@@ -0,0 +1,104 @@
+/**
+ *
+ *  Arena.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/utils/Arena.h>
+#include <algorithm>
+#include <stdlib.h>
+
+using namespace drogon;
+
+namespace
+{
+// The limit of the size to which the first block is enlarged
+const size_t kMaxFirstBlockSize = 64 * 1024;
+}  // namespace
+
+Arena::~Arena()
+{
+    releaseSlow();
+    free(_firstBlock);
+}
+
+void *Arena::allocateSlow(size_t size, size_t alignment)
+{
+    if (!_firstBlock)
+    {
+        auto blockSize =
+            std::max(std::max(_firstBlockSize, _blockSize), size + alignment);
+        _firstBlock = static_cast<char *>(malloc(blockSize));
+        if (!_firstBlock)
+            throw std::bad_alloc();
+        _firstBlockSize = blockSize;
+        _ptr = _firstBlock;
+        _end = _firstBlock + blockSize;
+        return allocate(size, alignment);
+    }
+    auto blockSize = std::max(_blockSize, sizeof(Block) + size + alignment);
+    auto block = static_cast<Block *>(malloc(blockSize));
+    if (!block)
+        throw std::bad_alloc();
+    block->_next = _extraBlocks;
+    _extraBlocks = block;
+    _extraSize += blockSize;
+    auto data = reinterpret_cast<size_t>(block + 1);
+    if (size > _blockSize / 2)
+    {
+        // A large piece takes a block by itself, the rest of the current
+        // block is still used.
+        return reinterpret_cast<void *>((data + alignment - 1) &
+                                        ~(alignment - 1));
+    }
+    _ptr = reinterpret_cast<char *>(data);
+    _end = reinterpret_cast<char *>(block) + blockSize;
+    return allocate(size, alignment);
+}
+
+void Arena::addDestructor(void *object, void (*destroy)(void *))
+{
+    auto destructor = static_cast<Destructor *>(
+        allocate(sizeof(Destructor), alignof(Destructor)));
+    destructor->_destroy = destroy;
+    destructor->_object = object;
+    destructor->_next = _destructors;
+    _destructors = destructor;
+}
+
+void Arena::releaseSlow()
+{
+    // The objects are destroyed in the reverse order of their creation
+    while (_destructors)
+    {
+        auto destructor = _destructors;
+        _destructors = destructor->_next;
+        destructor->_destroy(destructor->_object);
+    }
+    if (!_extraBlocks)
+        return;
+    auto totalSize = _firstBlockSize + _extraSize;
+    while (_extraBlocks)
+    {
+        auto block = _extraBlocks;
+        _extraBlocks = block->_next;
+        free(block);
+    }
+    _extraSize = 0;
+    if (_firstBlockSize < kMaxFirstBlockSize)
+    {
+        // A larger first block is allocated by the next allocation, so a
+        // similar request fits in it.
+        free(_firstBlock);
+        _firstBlock = nullptr;
+        _firstBlockSize = std::min(totalSize, kMaxFirstBlockSize);
+    }
+}
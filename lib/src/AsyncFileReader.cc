@@ -0,0 +1,260 @@
+/**
+ *
+ *  AsyncFileReader.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "AsyncFileReader.h"
+#include <trantor/utils/ConcurrentTaskQueue.h>
+#include <trantor/utils/Logger.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef USE_IO_URING
+#include <sys/eventfd.h>
+#endif
+
+using namespace drogon;
+
+namespace
+{
+// Read the rest of the file from the offset, return 0 or an errno value.
+int preadAll(int fd, std::string &content, size_t offset)
+{
+    while (offset < content.length())
+    {
+        auto n = pread(fd,
+                       &content[offset],
+                       content.length() - offset,
+                       static_cast<off_t>(offset));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return errno;
+        }
+        if (n == 0)
+        {
+            // The file is truncated after its size is got
+            content.resize(offset);
+            break;
+        }
+        offset += static_cast<size_t>(n);
+    }
+    return 0;
+}
+
+// The threads reading files without io_uring, they are shared by all the
+// readers and never freed as the readers.
+trantor::ConcurrentTaskQueue &readerPool()
+{
+    static auto pool = new trantor::ConcurrentTaskQueue(4, "AsyncFileReader");
+    return *pool;
+}
+
+#ifdef USE_IO_URING
+const unsigned kQueueDepth = 64;
+#endif
+}  // namespace
+
+AsyncFileReader *AsyncFileReader::instance()
+{
+    // The readers are never freed because they may be used until the loops
+    // quit.
+    thread_local AsyncFileReader *reader = nullptr;
+    if (!reader)
+    {
+        auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+        if (!loop)
+            return nullptr;
+        reader = new AsyncFileReader(loop);
+    }
+    return reader;
+}
+
+AsyncFileReader::AsyncFileReader(trantor::EventLoop *loop) : _loop(loop)
+{
+#ifdef USE_IO_URING
+    auto ret = io_uring_queue_init(kQueueDepth, &_ring, 0);
+    if (ret < 0)
+    {
+        LOG_WARN << "io_uring is not available (errno=" << -ret
+                 << "), static files are read by a thread pool";
+        return;
+    }
+    _eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_eventFd < 0 || io_uring_register_eventfd(&_ring, _eventFd) < 0)
+    {
+        LOG_SYSERR << "Failed to register the eventfd of io_uring";
+        if (_eventFd >= 0)
+            close(_eventFd);
+        io_uring_queue_exit(&_ring);
+        return;
+    }
+    _channelPtr =
+        std::unique_ptr<trantor::Channel>(new trantor::Channel(loop, _eventFd));
+    _channelPtr->setReadCallback([this]() { handleCompletions(); });
+    _channelPtr->enableReading();
+    _ringReady = true;
+#endif
+}
+
+void AsyncFileReader::readInPool(const std::string &path,
+                                 size_t size,
+                                 ReadCallback &&callback)
+{
+    readerPool().runTaskInQueue(
+        [this, path, size, callback = std::move(callback)]() mutable {
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                callInLoop(std::move(callback), errno, std::string());
+                return;
+            }
+            std::string content(size, '\0');
+            auto error = preadAll(fd, content, 0);
+            close(fd);
+            if (error)
+                content.clear();
+            callInLoop(std::move(callback), error, std::move(content));
+        });
+}
+
+void AsyncFileReader::callInLoop(ReadCallback &&callback,
+                                 int error,
+                                 std::string &&content)
+{
+    _loop->queueInLoop([callback = std::move(callback),
+                        error,
+                        content = std::move(content)]() mutable {
+        callback(error, std::move(content));
+    });
+}
+
+void AsyncFileReader::read(const std::string &path,
+                           size_t size,
+                           ReadCallback &&callback)
+{
+    _loop->assertInLoopThread();
+#ifdef USE_IO_URING
+    if (_ringReady && size > 0)
+    {
+        // Opening a file doesn't block as reading it does, the cost of an
+        // extra round trip to the kernel for IORING_OP_OPENAT isn't worth it.
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            callInLoop(std::move(callback), errno, std::string());
+            return;
+        }
+        queueRead(new Request{
+            fd, std::string(size, '\0'), 0, std::move(callback)});
+        return;
+    }
+#endif
+    readInPool(path, size, std::move(callback));
+}
+
+#ifdef USE_IO_URING
+void AsyncFileReader::queueRead(Request *request)
+{
+    auto sqe = io_uring_get_sqe(&_ring);
+    if (!sqe)
+    {
+        // The submission queue is full, submit it now.
+        submit();
+        sqe = io_uring_get_sqe(&_ring);
+    }
+    if (!sqe)
+    {
+        // Read the rest in the thread pool
+        readerPool().runTaskInQueue([this, request]() {
+            auto error =
+                preadAll(request->_fd, request->_content, request->_offset);
+            close(request->_fd);
+            if (error)
+                request->_content.clear();
+            callInLoop(std::move(request->_callback),
+                       error,
+                       std::move(request->_content));
+            delete request;
+        });
+        return;
+    }
+    io_uring_prep_read(sqe,
+                       request->_fd,
+                       &request->_content[request->_offset],
+                       request->_content.length() - request->_offset,
+                       request->_offset);
+    io_uring_sqe_set_data(sqe, request);
+    if (!_submitQueued)
+    {
+        // All the reads queued while the loop handles the current events are
+        // submitted by one system call.
+        _submitQueued = true;
+        _loop->queueInLoop([this]() {
+            _submitQueued = false;
+            submit();
+        });
+    }
+}
+
+void AsyncFileReader::submit()
+{
+    auto ret = io_uring_submit(&_ring);
+    if (ret < 0)
+    {
+        LOG_ERROR << "io_uring_submit failed (errno=" << -ret << ")";
+    }
+}
+
+void AsyncFileReader::handleCompletions()
+{
+    uint64_t count;
+    if (::read(_eventFd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+    {
+        LOG_SYSERR << "Failed to read the eventfd of io_uring";
+    }
+    struct io_uring_cqe *cqe;
+    while (io_uring_peek_cqe(&_ring, &cqe) == 0)
+    {
+        auto request = static_cast<Request *>(io_uring_cqe_get_data(cqe));
+        auto res = cqe->res;
+        io_uring_cqe_seen(&_ring, cqe);
+        if (res == -EAGAIN || res == -EINTR)
+        {
+            queueRead(request);
+            continue;
+        }
+        if (res > 0)
+        {
+            request->_offset += static_cast<size_t>(res);
+            if (request->_offset < request->_content.length())
+            {
+                // A short read, read the rest.
+                queueRead(request);
+                continue;
+            }
+        }
+        else if (res == 0)
+        {
+            // The file is truncated after its size is got
+            request->_content.resize(request->_offset);
+        }
+        close(request->_fd);
+        int error = res < 0 ? -res : 0;
+        if (error)
+            request->_content.clear();
+        request->_callback(error, std::move(request->_content));
+        delete request;
+    }
+}
+#endif
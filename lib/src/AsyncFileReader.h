@@ -0,0 +1,87 @@
+/**
+ *
+ *  AsyncFileReader.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/NonCopyable.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef USE_IO_URING
+#include <liburing.h>
+#include <trantor/net/inner/Channel.h>
+#endif
+
+namespace drogon
+{
+/// Read whole files without blocking the event loop
+/**
+ * If drogon is built with io_uring (the USE_IO_URING option), the reads are
+ * queued to the io_uring of the loop and submitted together after the loop
+ * handles the current events, the completions are signalled by an eventfd
+ * watched by the loop. Otherwise, or if the kernel doesn't support io_uring,
+ * the file is read by a pool of threads shared by all the loops.
+ *
+ * The callbacks are always called in the thread of the loop after read()
+ * returns.
+ */
+class AsyncFileReader : public trantor::NonCopyable
+{
+  public:
+    /// The error code is 0 or an errno value, e.g. ENOENT.
+    typedef std::function<void(int error, std::string &&content)>
+        ReadCallback;
+
+    /// Get the reader of the loop running in the current thread, return
+    /// nullptr if the thread doesn't run a loop.
+    static AsyncFileReader *instance();
+
+    /// Read the file whose size is already known, e.g. by stat().
+    void read(const std::string &path, size_t size, ReadCallback &&callback);
+
+  private:
+    explicit AsyncFileReader(trantor::EventLoop *loop);
+    /// Read the file in the thread pool, the callback is queued to the loop.
+    void readInPool(const std::string &path,
+                    size_t size,
+                    ReadCallback &&callback);
+    void callInLoop(ReadCallback &&callback,
+                    int error,
+                    std::string &&content);
+
+    trantor::EventLoop *_loop;
+#ifdef USE_IO_URING
+    struct Request
+    {
+        int _fd;
+        std::string _content;
+        size_t _offset;
+        ReadCallback _callback;
+    };
+    void queueRead(Request *request);
+    void submit();
+    void handleCompletions();
+
+    struct io_uring _ring;
+    bool _ringReady = false;
+    bool _submitQueued = false;
+    int _eventFd = -1;
+    std::unique_ptr<trantor::Channel> _channelPtr;
+#endif
+};
+
+}  // namespace drogon
@@ -14,15 +14,63 @@
 
 #include "CacheFile.h"
 #include <trantor/utils/Logger.h>
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <stdio.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 
 using namespace drogon;
 
-CacheFile::CacheFile(const std::string &path, bool autoDelete)
-    : _autoDelete(autoDelete), _path(path)
+// The size of the blocks written to the file
+static const size_t kBlockSize = 64 * 1024;
+
+static bool writeAll(int fd, const char *data, size_t length)
 {
-    _file = fopen(_path.data(), "w+");
+    while (length > 0)
+    {
+        auto n = write(fd, data, length);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            LOG_SYSERR << "write:";
+            return false;
+        }
+        data += n;
+        length -= n;
+    }
+    return true;
+}
+
+CacheFile::CacheFile(const std::string &path, size_t expectedSize)
+{
+#ifdef O_TMPFILE
+    std::string dir = path;
+    _fd = open(dirname(&dir[0]), O_TMPFILE | O_RDWR | O_CLOEXEC, 0666);
+#endif
+    if (_fd < 0)
+    {
+        // The file system doesn't support O_TMPFILE
+        _fd = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR | O_CLOEXEC, 0666);
+        if (_fd < 0)
+        {
+            LOG_SYSERR << "Can't create the file " << path;
+            return;
+        }
+        _path = path;
+    }
+#ifdef __linux__
+    // It fails on the file systems which don't support it, and that's fine.
+    if (expectedSize > 0)
+        fallocate(_fd, FALLOC_FL_KEEP_SIZE, 0, expectedSize);
+#else
+    (void)expectedSize;
+#endif
+    _buffer.reserve(kBlockSize);
 }
 
 CacheFile::~CacheFile()
@@ -31,41 +79,70 @@ CacheFile::~CacheFile()
     {
         munmap(_data, _dataLength);
     }
-    if (_autoDelete && _file)
+    if (_fd >= 0)
+    {
+        close(_fd);
+        if (!_path.empty())
+            unlink(_path.c_str());
+    }
+}
+
+bool CacheFile::append(const char *data, size_t length)
+{
+    if (_fd < 0)
+        return false;
+    _length += length;
+    if (_buffer.length() + length < kBlockSize)
     {
-        fclose(_file);
-        unlink(_path.data());
+        _buffer.append(data, length);
+        return true;
     }
-    else if (_file)
+    // Fill the buffer up to a block and write it, then write the whole blocks
+    // in the data directly, so every write starts at an aligned offset.
+    auto len = kBlockSize - _buffer.length();
+    _buffer.append(data, len);
+    data += len;
+    length -= len;
+    bool ok = writeAll(_fd, _buffer.data(), _buffer.length());
+    _buffer.clear();
+    len = length - length % kBlockSize;
+    if (ok && len > 0)
     {
-        fclose(_file);
+        ok = writeAll(_fd, data, len);
+        data += len;
+        length -= len;
     }
+    _buffer.append(data, length);
+    return ok;
 }
 
-void CacheFile::append(const char *data, size_t length)
+bool CacheFile::flush()
 {
-    if (_file)
-        fwrite(data, length, 1, _file);
+    if (_fd < 0)
+        return false;
+    if (!_buffer.empty())
+    {
+        auto ret = writeAll(_fd, _buffer.data(), _buffer.length());
+        _buffer.clear();
+        return ret;
+    }
+    return true;
 }
 
-size_t CacheFile::length()
+int CacheFile::fd()
 {
-    if (_file)
-        return ftell(_file);
-    return 0;
+    if (!flush())
+        return -1;
+    return _fd;
 }
 
 char *CacheFile::data()
 {
-    if (!_file)
-        return nullptr;
-    if (!_data)
+    if (!_data && _length > 0 && flush())
     {
-        fflush(_file);
-        auto fd = fileno(_file);
-        _dataLength = length();
+        _dataLength = _length;
         _data = static_cast<char *>(
-            mmap(nullptr, _dataLength, PROT_READ, MAP_SHARED, fd, 0));
+            mmap(nullptr, _dataLength, PROT_READ, MAP_SHARED, _fd, 0));
         if (_data == MAP_FAILED)
         {
             _data = nullptr;
@@ -73,4 +150,72 @@ char *CacheFile::data()
         }
     }
     return _data;
-}
\ No newline at end of file
+}
+
+int CacheFile::linkTo(const std::string &path)
+{
+    if (!flush())
+        return -1;
+    // The file gets a temporary name in the directory of the path first, so
+    // a file already at the path is only replaced on success.
+    static std::atomic<size_t> tmpId{0};
+    auto tmpPath = path + "." + std::to_string(getpid()) + "." +
+                   std::to_string(++tmpId) + ".tmp";
+    if (!linkOrCopyTo(tmpPath))
+    {
+        unlink(tmpPath.c_str());
+        return -1;
+    }
+    if (rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        LOG_SYSERR << "Can't rename the file to " << path;
+        unlink(tmpPath.c_str());
+        return -1;
+    }
+    return 0;
+}
+
+bool CacheFile::linkOrCopyTo(const std::string &path)
+{
+    if (_path.empty())
+    {
+#ifdef O_TMPFILE
+        auto procPath = "/proc/self/fd/" + std::to_string(_fd);
+        if (linkat(AT_FDCWD,
+                   procPath.c_str(),
+                   AT_FDCWD,
+                   path.c_str(),
+                   AT_SYMLINK_FOLLOW) == 0)
+            return true;
+#endif
+    }
+    else if (link(_path.c_str(), path.c_str()) == 0)
+    {
+        return true;
+    }
+    // Copy the file to another file system
+    int fd = open(path.c_str(), O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, 0666);
+    if (fd < 0)
+    {
+        LOG_SYSERR << "Can't create the file " << path;
+        return false;
+    }
+    char buf[kBlockSize];
+    off_t offset = 0;
+    while ((size_t)offset < _length)
+    {
+        auto n = pread(_fd, buf, sizeof(buf), offset);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        offset += n;
+        if (!writeAll(fd, buf, n))
+        {
+            close(fd);
+            return false;
+        }
+    }
+    close(fd);
+    return (size_t)offset == _length;
+}
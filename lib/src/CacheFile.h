@@ -17,20 +17,31 @@
 #include <drogon/utils/string_view.h>
 #include <trantor/utils/NonCopyable.h>
 #include <string>
-#include <stdio.h>
 
 namespace drogon
 {
+/// A temporary file storing a request body which is too large for memory
+/**
+ * The file is created without a name (O_TMPFILE) in the directory of the
+ * path if the system supports it, so it disappears with the process in any
+ * case. Otherwise it's created with the path and removed by the destructor.
+ * The data are written in large blocks at aligned offsets.
+ */
 class CacheFile : public trantor::NonCopyable
 {
   public:
-    explicit CacheFile(const std::string &path, bool autoDelete = true);
+    /**
+     * @param expectedSize The disk space is allocated in advance if it's
+     * not 0, e.g. by the Content-Length of the request.
+     */
+    explicit CacheFile(const std::string &path, size_t expectedSize = 0);
     ~CacheFile();
-    void append(const std::string &data)
+    /// Return false if the data can't be written
+    bool append(const std::string &data)
     {
-        append(data.data(), data.length());
+        return append(data.data(), data.length());
     }
-    void append(const char *data, size_t length);
+    bool append(const char *data, size_t length);
     string_view getStringView()
     {
         if (data())
@@ -38,12 +49,28 @@ class CacheFile : public trantor::NonCopyable
         return string_view();
     }
 
+    /// Return the descriptor of the file after all data are written to it,
+    /// or -1 if the file can't be created.
+    int fd();
+
+    /// Give the file the path, return 0 on success.
+    /**
+     * The file is linked to the path instead of being copied unless they are
+     * in different file systems. It replaces a file at the path atomically,
+     * which is kept if the file can't be linked or copied.
+     */
+    int linkTo(const std::string &path);
+
   private:
+    bool linkOrCopyTo(const std::string &path);
     char *data();
-    size_t length();
-    FILE *_file = nullptr;
-    bool _autoDelete = true;
-    const std::string _path;
+    bool flush();
+    int _fd = -1;
+    // Empty if the file has no name
+    std::string _path;
+    std::string _buffer;
+    // The number of bytes in the file and the buffer
+    size_t _length = 0;
     char *_data = nullptr;
     size_t _dataLength = 0;
 };
@@ -0,0 +1,145 @@
+/**
+ *
+ *  ChainState.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "ChainState.h"
+#include "HttpAppFrameworkImpl.h"
+#include "HttpRequestImpl.h"
+#include <trantor/utils/Logger.h>
+#include <vector>
+
+using namespace drogon;
+
+namespace
+{
+// The states live as long as their thread because a callback of a finished
+// chain may be called later, it only finds a different generation in the
+// state.
+struct StatePool
+{
+    std::vector<ChainState *> _states;
+    ~StatePool()
+    {
+        for (auto state : _states)
+            delete state;
+    }
+};
+thread_local StatePool statePool;
+}  // namespace
+
+void ChainState::run(const void *steps,
+                     size_t size,
+                     StepRunner stepRunner,
+                     const HttpRequestImplPtr &req,
+                     std::function<void(const HttpResponsePtr &)> &&callback,
+                     ChainPassCallback &&passCallback,
+                     bool callCallback)
+{
+    if (size == 0)
+    {
+        passCallback(std::move(callback));
+        return;
+    }
+    ChainState *state;
+    if (statePool._states.empty())
+    {
+        state = new ChainState;
+        state->_loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    }
+    else
+    {
+        state = statePool._states.back();
+        statePool._states.pop_back();
+    }
+    state->_steps = steps;
+    state->_size = size;
+    state->_index = 0;
+    state->_stepRunner = stepRunner;
+    state->_req = req;
+    state->_callback = std::move(callback);
+    state->_passCallback = std::move(passCallback);
+    state->_callCallback = callCallback;
+    state->runSteps();
+}
+
+size_t ChainState::poolSize()
+{
+    return statePool._states.size();
+}
+
+void ChainState::runSteps()
+{
+    while (_index < _size)
+    {
+        ++_generation;
+        if (!_stepRunner(this, _index))
+            return;
+        ++_index;
+    }
+    auto callback = std::move(_callback);
+    auto passCallback = std::move(_passCallback);
+    release();
+    passCallback(std::move(callback));
+}
+
+void ChainState::respond(const HttpResponsePtr &resp)
+{
+    auto req = std::move(_req);
+    auto callback = std::move(_callback);
+    auto callCallback = _callCallback;
+    release();
+    if (callCallback)
+        HttpAppFrameworkImpl::instance().callCallback(req, resp, callback);
+    else
+        callback(resp);
+}
+
+void ChainState::release()
+{
+    // A callback of the last step is stale from now on
+    ++_generation;
+    _req.reset();
+    _callback = nullptr;
+    _passCallback.reset();
+    if (!_loop || _loop->isInLoopThread())
+    {
+        statePool._states.push_back(this);
+        return;
+    }
+    // The chain finished in another thread, e.g. a filter called its
+    // callback there.
+    auto state = this;
+    _loop->queueInLoop([state]() { statePool._states.push_back(state); });
+}
+
+bool ChainState::claim(uint64_t generation)
+{
+    if (_generation.compare_exchange_strong(generation, generation + 1))
+        return true;
+    LOG_ERROR << "The callback of a filter or an advice is called twice";
+    return false;
+}
+
+void ChainState::RespondCallback::operator()(const HttpResponsePtr &resp) const
+{
+    if (_state->claim(_generation))
+        _state->respond(resp);
+}
+
+void ChainState::NextCallback::operator()() const
+{
+    if (!_state->claim(_generation))
+        return;
+    ++_state->_index;
+    _state->runSteps();
+}
@@ -0,0 +1,113 @@
+/**
+ *
+ *  ChainState.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "impl_forwards.h"
+#include "SmallFunction.h"
+#include <trantor/net/EventLoop.h>
+#include <atomic>
+#include <functional>
+#include <stdint.h>
+
+namespace drogon
+{
+/// Called with the response callback when a request passes all the filters
+/// or advices of a chain
+typedef SmallFunction<void(std::function<void(const HttpResponsePtr &)> &&)>
+    ChainPassCallback;
+
+/// The state of a filter or advice chain running for a request
+/**
+ * The states are pooled in every thread and freed when the thread exits. A
+ * state is returned to the pool of the event loop which created it, even if
+ * the chain finishes in another thread. The callbacks given to the filters
+ * and advices only hold a pointer to the state and the generation of the
+ * step, so std::function stores them without allocation. The first callback
+ * of a step claims it by advancing the generation, the others and the
+ * callbacks of finished steps are ignored.
+ */
+class ChainState
+{
+  public:
+    /// Run a step of the chain, return true if the request passes it
+    /// immediately, otherwise the step calls the callbacks.
+    typedef bool (*StepRunner)(ChainState *state, size_t index);
+
+    static void run(const void *steps,
+                    size_t size,
+                    StepRunner stepRunner,
+                    const HttpRequestImplPtr &req,
+                    std::function<void(const HttpResponsePtr &)> &&callback,
+                    ChainPassCallback &&passCallback,
+                    bool callCallback);
+
+    /// The number of the pooled states of the current thread
+    static size_t poolSize();
+
+    const void *steps() const
+    {
+        return _steps;
+    }
+    const HttpRequestImplPtr &request() const
+    {
+        return _req;
+    }
+
+    /// Send the response and finish the chain.
+    void respond(const HttpResponsePtr &resp);
+
+    struct RespondCallback
+    {
+        ChainState *_state;
+        uint64_t _generation;
+        void operator()(const HttpResponsePtr &resp) const;
+    };
+    struct NextCallback
+    {
+        ChainState *_state;
+        uint64_t _generation;
+        void operator()() const;
+    };
+    /// The callbacks of the current step
+    RespondCallback respondCallback()
+    {
+        return RespondCallback{this, _generation.load()};
+    }
+    NextCallback nextCallback()
+    {
+        return NextCallback{this, _generation.load()};
+    }
+
+  private:
+    void runSteps();
+    void release();
+    bool claim(uint64_t generation);
+
+    const void *_steps = nullptr;
+    size_t _size = 0;
+    size_t _index = 0;
+    StepRunner _stepRunner = nullptr;
+    HttpRequestImplPtr _req;
+    std::function<void(const HttpResponsePtr &)> _callback;
+    ChainPassCallback _passCallback;
+    // Send the response by HttpAppFrameworkImpl::callCallback()
+    bool _callCallback = false;
+    std::atomic<uint64_t> _generation{0};
+    // The loop whose pool the state returns to, nullptr if it was created
+    // outside of an event loop.
+    trantor::EventLoop *_loop = nullptr;
+};
+
+}  // namespace drogon
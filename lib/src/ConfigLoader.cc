@@ -333,6 +333,8 @@ static void loadApp(const Json::Value &app)
         std::cerr << "Error format of client_max_memory_body_size" << std::endl;
         exit(1);
     }
+    auto uploadMd5 = app.get("upload_md5", false).asBool();
+    drogon::app().enableUploadMd5(uploadMd5);
     auto maxWsMsgSize =
         app.get("client_max_websocket_message_size", "128K").asString();
     if (bytesSize(maxWsMsgSize, size))
@@ -345,7 +347,52 @@ static void loadApp(const Json::Value &app)
                   << std::endl;
         exit(1);
     }
+    drogon::app().enableWebSocketCompression(
+        app.get("enable_websocket_compression", false).asBool(),
+        app.get("websocket_compression_threshold", 128).asUInt64(),
+        app.get("websocket_context_takeover", false).asBool());
+    size_t highWaterMark, maxQueueSize;
+    auto highWaterMarkStr =
+        app.get("websocket_send_high_water_mark", "").asString();
+    auto maxQueueSizeStr =
+        app.get("websocket_max_send_queue_size", "").asString();
+    if (!bytesSize(highWaterMarkStr, highWaterMark) ||
+        !bytesSize(maxQueueSizeStr, maxQueueSize))
+    {
+        std::cerr << "Error format of websocket_send_high_water_mark or "
+                     "websocket_max_send_queue_size"
+                  << std::endl;
+        exit(1);
+    }
+    // An empty string means no send queue and no limit respectively
+    if (highWaterMark == size_t(-1))
+        highWaterMark = 0;
+    if (maxQueueSize == size_t(-1))
+        maxQueueSize = 0;
+    auto policyStr =
+        app.get("websocket_send_queue_policy", "drop_oldest").asString();
+    WebSocketSendQueuePolicy policy;
+    if (policyStr == "drop_oldest")
+        policy = WebSocketSendQueuePolicy::DropOldest;
+    else if (policyStr == "drop_newest")
+        policy = WebSocketSendQueuePolicy::DropNewest;
+    else if (policyStr == "close_1008")
+        policy = WebSocketSendQueuePolicy::CloseWithPolicyViolation;
+    else if (policyStr == "close_1013")
+        policy = WebSocketSendQueuePolicy::CloseWithTryAgainLater;
+    else
+    {
+        std::cerr << "Unknown websocket_send_queue_policy: " << policyStr
+                  << std::endl;
+        exit(1);
+    }
+    drogon::app().setWebSocketSendQueueLimits(highWaterMark,
+                                              maxQueueSize,
+                                              policy);
     drogon::app().setHomePage(app.get("home_page", "index.html").asString());
+    drogon::app().setDnsCacheTtl(
+        app.get("dns_cache_ttl", 60.0).asDouble(),
+        app.get("dns_negative_cache_ttl", 5.0).asDouble());
 }
 static void loadDbClients(const Json::Value &dbClients)
 {
@@ -379,6 +426,44 @@ static void loadDbClients(const Json::Value &dbClients)
                                      filename,
                                      name,
                                      isFast);
+        auto &replicas = client["replicas"];
+        for (auto const &replica : replicas)
+        {
+            drogon::app().addDbClientReplica(
+                name,
+                replica.get("host", host).asString(),
+                (u_short)replica.get("port", port).asUInt(),
+                replica.get("dbname", dbname).asString(),
+                replica.get("user", user).asString(),
+                replica.get("passwd", password).asString(),
+                replica.get("connection_number", connNum).asUInt());
+        }
+        if (!replicas.empty())
+        {
+            drogon::app().setDbClientStickyWindow(
+                name, client.get("sticky_window", 0.0).asDouble());
+        }
+        auto cacheTimeout = client.get("query_cache_timeout", 0.0).asDouble();
+        if (cacheTimeout > 0)
+        {
+            drogon::app().setDbClientQueryCache(
+                name,
+                cacheTimeout,
+                client.get("query_cache_max_entries", 10000).asUInt());
+        }
+        orm::DbPoolOptions poolOptions;
+        poolOptions._maxConnections =
+            client.get("max_connection_number", 0).asUInt();
+        poolOptions._idleTimeout = client.get("idle_timeout", 60.0).asDouble();
+        poolOptions._queueTimeout =
+            client.get("queue_timeout", 0.0).asDouble();
+        poolOptions._queryTimeout =
+            client.get("query_timeout", 0.0).asDouble();
+        poolOptions._healthCheckInterval =
+            client.get("health_check_interval", 0.0).asDouble();
+        poolOptions._maxQueueSize =
+            client.get("max_queue_size", 200000).asUInt();
+        drogon::app().setDbClientPoolOptions(name, poolOptions);
     }
 }
 static void loadListeners(const Json::Value &listeners)
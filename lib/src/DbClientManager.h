@@ -51,6 +51,19 @@ class DbClientManager : public trantor::NonCopyable
                         const std::string &filename,
                         const std::string &name,
                         const bool isFast);
+    void addDbClientReplica(const std::string &name,
+                            const std::string &host,
+                            const u_short port,
+                            const std::string &databaseName,
+                            const std::string &userName,
+                            const std::string &password,
+                            const size_t connectionNum);
+    void setDbClientStickyWindow(const std::string &name, double seconds);
+    void setDbClientQueryCache(const std::string &name,
+                               double timeout,
+                               size_t maxEntries);
+    void setDbClientPoolOptions(const std::string &name,
+                                const DbPoolOptions &options);
 
   private:
     std::map<std::string, DbClientPtr> _dbClientsMap;
@@ -61,7 +74,18 @@ class DbClientManager : public trantor::NonCopyable
         ClientType _dbType;
         bool _isFast;
         size_t _connectionNumber;
+        struct ReplicaInfo
+        {
+            std::string _connectionInfo;
+            size_t _connectionNumber;
+        };
+        std::vector<ReplicaInfo> _replicas;
+        double _stickyWindow = 0;
+        double _queryCacheTimeout = 0;
+        size_t _queryCacheMaxEntries = 10000;
+        DbPoolOptions _poolOptions;
     };
+    DbInfo &findDbInfo(const std::string &name);
     std::vector<DbInfo> _dbInfos;
     std::map<std::string, std::map<trantor::EventLoop *, orm::DbClientPtr>>
         _dbFastClientsMap;
@@ -41,4 +41,41 @@ void DbClientManager::createDbClient(const std::string &dbType,
     LOG_FATAL << "No database is supported by drogon, please install the "
                  "database development library first.";
     abort();
-}
\ No newline at end of file
+}
+void DbClientManager::addDbClientReplica(const std::string &name,
+                                         const std::string &host,
+                                         const u_short port,
+                                         const std::string &databaseName,
+                                         const std::string &userName,
+                                         const std::string &password,
+                                         const size_t connectionNum)
+{
+    LOG_FATAL << "No database is supported by drogon, please install the "
+                 "database development library first.";
+    abort();
+}
+
+void DbClientManager::setDbClientStickyWindow(const std::string &name,
+                                              double seconds)
+{
+    LOG_FATAL << "No database is supported by drogon, please install the "
+                 "database development library first.";
+    abort();
+}
+
+void DbClientManager::setDbClientQueryCache(const std::string &name,
+                                            double timeout,
+                                            size_t maxEntries)
+{
+    LOG_FATAL << "No database is supported by drogon, please install the "
+                 "database development library first.";
+    abort();
+}
+
+void DbClientManager::setDbClientPoolOptions(const std::string &name,
+                                             const DbPoolOptions &options)
+{
+    LOG_FATAL << "No database is supported by drogon, please install the "
+                 "database development library first.";
+    abort();
+}
@@ -0,0 +1,161 @@
+/**
+ *
+ *  DnsCache.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "DnsCache.h"
+#include <trantor/utils/Logger.h>
+#include <netdb.h>
+#include <string.h>
+#include <sys/socket.h>
+
+using namespace drogon;
+
+DnsCache::DnsCache(size_t maxEntries)
+    : _maxEntries(maxEntries), _queue(4, "DnsCache")
+{
+}
+
+bool DnsCache::isUnspecified(const trantor::InetAddress &addr)
+{
+    if (!addr.isIpV6())
+        return addr.ipNetEndian() == 0;
+    auto ip = addr.ip6NetEndian();
+    for (int i = 0; i < 4; ++i)
+    {
+        if (ip[i] != 0)
+            return false;
+    }
+    return true;
+}
+
+void DnsCache::resolve(const std::string &host, const Callback &callback)
+{
+    trantor::InetAddress addr;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto now = _clock();
+        auto iter = _entries.find(host);
+        if (iter == _entries.end())
+        {
+            if (_entries.size() >= _maxEntries)
+                evictEntries(now);
+            iter = _entries.emplace(host, Entry()).first;
+        }
+        auto &entry = iter->second;
+        if (entry._expiry < now)
+        {
+            entry._callbacks.push_back(callback);
+            if (!entry._resolving)
+            {
+                entry._resolving = true;
+                lookup(host);
+            }
+            return;
+        }
+        if (!entry._addresses.empty())
+        {
+            addr = entry._addresses[entry._next++ % entry._addresses.size()];
+            if (!entry._resolving && entry._expiry.after(-_ttl / 10) < now)
+            {
+                entry._resolving = true;
+                lookup(host);
+            }
+        }
+    }
+    callback(!isUnspecified(addr), addr);
+}
+
+void DnsCache::evictEntries(const trantor::Date &now)
+{
+    for (auto iter = _entries.begin(); iter != _entries.end();)
+    {
+        if (!iter->second._resolving && iter->second._expiry < now)
+            iter = _entries.erase(iter);
+        else
+            ++iter;
+    }
+    // Evict a tenth of the entries at once if none has expired, so that the
+    // map isn't scanned for every new host.
+    auto target = _maxEntries - _maxEntries / 10;
+    for (auto iter = _entries.begin();
+         iter != _entries.end() && _entries.size() >= target;)
+    {
+        if (!iter->second._resolving)
+            iter = _entries.erase(iter);
+        else
+            ++iter;
+    }
+}
+
+void DnsCache::lookup(const std::string &host)
+{
+    _queue.runTaskInQueue([this, host]() {
+        std::vector<trantor::InetAddress> addresses;
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        struct addrinfo *result = nullptr;
+        auto ret = getaddrinfo(host.c_str(), nullptr, &hints, &result);
+        if (ret != 0)
+        {
+            LOG_ERROR << "Failed to resolve " << host << ": "
+                      << gai_strerror(ret);
+        }
+        else
+        {
+            for (auto info = result; info; info = info->ai_next)
+            {
+                if (info->ai_family == AF_INET)
+                    addresses.emplace_back(
+                        *reinterpret_cast<sockaddr_in *>(info->ai_addr));
+                else if (info->ai_family == AF_INET6)
+                    addresses.emplace_back(
+                        *reinterpret_cast<sockaddr_in6 *>(info->ai_addr));
+            }
+            freeaddrinfo(result);
+        }
+
+        std::vector<Callback> callbacks;
+        std::vector<trantor::InetAddress> results;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto &entry = _entries[host];
+            entry._resolving = false;
+            if (!addresses.empty())
+            {
+                entry._addresses.swap(addresses);
+                entry._expiry = _clock().after(_ttl);
+            }
+            else
+            {
+                // Old addresses are kept until the host is queried again
+                entry._expiry = _clock().after(_negativeTtl);
+            }
+            callbacks.swap(entry._callbacks);
+            for (size_t i = 0; i < callbacks.size(); ++i)
+            {
+                if (entry._addresses.empty())
+                    results.emplace_back();
+                else
+                    results.push_back(
+                        entry._addresses[entry._next++ %
+                                         entry._addresses.size()]);
+            }
+        }
+        for (size_t i = 0; i < callbacks.size(); ++i)
+        {
+            callbacks[i](!isUnspecified(results[i]), results[i]);
+        }
+    });
+}
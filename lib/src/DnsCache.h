@@ -0,0 +1,100 @@
+/**
+ *
+ *  DnsCache.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/net/InetAddress.h>
+#include <trantor/utils/ConcurrentTaskQueue.h>
+#include <trantor/utils/Date.h>
+#include <trantor/utils/NonCopyable.h>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon
+{
+/// The host names resolved by the HTTP and WebSocket clients of the
+/// application
+/**
+ * All addresses of a host are cached for a TTL and returned in turn. A host
+ * which can't be resolved is cached for a shorter negative TTL. An entry used
+ * in the last tenth of its TTL is refreshed in the background, and concurrent
+ * lookups of the same host share one query, the cached addresses are still
+ * returned while the entry is refreshed. At most maxEntries hosts are
+ * cached, the expired entries are evicted first when it is full.
+ */
+class DnsCache : public trantor::NonCopyable
+{
+  public:
+    /// The callback is given false and an unspecified address if the host
+    /// can't be resolved. The port of the address is 0.
+    typedef std::function<void(bool, const trantor::InetAddress &)> Callback;
+
+    explicit DnsCache(size_t maxEntries = 10000);
+
+    void setTtl(double ttl, double negativeTtl)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _ttl = ttl;
+        _negativeTtl = negativeTtl;
+    }
+
+    /// Set the clock the TTLs are measured with, e.g. a fake clock in tests.
+    void setClock(std::function<trantor::Date()> clock)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _clock = std::move(clock);
+    }
+
+    /// Resolve a host name, the callback is called in the current thread if
+    /// the host is cached, or in a thread of the cache otherwise.
+    void resolve(const std::string &host, const Callback &callback);
+
+    /// The number of cached hosts
+    size_t size()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _entries.size();
+    }
+
+    /// Return true if the address is 0.0.0.0 or ::, e.g. the address of an
+    /// InetAddress created with a host name.
+    static bool isUnspecified(const trantor::InetAddress &addr);
+
+  private:
+    struct Entry
+    {
+        std::vector<trantor::InetAddress> _addresses;
+        size_t _next = 0;
+        trantor::Date _expiry;
+        bool _resolving = false;
+        std::vector<Callback> _callbacks;
+    };
+    /// Query the host in a thread of the task queue.
+    void lookup(const std::string &host);
+    /// Make room for a new entry, the entries being resolved are kept.
+    void evictEntries(const trantor::Date &now);
+
+    std::mutex _mutex;
+    std::unordered_map<std::string, Entry> _entries;
+    double _ttl = 60.0;
+    double _negativeTtl = 5.0;
+    size_t _maxEntries;
+    std::function<trantor::Date()> _clock{trantor::Date::date};
+    trantor::ConcurrentTaskQueue _queue;
+};
+
+}  // namespace drogon
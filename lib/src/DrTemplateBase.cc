@@ -34,3 +34,9 @@ std::shared_ptr<DrTemplateBase> DrTemplateBase::newTemplate(
     return std::dynamic_pointer_cast<DrTemplateBase>(
         drogon::DrClassMap::getSingleInstance(templateName));
 }
+
+void DrTemplateBase::streamText(const DrTemplateData &data,
+                                const ResponseStreamPtr &stream)
+{
+    stream->send(genText(data));
+}
@@ -18,42 +18,26 @@
 #include "HttpAppFrameworkImpl.h"
 #include <drogon/HttpFilter.h>
 
-#include <queue>
-
 namespace drogon
 {
 namespace filters_function
 {
-static void doFilterChains(
-    const std::vector<std::shared_ptr<HttpFilterBase>> &filters,
-    size_t index,
-    const HttpRequestImplPtr &req,
-    const std::shared_ptr<const std::function<void(const HttpResponsePtr &)>>
-        &callbackPtr,
-    std::function<void()> &&missCallback)
+static bool runFilter(ChainState *state, size_t index)
 {
-    if (index < filters.size())
-    {
-        auto &filter = filters[index];
-        filter->doFilter(
-            req,
-            [req, callbackPtr](const HttpResponsePtr &res) {
-                HttpAppFrameworkImpl::instance().callCallback(req,
-                                                              res,
-                                                              *callbackPtr);
-            },
-            [=, &filters, missCallback = std::move(missCallback)]() mutable {
-                doFilterChains(filters,
-                               index + 1,
-                               req,
-                               callbackPtr,
-                               std::move(missCallback));
-            });
-    }
-    else
+    auto &filter = static_cast<const std::shared_ptr<HttpFilterBase> *>(
+        state->steps())[index];
+    if (filter->isSynchronous())
     {
-        missCallback();
+        auto resp = filter->doSyncFilter(state->request());
+        if (!resp)
+            return true;
+        state->respond(resp);
+        return false;
     }
+    filter->doFilter(state->request(),
+                     state->respondCallback(),
+                     state->nextCallback());
+    return false;
 }
 
 std::vector<std::shared_ptr<HttpFilterBase>> createFilters(
@@ -74,14 +58,18 @@ std::vector<std::shared_ptr<HttpFilterBase>> createFilters(
     return filters;
 }
 
-void doFilters(
-    const std::vector<std::shared_ptr<HttpFilterBase>> &filters,
-    const HttpRequestImplPtr &req,
-    const std::shared_ptr<const std::function<void(const HttpResponsePtr &)>>
-        &callbackPtr,
-    std::function<void()> &&missCallback)
+void doFilters(const std::vector<std::shared_ptr<HttpFilterBase>> &filters,
+               const HttpRequestImplPtr &req,
+               std::function<void(const HttpResponsePtr &)> &&callback,
+               ChainPassCallback &&passCallback)
 {
-    doFilterChains(filters, 0, req, callbackPtr, std::move(missCallback));
+    ChainState::run(filters.data(),
+                    filters.size(),
+                    runFilter,
+                    req,
+                    std::move(callback),
+                    std::move(passCallback),
+                    true);
 }
 
 }  // namespace filters_function
@@ -15,6 +15,7 @@
 #pragma once
 
 #include "impl_forwards.h"
+#include "ChainState.h"
 #include <memory>
 #include <string>
 #include <vector>
@@ -25,12 +26,12 @@ namespace filters_function
 {
 std::vector<std::shared_ptr<HttpFilterBase>> createFilters(
     const std::vector<std::string> &filterNames);
-void doFilters(
-    const std::vector<std::shared_ptr<HttpFilterBase>> &filters,
-    const HttpRequestImplPtr &req,
-    const std::shared_ptr<const std::function<void(const HttpResponsePtr &)>>
-        &callbackPtr,
-    std::function<void()> &&missCallback);
+/// Run the filters for the request, passCallback is called with the
+/// callback if the request passes all of them.
+void doFilters(const std::vector<std::shared_ptr<HttpFilterBase>> &filters,
+               const HttpRequestImplPtr &req,
+               std::function<void(const HttpResponsePtr &)> &&callback,
+               ChainPassCallback &&passCallback);
 
 }  // namespace filters_function
 }  // namespace drogon
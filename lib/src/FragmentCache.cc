@@ -0,0 +1,108 @@
+/**
+ *
+ *  FragmentCache.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include <drogon/FragmentCache.h>
+#include <trantor/utils/Date.h>
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+
+using namespace drogon;
+
+namespace
+{
+struct Fragment
+{
+    std::string _text;
+    // In microseconds since epoch, 0 means the fragment never expires
+    int64_t _expiration;
+};
+
+std::atomic<size_t> maxFragments{10000};
+
+struct ThreadFragments
+{
+    std::unordered_map<std::string, Fragment> _fragments;
+    // The expired fragments are removed when the number of the fragments
+    // reaches this size, so that a key used only once doesn't stay forever.
+    size_t _sweepSize = 64;
+
+    void sweep(int64_t now)
+    {
+        for (auto iter = _fragments.begin(); iter != _fragments.end();)
+        {
+            if (iter->second._expiration != 0 &&
+                iter->second._expiration <= now)
+                iter = _fragments.erase(iter);
+            else
+                ++iter;
+        }
+        auto maxSize = std::max<size_t>(1, maxFragments.load());
+        if (_fragments.size() >= maxSize)
+        {
+            // The fragments which never expire or expire late could grow
+            // without limit if their keys do, a tenth of them is dropped.
+            auto targetSize = maxSize - maxSize / 10;
+            for (auto iter = _fragments.begin();
+                 iter != _fragments.end() && _fragments.size() >= targetSize;)
+                iter = _fragments.erase(iter);
+        }
+        _sweepSize = std::min(maxSize,
+                              std::max<size_t>(64, _fragments.size() * 2));
+    }
+};
+
+thread_local ThreadFragments threadFragments;
+}  // namespace
+
+const std::string *FragmentCache::find(const std::string &key)
+{
+    auto &fragments = threadFragments._fragments;
+    auto iter = fragments.find(key);
+    if (iter == fragments.end())
+        return nullptr;
+    if (iter->second._expiration != 0 &&
+        iter->second._expiration <=
+            trantor::Date::now().microSecondsSinceEpoch())
+    {
+        fragments.erase(iter);
+        return nullptr;
+    }
+    return &iter->second._text;
+}
+
+void FragmentCache::insert(const std::string &key,
+                           std::string &&fragment,
+                           double ttl)
+{
+    auto now = trantor::Date::now().microSecondsSinceEpoch();
+    int64_t expiration = ttl > 0 ? now + (int64_t)(ttl * 1000000) : 0;
+    auto &fragments = threadFragments._fragments;
+    if (fragments.size() >= threadFragments._sweepSize &&
+        fragments.find(key) == fragments.end())
+        threadFragments.sweep(now);
+    auto &item = fragments[key];
+    item._text = std::move(fragment);
+    item._expiration = expiration;
+}
+
+void FragmentCache::setMaxSize(size_t size)
+{
+    maxFragments = size;
+}
+
+void FragmentCache::clear()
+{
+    threadFragments._fragments.clear();
+}
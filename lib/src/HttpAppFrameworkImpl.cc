@@ -299,6 +299,18 @@ HttpAppFramework &HttpAppFrameworkImpl::setSSLFiles(const std::string &certPath,
     return *this;
 }
 
+std::string HttpAppFrameworkImpl::newTmpFilePath() const
+{
+    auto fileName = utils::getUuid();
+    auto tmpfile = _uploadPath;
+    tmpfile.append("/tmp/")
+        .append(1, fileName[0])
+        .append(1, fileName[1])
+        .append("/")
+        .append(fileName);
+    return tmpfile;
+}
+
 void HttpAppFrameworkImpl::run()
 {
     //
@@ -611,20 +623,15 @@ void HttpAppFrameworkImpl::onAsyncRequest(
     }
     else
     {
-        auto callbackPtr =
-            std::make_shared<std::function<void(const HttpResponsePtr &)>>(
-                std::move(callback));
         doAdvicesChain(
             _preRoutingAdvices,
-            0,
             req,
-            std::make_shared<std::function<void(const HttpResponsePtr &)>>(
-                [req, callbackPtr, this](const HttpResponsePtr &resp) {
-                    callCallback(req, resp, *callbackPtr);
-                }),
-            [this, callbackPtr, req]() {
-                _httpSimpleCtrlsRouterPtr->route(req, std::move(*callbackPtr));
-            });
+            std::move(callback),
+            [this, req](
+                std::function<void(const HttpResponsePtr &)> &&callback) {
+                _httpSimpleCtrlsRouterPtr->route(req, std::move(callback));
+            },
+            true);
     }
 }
 
@@ -735,4 +742,43 @@ HttpAppFramework &HttpAppFrameworkImpl::createDbClient(
                                         name,
                                         isFast);
     return *this;
+}
+HttpAppFramework &HttpAppFrameworkImpl::addDbClientReplica(
+    const std::string &name,
+    const std::string &host,
+    const u_short port,
+    const std::string &databaseName,
+    const std::string &userName,
+    const std::string &password,
+    const size_t connectionNum)
+{
+    assert(!_running);
+    _dbClientManagerPtr->addDbClientReplica(
+        name, host, port, databaseName, userName, password, connectionNum);
+    return *this;
+}
+HttpAppFramework &HttpAppFrameworkImpl::setDbClientStickyWindow(
+    const std::string &name,
+    double seconds)
+{
+    assert(!_running);
+    _dbClientManagerPtr->setDbClientStickyWindow(name, seconds);
+    return *this;
+}
+HttpAppFramework &HttpAppFrameworkImpl::setDbClientQueryCache(
+    const std::string &name,
+    double timeout,
+    size_t maxEntries)
+{
+    assert(!_running);
+    _dbClientManagerPtr->setDbClientQueryCache(name, timeout, maxEntries);
+    return *this;
+}
+HttpAppFramework &HttpAppFrameworkImpl::setDbClientPoolOptions(
+    const std::string &name,
+    const orm::DbPoolOptions &options)
+{
+    assert(!_running);
+    _dbClientManagerPtr->setDbClientPoolOptions(name, options);
+    return *this;
 }
\ No newline at end of file
@@ -15,7 +15,9 @@
 #pragma once
 
 #include "impl_forwards.h"
+#include "DnsCache.h"
 #include <drogon/HttpAppFramework.h>
+#include <drogon/WebSocketConnection.h>
 #include <drogon/config.h>
 #include <memory>
 #include <mutex>
@@ -195,6 +197,17 @@ class HttpAppFrameworkImpl : public HttpAppFramework
         static auto resolver = trantor::Resolver::newResolver(getLoop());
         return resolver;
     }
+    DnsCache &getDnsCache() const
+    {
+        static DnsCache dnsCache;
+        return dnsCache;
+    }
+    virtual HttpAppFramework &setDnsCacheTtl(double ttl,
+                                             double negativeTtl) override
+    {
+        getDnsCache().setTtl(ttl, negativeTtl);
+        return *this;
+    }
     virtual HttpAppFramework &setUploadPath(
         const std::string &uploadPath) override;
     virtual HttpAppFramework &setFileTypes(
@@ -268,12 +281,38 @@ class HttpAppFrameworkImpl : public HttpAppFramework
         _clientMaxMemoryBodySize = maxSize;
         return *this;
     }
+    virtual HttpAppFramework &enableUploadMd5(bool enable) override
+    {
+        _uploadMd5 = enable;
+        return *this;
+    }
     virtual HttpAppFramework &setClientMaxWebSocketMessageSize(
         size_t maxSize) override
     {
         _clientMaxWebSocketMessageSize = maxSize;
         return *this;
     }
+    virtual HttpAppFramework &enableWebSocketCompression(
+        bool enable = true,
+        size_t threshold = 128,
+        bool contextTakeover = false) override
+    {
+        _webSocketCompression = enable;
+        _webSocketCompressionThreshold = threshold;
+        _webSocketContextTakeover = contextTakeover;
+        return *this;
+    }
+    virtual HttpAppFramework &setWebSocketSendQueueLimits(
+        size_t highWaterMark,
+        size_t maxQueueSize = 0,
+        WebSocketSendQueuePolicy policy =
+            WebSocketSendQueuePolicy::DropOldest) override
+    {
+        _webSocketSendQueueOptions._highWaterMark = highWaterMark;
+        _webSocketSendQueueOptions._maxQueueSize = maxQueueSize;
+        _webSocketSendQueueOptions._policy = policy;
+        return *this;
+    }
     virtual HttpAppFramework &setHomePage(
         const std::string &homePageFile) override
     {
@@ -292,10 +331,33 @@ class HttpAppFrameworkImpl : public HttpAppFramework
     {
         return _clientMaxMemoryBodySize;
     }
+    bool isUploadMd5Enabled() const
+    {
+        return _uploadMd5;
+    }
+    // Return a new path in the temporary directories created in run(), for
+    // a request body or an uploaded file cached on disk.
+    std::string newTmpFilePath() const;
     size_t getClientMaxWebSocketMessageSize() const
     {
         return _clientMaxWebSocketMessageSize;
     }
+    bool isWebSocketCompressionEnabled() const
+    {
+        return _webSocketCompression;
+    }
+    size_t getWebSocketCompressionThreshold() const
+    {
+        return _webSocketCompressionThreshold;
+    }
+    bool getWebSocketContextTakeover() const
+    {
+        return _webSocketContextTakeover;
+    }
+    const WebSocketSendQueueOptions &getWebSocketSendQueueOptions() const
+    {
+        return _webSocketSendQueueOptions;
+    }
     virtual std::vector<std::tuple<std::string, HttpMethod, std::string>>
     getHandlersInfo() const override;
 
@@ -369,6 +431,23 @@ class HttpAppFrameworkImpl : public HttpAppFramework
         const std::string &filename = "",
         const std::string &name = "default",
         const bool isFast = false) override;
+    virtual HttpAppFramework &addDbClientReplica(
+        const std::string &name,
+        const std::string &host,
+        const u_short port,
+        const std::string &databaseName,
+        const std::string &userName,
+        const std::string &password,
+        const size_t connectionNum = 1) override;
+    virtual HttpAppFramework &setDbClientStickyWindow(const std::string &name,
+                                                      double seconds) override;
+    virtual HttpAppFramework &setDbClientQueryCache(
+        const std::string &name,
+        double timeout,
+        size_t maxEntries = 10000) override;
+    virtual HttpAppFramework &setDbClientPoolOptions(
+        const std::string &name,
+        const orm::DbPoolOptions &options) override;
 
     inline static HttpAppFrameworkImpl &instance()
     {
@@ -460,7 +539,12 @@ class HttpAppFrameworkImpl : public HttpAppFramework
     bool _useGzip = true;
     size_t _clientMaxBodySize = 1024 * 1024;
     size_t _clientMaxMemoryBodySize = 64 * 1024;
+    bool _uploadMd5 = false;
     size_t _clientMaxWebSocketMessageSize = 128 * 1024;
+    bool _webSocketCompression = false;
+    size_t _webSocketCompressionThreshold = 128;
+    bool _webSocketContextTakeover = false;
+    WebSocketSendQueueOptions _webSocketSendQueueOptions;
     std::string _homePageFile = "index.html";
     std::unique_ptr<SessionManager> _sessionManagerPtr;
     // Json::Value _customConfig;
@@ -19,12 +19,172 @@
 #include "HttpAppFrameworkImpl.h"
 #include <drogon/config.h>
 #include <algorithm>
+#include <mutex>
 #include <stdlib.h>
+#include <zlib.h>
 
 using namespace trantor;
 using namespace drogon;
 using namespace std::placeholders;
 
+namespace
+{
+/// Decompress a body encoded with gzip part by part
+class GzipInflater : public trantor::NonCopyable
+{
+  public:
+    GzipInflater()
+    {
+        _ok = (inflateInit2(&_strm, MAX_WBITS + 16) == Z_OK);
+    }
+    ~GzipInflater()
+    {
+        if (_ok)
+            inflateEnd(&_strm);
+    }
+    /// Return false if the data is corrupted or the output returns false.
+    bool decompress(const char *data,
+                    size_t length,
+                    const HttpBodyCallback &output,
+                    bool &outputAborted)
+    {
+        if (!_ok)
+            return false;
+        char buffer[16 * 1024];
+        _strm.next_in = (Bytef *)data;
+        _strm.avail_in = length;
+        do
+        {
+            _strm.next_out = (Bytef *)buffer;
+            _strm.avail_out = sizeof(buffer);
+            auto ret = inflate(&_strm, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+            {
+                LOG_ERROR << "Failed to decompress the body of a response";
+                return false;
+            }
+            auto outLength = sizeof(buffer) - _strm.avail_out;
+            if (outLength > 0 && !output(buffer, outLength))
+            {
+                outputAborted = true;
+                return false;
+            }
+            if (ret == Z_STREAM_END)
+            {
+                // Concatenated gzip members
+                if (_strm.avail_in == 0)
+                    break;
+                inflateReset(&_strm);
+            }
+            else if (ret == Z_BUF_ERROR)
+            {
+                break;
+            }
+        } while (_strm.avail_in > 0 || _strm.avail_out == 0);
+        return true;
+    }
+
+  private:
+    z_stream _strm = {0};
+    bool _ok;
+};
+
+/// Pass the body of a response from a server to a streaming response, which
+/// is started after some parts of the body may have arrived.
+class BodyPipe : public trantor::NonCopyable
+{
+  public:
+    /// Return false if the streaming response is gone.
+    bool write(const char *data, size_t length)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_stream)
+            return _stream->send(data, length);
+        if (_dropped)
+            return false;
+        _buffer.append(data, length);
+        return true;
+    }
+    void finish(bool complete)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _finished = true;
+        _complete = complete;
+        if (_stream)
+        {
+            if (complete)
+                _stream->close();
+            else
+                _stream->abort();
+            _stream.reset();
+        }
+    }
+    void attach(const ResponseStreamPtr &stream)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (!_buffer.empty())
+        {
+            stream->send(_buffer);
+            std::string().swap(_buffer);
+        }
+        if (!_finished)
+            _stream = stream;
+        else if (_complete)
+            stream->close();
+        else
+            stream->abort();
+    }
+    /// Called when the streaming response is released without being sent.
+    void drop()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _dropped = true;
+        std::string().swap(_buffer);
+    }
+
+  private:
+    std::mutex _mutex;
+    ResponseStreamPtr _stream;
+    std::string _buffer;
+    bool _finished = false;
+    bool _complete = false;
+    bool _dropped = false;
+};
+
+/// Owned by the streaming response, drops the pipe with it.
+struct BodyPipeGuard
+{
+    explicit BodyPipeGuard(const std::shared_ptr<BodyPipe> &pipe) : _pipe(pipe)
+    {
+    }
+    ~BodyPipeGuard()
+    {
+        _pipe->drop();
+    }
+    std::shared_ptr<BodyPipe> _pipe;
+};
+}  // namespace
+
+namespace drogon
+{
+struct HttpClientImpl::StreamState
+{
+    HttpReqCallback _headersCallback;
+    HttpBodyCallback _bodyCallback;
+    std::function<void(ReqResult)> _completionCallback;
+    bool _decompress = true;
+    bool _gotHeaders = false;
+    // The headers are waited for until the timer expires if timeout > 0
+    double _timeout = 0;
+    trantor::TimerId _timerId;
+    bool _timedOut = false;
+    bool _aborted = false;
+    // True if the bodyCallback returned false
+    bool _cancelled = false;
+    std::unique_ptr<GzipInflater> _inflater;
+};
+}  // namespace drogon
+
 void HttpClientImpl::createTcpClient()
 {
     LOG_TRACE << "New TcpClient," << _server.toIpPort();
@@ -39,9 +199,11 @@ void HttpClientImpl::createTcpClient()
 #endif
     auto thisPtr = shared_from_this();
     std::weak_ptr<HttpClientImpl> weakPtr = thisPtr;
+    auto clientId = ++_tcpClientId;
+    _responsesOnConnection = 0;
 
     _tcpClient->setConnectionCallback(
-        [weakPtr](const trantor::TcpConnectionPtr &connPtr) {
+        [weakPtr, clientId](const trantor::TcpConnectionPtr &connPtr) {
             auto thisPtr = weakPtr.lock();
             if (!thisPtr)
                 return;
@@ -64,12 +226,22 @@ void HttpClientImpl::createTcpClient()
             else
             {
                 LOG_TRACE << "connection disconnect";
-                thisPtr->onError(ReqResult::NetworkFailure);
+                if (clientId != thisPtr->_tcpClientId)
+                    return;
+                auto responseParser =
+                    connPtr->getContext<HttpResponseParser>();
+                if (responseParser &&
+                    !thisPtr->_pipeliningCallbacks.empty() &&
+                    responseParser->parseResponseOnClose())
+                {
+                    thisPtr->handleResponse(*responseParser, connPtr);
+                }
+                thisPtr->onDisconnected();
             }
         });
-    _tcpClient->setConnectionErrorCallback([weakPtr]() {
+    _tcpClient->setConnectionErrorCallback([weakPtr, clientId]() {
         auto thisPtr = weakPtr.lock();
-        if (!thisPtr)
+        if (!thisPtr || clientId != thisPtr->_tcpClientId)
             return;
         // can't connect to server
         thisPtr->onError(ReqResult::BadServerAddress);
@@ -183,6 +355,7 @@ HttpClientImpl::HttpClientImpl(trantor::EventLoop *loop,
             }
         }
     }
+    _isDomainName = !_domain.empty() && DnsCache::isUnspecified(_server);
     LOG_TRACE << "userSSL=" << _useSSL << " domain=" << _domain;
 }
 
@@ -209,6 +382,153 @@ void HttpClientImpl::sendRequest(const drogon::HttpRequestPtr &req,
     });
 }
 
+void HttpClientImpl::sendRequest(const drogon::HttpRequestPtr &req,
+                                 const drogon::HttpReqCallback &callback,
+                                 double timeout)
+{
+    if (timeout <= 0)
+    {
+        sendRequest(req, callback);
+        return;
+    }
+    auto thisPtr = shared_from_this();
+    _loop->runInLoop([thisPtr, req, callback, timeout]() {
+        auto done = std::make_shared<bool>(false);
+        auto loop = thisPtr->_loop;
+        auto timerId =
+            loop->runAfter(timeout, [thisPtr, req, done, callback]() {
+                if (*done)
+                    return;
+                *done = true;
+                thisPtr->onRequestTimeout(req);
+                callback(ReqResult::Timeout, nullptr);
+            });
+        thisPtr->sendRequestInLoop(
+            req,
+            [done, callback, loop, timerId](ReqResult result,
+                                            const HttpResponsePtr &response) {
+                if (*done)
+                    return;
+                *done = true;
+                loop->invalidateTimer(timerId);
+                callback(result, response);
+            });
+    });
+}
+
+void HttpClientImpl::sendStreamRequest(
+    const HttpRequestPtr &req,
+    const HttpReqCallback &headersCallback,
+    const HttpBodyCallback &bodyCallback,
+    const std::function<void(ReqResult)> &completionCallback,
+    bool decompress,
+    double timeout)
+{
+    auto stream = std::make_shared<StreamState>();
+    stream->_headersCallback = headersCallback;
+    stream->_bodyCallback = bodyCallback;
+    stream->_completionCallback = completionCallback;
+    stream->_decompress = decompress;
+    stream->_timeout = timeout;
+    auto thisPtr = shared_from_this();
+    _loop->runInLoop([thisPtr, req, stream]() {
+        thisPtr->_streams[req.get()] = stream;
+        if (stream->_timeout > 0)
+        {
+            // The request stays in the pipeline, its response is dropped
+            // with the connection when the headers arrive.
+            stream->_timerId =
+                thisPtr->_loop->runAfter(stream->_timeout, [stream]() {
+                    if (stream->_gotHeaders)
+                        return;
+                    stream->_gotHeaders = true;
+                    stream->_timedOut = true;
+                    stream->_cancelled = true;
+                    stream->_headersCallback(ReqResult::Timeout, nullptr);
+                });
+        }
+        // Called with the complete response, or with an error
+        thisPtr->sendRequestInLoop(
+            req,
+            [thisPtr, req, stream](ReqResult result,
+                                   const HttpResponsePtr &response) {
+                thisPtr->_streams.erase(req.get());
+                if (stream->_timedOut)
+                    return;
+                if (!stream->_gotHeaders)
+                {
+                    if (stream->_timeout > 0)
+                        thisPtr->_loop->invalidateTimer(stream->_timerId);
+                    stream->_gotHeaders = true;
+                    stream->_headersCallback(result, response);
+                    if (result != ReqResult::Ok)
+                        return;
+                }
+                stream->_completionCallback(result);
+            });
+    });
+}
+
+void HttpClientImpl::setStreamCallbacks(
+    HttpResponseParser &responseParser,
+    const std::shared_ptr<StreamState> &stream)
+{
+    auto parser = &responseParser;
+    responseParser.setStreamCallbacks(
+        [parser, stream, loop = _loop]() {
+            if (stream->_timedOut)
+            {
+                stream->_aborted = true;
+                return;
+            }
+            if (stream->_timeout > 0)
+                loop->invalidateTimer(stream->_timerId);
+            auto resp = parser->responseImpl();
+            if (stream->_decompress &&
+                resp->getHeaderBy("content-encoding") == "gzip")
+            {
+                stream->_inflater = std::make_unique<GzipInflater>();
+                resp->removeHeader("content-encoding");
+            }
+            stream->_gotHeaders = true;
+            stream->_headersCallback(ReqResult::Ok, resp);
+        },
+        [stream](const char *data, size_t length) {
+            if (stream->_aborted)
+                return;
+            bool ok;
+            if (stream->_inflater)
+            {
+                ok = stream->_inflater->decompress(data,
+                                                   length,
+                                                   stream->_bodyCallback,
+                                                   stream->_cancelled);
+            }
+            else
+            {
+                ok = stream->_bodyCallback(data, length);
+                stream->_cancelled = !ok;
+            }
+            stream->_aborted = !ok;
+        });
+}
+
+void HttpClientImpl::abortStream(const trantor::TcpConnectionPtr &connPtr,
+                                 const std::shared_ptr<StreamState> &stream)
+{
+    // The rest of the body is discarded with the connection.
+    auto reqAndCb = std::move(_pipeliningCallbacks.front());
+    _pipeliningCallbacks.pop();
+    _streams.erase(reqAndCb.first.get());
+    ++_responsesOnConnection;
+    // Ignore the events of the dropped connection
+    ++_tcpClientId;
+    connPtr->forceClose();
+    onDisconnected();
+    if (!stream->_cancelled)
+        stream->_completionCallback(ReqResult::BadResponse);
+}
+
 void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
                                        const drogon::HttpReqCallback &callback)
 {
@@ -219,7 +539,10 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
     {
         req->addHeader("Host", _domain);
     }
-    req->addHeader("User-Agent", "DrogonClient");
+    if (req->getHeader("user-agent").empty())
+    {
+        req->addHeader("User-Agent", "DrogonClient");
+    }
 
     for (auto &cookie : _validCookies)
     {
@@ -255,32 +578,25 @@ void HttpClientImpl::sendRequestInLoop(const drogon::HttpRequestPtr &req,
                 }
             }
 
-            if (_server.ipNetEndian() == 0 && !hasIpv6Address &&
-                !_domain.empty() && _server.portNetEndian() != 0)
+            // The host name is resolved for every connection, so that the
+            // cached addresses are used in turn and changes are seen after
+            // the TTL.
+            if (_isDomainName && _server.portNetEndian() != 0)
             {
                 _dns = true;
-                if (!_resolver)
-                {
-                    _resolver = trantor::Resolver::newResolver(_loop);
-                }
-                _resolver->resolve(
+                HttpAppFrameworkImpl::instance().getDnsCache().resolve(
                     _domain,
-                    [thisPtr = shared_from_this(),
-                     hasIpv6Address](const trantor::InetAddress &addr) {
-                        thisPtr->_loop->runInLoop([thisPtr,
-                                                   addr,
-                                                   hasIpv6Address]() {
-                            struct sockaddr_in ad;
-                            auto port = thisPtr->_server.portNetEndian();
-                            thisPtr->_server = addr;
-                            thisPtr->_server.setPortNetEndian(port);
-                            LOG_TRACE << "dns:domain=" << thisPtr->_domain
-                                      << ";ip=" << thisPtr->_server.toIp();
+                    [thisPtr = shared_from_this()](
+                        bool found, const trantor::InetAddress &addr) {
+                        thisPtr->_loop->runInLoop([thisPtr, found, addr]() {
                             thisPtr->_dns = false;
-                            if ((thisPtr->_server.ipNetEndian() != 0 ||
-                                 hasIpv6Address) &&
-                                thisPtr->_server.portNetEndian() != 0)
+                            if (found)
                             {
+                                auto port = thisPtr->_server.portNetEndian();
+                                thisPtr->_server = addr;
+                                thisPtr->_server.setPortNetEndian(port);
+                                LOG_TRACE << "dns:domain=" << thisPtr->_domain
+                                          << ";ip=" << thisPtr->_server.toIp();
                                 thisPtr->createTcpClient();
                             }
                             else
@@ -364,6 +680,7 @@ void HttpClientImpl::sendReq(const trantor::TcpConnectionPtr &connPtr,
     LOG_TRACE << "Send request:"
               << std::string(buffer.peek(), buffer.readableBytes());
     _bytesSent += buffer.readableBytes();
+    _lastActiveDate = trantor::Date::date();
     connPtr->send(std::move(buffer));
 }
 
@@ -382,51 +699,34 @@ void HttpClientImpl::onRecvMessage(const trantor::TcpConnectionPtr &connPtr,
         {
             responseParser->setForHeadMethod();
         }
+        std::shared_ptr<StreamState> stream;
+        if (!_streams.empty())
+        {
+            auto iter = _streams.find(firstReq.first.get());
+            if (iter != _streams.end())
+            {
+                stream = iter->second;
+                if (!responseParser->isStreaming())
+                    setStreamCallbacks(*responseParser, stream);
+            }
+        }
         if (!responseParser->parseResponse(msg))
         {
             onError(ReqResult::BadResponse);
             _bytesReceived += (msgSize - msg->readableBytes());
             return;
         }
+        if (stream && stream->_aborted)
+        {
+            _bytesReceived += (msgSize - msg->readableBytes());
+            abortStream(connPtr, stream);
+            return;
+        }
         if (responseParser->gotAll())
         {
-            auto resp = responseParser->responseImpl();
-            responseParser->reset();
-            assert(!_pipeliningCallbacks.empty());
-            auto &type = resp->getHeaderBy("content-type");
-            if (resp->getHeaderBy("content-encoding") == "gzip")
-            {
-                resp->gunzip();
-            }
-            if (type.find("application/json") != std::string::npos)
-            {
-                resp->parseJson();
-            }
-            auto cb = std::move(firstReq);
-            _pipeliningCallbacks.pop();
-            handleCookies(resp);
             _bytesReceived += (msgSize - msg->readableBytes());
             msgSize = msg->readableBytes();
-            cb.second(ReqResult::Ok, resp);
-
-            // LOG_TRACE << "pipelining buffer size=" <<
-            // _pipeliningCallbacks.size(); LOG_TRACE << "requests buffer size="
-            // << _requestsBuffer.size();
-
-            if (!_requestsBuffer.empty())
-            {
-                auto &reqAndCb = _requestsBuffer.front();
-                sendReq(connPtr, reqAndCb.first);
-                _pipeliningCallbacks.push(std::move(reqAndCb));
-                _requestsBuffer.pop();
-            }
-            else
-            {
-                if (resp->ifCloseConnection() && _pipeliningCallbacks.empty())
-                {
-                    _tcpClient.reset();
-                }
-            }
+            handleResponse(*responseParser, connPtr);
         }
         else
         {
@@ -435,6 +735,54 @@ void HttpClientImpl::onRecvMessage(const trantor::TcpConnectionPtr &connPtr,
     }
 }
 
+void HttpClientImpl::handleResponse(HttpResponseParser &responseParser,
+                                    const trantor::TcpConnectionPtr &connPtr)
+{
+    assert(!_pipeliningCallbacks.empty());
+    auto resp = responseParser.responseImpl();
+    if (!responseParser.isStreaming())
+    {
+        auto &type = resp->getHeaderBy("content-type");
+        if (resp->getHeaderBy("content-encoding") == "gzip")
+        {
+            resp->gunzip();
+        }
+        if (type.find("application/json") != std::string::npos)
+        {
+            resp->parseJson();
+        }
+    }
+    responseParser.reset();
+    auto cb = std::move(_pipeliningCallbacks.front());
+    _pipeliningCallbacks.pop();
+    ++_responsesOnConnection;
+    _lastActiveDate = trantor::Date::date();
+    handleCookies(resp);
+    cb.second(ReqResult::Ok, resp);
+
+    // LOG_TRACE << "pipelining buffer size=" <<
+    // _pipeliningCallbacks.size(); LOG_TRACE << "requests buffer size="
+    // << _requestsBuffer.size();
+
+    if (!_requestsBuffer.empty())
+    {
+        if (connPtr->connected())
+        {
+            auto &reqAndCb = _requestsBuffer.front();
+            sendReq(connPtr, reqAndCb.first);
+            _pipeliningCallbacks.push(std::move(reqAndCb));
+            _requestsBuffer.pop();
+        }
+    }
+    else
+    {
+        if (resp->ifCloseConnection() && _pipeliningCallbacks.empty())
+        {
+            _tcpClient.reset();
+        }
+    }
+}
+
 HttpClientPtr HttpClient::newHttpClient(const std::string &ip,
                                         uint16_t port,
                                         bool useSSL,
@@ -455,6 +803,70 @@ HttpClientPtr HttpClient::newHttpClient(const std::string &hostString,
         hostString);
 }
 
+void HttpClient::forwardRequest(
+    const HttpRequestPtr &req,
+    const HttpReqCallback &callback,
+    const std::function<void(ReqResult)> &completionCallback,
+    double timeout)
+{
+    auto pipe = std::make_shared<BodyPipe>();
+    sendStreamRequest(
+        req,
+        [pipe, callback, completionCallback](ReqResult result,
+                                             const HttpResponsePtr &response) {
+            if (result != ReqResult::Ok)
+            {
+                callback(result, nullptr);
+                if (completionCallback)
+                    completionCallback(result);
+                return;
+            }
+            HttpResponsePtr resp;
+            auto code = response->statusCode();
+            if (code == k204NoContent || code == k304NotModified)
+            {
+                // No body at all, not even an empty chunk
+                resp = HttpResponse::newHttpResponse();
+            }
+            else
+            {
+                auto guard = std::make_shared<BodyPipeGuard>(pipe);
+                resp = HttpResponse::newStreamResponse(
+                    [guard](const ResponseStreamPtr &stream) {
+                        guard->_pipe->attach(stream);
+                    });
+            }
+            resp->setStatusCode(code);
+            // The Content-Type header is copied with the others
+            resp->setContentTypeCodeAndCustomString(CT_NONE, "");
+            for (auto &header : response->getHeaders())
+            {
+                auto &field = header.first;
+                if (field == "content-length" ||
+                    field == "transfer-encoding" || field == "connection" ||
+                    field == "keep-alive" || field == "date" ||
+                    field == "server")
+                    continue;
+                resp->addHeader(field, header.second);
+            }
+            for (auto &cookie : response->getCookies())
+            {
+                resp->addCookie(cookie.second);
+            }
+            callback(ReqResult::Ok, resp);
+        },
+        [pipe](const char *data, size_t length) {
+            return pipe->write(data, length);
+        },
+        [pipe, completionCallback](ReqResult result) {
+            pipe->finish(result == ReqResult::Ok);
+            if (completionCallback)
+                completionCallback(result);
+        },
+        false,
+        timeout);
+}
+
 void HttpClientImpl::onError(ReqResult result)
 {
     while (!_pipeliningCallbacks.empty())
@@ -472,6 +884,92 @@ void HttpClientImpl::onError(ReqResult result)
     _tcpClient.reset();
 }
 
+void HttpClientImpl::onDisconnected()
+{
+    if (_responsesOnConnection == 0 || requestsNumber() == 0)
+    {
+        onError(ReqResult::NetworkFailure);
+        return;
+    }
+    // The server closed a keep-alive connection which had been used, maybe
+    // before it read the requests in flight. Idempotent requests are sent
+    // again on a new connection, the others may have been processed.
+    std::queue<std::pair<HttpRequestPtr, HttpReqCallback>> requests;
+    while (!_pipeliningCallbacks.empty())
+    {
+        auto reqAndCb = std::move(_pipeliningCallbacks.front());
+        _pipeliningCallbacks.pop();
+        auto method = reqAndCb.first->method();
+        // A response whose body has been partly passed on can't be retried
+        auto iter = _streams.find(reqAndCb.first.get());
+        bool bodyStarted = iter != _streams.end() && iter->second->_gotHeaders;
+        if (!bodyStarted && (method == Get || method == Head || method == Put ||
+                             method == Delete || method == Options))
+        {
+            LOG_TRACE << "Retry the request to " << reqAndCb.first->path();
+            requests.push(std::move(reqAndCb));
+        }
+        else
+        {
+            reqAndCb.second(ReqResult::NetworkFailure, nullptr);
+        }
+    }
+    while (!_requestsBuffer.empty())
+    {
+        requests.push(std::move(_requestsBuffer.front()));
+        _requestsBuffer.pop();
+    }
+    _requestsBuffer.swap(requests);
+    _tcpClient.reset();
+    if (!_requestsBuffer.empty())
+        createTcpClient();
+}
+
+void HttpClientImpl::onRequestTimeout(const HttpRequestPtr &req)
+{
+    // A request which hasn't been sent is just dropped
+    std::queue<std::pair<HttpRequestPtr, HttpReqCallback>> requests;
+    while (!_requestsBuffer.empty())
+    {
+        if (_requestsBuffer.front().first != req)
+            requests.push(std::move(_requestsBuffer.front()));
+        _requestsBuffer.pop();
+    }
+    _requestsBuffer.swap(requests);
+    bool sent = false;
+    while (!_pipeliningCallbacks.empty())
+    {
+        if (_pipeliningCallbacks.front().first == req)
+            sent = true;
+        else
+            requests.push(std::move(_pipeliningCallbacks.front()));
+        _pipeliningCallbacks.pop();
+    }
+    _pipeliningCallbacks.swap(requests);
+    if (!sent)
+        return;
+    // The requests pipelined behind a sent one would wait for its response,
+    // so the connection is closed and they are sent again as if the server
+    // had closed it.
+    ++_responsesOnConnection;
+    // Ignore the events of the dropped connection
+    ++_tcpClientId;
+    if (_tcpClient && _tcpClient->connection())
+        _tcpClient->connection()->forceClose();
+    onDisconnected();
+}
+
+void HttpClientImpl::closeIfIdle(double idleTimeout)
+{
+    _loop->assertInLoopThread();
+    if (_tcpClient && requestsNumber() == 0 &&
+        _lastActiveDate.after(idleTimeout) < trantor::Date::date())
+    {
+        LOG_TRACE << "Close the idle connection to " << _server.toIpPort();
+        _tcpClient.reset();
+    }
+}
+
 void HttpClientImpl::handleCookies(const HttpResponseImplPtr &resp)
 {
     _loop->assertInLoopThread();
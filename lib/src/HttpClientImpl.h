@@ -19,9 +19,11 @@
 #include <drogon/Cookie.h>
 #include <trantor/net/EventLoop.h>
 #include <trantor/net/TcpClient.h>
-#include <trantor/net/Resolver.h>
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <queue>
+#include <unordered_map>
 #include <vector>
 
 namespace drogon
@@ -38,6 +40,16 @@ class HttpClientImpl : public HttpClient,
                              const HttpReqCallback &callback) override;
     virtual void sendRequest(const HttpRequestPtr &req,
                              HttpReqCallback &&callback) override;
+    virtual void sendRequest(const HttpRequestPtr &req,
+                             const HttpReqCallback &callback,
+                             double timeout) override;
+    virtual void sendStreamRequest(
+        const HttpRequestPtr &req,
+        const HttpReqCallback &headersCallback,
+        const HttpBodyCallback &bodyCallback,
+        const std::function<void(ReqResult)> &completionCallback,
+        bool decompress = true,
+        double timeout = 0) override;
     virtual trantor::EventLoop *getLoop() override
     {
         return _loop;
@@ -73,6 +85,16 @@ class HttpClientImpl : public HttpClient,
         return _bytesReceived;
     }
 
+    /// The number of requests which are waiting for their responses, must be
+    /// called in the loop of the client.
+    size_t requestsNumber() const
+    {
+        return _pipeliningCallbacks.size() + _requestsBuffer.size();
+    }
+    /// Close the connection if no request has been sent or answered for
+    /// idleTimeout seconds, must be called in the loop of the client.
+    void closeIfIdle(double idleTimeout);
+
   private:
     std::shared_ptr<trantor::TcpClient> _tcpClient;
     trantor::EventLoop *_loop;
@@ -87,15 +109,34 @@ class HttpClientImpl : public HttpClient,
     std::queue<std::pair<HttpRequestPtr, HttpReqCallback>> _pipeliningCallbacks;
     std::queue<std::pair<HttpRequestPtr, HttpReqCallback>> _requestsBuffer;
     void onRecvMessage(const trantor::TcpConnectionPtr &, trantor::MsgBuffer *);
+    void handleResponse(HttpResponseParser &responseParser,
+                        const trantor::TcpConnectionPtr &connPtr);
+    struct StreamState;
+    void setStreamCallbacks(HttpResponseParser &responseParser,
+                            const std::shared_ptr<StreamState> &stream);
+    void abortStream(const trantor::TcpConnectionPtr &connPtr,
+                     const std::shared_ptr<StreamState> &stream);
+    // The requests whose responses are received in parts
+    std::unordered_map<HttpRequest *, std::shared_ptr<StreamState>> _streams;
     void onError(ReqResult result);
+    void onDisconnected();
+    /// Drop a timed out request, and the connection if the request has been
+    /// sent on it, so the requests behind it go out on a new connection.
+    void onRequestTimeout(const HttpRequestPtr &req);
     std::string _domain;
     size_t _pipeliningDepth = 0;
     bool _enableCookies = false;
     std::vector<Cookie> _validCookies;
-    size_t _bytesSent = 0;
-    size_t _bytesReceived = 0;
+    // Read by the pool in other threads
+    std::atomic<size_t> _bytesSent{0};
+    std::atomic<size_t> _bytesReceived{0};
     bool _dns = false;
-    std::shared_ptr<trantor::Resolver> _resolver;
+    bool _isDomainName = false;
+    // Identify the current TcpClient, so that the events of a dropped
+    // connection are ignored.
+    size_t _tcpClientId = 0;
+    size_t _responsesOnConnection = 0;
+    trantor::Date _lastActiveDate;
 };
 typedef std::shared_ptr<HttpClientImpl> HttpClientImplPtr;
 }  // namespace drogon
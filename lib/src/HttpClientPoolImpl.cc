@@ -0,0 +1,274 @@
+/**
+ *
+ *  HttpClientPoolImpl.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HttpClientPoolImpl.h"
+#include "HttpAppFrameworkImpl.h"
+#include <atomic>
+
+using namespace drogon;
+
+HttpClientPoolImpl::HttpClientPoolImpl(const std::string &hostString,
+                                       size_t connectionsPerLoop,
+                                       double idleTimeout,
+                                       trantor::EventLoop *defaultLoop)
+    : _hostString(hostString),
+      _connectionsPerLoop(connectionsPerLoop > 0 ? connectionsPerLoop : 1),
+      _idleTimeout(idleTimeout),
+      _defaultLoop(defaultLoop),
+      _loops(std::make_shared<LoopList>())
+{
+}
+
+HttpClientPoolImpl::~HttpClientPoolImpl()
+{
+    auto loops = std::atomic_load(&_loops);
+    for (auto &item : *loops)
+    {
+        if (item.second->_timerId != trantor::InvalidTimerId)
+            item.first->invalidateTimer(item.second->_timerId);
+    }
+}
+
+std::shared_ptr<HttpClientPoolImpl::LoopClients>
+HttpClientPoolImpl::loopClients(trantor::EventLoop *loop)
+{
+    auto loops = std::atomic_load(&_loops);
+    for (auto &item : *loops)
+    {
+        if (item.first == loop)
+            return item.second;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    loops = std::atomic_load(&_loops);
+    for (auto &item : *loops)
+    {
+        if (item.first == loop)
+            return item.second;
+    }
+    auto clients = std::make_shared<LoopClients>();
+    if (_idleTimeout > 0)
+    {
+        std::weak_ptr<LoopClients> weakClients = clients;
+        auto idleTimeout = _idleTimeout;
+        clients->_timerId =
+            loop->runEvery(idleTimeout / 2, [weakClients, idleTimeout]() {
+                auto clients = weakClients.lock();
+                if (!clients)
+                    return;
+                for (auto &client : clients->_clients)
+                {
+                    client->closeIfIdle(idleTimeout);
+                }
+            });
+    }
+    auto newLoops = std::make_shared<LoopList>(*loops);
+    newLoops->emplace_back(loop, clients);
+    std::atomic_store(&_loops, std::shared_ptr<const LoopList>(newLoops));
+    return clients;
+}
+
+HttpClientImplPtr HttpClientPoolImpl::chooseClient(LoopClients &clients,
+                                                   trantor::EventLoop *loop)
+{
+    HttpClientImplPtr client;
+    for (auto &c : clients._clients)
+    {
+        if (!client || c->requestsNumber() < client->requestsNumber())
+            client = c;
+    }
+    if ((!client || client->requestsNumber() > 0) &&
+        clients._clients.size() < _connectionsPerLoop)
+    {
+        client = std::make_shared<HttpClientImpl>(loop, _hostString);
+        applySettings(client);
+        // Locked for bytesSent() and bytesReceived() called in other threads
+        std::lock_guard<std::mutex> lock(_mutex);
+        clients._clients.push_back(client);
+    }
+    return client;
+}
+
+void HttpClientPoolImpl::applySettings(const HttpClientImplPtr &client)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    client->setPipeliningDepth(_pipeliningDepth);
+    client->enableCookies(_enableCookies);
+    for (auto &cookie : _cookies)
+    {
+        client->addCookie(cookie);
+    }
+}
+
+void HttpClientPoolImpl::sendRequest(const HttpRequestPtr &req,
+                                     const HttpReqCallback &callback)
+{
+    sendRequest(req, callback, 0);
+}
+
+void HttpClientPoolImpl::sendRequest(const HttpRequestPtr &req,
+                                     HttpReqCallback &&callback)
+{
+    auto loop = getLoop();
+    auto clients = loopClients(loop);
+    loop->runInLoop([thisPtr = shared_from_this(),
+                     clients,
+                     loop,
+                     req,
+                     callback = std::move(callback)]() mutable {
+        thisPtr->chooseClient(*clients, loop)
+            ->sendRequest(req, std::move(callback));
+    });
+}
+
+void HttpClientPoolImpl::sendRequest(const HttpRequestPtr &req,
+                                     const HttpReqCallback &callback,
+                                     double timeout)
+{
+    auto loop = getLoop();
+    auto clients = loopClients(loop);
+    loop->runInLoop([thisPtr = shared_from_this(),
+                     clients,
+                     loop,
+                     req,
+                     callback,
+                     timeout]() {
+        thisPtr->chooseClient(*clients, loop)
+            ->sendRequest(req, callback, timeout);
+    });
+}
+
+void HttpClientPoolImpl::sendStreamRequest(
+    const HttpRequestPtr &req,
+    const HttpReqCallback &headersCallback,
+    const HttpBodyCallback &bodyCallback,
+    const std::function<void(ReqResult)> &completionCallback,
+    bool decompress,
+    double timeout)
+{
+    auto loop = getLoop();
+    auto clients = loopClients(loop);
+    loop->runInLoop([thisPtr = shared_from_this(),
+                     clients,
+                     loop,
+                     req,
+                     headersCallback,
+                     bodyCallback,
+                     completionCallback,
+                     decompress,
+                     timeout]() {
+        thisPtr->chooseClient(*clients, loop)
+            ->sendStreamRequest(req,
+                                headersCallback,
+                                bodyCallback,
+                                completionCallback,
+                                decompress,
+                                timeout);
+    });
+}
+
+trantor::EventLoop *HttpClientPoolImpl::getLoop()
+{
+    auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    return loop ? loop : _defaultLoop;
+}
+
+void HttpClientPoolImpl::setPipeliningDepth(size_t depth)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pipeliningDepth = depth;
+    }
+    auto loops = std::atomic_load(&_loops);
+    for (auto &item : *loops)
+    {
+        item.first->runInLoop([clients = item.second, depth]() {
+            for (auto &client : clients->_clients)
+                client->setPipeliningDepth(depth);
+        });
+    }
+}
+
+void HttpClientPoolImpl::enableCookies(bool flag)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _enableCookies = flag;
+    }
+    auto loops = std::atomic_load(&_loops);
+    for (auto &item : *loops)
+    {
+        item.first->runInLoop([clients = item.second, flag]() {
+            for (auto &client : clients->_clients)
+                client->enableCookies(flag);
+        });
+    }
+}
+
+void HttpClientPoolImpl::addCookie(const std::string &key,
+                                   const std::string &value)
+{
+    addCookie(Cookie(key, value));
+}
+
+void HttpClientPoolImpl::addCookie(const Cookie &cookie)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cookies.push_back(cookie);
+    }
+    auto loops = std::atomic_load(&_loops);
+    for (auto &item : *loops)
+    {
+        item.first->runInLoop([clients = item.second, cookie]() {
+            for (auto &client : clients->_clients)
+                client->addCookie(cookie);
+        });
+    }
+}
+
+size_t HttpClientPoolImpl::bytesSent() const
+{
+    size_t bytes = 0;
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto &item : *_loops)
+    {
+        for (auto &client : item.second->_clients)
+            bytes += client->bytesSent();
+    }
+    return bytes;
+}
+
+size_t HttpClientPoolImpl::bytesReceived() const
+{
+    size_t bytes = 0;
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto &item : *_loops)
+    {
+        for (auto &client : item.second->_clients)
+            bytes += client->bytesReceived();
+    }
+    return bytes;
+}
+
+HttpClientPtr HttpClient::newHttpClientPool(const std::string &hostString,
+                                            size_t connectionsPerLoop,
+                                            double idleTimeout,
+                                            trantor::EventLoop *loop)
+{
+    return std::make_shared<HttpClientPoolImpl>(
+        hostString,
+        connectionsPerLoop,
+        idleTimeout,
+        loop == nullptr ? HttpAppFrameworkImpl::instance().getLoop() : loop);
+}
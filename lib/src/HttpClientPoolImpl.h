@@ -0,0 +1,101 @@
+/**
+ *
+ *  HttpClientPoolImpl.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include "HttpClientImpl.h"
+#include <drogon/HttpClient.h>
+#include <drogon/Cookie.h>
+#include <trantor/net/EventLoop.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace drogon
+{
+/// Keep-alive connections to one server in every event loop which sends
+/// requests
+class HttpClientPoolImpl
+    : public HttpClient,
+      public std::enable_shared_from_this<HttpClientPoolImpl>
+{
+  public:
+    HttpClientPoolImpl(const std::string &hostString,
+                       size_t connectionsPerLoop,
+                       double idleTimeout,
+                       trantor::EventLoop *defaultLoop);
+    ~HttpClientPoolImpl();
+
+    virtual void sendRequest(const HttpRequestPtr &req,
+                             const HttpReqCallback &callback) override;
+    virtual void sendRequest(const HttpRequestPtr &req,
+                             HttpReqCallback &&callback) override;
+    virtual void sendRequest(const HttpRequestPtr &req,
+                             const HttpReqCallback &callback,
+                             double timeout) override;
+    virtual void sendStreamRequest(
+        const HttpRequestPtr &req,
+        const HttpReqCallback &headersCallback,
+        const HttpBodyCallback &bodyCallback,
+        const std::function<void(ReqResult)> &completionCallback,
+        bool decompress = true,
+        double timeout = 0) override;
+
+    /// Return the loop of the current thread if it is an event loop, or the
+    /// default loop of the pool.
+    virtual trantor::EventLoop *getLoop() override;
+
+    virtual void setPipeliningDepth(size_t depth) override;
+    virtual void enableCookies(bool flag = true) override;
+    virtual void addCookie(const std::string &key,
+                           const std::string &value) override;
+    virtual void addCookie(const Cookie &cookie) override;
+
+    /// The sums of all connections in the pool
+    virtual size_t bytesSent() const override;
+    virtual size_t bytesReceived() const override;
+
+  private:
+    /// The clients in one event loop, only accessed in the loop.
+    struct LoopClients
+    {
+        std::vector<HttpClientImplPtr> _clients;
+        trantor::TimerId _timerId = trantor::InvalidTimerId;
+    };
+    typedef std::vector<
+        std::pair<trantor::EventLoop *, std::shared_ptr<LoopClients>>>
+        LoopList;
+    std::shared_ptr<LoopClients> loopClients(trantor::EventLoop *loop);
+    /// Choose the client with the fewest requests in flight, and open a new
+    /// connection if all of them are busy.
+    HttpClientImplPtr chooseClient(LoopClients &clients,
+                                   trantor::EventLoop *loop);
+    void applySettings(const HttpClientImplPtr &client);
+
+    const std::string _hostString;
+    const size_t _connectionsPerLoop;
+    const double _idleTimeout;
+    trantor::EventLoop *_defaultLoop;
+
+    mutable std::mutex _mutex;
+    /// Copied on write, so sending requests doesn't need the mutex.
+    std::shared_ptr<const LoopList> _loops;
+    size_t _pipeliningDepth = 0;
+    bool _enableCookies = false;
+    std::vector<Cookie> _cookies;
+};
+
+}  // namespace drogon
@@ -256,19 +256,17 @@ void HttpControllersRouter::route(
                         if (!binder->_filters.empty())
                         {
                             auto &filters = binder->_filters;
-                            auto callbackPtr = std::make_shared<
-                                std::function<void(const HttpResponsePtr &)>>(
-                                std::move(callback));
                             filters_function::doFilters(
                                 filters,
                                 req,
-                                callbackPtr,
-                                [=, &binder, &routerItem]() {
+                                std::move(callback),
+                                [=, &binder, &routerItem](
+                                    std::function<void(
+                                        const HttpResponsePtr &)> &&callback) {
                                     doPreHandlingAdvices(binder,
                                                          routerItem,
                                                          req,
-                                                         std::move(
-                                                             *callbackPtr));
+                                                         std::move(callback));
                                 });
                         }
                         else
@@ -281,43 +279,40 @@ void HttpControllersRouter::route(
                     }
                     else
                     {
-                        auto callbackPtr = std::make_shared<
-                            std::function<void(const HttpResponsePtr &)>>(
-                            std::move(callback));
-                        doAdvicesChain(_postRoutingAdvices,
-                                       0,
-                                       req,
-                                       callbackPtr,
-                                       [&binder,
-                                        callbackPtr,
+                        doAdvicesChain(
+                            _postRoutingAdvices,
+                            req,
+                            std::move(callback),
+                            [&binder, req, this, &routerItem](
+                                std::function<void(const HttpResponsePtr &)>
+                                    &&callback) {
+                                if (!binder->_filters.empty())
+                                {
+                                    auto &filters = binder->_filters;
+                                    filters_function::doFilters(
+                                        filters,
                                         req,
-                                        this,
-                                        &routerItem]() mutable {
-                                           if (!binder->_filters.empty())
-                                           {
-                                               auto &filters = binder->_filters;
-                                               filters_function::doFilters(
-                                                   filters,
-                                                   req,
-                                                   callbackPtr,
-                                                   [=, &binder, &routerItem]() {
-                                                       doPreHandlingAdvices(
-                                                           binder,
-                                                           routerItem,
-                                                           req,
-                                                           std::move(
-                                                               *callbackPtr));
-                                                   });
-                                           }
-                                           else
-                                           {
-                                               doPreHandlingAdvices(
-                                                   binder,
-                                                   routerItem,
-                                                   req,
-                                                   std::move(*callbackPtr));
-                                           }
-                                       });
+                                        std::move(callback),
+                                        [=, &binder, &routerItem](
+                                            std::function<void(
+                                                const HttpResponsePtr &)>
+                                                &&callback) {
+                                            doPreHandlingAdvices(
+                                                binder,
+                                                routerItem,
+                                                req,
+                                                std::move(callback));
+                                        });
+                                }
+                                else
+                                {
+                                    doPreHandlingAdvices(binder,
+                                                         routerItem,
+                                                         req,
+                                                         std::move(callback));
+                                }
+                            },
+                            false);
                     }
                 }
             }
@@ -358,7 +353,9 @@ void HttpControllersRouter::doControllerHandler(
         ctrlBinderPtr->_hasCachedResponse = false;
     }
 
-    std::vector<std::string> params(ctrlBinderPtr->_parameterPlaces.size());
+    auto &params = req->routingParameters();
+    params.clear();
+    params.resize(ctrlBinderPtr->_parameterPlaces.size());
     std::smatch r;
     if (std::regex_match(req->path(), r, routerItem._regex))
     {
@@ -373,29 +370,22 @@ void HttpControllersRouter::doControllerHandler(
     }
     if (ctrlBinderPtr->_queryParametersPlaces.size() > 0)
     {
-        auto qureyPara = req->getParameters();
-        for (auto const &parameter : qureyPara)
+        auto &queryPara = req->getParameters();
+        for (auto const &parameter : queryPara)
         {
-            if (ctrlBinderPtr->_queryParametersPlaces.find(parameter.first) !=
-                ctrlBinderPtr->_queryParametersPlaces.end())
+            auto iter =
+                ctrlBinderPtr->_queryParametersPlaces.find(parameter.first);
+            if (iter != ctrlBinderPtr->_queryParametersPlaces.end())
             {
-                auto place =
-                    ctrlBinderPtr->_queryParametersPlaces.find(parameter.first)
-                        ->second;
+                auto place = iter->second;
                 if (place > params.size())
                     params.resize(place);
                 params[place - 1] = parameter.second;
             }
         }
     }
-    std::list<std::string> paraList;
-    for (auto &p : params)  /// Use reference
-    {
-        LOG_TRACE << p;
-        paraList.push_back(std::move(p));
-    }
     ctrlBinderPtr->_binderPtr->handleHttpRequest(
-        paraList,
+        params,
         req,
         [=, callback = std::move(callback)](const HttpResponsePtr &resp) {
             if (resp->expiredTime() >= 0)
@@ -481,25 +471,18 @@ void HttpControllersRouter::doPreHandlingAdvices(
     }
     else
     {
-        auto callbackPtr =
-            std::make_shared<std::function<void(const HttpResponsePtr &)>>(
-                std::move(callback));
         doAdvicesChain(
             _preHandlingAdvices,
-            0,
             req,
-            std::make_shared<std::function<void(const HttpResponsePtr &)>>(
-                [req, callbackPtr](const HttpResponsePtr &resp) {
-                    HttpAppFrameworkImpl::instance().callCallback(req,
-                                                                  resp,
-                                                                  *callbackPtr);
-                }),
-            [this, ctrlBinderPtr, &routerItem, req, callbackPtr]() {
+            std::move(callback),
+            [this, ctrlBinderPtr, &routerItem, req](
+                std::function<void(const HttpResponsePtr &)> &&callback) {
                 doControllerHandler(ctrlBinderPtr,
                                     routerItem,
                                     req,
-                                    std::move(*callbackPtr));
-            });
+                                    std::move(callback));
+            },
+            true);
     }
 }
 
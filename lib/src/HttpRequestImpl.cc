@@ -15,6 +15,8 @@
 #include "HttpRequestImpl.h"
 #include "HttpFileUploadRequest.h"
 #include "HttpAppFrameworkImpl.h"
+#include "HttpUtils.h"
+#include "JsonCodec.h"
 
 #include <drogon/utils/Utilities.h>
 #include <fstream>
@@ -23,6 +25,24 @@
 
 using namespace drogon;
 
+namespace
+{
+// The limit of the nodes kept for the headers, cookies and parameters of the
+// next request
+const size_t kMaxSpareNodes = 64;
+
+bool equalsIgnoreCase(const string_view &str, const char *lowerCase)
+{
+    size_t i = 0;
+    for (; i < str.length() && lowerCase[i]; ++i)
+    {
+        if (tolower(str[i]) != lowerCase[i])
+            return false;
+    }
+    return i == str.length() && lowerCase[i] == 0;
+}
+}  // namespace
+
 void HttpRequestImpl::parseParameters() const
 {
     auto input = queryView();
@@ -56,7 +76,7 @@ void HttpRequestImpl::parseParameters() const
                 auto pvalue = coo.substr(epos + 1);
                 std::string pdecode = utils::urlDecode(pvalue);
                 std::string keydecode = utils::urlDecode(key);
-                _parameters[keydecode] = pdecode;
+                setItem(_parameters, keydecode, pdecode, true);
             }
             value = value.substr(pos + 1);
         }
@@ -74,7 +94,7 @@ void HttpRequestImpl::parseParameters() const
                 auto pvalue = coo.substr(epos + 1);
                 std::string pdecode = utils::urlDecode(pvalue);
                 std::string keydecode = utils::urlDecode(key);
-                _parameters[keydecode] = pdecode;
+                setItem(_parameters, keydecode, pdecode, true);
             }
         }
     }
@@ -82,14 +102,11 @@ void HttpRequestImpl::parseParameters() const
     {
         // parse json data in request
         _jsonPtr = std::make_shared<Json::Value>();
-        Json::CharReaderBuilder builder;
-        builder["collectComments"] = false;
-        JSONCPP_STRING errs;
-        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
-        if (!reader->parse(input.data(),
-                           input.data() + input.size(),
-                           _jsonPtr.get(),
-                           &errs))
+        std::string errs;
+        if (!readJson(input.data(),
+                      input.data() + input.size(),
+                      *_jsonPtr,
+                      errs))
         {
             LOG_ERROR << errs;
             _jsonPtr.reset();
@@ -136,6 +153,13 @@ void HttpRequestImpl::appendToBuffer(trantor::MsgBuffer *output) const
     {
         output->append("/");
     }
+    // A query string which hasn't been parsed into parameters is passed on
+    // as it is.
+    if (!_query.empty() && _parameters.empty())
+    {
+        output->append("?");
+        output->append(_query);
+    }
 
     std::string content;
     if (!_parameters.empty() && _contentType != CT_MULTIPART_FORM_DATA)
@@ -296,54 +320,34 @@ void HttpRequestImpl::addHeader(const char *start,
                                 const char *colon,
                                 const char *end)
 {
-    std::string field(start, colon);
     // Field name is case-insensitive.so we transform it to lower;(rfc2616-4.2)
-    std::transform(field.begin(), field.end(), field.begin(), ::tolower);
+    string_view field(start, colon - start);
     ++colon;
     while (colon < end && isspace(*colon))
     {
         ++colon;
     }
-    std::string value(colon, end);
-    while (!value.empty() && isspace(value[value.size() - 1]))
+    while (end > colon && isspace(*(end - 1)))
     {
-        value.resize(value.size() - 1);
+        --end;
     }
-    if (field.length() == 6 && field == "cookie")
+    string_view value(colon, end - colon);
+    if (field.length() == 6 && equalsIgnoreCase(field, "cookie"))
     {
-        LOG_TRACE << "cookies!!!:" << value;
-        std::string::size_type pos;
-        while ((pos = value.find(';')) != std::string::npos)
+        LOG_TRACE << "cookies!!!:" << std::string(value.data(), value.length());
+        while (!value.empty())
         {
-            std::string coo = value.substr(0, pos);
-            auto epos = coo.find('=');
-            if (epos != std::string::npos)
-            {
-                std::string cookie_name = coo.substr(0, epos);
-                std::string::size_type cpos = 0;
-                while (cpos < cookie_name.length() &&
-                       isspace(cookie_name[cpos]))
-                    cpos++;
-                cookie_name = cookie_name.substr(cpos);
-                std::string cookie_value = coo.substr(epos + 1);
-                _cookies[std::move(cookie_name)] = std::move(cookie_value);
-            }
-            value = value.substr(pos + 1);
-        }
-        if (value.length() > 0)
-        {
-            std::string &coo = value;
+            auto pos = value.find(';');
+            auto coo = value.substr(0, pos);
+            value = pos == string_view::npos ? string_view()
+                                              : value.substr(pos + 1);
             auto epos = coo.find('=');
-            if (epos != std::string::npos)
+            if (epos != string_view::npos)
             {
-                std::string cookie_name = coo.substr(0, epos);
-                std::string::size_type cpos = 0;
-                while (cpos < cookie_name.length() &&
-                       isspace(cookie_name[cpos]))
-                    cpos++;
-                cookie_name = cookie_name.substr(cpos);
-                std::string cookie_value = coo.substr(epos + 1);
-                _cookies[std::move(cookie_name)] = std::move(cookie_value);
+                auto cookieName = coo.substr(0, epos);
+                while (!cookieName.empty() && isspace(cookieName.front()))
+                    cookieName.remove_prefix(1);
+                setItem(_cookies, cookieName, coo.substr(epos + 1), true);
             }
         }
     }
@@ -352,14 +356,14 @@ void HttpRequestImpl::addHeader(const char *start,
         switch (field.length())
         {
             case 6:
-                if (field == "expect")
+                if (equalsIgnoreCase(field, "expect"))
                 {
-                    _expect = value;
+                    _expect.assign(value.data(), value.length());
                 }
                 break;
             case 10:
             {
-                if (field == "connection")
+                if (equalsIgnoreCase(field, "connection"))
                 {
                     if (_version == kHttp11)
                     {
@@ -375,16 +379,69 @@ void HttpRequestImpl::addHeader(const char *start,
             }
             break;
             case 14:
-                if (field == "content-length")
+                if (equalsIgnoreCase(field, "content-length"))
                 {
-                    _contentLen = std::stoull(value.c_str());
+                    _contentLen =
+                        std::stoull(std::string(value.data(), value.length()));
                 }
                 break;
             default:
                 break;
         }
-        _headers.emplace(std::move(field), std::move(value));
+        setItem(_headers, field, value, false, true);
+    }
+}
+
+void HttpRequestImpl::setItem(StringMap &map,
+                              const string_view &key,
+                              const string_view &value,
+                              bool overwrite,
+                              bool lowerKey) const
+{
+#ifdef __cpp_lib_node_extract
+    if (!_spareNodes.empty())
+    {
+        auto node = std::move(_spareNodes.back());
+        _spareNodes.pop_back();
+        auto &nodeKey = node.key();
+        nodeKey.assign(key.data(), key.length());
+        if (lowerKey)
+            std::transform(nodeKey.begin(),
+                           nodeKey.end(),
+                           nodeKey.begin(),
+                           tolower);
+        auto iter = map.find(nodeKey);
+        if (iter == map.end())
+        {
+            node.mapped().assign(value.data(), value.length());
+            map.insert(std::move(node));
+            return;
+        }
+        if (overwrite)
+            iter->second.assign(value.data(), value.length());
+        _spareNodes.push_back(std::move(node));
+        return;
+    }
+#endif
+    std::string mapKey(key.data(), key.length());
+    if (lowerKey)
+        std::transform(mapKey.begin(), mapKey.end(), mapKey.begin(), tolower);
+    if (overwrite)
+        map[std::move(mapKey)].assign(value.data(), value.length());
+    else
+        map.emplace(std::move(mapKey),
+                    std::string(value.data(), value.length()));
+}
+
+void HttpRequestImpl::recycleItems(StringMap &map) const
+{
+#ifdef __cpp_lib_node_extract
+    while (!map.empty() && _spareNodes.size() < kMaxSpareNodes)
+    {
+        _spareNodes.push_back(map.extract(map.begin()));
     }
+#endif
+    map.clear();
 }
 
 HttpRequestPtr HttpRequest::newHttpRequest()
@@ -406,17 +463,11 @@ HttpRequestPtr HttpRequest::newHttpFormPostRequest()
 
 HttpRequestPtr HttpRequest::newHttpJsonRequest(const Json::Value &data)
 {
-    static std::once_flag once;
-    static Json::StreamWriterBuilder builder;
-    std::call_once(once, []() {
-        builder["commentStyle"] = "None";
-        builder["indentation"] = "";
-    });
     auto req = std::make_shared<HttpRequestImpl>(nullptr);
     req->setMethod(drogon::Get);
     req->setVersion(drogon::HttpRequest::kHttp11);
     req->_contentType = CT_APPLICATION_JSON;
-    req->setContent(writeString(builder, data));
+    req->setContent(writeJson(data));
     return req;
 }
 
@@ -431,6 +482,7 @@ void HttpRequestImpl::swap(HttpRequestImpl &that) noexcept
     std::swap(_method, that._method);
     std::swap(_version, that._version);
     _path.swap(that._path);
+    _routingParameters.swap(that._routingParameters);
     _query.swap(that._query);
 
     _headers.swap(that._headers);
@@ -444,6 +496,7 @@ void HttpRequestImpl::swap(HttpRequestImpl &that) noexcept
     _date.swap(that._date);
     _content.swap(that._content);
     std::swap(_contentLen, that._contentLen);
+    _multiPartParserPtr.swap(that._multiPartParserPtr);
 }
 
 const char *HttpRequestImpl::methodString() const
@@ -551,21 +604,55 @@ HttpRequestImpl::~HttpRequestImpl()
 
 void HttpRequestImpl::reserveBodySize()
 {
-    if (_contentLen <=
-        HttpAppFrameworkImpl::instance().getClientMaxMemoryBodySize())
+    auto &app = HttpAppFrameworkImpl::instance();
+    if (_contentLen <= app.getClientMaxMemoryBodySize())
     {
         _content.reserve(_contentLen);
+        return;
+    }
+    std::string boundary;
+    if (_method == Post &&
+        MultiPartStreamParser::getBoundary(getHeaderBy("content-type"),
+                                           boundary))
+    {
+        // Write the uploaded files to the upload path directly
+        _multiPartParserPtr = std::make_unique<MultiPartStreamParser>(
+            boundary,
+            app.getClientMaxMemoryBodySize(),
+            app.isUploadMd5Enabled());
     }
     else
     {
         // Store data of body to a temperary file
-        auto tmpfile = HttpAppFrameworkImpl::instance().getUploadPath();
-        auto fileName = utils::getUuid();
-        tmpfile.append("/tmp/")
-            .append(1, fileName[0])
-            .append(1, fileName[1])
-            .append("/")
-            .append(fileName);
-        _cacheFilePtr = std::make_unique<CacheFile>(tmpfile);
+        _cacheFilePtr =
+            std::make_unique<CacheFile>(app.newTmpFilePath(), _contentLen);
     }
+}
+
+int HttpRequest::saveBodyAs(const std::string &filename) const
+{
+    auto pathAndFileName = makeSavePath(
+        filename, HttpAppFrameworkImpl::instance().getUploadPath());
+    if (pathAndFileName.empty())
+        return -1;
+    std::ofstream file(pathAndFileName, std::ios::binary);
+    if (!file.is_open())
+    {
+        LOG_ERROR << "Can't create the file " << pathAndFileName;
+        return -1;
+    }
+    file.write(bodyData(), bodyLength());
+    file.close();
+    return file ? 0 : -1;
+}
+
+int HttpRequestImpl::saveBodyAs(const std::string &filename) const
+{
+    if (!_cacheFilePtr)
+        return HttpRequest::saveBodyAs(filename);
+    auto pathAndFileName = makeSavePath(
+        filename, HttpAppFrameworkImpl::instance().getUploadPath());
+    if (pathAndFileName.empty())
+        return -1;
+    return _cacheFilePtr->linkTo(pathAndFileName);
 }
\ No newline at end of file
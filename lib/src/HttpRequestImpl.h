@@ -16,6 +16,7 @@
 
 #include "HttpUtils.h"
 #include "CacheFile.h"
+#include "MultiPartStreamParser.h"
 #include <drogon/utils/Utilities.h>
 #include <drogon/HttpRequest.h>
 #include <drogon/utils/Utilities.h>
@@ -28,6 +29,7 @@
 #include <string>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 #include <assert.h>
 #include <stdio.h>
 
@@ -51,21 +53,24 @@ class HttpRequestImpl : public HttpRequest
         _method = Invalid;
         _version = kUnknown;
         _contentLen = 0;
-        _headers.clear();
-        _cookies.clear();
+        recycleItems(_headers);
+        recycleItems(_cookies);
         _flagForParsingParameters = false;
         _path.clear();
         _matchedPathPattern = "";
+        _routingParameters.clear();
         _query.clear();
-        _parameters.clear();
+        recycleItems(_parameters);
         _jsonPtr.reset();
         _sessionPtr.reset();
         _cacheFilePtr.reset();
+        _multiPartParserPtr.reset();
         _expect.clear();
         _content.clear();
         _contentType = CT_TEXT_PLAIN;
         _contentTypeString.clear();
         _keepAlive = true;
+        _arena.reset();
     }
     trantor::EventLoop *getLoop()
     {
@@ -176,8 +181,24 @@ class HttpRequestImpl : public HttpRequest
         return _content.length();
     }
 
-    void appendToBody(const char *data, size_t length)
+    virtual int saveBodyAs(const std::string &filename) const override;
+
+    virtual int bodyFileDescriptor() const override
+    {
+        if (_cacheFilePtr)
+        {
+            return _cacheFilePtr->fd();
+        }
+        return -1;
+    }
+
+    // Return false if the body is malformed
+    bool appendToBody(const char *data, size_t length)
     {
+        if (_multiPartParserPtr)
+        {
+            return _multiPartParserPtr->parse(data, length);
+        }
         if (_cacheFilePtr)
         {
             _cacheFilePtr->append(data, length);
@@ -186,10 +207,18 @@ class HttpRequestImpl : public HttpRequest
         {
             _content.append(data, length);
         }
+        return true;
     }
 
     void reserveBodySize();
 
+    /// The parser of a large multipart/form-data body, which is parsed while
+    /// it's received instead of being stored, so the body is empty.
+    const MultiPartStreamParser *multiPartStreamParser() const
+    {
+        return _multiPartParserPtr.get();
+    }
+
     string_view queryView() const
     {
         if (!_query.empty())
@@ -292,7 +321,7 @@ class HttpRequestImpl : public HttpRequest
                               const std::string &value) override
     {
         _flagForParsingParameters = true;
-        _parameters[key] = value;
+        setItem(_parameters, key, value, true);
     }
 
     const std::string &getContent() const
@@ -320,17 +349,30 @@ class HttpRequestImpl : public HttpRequest
     virtual void addHeader(const std::string &key,
                            const std::string &value) override
     {
-        _headers[key] = value;
+        setItem(_headers, key, value, true);
     }
 
     virtual void addCookie(const std::string &key,
                            const std::string &value) override
     {
-        _cookies[key] = value;
+        setItem(_cookies, key, value, true);
+    }
+
+    virtual Arena &arena() override
+    {
+        return _arena;
     }
 
     void appendToBuffer(trantor::MsgBuffer *output) const;
 
+    /// Set the content type line of a request to be sent, such as
+    /// "Content-Type: text/plain\r\n".
+    void setCustomContentTypeString(std::string &&typeString)
+    {
+        _contentType = CT_NONE;
+        setContentType(std::move(typeString));
+    }
+
     virtual SessionPtr session() const override
     {
         return _sessionPtr;
@@ -379,6 +421,12 @@ class HttpRequestImpl : public HttpRequest
     {
         _matchedPathPattern = pathPattern;
     }
+    /// The parameters of the handler, they are kept in the request because
+    /// the string_view arguments refer to them.
+    std::vector<std::string> &routingParameters()
+    {
+        return _routingParameters;
+    }
     const std::string &expect() const
     {
         return _expect;
@@ -401,6 +449,18 @@ class HttpRequestImpl : public HttpRequest
     }
 
   private:
+    typedef std::unordered_map<std::string, std::string> StringMap;
+    /// Insert the item to the map, or assign the value if the key exists and
+    /// overwrite is true. A node kept by recycleItems() is used if there is
+    /// one.
+    void setItem(StringMap &map,
+                 const string_view &key,
+                 const string_view &value,
+                 bool overwrite,
+                 bool lowerKey = false) const;
+    /// Clear the map and keep its nodes for the next request, so a pooled
+    /// request doesn't allocate the nodes and strings again.
+    void recycleItems(StringMap &map) const;
     void parseParameters() const;
     void parseParametersOnce() const
     {
@@ -417,6 +477,7 @@ class HttpRequestImpl : public HttpRequest
     Version _version;
     std::string _path;
     string_view _matchedPathPattern = "";
+    std::vector<std::string> _routingParameters;
     std::string _query;
     std::unordered_map<std::string, std::string> _headers;
     std::unordered_map<std::string, std::string> _cookies;
@@ -427,8 +488,13 @@ class HttpRequestImpl : public HttpRequest
     trantor::InetAddress _local;
     trantor::Date _date;
     std::unique_ptr<CacheFile> _cacheFilePtr;
+    std::unique_ptr<MultiPartStreamParser> _multiPartParserPtr;
     std::string _expect;
     bool _keepAlive = true;
+#ifdef __cpp_lib_node_extract
+    mutable std::vector<StringMap::node_type> _spareNodes;
+#endif
+    Arena _arena;
 
   protected:
     std::string _content;
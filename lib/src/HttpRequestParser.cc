@@ -295,15 +295,21 @@ bool HttpRequestParser::parseRequest(MsgBuffer *buf)
             if (_request->_contentLen >= buf->readableBytes())
             {
                 _request->_contentLen -= buf->readableBytes();
-                _request->appendToBody(buf->peek(), buf->readableBytes());
+                ok = _request->appendToBody(buf->peek(), buf->readableBytes());
                 buf->retrieveAll();
             }
             else
             {
-                _request->appendToBody(buf->peek(), _request->_contentLen);
+                ok = _request->appendToBody(buf->peek(), _request->_contentLen);
                 buf->retrieve(_request->_contentLen);
                 _request->_contentLen = 0;
             }
+            if (!ok)
+            {
+                buf->retrieveAll();
+                shutdownConnection(k400BadRequest);
+                return false;
+            }
             if (_request->_contentLen == 0)
             {
                 _state = HttpRequestParseState_GotAll;
@@ -114,6 +114,21 @@ class HttpRequestParser : public trantor::NonCopyable,
         }
         return *_responseBuffer;
     }
+    /// Return true if the body of a streaming response is being sent, then
+    /// the next responses are held in getResponsesAfterStream().
+    bool isStreaming() const
+    {
+        return _isStreaming;
+    }
+    void setStreaming(bool on)
+    {
+        _isStreaming = on;
+    }
+    std::vector<std::pair<HttpResponsePtr, bool>> &getResponsesAfterStream()
+    {
+        assert(_loop->isInLoopThread());
+        return _responsesAfterStream;
+    }
     std::vector<HttpRequestImplPtr> &getRequestBuffer()
     {
         assert(_loop->isInLoopThread());
@@ -143,6 +158,8 @@ class HttpRequestParser : public trantor::NonCopyable,
     std::unique_ptr<std::vector<std::pair<HttpResponsePtr, bool>>>
         _responseBuffer;
     std::unique_ptr<std::vector<HttpRequestImplPtr>> _requestBuffer;
+    bool _isStreaming = false;
+    std::vector<std::pair<HttpResponsePtr, bool>> _responsesAfterStream;
     std::vector<HttpRequestImplPtr> _requestsPool;
 };
 
@@ -15,6 +15,7 @@
 #include "HttpResponseImpl.h"
 #include "HttpAppFrameworkImpl.h"
 #include "HttpUtils.h"
+#include "JsonCodec.h"
 #include <drogon/HttpViewData.h>
 #include <fstream>
 #include <memory>
@@ -53,14 +54,8 @@ HttpResponsePtr HttpResponse::newHttpResponse()
 
 HttpResponsePtr HttpResponse::newHttpJsonResponse(const Json::Value &data)
 {
-    static std::once_flag once;
-    static Json::StreamWriterBuilder builder;
-    std::call_once(once, []() {
-        builder["commentStyle"] = "None";
-        builder["indentation"] = "";
-    });
     auto res = std::make_shared<HttpResponseImpl>(k200OK, CT_APPLICATION_JSON);
-    res->setBody(writeString(builder, data));
+    res->setBody(writeJson(data));
     return res;
 }
 
@@ -99,6 +94,21 @@ HttpResponsePtr HttpResponse::newHttpViewResponse(const std::string &viewName,
     return genHttpResponse(viewName, data);
 }
 
+HttpResponsePtr HttpResponse::newStreamViewResponse(const std::string &viewName,
+                                                    const HttpViewData &data)
+{
+    auto templ = DrTemplateBase::newTemplate(viewName);
+    if (!templ)
+        return drogon::HttpResponse::newNotFoundResponse();
+    auto resp =
+        newStreamResponse([templ, data](const ResponseStreamPtr &stream) {
+            templ->streamText(data, stream);
+            stream->close();
+        });
+    resp->setContentTypeCode(CT_TEXT_HTML);
+    return resp;
+}
+
 HttpResponsePtr HttpResponse::newFileResponse(
     const std::string &fullPath,
     const std::string &attachmentFileName,
@@ -157,6 +167,14 @@ HttpResponsePtr HttpResponse::newFileResponse(
     return resp;
 }
 
+HttpResponsePtr HttpResponse::newStreamResponse(
+    const std::function<void(const ResponseStreamPtr &)> &callback)
+{
+    auto resp = std::make_shared<HttpResponseImpl>();
+    resp->setStreamCallback(callback);
+    return resp;
+}
+
 void HttpResponseImpl::makeHeaderString(
     const std::shared_ptr<std::string> &headerStringPtr) const
 {
@@ -167,7 +185,14 @@ void HttpResponseImpl::makeHeaderString(
     if (!_statusMessage.empty())
         headerStringPtr->append(_statusMessage.data(), _statusMessage.length());
     headerStringPtr->append("\r\n");
-    if (_sendfileName.empty())
+    if (_streamCallback)
+    {
+        len = _streamChunked ? snprintf(buf,
+                                        sizeof buf,
+                                        "Transfer-Encoding: chunked\r\n")
+                             : 0;
+    }
+    else if (_sendfileName.empty())
     {
         long unsigned int bodyLength =
             _bodyPtr ? _bodyPtr->length()
@@ -232,7 +257,15 @@ void HttpResponseImpl::renderToBuffer(trantor::MsgBuffer &buffer) const
         if (!_statusMessage.empty())
             buffer.append(_statusMessage.data(), _statusMessage.length());
         buffer.append("\r\n");
-        if (_sendfileName.empty())
+        if (_streamCallback)
+        {
+            len = _streamChunked
+                      ? snprintf(buf,
+                                 sizeof buf,
+                                 "Transfer-Encoding: chunked\r\n")
+                      : 0;
+        }
+        else if (_sendfileName.empty())
         {
             long unsigned int bodyLength =
                 _bodyPtr ? _bodyPtr->length()
@@ -539,6 +572,8 @@ void HttpResponseImpl::swap(HttpResponseImpl &that) noexcept
     swap(_closeConnection, that._closeConnection);
     _bodyPtr.swap(that._bodyPtr);
     _bodyViewPtr.swap(that._bodyViewPtr);
+    _streamCallback.swap(that._streamCallback);
+    swap(_streamChunked, that._streamChunked);
     swap(_leftBodyLength, that._leftBodyLength);
     swap(_currentChunkLength, that._currentChunkLength);
     swap(_contentType, that._contentType);
@@ -567,16 +602,13 @@ void HttpResponseImpl::parseJson() const
 {
     // parse json data in reponse
     _jsonPtr = std::make_shared<Json::Value>();
-    Json::CharReaderBuilder builder;
-    builder["collectComments"] = false;
-    JSONCPP_STRING errs;
-    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    std::string errs;
     if (_bodyPtr)
     {
-        if (!reader->parse(_bodyPtr->data(),
-                           _bodyPtr->data() + _bodyPtr->size(),
-                           _jsonPtr.get(),
-                           &errs))
+        if (!readJson(_bodyPtr->data(),
+                      _bodyPtr->data() + _bodyPtr->size(),
+                      *_jsonPtr,
+                      errs))
         {
             LOG_ERROR << errs;
             LOG_ERROR << "body: " << *_bodyPtr;
@@ -585,10 +617,10 @@ void HttpResponseImpl::parseJson() const
     }
     else if (_bodyViewPtr)
     {
-        if (!reader->parse(_bodyViewPtr->data(),
-                           _bodyViewPtr->data() + _bodyViewPtr->size(),
-                           _jsonPtr.get(),
-                           &errs))
+        if (!readJson(_bodyViewPtr->data(),
+                      _bodyViewPtr->data() + _bodyViewPtr->size(),
+                      *_jsonPtr,
+                      errs))
         {
             LOG_ERROR << errs;
             _jsonPtr.reset();
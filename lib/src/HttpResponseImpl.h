@@ -299,6 +299,26 @@ class HttpResponseImpl : public HttpResponse
     {
         _sendfileName = filename;
     }
+    const std::function<void(const ResponseStreamPtr &)> &streamCallback()
+        const
+    {
+        return _streamCallback;
+    }
+    void setStreamCallback(
+        const std::function<void(const ResponseStreamPtr &)> &callback)
+    {
+        _streamCallback = callback;
+    }
+    /// The body of a streaming response is sent in chunks, or until the
+    /// connection is closed for HTTP/1.0 clients.
+    bool isStreamChunked() const
+    {
+        return _streamChunked;
+    }
+    void setStreamChunked(bool chunked)
+    {
+        _streamChunked = chunked;
+    }
     void makeHeaderString()
     {
         _fullHeaderString = std::make_shared<std::string>();
@@ -350,6 +370,8 @@ class HttpResponseImpl : public HttpResponse
     std::shared_ptr<string_view> _bodyViewPtr;
     ssize_t _expriedTime = -1;
     std::string _sendfileName;
+    std::function<void(const ResponseStreamPtr &)> _streamCallback;
+    bool _streamChunked = true;
     mutable std::shared_ptr<Json::Value> _jsonPtr;
 
     std::shared_ptr<std::string> _fullHeaderString;
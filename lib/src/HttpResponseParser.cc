@@ -25,6 +25,33 @@ void HttpResponseParser::reset()
     _state = HttpResponseParseState::kExpectResponseLine;
     _response.reset(new HttpResponseImpl);
     _parseResponseForHeadMethod = false;
+    _headersCallback = nullptr;
+    _bodyCallback = nullptr;
+}
+
+bool HttpResponseParser::parseResponseOnClose()
+{
+    if (_state == HttpResponseParseState::kExpectClose)
+    {
+        _state = HttpResponseParseState::kGotAll;
+        return true;
+    }
+    return false;
+}
+
+void HttpResponseParser::appendBody(const char *data, size_t length)
+{
+    if (_bodyCallback)
+    {
+        if (length > 0)
+            _bodyCallback(data, length);
+        return;
+    }
+    if (!_response->_bodyPtr)
+    {
+        _response->_bodyPtr = std::make_shared<std::string>();
+    }
+    _response->_bodyPtr->append(data, length);
 }
 
 HttpResponseParser::HttpResponseParser()
@@ -153,6 +180,10 @@ bool HttpResponseParser::parseResponse(MsgBuffer *buf)
                         _state = HttpResponseParseState::kGotAll;
                         hasMore = false;
                     }
+                    if (_headersCallback)
+                    {
+                        _headersCallback();
+                    }
                 }
                 buf->retrieveUntil(crlf + 2);
             }
@@ -173,22 +204,15 @@ bool HttpResponseParser::parseResponse(MsgBuffer *buf)
                 }
                 break;
             }
-            if (!_response->_bodyPtr)
-            {
-                _response->_bodyPtr = std::make_shared<std::string>();
-            }
             if (_response->_leftBodyLength >= buf->readableBytes())
             {
                 _response->_leftBodyLength -= buf->readableBytes();
-
-                _response->_bodyPtr->append(
-                    std::string(buf->peek(), buf->readableBytes()));
+                appendBody(buf->peek(), buf->readableBytes());
                 buf->retrieveAll();
             }
             else
             {
-                _response->_bodyPtr->append(
-                    std::string(buf->peek(), _response->_leftBodyLength));
+                appendBody(buf->peek(), _response->_leftBodyLength);
                 buf->retrieve(_response->_leftBodyLength);
                 _response->_leftBodyLength = 0;
             }
@@ -203,8 +227,7 @@ bool HttpResponseParser::parseResponse(MsgBuffer *buf)
         }
         else if (_state == HttpResponseParseState::kExpectClose)
         {
-            _response->_bodyPtr->append(
-                std::string(buf->peek(), buf->readableBytes()));
+            appendBody(buf->peek(), buf->readableBytes());
             buf->retrieveAll();
             break;
         }
@@ -237,29 +260,32 @@ bool HttpResponseParser::parseResponse(MsgBuffer *buf)
         else if (_state == HttpResponseParseState::kExpectChunkBody)
         {
             // LOG_TRACE<<"expect chunk len="<<_response->_currentChunkLength;
-            if (buf->readableBytes() >= (_response->_currentChunkLength + 2))
+            // A chunk is passed on as it arrives instead of being buffered
+            // until it is complete.
+            if (_response->_currentChunkLength > 0)
             {
-                if (*(buf->peek() + _response->_currentChunkLength) == '\r' &&
-                    *(buf->peek() + _response->_currentChunkLength + 1) == '\n')
-                {
-                    _response->_bodyPtr->append(
-                        std::string(buf->peek(),
-                                    _response->_currentChunkLength));
-                    buf->retrieve(_response->_currentChunkLength + 2);
-                    _response->_currentChunkLength = 0;
-                    _state = HttpResponseParseState::kExpectChunkLen;
-                }
-                else
-                {
-                    // error!
-                    buf->retrieveAll();
-                    return false;
-                }
+                auto length = (std::min)(buf->readableBytes(),
+                                         _response->_currentChunkLength);
+                appendBody(buf->peek(), length);
+                buf->retrieve(length);
+                _response->_currentChunkLength -= length;
             }
-            else
+            if (_response->_currentChunkLength > 0 ||
+                buf->readableBytes() < 2)
             {
                 hasMore = false;
             }
+            else if (*(buf->peek()) == '\r' && *(buf->peek() + 1) == '\n')
+            {
+                buf->retrieve(2);
+                _state = HttpResponseParseState::kExpectChunkLen;
+            }
+            else
+            {
+                // error!
+                buf->retrieveAll();
+                return false;
+            }
         }
         else if (_state == HttpResponseParseState::kExpectLastEmptyChunk)
         {
@@ -18,6 +18,7 @@
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/TcpConnection.h>
 #include <trantor/utils/MsgBuffer.h>
+#include <functional>
 #include <list>
 #include <mutex>
 
@@ -57,6 +58,28 @@ class HttpResponseParser : public trantor::NonCopyable
 
     void reset();
 
+    /// Pass the body of the current response to the bodyCallback as it is
+    /// received instead of storing it in the response.
+    /**
+     * The headersCallback is called after the headers are parsed, before any
+     * part of the body is passed.
+     */
+    void setStreamCallbacks(
+        std::function<void()> &&headersCallback,
+        std::function<void(const char *, size_t)> &&bodyCallback)
+    {
+        _headersCallback = std::move(headersCallback);
+        _bodyCallback = std::move(bodyCallback);
+    }
+    bool isStreaming() const
+    {
+        return (bool)_bodyCallback;
+    }
+
+    /// Called when the connection is closed, return true if it completes the
+    /// response whose body is delimited by the end of the connection.
+    bool parseResponseOnClose();
+
     const HttpResponseImplPtr &responseImpl() const
     {
         return _response;
@@ -64,10 +87,13 @@ class HttpResponseParser : public trantor::NonCopyable
 
   private:
     bool processResponseLine(const char *begin, const char *end);
+    void appendBody(const char *data, size_t length);
 
     HttpResponseParseState _state;
     HttpResponseImplPtr _response;
     bool _parseResponseForHeadMethod = false;
+    std::function<void()> _headersCallback;
+    std::function<void(const char *, size_t)> _bodyCallback;
 };
 
 }  // namespace drogon
@@ -22,6 +22,7 @@
 #include <drogon/HttpResponse.h>
 #include <drogon/utils/Utilities.h>
 #include <functional>
+#include <mutex>
 #include <trantor/utils/Logger.h>
 
 using namespace std::placeholders;
@@ -29,6 +30,96 @@ using namespace drogon;
 using namespace trantor;
 namespace drogon
 {
+/// The body of a streaming response, sent in chunks or, for HTTP/1.0
+/// clients, until the connection is closed
+class ResponseStreamImpl : public ResponseStream
+{
+  public:
+    ResponseStreamImpl(const TcpConnectionPtr &conn,
+                       bool chunked,
+                       std::function<void()> &&finishCallback)
+        : _conn(conn),
+          _chunked(chunked),
+          _finishCallback(std::move(finishCallback))
+    {
+    }
+    ~ResponseStreamImpl()
+    {
+        close();
+    }
+    virtual bool send(const char *data, size_t length) override
+    {
+        // The check and the send must not be split by close() in another
+        // thread, or a chunk could follow the last one.
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_finished || !_conn->connected())
+            return false;
+        // An empty chunk would end the body
+        if (length == 0)
+            return true;
+        if (!_chunked)
+        {
+            _conn->send(data, length);
+            return true;
+        }
+        char header[32];
+        auto headerLength = snprintf(header, sizeof header, "%zx\r\n", length);
+        std::string chunk;
+        chunk.reserve(headerLength + length + 2);
+        chunk.append(header, headerLength);
+        chunk.append(data, length);
+        chunk.append("\r\n");
+        _conn->send(std::move(chunk));
+        return true;
+    }
+    virtual void close() override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_finished)
+            return;
+        _finished = true;
+        // Queued after the chunks sent from other threads, which are queued
+        // to the loop too.
+        _conn->getLoop()->queueInLoop([conn = _conn,
+                                       chunked = _chunked,
+                                       finishCallback =
+                                           std::move(_finishCallback)]() {
+            if (chunked)
+                conn->send("0\r\n\r\n", 5);
+            finishCallback();
+        });
+    }
+    virtual void abort() override
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_finished)
+            return;
+        _finished = true;
+        _conn->forceClose();
+    }
+
+  private:
+    TcpConnectionPtr _conn;
+    bool _chunked;
+    std::function<void()> _finishCallback;
+    std::mutex _mutex;
+    bool _finished = false;
+};
+
+/// HTTP/1.0 clients don't know the chunked encoding, the body of a streaming
+/// response is delimited by closing the connection.
+static void setStreamFraming(const HttpRequestImplPtr &req,
+                             const HttpResponsePtr &response)
+{
+    auto respImplPtr = static_cast<HttpResponseImpl *>(response.get());
+    if (respImplPtr->streamCallback() &&
+        req->version() == HttpRequest::kHttp10)
+    {
+        respImplPtr->setStreamChunked(false);
+        respImplPtr->setCloseConnection(true);
+    }
+}
+
 static HttpResponsePtr getCompressedResponse(const HttpRequestImplPtr &req,
                                              const HttpResponsePtr &response,
                                              bool isHeadMethod)
@@ -127,6 +218,8 @@ HttpServer::HttpServer(
         std::bind(&HttpServer::onConnection, this, _1));
     _server.setRecvMessageCallback(
         std::bind(&HttpServer::onMessage, this, _1, _2));
+    _server.setWriteCompleteCallback(
+        std::bind(&HttpServer::onWriteComplete, this, _1));
 }
 
 HttpServer::~HttpServer()
@@ -165,6 +258,17 @@ void HttpServer::onConnection(const TcpConnectionPtr &conn)
     }
 }
 
+void HttpServer::onWriteComplete(const TcpConnectionPtr &conn)
+{
+    // Only WebSocket connections with a send queue wait for the output
+    // buffers to be drained.
+    if (!conn->hasContext())
+        return;
+    auto requestParser = conn->getContext<HttpRequestParser>();
+    if (requestParser && requestParser->webSocketConn())
+        requestParser->webSocketConn()->onWriteComplete();
+}
+
 void HttpServer::onMessage(const TcpConnectionPtr &conn, MsgBuffer *buf)
 {
     if (!conn->hasContext())
@@ -291,6 +395,7 @@ void HttpServer::onRequests(
                 auto resp = advice(req);
                 if (resp)
                 {
+                    setStreamFraming(req, resp);
                     if (!syncFlag)
                     {
                         requestParser->getResponseBuffer().emplace_back(
@@ -327,6 +432,7 @@ void HttpServer::onRequests(
                 if (!conn->connected())
                     return;
                 response->setCloseConnection(_close);
+                setStreamFraming(req, response);
                 auto newResp =
                     getCompressedResponse(req, response, isHeadMethod);
                 if (conn->getLoop()->isInLoopThread())
@@ -372,7 +478,7 @@ void HttpServer::onRequests(
                             else
                                 break;
                         }
-                        sendResponses(conn, resps, requestParser->getBuffer());
+                        sendResponses(conn, resps, requestParser);
                     }
                     else
                     {
@@ -410,9 +516,7 @@ void HttpServer::onRequests(
                                     else
                                         break;
                                 }
-                                sendResponses(conn,
-                                              resps,
-                                              requestParser->getBuffer());
+                                sendResponses(conn, resps, requestParser);
                             }
                             else
                             {
@@ -433,9 +537,7 @@ void HttpServer::onRequests(
     *loopFlagPtr = false;
     if (conn->connected() && !requestParser->getResponseBuffer().empty())
     {
-        sendResponses(conn,
-                      requestParser->getResponseBuffer(),
-                      requestParser->getBuffer());
+        sendResponses(conn, requestParser->getResponseBuffer(), requestParser);
         requestParser->getResponseBuffer().clear();
     }
 }
@@ -471,18 +573,31 @@ void HttpServer::sendResponse(const TcpConnectionPtr &conn,
 void HttpServer::sendResponses(
     const TcpConnectionPtr &conn,
     const std::vector<std::pair<HttpResponsePtr, bool>> &responses,
-    trantor::MsgBuffer &buffer)
+    const std::shared_ptr<HttpRequestParser> &requestParser)
 {
     conn->getLoop()->assertInLoopThread();
     if (responses.empty())
         return;
-    if (responses.size() == 1)
+    if (requestParser->isStreaming())
+    {
+        // Sent after the body of the streaming response
+        auto &heldResponses = requestParser->getResponsesAfterStream();
+        heldResponses.insert(heldResponses.end(),
+                             responses.begin(),
+                             responses.end());
+        return;
+    }
+    if (responses.size() == 1 &&
+        !static_cast<HttpResponseImpl *>(responses[0].first.get())
+             ->streamCallback())
     {
         sendResponse(conn, responses[0].first, responses[0].second);
         return;
     }
-    for (auto const &resp : responses)
+    auto &buffer = requestParser->getBuffer();
+    for (size_t i = 0; i < responses.size(); ++i)
     {
+        auto const &resp = responses[i];
         auto respImplPtr = static_cast<HttpResponseImpl *>(resp.first.get());
         if (!resp.second)
         {
@@ -495,6 +610,15 @@ void HttpServer::sendResponses(
                 buffer.retrieveAll();
                 conn->sendFile(sendfileName.c_str());
             }
+            else if (respImplPtr->streamCallback())
+            {
+                conn->send(buffer);
+                buffer.retrieveAll();
+                requestParser->getResponsesAfterStream().assign(
+                    responses.begin() + i + 1, responses.end());
+                startStream(conn, resp.first, requestParser);
+                return;
+            }
         }
         else
         {
@@ -518,3 +642,27 @@ void HttpServer::sendResponses(
     }
     buffer.retrieveAll();
 }
+
+void HttpServer::startStream(
+    const TcpConnectionPtr &conn,
+    const HttpResponsePtr &response,
+    const std::shared_ptr<HttpRequestParser> &requestParser)
+{
+    requestParser->setStreaming(true);
+    bool closeConnection = response->ifCloseConnection();
+    auto stream = std::make_shared<ResponseStreamImpl>(
+        conn,
+        static_cast<HttpResponseImpl *>(response.get())->isStreamChunked(),
+        [this, conn, requestParser, closeConnection]() {
+            requestParser->setStreaming(false);
+            if (closeConnection)
+            {
+                conn->shutdown();
+                return;
+            }
+            std::vector<std::pair<HttpResponsePtr, bool>> responses;
+            responses.swap(requestParser->getResponsesAfterStream());
+            sendResponses(conn, responses, requestParser);
+        });
+    static_cast<HttpResponseImpl *>(response.get())->streamCallback()(stream);
+}
@@ -84,6 +84,7 @@ class HttpServer : trantor::NonCopyable
   private:
     void onConnection(const trantor::TcpConnectionPtr &conn);
     void onMessage(const trantor::TcpConnectionPtr &, trantor::MsgBuffer *);
+    void onWriteComplete(const trantor::TcpConnectionPtr &conn);
     void onRequests(const trantor::TcpConnectionPtr &,
                     const std::vector<HttpRequestImplPtr> &,
                     const std::shared_ptr<HttpRequestParser> &);
@@ -93,7 +94,10 @@ class HttpServer : trantor::NonCopyable
     void sendResponses(
         const trantor::TcpConnectionPtr &conn,
         const std::vector<std::pair<HttpResponsePtr, bool>> &responses,
-        trantor::MsgBuffer &buffer);
+        const std::shared_ptr<HttpRequestParser> &requestParser);
+    void startStream(const trantor::TcpConnectionPtr &conn,
+                     const HttpResponsePtr &response,
+                     const std::shared_ptr<HttpRequestParser> &requestParser);
     trantor::TcpServer _server;
     HttpAsyncCallback _httpAsyncCallback;
     WebSocketNewAsyncCallback _newWebsocketCallback;
@@ -126,15 +126,17 @@ void HttpSimpleControllersRouter::route(
         {
             if (!filters.empty())
             {
-                auto callbackPtr = std::make_shared<
-                    std::function<void(const HttpResponsePtr &)>>(
-                    std::move(callback));
                 filters_function::doFilters(
-                    filters, req, callbackPtr, [=, &binder]() mutable {
+                    filters,
+                    req,
+                    std::move(callback),
+                    [this, req, &ctrlInfo, &binder](
+                        std::function<void(const HttpResponsePtr &)>
+                            &&callback) {
                         doPreHandlingAdvices(binder,
                                              ctrlInfo,
                                              req,
-                                             std::move(*callbackPtr));
+                                             std::move(callback));
                     });
             }
             else
@@ -148,28 +150,25 @@ void HttpSimpleControllersRouter::route(
         }
         else
         {
-            auto callbackPtr =
-                std::make_shared<std::function<void(const HttpResponsePtr &)>>(
-                    std::move(callback));
             doAdvicesChain(
                 _postRoutingAdvices,
-                0,
                 req,
-                callbackPtr,
-                [callbackPtr,
-                 &filters,
-                 req,
-                 &ctrlInfo,
-                 this,
-                 &binder]() mutable {
+                std::move(callback),
+                [&filters, req, &ctrlInfo, this, &binder](
+                    std::function<void(const HttpResponsePtr &)> &&callback) {
                     if (!filters.empty())
                     {
                         filters_function::doFilters(
-                            filters, req, callbackPtr, [=, &binder]() mutable {
+                            filters,
+                            req,
+                            std::move(callback),
+                            [this, req, &ctrlInfo, &binder](
+                                std::function<void(const HttpResponsePtr &)>
+                                    &&callback) {
                                 doPreHandlingAdvices(binder,
                                                      ctrlInfo,
                                                      req,
-                                                     std::move(*callbackPtr));
+                                                     std::move(callback));
                             });
                     }
                     else
@@ -177,9 +176,10 @@ void HttpSimpleControllersRouter::route(
                         doPreHandlingAdvices(binder,
                                              ctrlInfo,
                                              req,
-                                             std::move(*callbackPtr));
+                                             std::move(callback));
                     }
-                });
+                },
+                false);
         }
         return;
     }
@@ -355,25 +355,18 @@ void HttpSimpleControllersRouter::doPreHandlingAdvices(
     }
     else
     {
-        auto callbackPtr =
-            std::make_shared<std::function<void(const HttpResponsePtr &)>>(
-                std::move(callback));
         doAdvicesChain(
             _preHandlingAdvices,
-            0,
             req,
-            std::make_shared<std::function<void(const HttpResponsePtr &)>>(
-                [req, callbackPtr](const HttpResponsePtr &resp) {
-                    HttpAppFrameworkImpl::instance().callCallback(req,
-                                                                  resp,
-                                                                  *callbackPtr);
-                }),
-            [this, ctrlBinderPtr, &routerItem, req, callbackPtr]() {
+            std::move(callback),
+            [this, ctrlBinderPtr, &routerItem, req](
+                std::function<void(const HttpResponsePtr &)> &&callback) {
                 doControllerHandler(ctrlBinderPtr,
                                     routerItem,
                                     req,
-                                    std::move(*callbackPtr));
-            });
+                                    std::move(callback));
+            },
+            true);
     }
 }
 
@@ -15,6 +15,7 @@
 #include "HttpUtils.h"
 #include <drogon/utils/Utilities.h>
 #include <trantor/utils/Logger.h>
+#include <assert.h>
 
 namespace drogon
 {
@@ -488,4 +489,33 @@ ContentType getContentType(const std::string &fileName)
     }
 }
 
+std::string makeSavePath(const std::string &filename,
+                         const std::string &uploadPath)
+{
+    assert(!filename.empty());
+    auto pathAndFileName = filename;
+    if (filename[0] == '/' ||
+        (filename.length() >= 2 && filename[0] == '.' && filename[1] == '/') ||
+        (filename.length() >= 3 && filename[0] == '.' && filename[1] == '.' &&
+         filename[2] == '/'))
+    {
+        // Absolute or relative path
+    }
+    else
+    {
+        if (uploadPath[uploadPath.length() - 1] == '/')
+            pathAndFileName = uploadPath + filename;
+        else
+            pathAndFileName = uploadPath + "/" + filename;
+    }
+    auto pathPos = pathAndFileName.rfind('/');
+    if (pathPos != std::string::npos)
+    {
+        std::string path = pathAndFileName.substr(0, pathPos);
+        if (utils::createPath(path) < 0)
+            return std::string();
+    }
+    return pathAndFileName;
+}
+
 }  // namespace drogon
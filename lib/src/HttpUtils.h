@@ -24,5 +24,11 @@ namespace drogon
 const string_view &webContentTypeToString(ContentType contenttype);
 const string_view &statusCodeToString(int code);
 ContentType getContentType(const std::string &fileName);
+/// Resolve the path of a file saved by HttpFile::saveAs() or
+/// HttpRequest::saveBodyAs() and create its directory, return an empty
+/// string if the directory can't be created. A file name which isn't
+/// prefixed with "/", "./" or "../" is relative to the upload path.
+std::string makeSavePath(const std::string &filename,
+                         const std::string &uploadPath);
 
 }  // namespace drogon
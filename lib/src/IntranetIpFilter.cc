@@ -15,15 +15,9 @@
 #include "HttpResponseImpl.h"
 #include <drogon/IntranetIpFilter.h>
 using namespace drogon;
-void IntranetIpFilter::doFilter(const HttpRequestPtr &req,
-                                FilterCallback &&fcb,
-                                FilterChainCallback &&fccb)
+HttpResponsePtr IntranetIpFilter::doSyncFilter(const HttpRequestPtr &req)
 {
     if (req->peerAddr().isIntranetIp())
-    {
-        fccb();
-        return;
-    }
-    auto res = drogon::HttpResponse::newNotFoundResponse();
-    fcb(res);
+        return nullptr;
+    return drogon::HttpResponse::newNotFoundResponse();
 }
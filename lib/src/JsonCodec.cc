@@ -0,0 +1,327 @@
+/**
+ *
+ *  JsonCodec.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "JsonCodec.h"
+#include <drogon/config.h>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if USE_SIMDJSON
+#include <simdjson.h>
+#endif
+
+using namespace drogon;
+
+#if USE_SIMDJSON
+
+namespace
+{
+void toJsonValue(const simdjson::dom::element &element, Json::Value &value)
+{
+    switch (element.type())
+    {
+        case simdjson::dom::element_type::ARRAY:
+        {
+            value = Json::Value(Json::arrayValue);
+            simdjson::dom::array array;
+            element.get(array);
+            value.resize((Json::ArrayIndex)array.size());
+            Json::ArrayIndex index = 0;
+            for (auto item : array)
+            {
+                toJsonValue(item, value[index++]);
+            }
+            break;
+        }
+        case simdjson::dom::element_type::OBJECT:
+        {
+            value = Json::Value(Json::objectValue);
+            simdjson::dom::object object;
+            element.get(object);
+            for (auto field : object)
+            {
+                toJsonValue(field.value,
+                            value[std::string(field.key.data(),
+                                              field.key.length())]);
+            }
+            break;
+        }
+        case simdjson::dom::element_type::INT64:
+        {
+            int64_t number = 0;
+            element.get(number);
+            value = Json::Value((Json::Int64)number);
+            break;
+        }
+        case simdjson::dom::element_type::UINT64:
+        {
+            uint64_t number = 0;
+            element.get(number);
+            value = Json::Value((Json::UInt64)number);
+            break;
+        }
+        case simdjson::dom::element_type::DOUBLE:
+        {
+            double number = 0;
+            element.get(number);
+            value = Json::Value(number);
+            break;
+        }
+        case simdjson::dom::element_type::STRING:
+        {
+            std::string_view str;
+            element.get(str);
+            value = Json::Value(str.data(), str.data() + str.length());
+            break;
+        }
+        case simdjson::dom::element_type::BOOL:
+        {
+            bool flag = false;
+            element.get(flag);
+            value = Json::Value(flag);
+            break;
+        }
+        default:
+            value = Json::Value();
+            break;
+    }
+}
+
+void appendInteger(std::string &output, uint64_t number, bool negative)
+{
+    char buf[24];
+    char *end = buf + sizeof(buf);
+    char *p = end;
+    do
+    {
+        *--p = (char)('0' + number % 10);
+        number /= 10;
+    } while (number != 0);
+    if (negative)
+        *--p = '-';
+    output.append(p, end);
+}
+
+void appendDouble(std::string &output, double number)
+{
+    // The same as jsoncpp does without the special floats
+    if (std::isnan(number))
+    {
+        output.append("null");
+        return;
+    }
+    if (std::isinf(number))
+    {
+        output.append(number < 0 ? "-1e+9999" : "1e+9999");
+        return;
+    }
+    char buf[32];
+    // Use the shorter form if it reads back to the same number
+    auto len = snprintf(buf, sizeof(buf), "%.15g", number);
+    if (strtod(buf, nullptr) != number)
+        len = snprintf(buf, sizeof(buf), "%.17g", number);
+    bool isReal = false;
+    for (int i = 0; i < len; ++i)
+    {
+        // The decimal point of some locales
+        if (buf[i] == ',')
+            buf[i] = '.';
+        if (buf[i] == '.' || buf[i] == 'e')
+            isReal = true;
+    }
+    output.append(buf, len);
+    // Keep it a real number when it's parsed again
+    if (!isReal)
+        output.append(".0");
+}
+
+void appendString(std::string &output, const char *begin, const char *end)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+    output.push_back('"');
+    auto start = begin;
+    for (auto p = begin; p < end; ++p)
+    {
+        auto c = (unsigned char)*p;
+        if (c >= 0x20 && c != '"' && c != '\\')
+            continue;
+        output.append(start, p);
+        start = p + 1;
+        switch (c)
+        {
+            case '"':
+                output.append("\\\"");
+                break;
+            case '\\':
+                output.append("\\\\");
+                break;
+            case '\b':
+                output.append("\\b");
+                break;
+            case '\f':
+                output.append("\\f");
+                break;
+            case '\n':
+                output.append("\\n");
+                break;
+            case '\r':
+                output.append("\\r");
+                break;
+            case '\t':
+                output.append("\\t");
+                break;
+            default:
+                output.append("\\u00");
+                output.push_back(hexDigits[c >> 4]);
+                output.push_back(hexDigits[c & 0xf]);
+                break;
+        }
+    }
+    output.append(start, end);
+    output.push_back('"');
+}
+
+void appendValue(std::string &output, const Json::Value &value)
+{
+    switch (value.type())
+    {
+        case Json::nullValue:
+            output.append("null");
+            break;
+        case Json::intValue:
+        {
+            auto number = value.asLargestInt();
+            if (number < 0)
+                appendInteger(output, 0 - (uint64_t)number, true);
+            else
+                appendInteger(output, (uint64_t)number, false);
+            break;
+        }
+        case Json::uintValue:
+            appendInteger(output, value.asLargestUInt(), false);
+            break;
+        case Json::realValue:
+            appendDouble(output, value.asDouble());
+            break;
+        case Json::stringValue:
+        {
+            const char *begin;
+            const char *end;
+            if (value.getString(&begin, &end))
+                appendString(output, begin, end);
+            else
+                output.append("\"\"");
+            break;
+        }
+        case Json::booleanValue:
+            output.append(value.asBool() ? "true" : "false");
+            break;
+        case Json::arrayValue:
+        {
+            output.push_back('[');
+            auto size = value.size();
+            for (Json::ArrayIndex i = 0; i < size; ++i)
+            {
+                if (i > 0)
+                    output.push_back(',');
+                appendValue(output, value[i]);
+            }
+            output.push_back(']');
+            break;
+        }
+        case Json::objectValue:
+        {
+            output.push_back('{');
+            for (auto iter = value.begin(); iter != value.end(); ++iter)
+            {
+                if (iter != value.begin())
+                    output.push_back(',');
+                const char *keyEnd;
+                auto key = iter.memberName(&keyEnd);
+                appendString(output, key, keyEnd);
+                output.push_back(':');
+                appendValue(output, *iter);
+            }
+            output.push_back('}');
+            break;
+        }
+    }
+}
+}  // namespace
+
+bool drogon::readJson(const char *begin,
+                      const char *end,
+                      Json::Value &value,
+                      std::string &errs)
+{
+    static thread_local simdjson::dom::parser parser;
+    simdjson::dom::element element;
+    auto error = parser.parse(begin, end - begin).get(element);
+    if (error)
+    {
+        errs = simdjson::error_message(error);
+        return false;
+    }
+    toJsonValue(element, value);
+    return true;
+}
+
+std::string drogon::writeJson(const Json::Value &value)
+{
+    // Strings are written in UTF-8 instead of \u escapes.
+    std::string output;
+    output.reserve(128);
+    appendValue(output, value);
+    return output;
+}
+
+#else
+
+bool drogon::readJson(const char *begin,
+                      const char *end,
+                      Json::Value &value,
+                      std::string &errs)
+{
+    static thread_local std::unique_ptr<Json::CharReader> reader = []() {
+        Json::CharReaderBuilder builder;
+        builder["collectComments"] = false;
+        return std::unique_ptr<Json::CharReader>(builder.newCharReader());
+    }();
+    JSONCPP_STRING errors;
+    if (!reader->parse(begin, end, &value, &errors))
+    {
+        errs = errors;
+        return false;
+    }
+    return true;
+}
+
+std::string drogon::writeJson(const Json::Value &value)
+{
+    static thread_local std::unique_ptr<Json::StreamWriter> writer = []() {
+        Json::StreamWriterBuilder builder;
+        builder["commentStyle"] = "None";
+        builder["indentation"] = "";
+        return std::unique_ptr<Json::StreamWriter>(builder.newStreamWriter());
+    }();
+    static thread_local std::ostringstream stream;
+    stream.str("");
+    writer->write(value, &stream);
+    return stream.str();
+}
+
+#endif
@@ -0,0 +1,35 @@
+/**
+ *
+ *  JsonCodec.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <json/json.h>
+#include <string>
+
+namespace drogon
+{
+/// The JSON backend of the request and response bodies, it's chosen by the
+/// DROGON_JSON_BACKEND cmake option. The parser and the writer of every
+/// thread are created once and reused.
+
+/// Parse a JSON text. Return false and set the errors if it's invalid.
+bool readJson(const char *begin,
+              const char *end,
+              Json::Value &value,
+              std::string &errs);
+
+/// Serialize a JSON value without indentation and comments.
+std::string writeJson(const Json::Value &value);
+
+}  // namespace drogon
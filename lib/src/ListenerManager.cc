@@ -75,70 +75,31 @@ std::vector<trantor::EventLoop *> ListenerManager::createListeners(
         &syncAdvices)
 {
 #ifdef __linux__
-    std::vector<trantor::EventLoop *> ioLoops;
-    for (size_t i = 0; i < threadNum; i++)
+    // Every server has its own SSL context, so the sessions and the ticket
+    // keys of a HTTPS listener are only shared by the connections accepted
+    // by the same server. If the listener ran a server with SO_REUSEPORT in
+    // every IO thread, a client resuming its session would do a full
+    // handshake whenever it's accepted by another thread. So a HTTPS
+    // listener has only one server, which spreads its connections over the
+    // IO threads, while the HTTP listeners still run a server in every IO
+    // thread.
+    bool hasSSLListener = false;
+    for (auto const &listener : _listeners)
     {
-        LOG_TRACE << "thread num=" << threadNum;
-        auto loopThreadPtr = std::make_shared<EventLoopThread>("DrogonIoLoop");
-        _listeningloopThreads.push_back(loopThreadPtr);
-        ioLoops.push_back(loopThreadPtr->getLoop());
-        for (auto const &listener : _listeners)
+        if (listener._useSSL)
         {
-            auto const &ip = listener._ip;
-            bool isIpv6 = ip.find(':') == std::string::npos ? false : true;
-            std::shared_ptr<HttpServer> serverPtr;
-            if (i == 0)
-            {
-                DrogonFileLocker lock;
-                // Check whether the port is in use.
-                TcpServer server(HttpAppFrameworkImpl::instance().getLoop(),
-                                 InetAddress(ip, listener._port, isIpv6),
-                                 "drogonPortTest",
-                                 true,
-                                 false);
-                serverPtr = std::make_shared<HttpServer>(
-                    loopThreadPtr->getLoop(),
-                    InetAddress(ip, listener._port, isIpv6),
-                    "drogon",
-                    syncAdvices);
-            }
-            else
-            {
-                serverPtr = std::make_shared<HttpServer>(
-                    loopThreadPtr->getLoop(),
-                    InetAddress(ip, listener._port, isIpv6),
-                    "drogon",
-                    syncAdvices);
-            }
-
-            if (listener._useSSL)
-            {
-#ifdef OpenSSL_FOUND
-                auto cert = listener._certFile;
-                auto key = listener._keyFile;
-                if (cert == "")
-                    cert = globalCertFile;
-                if (key == "")
-                    key = globalKeyFile;
-                if (cert == "" || key == "")
-                {
-                    std::cerr
-                        << "You can't use https without cert file or key file"
-                        << std::endl;
-                    exit(1);
-                }
-                serverPtr->enableSSL(cert, key);
-#endif
-            }
-            serverPtr->setHttpAsyncCallback(httpCallback);
-            serverPtr->setNewWebsocketCallback(webSocketCallback);
-            serverPtr->setConnectionCallback(connectionCallback);
-            serverPtr->kickoffIdleConnections(connectionTimeout);
-            serverPtr->start();
-            _servers.push_back(serverPtr);
+            hasSSLListener = true;
+            break;
         }
     }
-#else
+    if (!hasSSLListener)
+        return createReusePortListeners(httpCallback,
+                                        webSocketCallback,
+                                        connectionCallback,
+                                        connectionTimeout,
+                                        threadNum,
+                                        syncAdvices);
+#endif
     auto loopThreadPtr =
         std::make_shared<EventLoopThread>("DrogonListeningLoop");
     _listeningloopThreads.push_back(loopThreadPtr);
@@ -146,6 +107,19 @@ std::vector<trantor::EventLoop *> ListenerManager::createListeners(
     for (auto const &listener : _listeners)
     {
         LOG_TRACE << "thread num=" << threadNum;
+#ifdef __linux__
+        if (!listener._useSSL)
+        {
+            createReusePortServers(listener,
+                                   _ioLoopThreadPoolPtr->getLoops(),
+                                   httpCallback,
+                                   webSocketCallback,
+                                   connectionCallback,
+                                   connectionTimeout,
+                                   syncAdvices);
+            continue;
+        }
+#endif
         auto ip = listener._ip;
         bool isIpv6 = ip.find(':') == std::string::npos ? false : true;
         auto serverPtr = std::make_shared<HttpServer>(
@@ -179,11 +153,89 @@ std::vector<trantor::EventLoop *> ListenerManager::createListeners(
         serverPtr->start();
         _servers.push_back(serverPtr);
     }
-    auto ioLoops = _ioLoopThreadPoolPtr->getLoops();
-#endif
+    return _ioLoopThreadPoolPtr->getLoops();
+}
+
+#ifdef __linux__
+std::vector<trantor::EventLoop *> ListenerManager::createReusePortListeners(
+    const HttpAsyncCallback &httpCallback,
+    const WebSocketNewAsyncCallback &webSocketCallback,
+    const ConnectionCallback &connectionCallback,
+    size_t connectionTimeout,
+    size_t threadNum,
+    const std::vector<std::function<HttpResponsePtr(const HttpRequestPtr &)>>
+        &syncAdvices)
+{
+    std::vector<trantor::EventLoop *> ioLoops;
+    for (size_t i = 0; i < threadNum; i++)
+    {
+        LOG_TRACE << "thread num=" << threadNum;
+        auto loopThreadPtr = std::make_shared<EventLoopThread>("DrogonIoLoop");
+        _listeningloopThreads.push_back(loopThreadPtr);
+        ioLoops.push_back(loopThreadPtr->getLoop());
+    }
+    for (auto const &listener : _listeners)
+    {
+        createReusePortServers(listener,
+                               ioLoops,
+                               httpCallback,
+                               webSocketCallback,
+                               connectionCallback,
+                               connectionTimeout,
+                               syncAdvices);
+    }
     return ioLoops;
 }
 
+void ListenerManager::createReusePortServers(
+    const ListenerInfo &listener,
+    const std::vector<trantor::EventLoop *> &ioLoops,
+    const HttpAsyncCallback &httpCallback,
+    const WebSocketNewAsyncCallback &webSocketCallback,
+    const ConnectionCallback &connectionCallback,
+    size_t connectionTimeout,
+    const std::vector<std::function<HttpResponsePtr(const HttpRequestPtr &)>>
+        &syncAdvices)
+{
+    auto const &ip = listener._ip;
+    bool isIpv6 = ip.find(':') == std::string::npos ? false : true;
+    for (size_t i = 0; i < ioLoops.size(); i++)
+    {
+        std::shared_ptr<HttpServer> serverPtr;
+        if (i == 0)
+        {
+            DrogonFileLocker lock;
+            // Check whether the port is in use.
+            TcpServer server(HttpAppFrameworkImpl::instance().getLoop(),
+                             InetAddress(ip, listener._port, isIpv6),
+                             "drogonPortTest",
+                             true,
+                             false);
+            serverPtr = std::make_shared<HttpServer>(
+                ioLoops[i],
+                InetAddress(ip, listener._port, isIpv6),
+                "drogon",
+                syncAdvices);
+        }
+        else
+        {
+            serverPtr = std::make_shared<HttpServer>(
+                ioLoops[i],
+                InetAddress(ip, listener._port, isIpv6),
+                "drogon",
+                syncAdvices);
+        }
+
+        serverPtr->setHttpAsyncCallback(httpCallback);
+        serverPtr->setNewWebsocketCallback(webSocketCallback);
+        serverPtr->setConnectionCallback(connectionCallback);
+        serverPtr->kickoffIdleConnections(connectionTimeout);
+        serverPtr->start();
+        _servers.push_back(serverPtr);
+    }
+}
+#endif
+
 void ListenerManager::startListening()
 {
     for (auto &loopThread : _listeningloopThreads)
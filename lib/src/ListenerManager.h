@@ -46,6 +46,18 @@ class ListenerManager : public trantor::NonCopyable
     void startListening();
 
   private:
+#ifdef __linux__
+    // Run a server with SO_REUSEPORT in every IO thread for every listener.
+    std::vector<trantor::EventLoop *> createReusePortListeners(
+        const HttpAsyncCallback &httpCallback,
+        const WebSocketNewAsyncCallback &webSocketCallback,
+        const trantor::ConnectionCallback &connectionCallback,
+        size_t connectionTimeout,
+        size_t threadNum,
+        const std::vector<
+            std::function<HttpResponsePtr(const HttpRequestPtr &)>>
+            &syncAdvices);
+#endif
     struct ListenerInfo
     {
         ListenerInfo(const std::string &ip,
@@ -66,6 +78,19 @@ class ListenerManager : public trantor::NonCopyable
         std::string _certFile;
         std::string _keyFile;
     };
+#ifdef __linux__
+    // Run a server with SO_REUSEPORT in every IO loop for the listener.
+    void createReusePortServers(
+        const ListenerInfo &listener,
+        const std::vector<trantor::EventLoop *> &ioLoops,
+        const HttpAsyncCallback &httpCallback,
+        const WebSocketNewAsyncCallback &webSocketCallback,
+        const trantor::ConnectionCallback &connectionCallback,
+        size_t connectionTimeout,
+        const std::vector<
+            std::function<HttpResponsePtr(const HttpRequestPtr &)>>
+            &syncAdvices);
+#endif
     std::vector<ListenerInfo> _listeners;
     std::vector<std::shared_ptr<HttpServer>> _servers;
     std::vector<std::shared_ptr<trantor::EventLoopThread>>
@@ -15,15 +15,9 @@
 #include "HttpResponseImpl.h"
 #include <drogon/LocalHostFilter.h>
 using namespace drogon;
-void LocalHostFilter::doFilter(const HttpRequestPtr &req,
-                               FilterCallback &&fcb,
-                               FilterChainCallback &&fccb)
+HttpResponsePtr LocalHostFilter::doSyncFilter(const HttpRequestPtr &req)
 {
     if (req->peerAddr().isLoopbackIp())
-    {
-        fccb();
-        return;
-    }
-    auto res = drogon::HttpResponse::newNotFoundResponse();
-    fcb(res);
+        return nullptr;
+    return drogon::HttpResponse::newNotFoundResponse();
 }
@@ -15,14 +15,11 @@
 #include "HttpRequestImpl.h"
 #include "HttpUtils.h"
 #include "HttpAppFrameworkImpl.h"
+#include "CacheFile.h"
+#include "MultiPartStreamParser.h"
 #include <drogon/MultiPart.h>
 #include <drogon/utils/Utilities.h>
 #include <drogon/config.h>
-#ifdef OpenSSL_FOUND
-#include <openssl/md5.h>
-#else
-#include "ssl_funcs/Md5.h"
-#endif
 #include <algorithm>
 #include <fcntl.h>
 #include <fstream>
@@ -46,25 +43,22 @@ int MultiPartParser::parse(const HttpRequestPtr &req)
 {
     if (req->method() != Post)
         return -1;
-    const std::string &contentType =
-        static_cast<HttpRequestImpl *>(req.get())->getHeaderBy("content-type");
-    if (contentType.empty())
+    auto reqImpl = static_cast<HttpRequestImpl *>(req.get());
+    auto streamParser = reqImpl->multiPartStreamParser();
+    if (streamParser)
     {
-        return -1;
+        // The body has been parsed while it was received
+        if (!streamParser->finished())
+            return -1;
+        _files = streamParser->files();
+        _parameters = streamParser->parameters();
+        return 0;
     }
-    std::string::size_type pos = contentType.find(';');
-    if (pos == std::string::npos)
+    std::string boundary;
+    auto &contentType = reqImpl->getHeaderBy("content-type");
+    if (!MultiPartStreamParser::getBoundary(contentType, boundary))
         return -1;
 
-    std::string type = contentType.substr(0, pos);
-    std::transform(type.begin(), type.end(), type.begin(), tolower);
-    if (type != "multipart/form-data")
-        return -1;
-    pos = contentType.find("boundary=");
-    if (pos == std::string::npos)
-        return -1;
-    std::string boundary = contentType.substr(pos + 9);
-
     return parse(req, boundary);
 }
 
@@ -180,35 +174,19 @@ int HttpFile::save() const
 }
 int HttpFile::saveAs(const std::string &filename) const
 {
-    assert(!filename.empty());
-    auto pathAndFileName = filename;
-    if (filename[0] == '/' ||
-        (filename.length() >= 2 && filename[0] == '.' && filename[1] == '/') ||
-        (filename.length() >= 3 && filename[0] == '.' && filename[1] == '.' &&
-         filename[2] == '/'))
-    {
-        // Absolute or relative path
-    }
-    else
-    {
-        auto &uploadPath = HttpAppFrameworkImpl::instance().getUploadPath();
-        if (uploadPath[uploadPath.length() - 1] == '/')
-            pathAndFileName = uploadPath + filename;
-        else
-            pathAndFileName = uploadPath + "/" + filename;
-    }
-    auto pathPos = pathAndFileName.rfind('/');
-    if (pathPos != std::string::npos)
-    {
-        std::string path = pathAndFileName.substr(0, pathPos);
-        if (utils::createPath(path) < 0)
-            return -1;
-    }
+    auto pathAndFileName = makeSavePath(
+        filename, HttpAppFrameworkImpl::instance().getUploadPath());
+    if (pathAndFileName.empty())
+        return -1;
     return saveTo(pathAndFileName);
 }
 int HttpFile::saveTo(const std::string &pathAndFilename) const
 {
     LOG_TRACE << "save uploaded file:" << pathAndFilename;
+    if (_cacheFilePtr)
+    {
+        return _cacheFilePtr->linkTo(pathAndFilename);
+    }
     std::ofstream file(pathAndFilename);
     if (file.is_open())
     {
@@ -224,6 +202,15 @@ int HttpFile::saveTo(const std::string &pathAndFilename) const
 }
 const std::string HttpFile::getMd5() const
 {
+    if (!_md5.empty())
+        return _md5;
+    if (_cacheFilePtr)
+    {
+        auto content = _cacheFilePtr->getStringView();
+        Md5Calculator md5;
+        md5.update(content.data(), content.length());
+        return md5.final();
+    }
 #ifdef OpenSSL_FOUND
     MD5_CTX c;
     unsigned char md5[16] = {0};
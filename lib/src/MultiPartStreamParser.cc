@@ -0,0 +1,333 @@
+/**
+ *
+ *  MultiPartStreamParser.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "MultiPartStreamParser.h"
+#include "HttpAppFrameworkImpl.h"
+#include "CacheFile.h"
+#include <drogon/utils/Utilities.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+
+using namespace drogon;
+
+namespace
+{
+// The limit of the headers of a part
+const size_t kMaxHeadersSize = 8 * 1024;
+
+string_view trim(string_view str)
+{
+    while (!str.empty() && isspace(str.front()))
+        str.remove_prefix(1);
+    while (!str.empty() && isspace(str.back()))
+        str.remove_suffix(1);
+    return str;
+}
+
+bool equalsIgnoreCase(string_view str, const char *lowerCase)
+{
+    size_t i = 0;
+    for (; i < str.length() && lowerCase[i]; ++i)
+    {
+        if (tolower(str[i]) != lowerCase[i])
+            return false;
+    }
+    return i == str.length() && lowerCase[i] == 0;
+}
+
+// Get the parameter of a header value such as
+// form-data; name="file"; filename="a.txt"
+bool getHeaderParameter(string_view value, const char *key, std::string &param)
+{
+    while (!value.empty())
+    {
+        auto pos = value.find(';');
+        auto item = trim(value.substr(0, pos));
+        value = pos == string_view::npos ? string_view()
+                                          : value.substr(pos + 1);
+        auto epos = item.find('=');
+        if (epos == string_view::npos ||
+            !equalsIgnoreCase(trim(item.substr(0, epos)), key))
+            continue;
+        auto val = trim(item.substr(epos + 1));
+        if (val.length() >= 2 && val.front() == '"' && val.back() == '"')
+            val = val.substr(1, val.length() - 2);
+        param.assign(val.data(), val.length());
+        return true;
+    }
+    return false;
+}
+}  // namespace
+
+Md5Calculator::Md5Calculator()
+{
+#ifdef OpenSSL_FOUND
+    MD5_Init(&_context);
+#else
+    Md5Encode::init(_context);
+#endif
+}
+
+void Md5Calculator::update(const char *data, size_t length)
+{
+#ifdef OpenSSL_FOUND
+    MD5_Update(&_context, data, length);
+#else
+    Md5Encode::update(_context, data, length);
+#endif
+}
+
+std::string Md5Calculator::final()
+{
+#ifdef OpenSSL_FOUND
+    unsigned char md5[16] = {0};
+    MD5_Final(md5, &_context);
+    return utils::binaryStringToHex(md5, 16);
+#else
+    return Md5Encode::final(_context);
+#endif
+}
+
+MultiPartStreamParser::MultiPartStreamParser(const std::string &boundary,
+                                             size_t maxFieldsSize,
+                                             bool computeMd5)
+    : _delimiter("\r\n--" + boundary),
+      _buffer("\r\n"),
+      _maxFieldsSize(maxFieldsSize),
+      _computeMd5(computeMd5)
+{
+    // The first delimiter is not preceded by CRLF if there is no preamble,
+    // so it is put at the beginning of the buffer.
+}
+
+bool MultiPartStreamParser::getBoundary(const std::string &contentType,
+                                        std::string &boundary)
+{
+    auto pos = contentType.find(';');
+    if (pos == std::string::npos ||
+        !equalsIgnoreCase(trim(string_view(contentType.data(), pos)),
+                          "multipart/form-data"))
+        return false;
+    return getHeaderParameter(string_view(contentType).substr(pos + 1),
+                              "boundary",
+                              boundary) &&
+           !boundary.empty();
+}
+
+bool MultiPartStreamParser::parse(const char *data, size_t length)
+{
+    if (!_buffer.empty())
+    {
+        // Join the bytes left by the last piece with the beginning of this
+        // one, which is enough to parse past them if the piece is not too
+        // short.
+        auto joinedLength =
+            std::min(length, kMaxHeadersSize + _delimiter.length());
+        _buffer.append(data, joinedLength);
+        size_t parsedLength;
+        if (!parseData(_buffer, parsedLength))
+            return false;
+        auto leftLength = _buffer.length() - parsedLength;
+        if (leftLength > joinedLength)
+        {
+            // No state leaves more than the headers unparsed, so the whole
+            // piece has been joined.
+            _buffer.erase(0, parsedLength);
+            return true;
+        }
+        // The bytes left are the end of the joined ones, they are parsed
+        // again in place with the rest of the piece.
+        _buffer.clear();
+        data += joinedLength - leftLength;
+        length -= joinedLength - leftLength;
+    }
+    size_t parsedLength;
+    if (!parseData(string_view(data, length), parsedLength))
+        return false;
+    _buffer.assign(data + parsedLength, length - parsedLength);
+    return true;
+}
+
+bool MultiPartStreamParser::parseData(string_view data, size_t &parsedLength)
+{
+    size_t pos = 0;
+    bool hasMore = true;
+    while (hasMore)
+    {
+        switch (_state)
+        {
+            case kPreamble:
+            {
+                auto dpos = data.find(_delimiter, pos);
+                if (dpos == string_view::npos)
+                {
+                    if (data.length() >= _delimiter.length())
+                        pos = data.length() - _delimiter.length() + 1;
+                    hasMore = false;
+                    break;
+                }
+                pos = dpos + _delimiter.length();
+                _state = kAfterDelimiter;
+                break;
+            }
+            case kAfterDelimiter:
+            {
+                if (data.length() - pos < 2)
+                {
+                    hasMore = false;
+                    break;
+                }
+                if (data[pos] == '-' && data[pos + 1] == '-')
+                {
+                    // The epilogue is ignored
+                    _state = kFinished;
+                    break;
+                }
+                if (data[pos] != '\r' || data[pos + 1] != '\n')
+                    return false;
+                pos += 2;
+                _state = kHeaders;
+                break;
+            }
+            case kHeaders:
+            {
+                if (data.length() - pos < 2)
+                {
+                    hasMore = false;
+                    break;
+                }
+                // A part without headers has no name
+                if (data.compare(pos, 2, "\r\n") == 0)
+                    return false;
+                auto hpos = data.find("\r\n\r\n", pos);
+                if (hpos == string_view::npos)
+                {
+                    if (data.length() - pos > kMaxHeadersSize)
+                        return false;
+                    hasMore = false;
+                    break;
+                }
+                if (!startPart(data.data() + pos, data.data() + hpos))
+                    return false;
+                pos = hpos + 4;
+                _state = kBody;
+                break;
+            }
+            case kBody:
+            {
+                auto dpos = data.find(_delimiter, pos);
+                if (dpos == string_view::npos)
+                {
+                    // The tail may be the beginning of the delimiter
+                    auto keepLength = _delimiter.length() - 1;
+                    if (data.length() - pos > keepLength)
+                    {
+                        auto len = data.length() - pos - keepLength;
+                        if (!appendToPart(data.data() + pos, len))
+                            return false;
+                        pos += len;
+                    }
+                    hasMore = false;
+                    break;
+                }
+                if (!appendToPart(data.data() + pos, dpos - pos))
+                    return false;
+                finishPart();
+                pos = dpos + _delimiter.length();
+                _state = kAfterDelimiter;
+                break;
+            }
+            case kFinished:
+                pos = data.length();
+                hasMore = false;
+                break;
+        }
+    }
+    parsedLength = pos;
+    return true;
+}
+
+bool MultiPartStreamParser::startPart(const char *begin, const char *end)
+{
+    _name.clear();
+    _isFile = false;
+    std::string fileName;
+    string_view headers(begin, end - begin);
+    while (!headers.empty())
+    {
+        auto pos = headers.find("\r\n");
+        auto line = headers.substr(0, pos);
+        headers = pos == string_view::npos ? string_view()
+                                            : headers.substr(pos + 2);
+        auto colon = line.find(':');
+        if (colon == string_view::npos ||
+            !equalsIgnoreCase(trim(line.substr(0, colon)),
+                              "content-disposition"))
+            continue;
+        auto value = line.substr(colon + 1);
+        getHeaderParameter(value, "name", _name);
+        _isFile = getHeaderParameter(value, "filename", fileName);
+    }
+    if (_name.empty())
+        return false;
+    if (!_isFile)
+        return true;
+
+    _file = HttpFile();
+    _file.setFileName(fileName);
+    _file._cacheFilePtr = std::make_shared<CacheFile>(
+        HttpAppFrameworkImpl::instance().newTmpFilePath());
+    if (_file._cacheFilePtr->fd() < 0)
+        return false;
+    if (_computeMd5)
+        _md5Ptr = std::make_unique<Md5Calculator>();
+    return true;
+}
+
+bool MultiPartStreamParser::appendToPart(const char *data, size_t length)
+{
+    if (length == 0)
+        return true;
+    if (!_isFile)
+    {
+        _fieldsSize += length;
+        if (_fieldsSize > _maxFieldsSize)
+            return false;
+        _value.append(data, length);
+        return true;
+    }
+    if (!_file._cacheFilePtr->append(data, length))
+        return false;
+    _file._fileLength += length;
+    if (_md5Ptr)
+        _md5Ptr->update(data, length);
+    return true;
+}
+
+void MultiPartStreamParser::finishPart()
+{
+    if (!_isFile)
+    {
+        _parameters[_name] = std::move(_value);
+        _value.clear();
+        return;
+    }
+    if (_md5Ptr)
+    {
+        _file._md5 = _md5Ptr->final();
+        _md5Ptr.reset();
+    }
+    _files.push_back(std::move(_file));
+    _file = HttpFile();
+}
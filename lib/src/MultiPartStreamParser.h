@@ -0,0 +1,127 @@
+/**
+ *
+ *  MultiPartStreamParser.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/HttpRequest.h>
+#include <drogon/MultiPart.h>
+#include <drogon/config.h>
+#include <trantor/utils/NonCopyable.h>
+#ifdef OpenSSL_FOUND
+#include <openssl/md5.h>
+#else
+#include "ssl_funcs/Md5.h"
+#endif
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace drogon
+{
+/// Compute the MD5 string of the data given in pieces
+class Md5Calculator
+{
+  public:
+    Md5Calculator();
+    void update(const char *data, size_t length);
+    std::string final();
+
+  private:
+#ifdef OpenSSL_FOUND
+    MD5_CTX _context;
+#else
+    Md5Encode::Context _context;
+#endif
+};
+
+/// Parse a multipart/form-data request body while it is being received
+/**
+ * The contents of the files are written to cache files in the upload path
+ * as they arrive, straight from the pieces of the body, so a large upload is
+ * never held in memory or copied again after it is received. Only the form
+ * fields are kept in memory.
+ */
+class MultiPartStreamParser : public trantor::NonCopyable
+{
+  public:
+    /**
+     * @param maxFieldsSize The max total size of the form fields kept in
+     * memory, the body is malformed if they are larger.
+     * @param computeMd5 If true, the MD5 strings of the files are computed
+     * while they are written.
+     */
+    MultiPartStreamParser(const std::string &boundary,
+                          size_t maxFieldsSize,
+                          bool computeMd5);
+
+    /// Parse the next piece of the body, return false if it's malformed.
+    bool parse(const char *data, size_t length);
+
+    /// Return true if the last boundary of the body has been parsed.
+    bool finished() const
+    {
+        return _state == kFinished;
+    }
+    const std::vector<HttpFile> &files() const
+    {
+        return _files;
+    }
+    const std::map<std::string, std::string> &parameters() const
+    {
+        return _parameters;
+    }
+
+    /// Get the boundary from the value of the content-type header, return
+    /// false if the type is not multipart/form-data.
+    static bool getBoundary(const std::string &contentType,
+                            std::string &boundary);
+
+  private:
+    enum State
+    {
+        kPreamble,
+        kAfterDelimiter,
+        kHeaders,
+        kBody,
+        kFinished
+    };
+    /// Parse the data from the current state, set the number of bytes parsed,
+    /// the rest can't be parsed until more data arrive.
+    bool parseData(string_view data, size_t &parsedLength);
+    bool startPart(const char *begin, const char *end);
+    bool appendToPart(const char *data, size_t length);
+    void finishPart();
+
+    State _state = kPreamble;
+    // CRLF, "--" and the boundary, see rfc2046-5.1.1
+    const std::string _delimiter;
+    // The bytes which can't be parsed until more data arrive
+    std::string _buffer;
+    const size_t _maxFieldsSize;
+    size_t _fieldsSize = 0;
+    const bool _computeMd5;
+
+    // The part being parsed
+    std::string _name;
+    bool _isFile = false;
+    std::string _value;
+    HttpFile _file;
+    std::unique_ptr<Md5Calculator> _md5Ptr;
+
+    std::vector<HttpFile> _files;
+    std::map<std::string, std::string> _parameters;
+};
+
+}  // namespace drogon
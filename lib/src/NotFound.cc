@@ -15,6 +15,7 @@
  */
 
 #include <drogon/NotFound.h>
+#include <drogon/utils/OStringStream.h>
 #include <map>
 #include <set>
 #include <sstream>
@@ -25,27 +26,26 @@ using namespace drogon;
 
 std::string NotFound::genText(const HttpViewData &NotFound_view_data)
 {
-    std::stringstream NotFound_tmp_stream;
-    NotFound_tmp_stream << "<html>\n";
-    NotFound_tmp_stream << "<head><title>404 Not Found</title></head>\n";
-    NotFound_tmp_stream << "<body bgcolor=\"white\">\n";
-    NotFound_tmp_stream << "<center><h1>404 Not Found</h1></center>\n";
-    NotFound_tmp_stream << "<hr><center>drogon/";
+    static thread_local size_t NotFound_size_hint = 0;
+    drogon::OStringStream NotFound_tmp_stream(NotFound_size_hint);
+    NotFound_tmp_stream
+        << "<html>\n"
+        "<head><title>404 Not Found</title></head>\n"
+        "<body bgcolor=\"white\">\n"
+        "<center><h1>404 Not Found</h1></center>\n"
+        "<hr><center>drogon/";
     NotFound_tmp_stream << NotFound_view_data.get<std::string>("version");
-    NotFound_tmp_stream << "</center>\n";
-    NotFound_tmp_stream << "</body>\n";
-    NotFound_tmp_stream << "</html>\n";
-    NotFound_tmp_stream << "<!-- a padding to disable MSIE and Chrome friendly "
-                           "error page -->\n";
-    NotFound_tmp_stream << "<!-- a padding to disable MSIE and Chrome friendly "
-                           "error page -->\n";
-    NotFound_tmp_stream << "<!-- a padding to disable MSIE and Chrome friendly "
-                           "error page -->\n";
-    NotFound_tmp_stream << "<!-- a padding to disable MSIE and Chrome friendly "
-                           "error page -->\n";
-    NotFound_tmp_stream << "<!-- a padding to disable MSIE and Chrome friendly "
-                           "error page -->\n";
-    NotFound_tmp_stream << "<!-- a padding to disable MSIE and Chrome friendly "
-                           "error page -->\n";
-    return NotFound_tmp_stream.str();
+    NotFound_tmp_stream
+        << "</center>\n"
+        "</body>\n"
+        "</html>\n"
+        "<!-- a padding to disable MSIE and Chrome friendly error page -->\n"
+        "<!-- a padding to disable MSIE and Chrome friendly error page -->\n"
+        "<!-- a padding to disable MSIE and Chrome friendly error page -->\n"
+        "<!-- a padding to disable MSIE and Chrome friendly error page -->\n"
+        "<!-- a padding to disable MSIE and Chrome friendly error page -->\n"
+        "<!-- a padding to disable MSIE and Chrome friendly error page -->\n";
+    NotFound_size_hint =
+        NotFound_tmp_stream.length() + NotFound_tmp_stream.length() / 8;
+    return std::move(NotFound_tmp_stream.str());
 }
@@ -13,10 +13,19 @@
  */
 
 #include "PluginsManager.h"
+#include <drogon/plugins/ReverseProxy.h>
 #include <trantor/utils/Logger.h>
 
 using namespace drogon;
 
+namespace
+{
+// Reference the built-in plugins, so that they are registered even if the
+// framework is linked as a static library.
+const std::string *builtinPlugins[] = {
+    &plugin::ReverseProxy::classTypeName()};
+}  // namespace
+
 PluginsManager::~PluginsManager()
 {
     // Shut down all plugins in reverse order of initializaiton.
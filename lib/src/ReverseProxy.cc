@@ -0,0 +1,571 @@
+/**
+ *
+ *  ReverseProxy.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "HttpRequestImpl.h"
+#include <drogon/plugins/ReverseProxy.h>
+#include <drogon/HttpAppFramework.h>
+#include <drogon/HttpClient.h>
+#include <drogon/HttpResponse.h>
+#include <trantor/utils/Date.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
+using namespace drogon;
+using namespace drogon::plugin;
+
+namespace drogon
+{
+namespace plugin
+{
+struct ReverseProxy::Backend
+{
+    explicit Backend(const std::string &host) : _host(host)
+    {
+    }
+    std::string _host;
+    HttpClientPtr _pool;
+    // The requests which are waiting for their responses or whose bodies
+    // are being forwarded
+    std::atomic<size_t> _activeRequests{0};
+    std::atomic<size_t> _failures{0};
+    // The backend is skipped until this time, in microseconds since epoch
+    std::atomic<int64_t> _downUntil{0};
+};
+
+/// Counts a request as active on its backend as long as the client keeps
+/// its callbacks, i.e. until the response is complete, the request fails or
+/// it is aborted.
+struct ReverseProxy::ActiveRequest
+{
+    explicit ActiveRequest(Backend *backend) : _backend(backend)
+    {
+        ++_backend->_activeRequests;
+    }
+    ~ActiveRequest()
+    {
+        --_backend->_activeRequests;
+    }
+    Backend *_backend;
+};
+
+struct ReverseProxy::Upstream
+{
+    enum class Balance
+    {
+        RoundRobin,
+        LeastConnections,
+        ConsistentHash
+    };
+    enum class HashKey
+    {
+        Ip,
+        Path,
+        Header
+    };
+    std::string _name;
+    std::vector<std::unique_ptr<Backend>> _backends;
+    Balance _balance = Balance::RoundRobin;
+    HashKey _hashKey = HashKey::Ip;
+    std::string _hashHeader;
+    // The virtual nodes of the backends sorted by their hash values
+    std::vector<std::pair<size_t, Backend *>> _ring;
+    std::atomic<size_t> _next{0};
+    size_t _maxFails = 3;
+    double _failTimeout = 10.0;
+    // The time in seconds to wait for the headers of a response
+    double _timeout = 60.0;
+
+    Backend *choose(const HttpRequestPtr &req,
+                    const std::vector<Backend *> &triedBackends);
+    void onResult(Backend *backend, bool failed);
+};
+
+struct ReverseProxy::Route
+{
+    std::string _pathPrefix;
+    bool _rewritePath = false;
+    std::string _rewritePrefix;
+    std::shared_ptr<Upstream> _upstream;
+    // The names of the headers are in lower case.
+    std::vector<std::pair<std::string, std::string>> _setRequestHeaders;
+    std::vector<std::string> _removeRequestHeaders;
+    std::vector<std::pair<std::string, std::string>> _setResponseHeaders;
+    std::vector<std::string> _removeResponseHeaders;
+
+    bool isReplacedRequestHeader(const std::string &field) const
+    {
+        for (auto &header : _setRequestHeaders)
+        {
+            if (header.first == field)
+                return true;
+        }
+        return std::find(_removeRequestHeaders.begin(),
+                         _removeRequestHeaders.end(),
+                         field) != _removeRequestHeaders.end();
+    }
+};
+}  // namespace plugin
+}  // namespace drogon
+
+namespace
+{
+// The number of points of every backend on the hash ring
+const size_t virtualNodesNumber = 160;
+
+std::string toLower(std::string str)
+{
+    std::transform(str.begin(), str.end(), str.begin(), tolower);
+    return str;
+}
+
+/// Headers which only concern one connection, rfc7230-6.1
+bool isHopByHopHeader(const std::string &field)
+{
+    return field == "connection" || field == "keep-alive" ||
+           field == "proxy-connection" || field == "te" ||
+           field == "trailer" || field == "transfer-encoding" ||
+           field == "upgrade";
+}
+
+/// Return true if the path is the prefix or one of its sub-paths, so that
+/// "/api" matches "/api" and "/api/users" but not "/apiary".
+bool matchPrefix(const std::string &path, const std::string &prefix)
+{
+    if (path.compare(0, prefix.length(), prefix) != 0)
+        return false;
+    return path.length() == prefix.length() || prefix.empty() ||
+           prefix.back() == '/' || path[prefix.length()] == '/';
+}
+
+void loadHeaders(const Json::Value &config,
+                 std::vector<std::pair<std::string, std::string>> &headers)
+{
+    for (auto &name : config.getMemberNames())
+    {
+        headers.emplace_back(toLower(name), config[name].asString());
+    }
+}
+
+void loadHeaderNames(const Json::Value &config, std::vector<std::string> &names)
+{
+    for (auto &name : config)
+    {
+        names.push_back(toLower(name.asString()));
+    }
+}
+}  // namespace
+
+ReverseProxy::Backend *ReverseProxy::Upstream::choose(
+    const HttpRequestPtr &req,
+    const std::vector<Backend *> &triedBackends)
+{
+    auto now = trantor::Date::now().microSecondsSinceEpoch();
+    auto size = _backends.size();
+    // If all the backends are down, they are tried anyway.
+    for (bool checkHealth : {true, false})
+    {
+        auto usable = [&triedBackends, now, checkHealth](Backend *backend) {
+            return std::find(triedBackends.begin(),
+                             triedBackends.end(),
+                             backend) == triedBackends.end() &&
+                   (!checkHealth || backend->_downUntil.load() <= now);
+        };
+        Backend *chosen = nullptr;
+        switch (_balance)
+        {
+            case Balance::RoundRobin:
+            {
+                auto start = _next.fetch_add(1);
+                for (size_t i = 0; i < size; ++i)
+                {
+                    auto backend = _backends[(start + i) % size].get();
+                    if (usable(backend))
+                    {
+                        chosen = backend;
+                        break;
+                    }
+                }
+                break;
+            }
+            case Balance::LeastConnections:
+            {
+                // Start from a different backend every time, so that the
+                // requests are spread when the backends are equally busy.
+                auto start = _next.fetch_add(1);
+                for (size_t i = 0; i < size; ++i)
+                {
+                    auto backend = _backends[(start + i) % size].get();
+                    if (usable(backend) &&
+                        (!chosen || backend->_activeRequests.load() <
+                                        chosen->_activeRequests.load()))
+                    {
+                        chosen = backend;
+                    }
+                }
+                break;
+            }
+            case Balance::ConsistentHash:
+            {
+                std::hash<std::string> hashFunc;
+                size_t hash;
+                if (_hashKey == HashKey::Ip)
+                    hash = hashFunc(req->peerAddr().toIp());
+                else if (_hashKey == HashKey::Path)
+                    hash = hashFunc(req->path());
+                else
+                    hash = hashFunc(req->getHeader(_hashHeader));
+                auto iter = std::lower_bound(
+                    _ring.begin(),
+                    _ring.end(),
+                    hash,
+                    [](const std::pair<size_t, Backend *> &node, size_t value) {
+                        return node.first < value;
+                    });
+                for (size_t i = 0; i < _ring.size(); ++i, ++iter)
+                {
+                    if (iter == _ring.end())
+                        iter = _ring.begin();
+                    if (usable(iter->second))
+                    {
+                        chosen = iter->second;
+                        break;
+                    }
+                }
+                break;
+            }
+        }
+        if (chosen)
+            return chosen;
+    }
+    return nullptr;
+}
+
+void ReverseProxy::Upstream::onResult(Backend *backend, bool failed)
+{
+    if (_maxFails == 0)
+        return;
+    if (!failed)
+    {
+        backend->_failures = 0;
+        return;
+    }
+    if (++backend->_failures >= _maxFails)
+    {
+        backend->_failures = 0;
+        backend->_downUntil =
+            trantor::Date::now().microSecondsSinceEpoch() +
+            static_cast<int64_t>(_failTimeout * 1000000);
+        LOG_WARN << "The backend " << backend->_host << " of the upstream "
+                 << _name << " is skipped for " << _failTimeout << " seconds";
+    }
+}
+
+ReverseProxy::ReverseProxy()
+{
+}
+
+ReverseProxy::~ReverseProxy()
+{
+}
+
+void ReverseProxy::initAndStart(const Json::Value &config)
+{
+    auto &upstreams = config["upstreams"];
+    for (auto &name : upstreams.getMemberNames())
+    {
+        auto &upstreamConfig = upstreams[name];
+        auto upstream = std::make_shared<Upstream>();
+        upstream->_name = name;
+        auto connectionsPerLoop =
+            upstreamConfig.get("connections_per_loop", 4).asUInt();
+        auto idleTimeout = upstreamConfig.get("idle_timeout", 60.0).asDouble();
+        for (auto &host : upstreamConfig["backends"])
+        {
+            auto backend = std::make_unique<Backend>(host.asString());
+            backend->_pool = HttpClient::newHttpClientPool(backend->_host,
+                                                           connectionsPerLoop,
+                                                           idleTimeout);
+            upstream->_backends.push_back(std::move(backend));
+        }
+        if (upstream->_backends.empty())
+        {
+            LOG_ERROR << "The upstream " << name << " has no backend";
+            continue;
+        }
+        auto balance = upstreamConfig.get("balance", "round_robin").asString();
+        if (balance == "least_connections")
+        {
+            upstream->_balance = Upstream::Balance::LeastConnections;
+        }
+        else if (balance == "consistent_hash")
+        {
+            upstream->_balance = Upstream::Balance::ConsistentHash;
+            auto key = upstreamConfig.get("hash_key", "ip").asString();
+            if (key == "path")
+            {
+                upstream->_hashKey = Upstream::HashKey::Path;
+            }
+            else if (key.find("header:") == 0)
+            {
+                upstream->_hashKey = Upstream::HashKey::Header;
+                upstream->_hashHeader = toLower(key.substr(7));
+            }
+            else if (key != "ip")
+            {
+                LOG_ERROR << "Unknown hash key " << key << ", use ip";
+            }
+            for (auto &backend : upstream->_backends)
+            {
+                for (size_t i = 0; i < virtualNodesNumber; ++i)
+                {
+                    upstream->_ring.emplace_back(
+                        std::hash<std::string>()(backend->_host + "#" +
+                                                 std::to_string(i)),
+                        backend.get());
+                }
+            }
+            std::sort(upstream->_ring.begin(),
+                      upstream->_ring.end(),
+                      [](const std::pair<size_t, Backend *> &node1,
+                         const std::pair<size_t, Backend *> &node2) {
+                          return node1.first < node2.first;
+                      });
+        }
+        else if (balance != "round_robin")
+        {
+            LOG_ERROR << "Unknown balance method " << balance
+                      << ", use round_robin";
+        }
+        upstream->_maxFails = upstreamConfig.get("max_fails", 3).asUInt();
+        upstream->_failTimeout =
+            upstreamConfig.get("fail_timeout", 10.0).asDouble();
+        upstream->_timeout = upstreamConfig.get("timeout", 60.0).asDouble();
+        _upstreams[name] = upstream;
+    }
+
+    for (auto &routeConfig : config["routes"])
+    {
+        Route route;
+        route._pathPrefix = routeConfig.get("path_prefix", "/").asString();
+        auto upstreamName = routeConfig.get("upstream", "").asString();
+        auto iter = _upstreams.find(upstreamName);
+        if (iter == _upstreams.end())
+        {
+            LOG_ERROR << "The upstream " << upstreamName << " of the route "
+                      << route._pathPrefix << " is not defined";
+            continue;
+        }
+        route._upstream = iter->second;
+        if (routeConfig.isMember("rewrite_prefix"))
+        {
+            route._rewritePath = true;
+            route._rewritePrefix = routeConfig["rewrite_prefix"].asString();
+        }
+        loadHeaders(routeConfig["set_request_headers"],
+                    route._setRequestHeaders);
+        loadHeaderNames(routeConfig["remove_request_headers"],
+                        route._removeRequestHeaders);
+        loadHeaders(routeConfig["set_response_headers"],
+                    route._setResponseHeaders);
+        loadHeaderNames(routeConfig["remove_response_headers"],
+                        route._removeResponseHeaders);
+        _routes.push_back(std::move(route));
+    }
+    _xForwardedFor = config.get("x_forwarded_for", true).asBool();
+    if (_routes.empty())
+        return;
+
+    app().registerPreRoutingAdvice([this](const HttpRequestPtr &req,
+                                          AdviceCallback &&acb,
+                                          AdviceChainCallback &&accb) {
+        auto &path = req->path();
+        for (auto &route : _routes)
+        {
+            if (matchPrefix(path, route._pathPrefix))
+            {
+                proxy(req, route, std::move(acb));
+                return;
+            }
+        }
+        accb();
+    });
+}
+
+void ReverseProxy::shutdown()
+{
+}
+
+void ReverseProxy::proxy(const HttpRequestPtr &req,
+                         const Route &route,
+                         AdviceCallback &&callback)
+{
+    // The request parser answers 405 to the methods it doesn't know, this
+    // guards against a request the client couldn't serialize.
+    switch (req->method())
+    {
+        case Get:
+        case Post:
+        case Head:
+        case Put:
+        case Delete:
+        case Options:
+            break;
+        default:
+        {
+            auto resp = HttpResponse::newHttpResponse();
+            resp->setStatusCode(k501NotImplemented);
+            callback(resp);
+            return;
+        }
+    }
+    auto upstreamReq = std::make_shared<HttpRequestImpl>(nullptr);
+    upstreamReq->setMethod(req->method());
+    upstreamReq->setVersion(HttpRequest::kHttp11);
+    if (route._rewritePath)
+    {
+        upstreamReq->setPath(route._rewritePrefix +
+                             req->path().substr(route._pathPrefix.length()));
+    }
+    else
+    {
+        upstreamReq->setPath(req->path());
+    }
+    upstreamReq->setQuery(req->query());
+
+    // The Host header is set to the backend by the client.
+    for (auto &header : req->headers())
+    {
+        auto &field = header.first;
+        if (isHopByHopHeader(field) || field == "host" ||
+            field == "content-length" || route.isReplacedRequestHeader(field))
+            continue;
+        if (field == "content-type")
+        {
+            upstreamReq->setCustomContentTypeString("Content-Type: " +
+                                                    header.second + "\r\n");
+            continue;
+        }
+        upstreamReq->addHeader(field, header.second);
+    }
+    if (!req->cookies().empty() && !route.isReplacedRequestHeader("cookie"))
+    {
+        std::string cookies;
+        for (auto &cookie : req->cookies())
+        {
+            if (!cookies.empty())
+                cookies.append("; ");
+            cookies.append(cookie.first);
+            cookies.append("=");
+            cookies.append(cookie.second);
+        }
+        upstreamReq->addHeader("cookie", cookies);
+    }
+    if (_xForwardedFor)
+    {
+        auto forwardedFor = req->getHeader("x-forwarded-for");
+        if (!forwardedFor.empty())
+            forwardedFor.append(", ");
+        forwardedFor.append(req->peerAddr().toIp());
+        upstreamReq->addHeader("x-forwarded-for", forwardedFor);
+        auto &host = req->getHeader("host");
+        if (!host.empty() && req->getHeader("x-forwarded-host").empty())
+            upstreamReq->addHeader("x-forwarded-host", host);
+    }
+    for (auto &header : route._setRequestHeaders)
+    {
+        upstreamReq->addHeader(header.first, header.second);
+    }
+    if (req->bodyLength() > 0)
+    {
+        upstreamReq->setBody(std::string(req->bodyData(), req->bodyLength()));
+    }
+
+    sendToBackend(req,
+                  upstreamReq,
+                  route,
+                  std::make_shared<AdviceCallback>(std::move(callback)),
+                  std::vector<Backend *>());
+}
+
+void ReverseProxy::sendToBackend(
+    const HttpRequestPtr &req,
+    const HttpRequestPtr &upstreamReq,
+    const Route &route,
+    const std::shared_ptr<AdviceCallback> &callback,
+    std::vector<Backend *> &&triedBackends)
+{
+    auto upstream = route._upstream.get();
+    auto backend = upstream->choose(req, triedBackends);
+    if (!backend)
+    {
+        auto resp = HttpResponse::newHttpResponse();
+        resp->setStatusCode(k502BadGateway);
+        (*callback)(resp);
+        return;
+    }
+    triedBackends.push_back(backend);
+    auto activeRequest = std::make_shared<ActiveRequest>(backend);
+    auto tried = std::make_shared<std::vector<Backend *>>(
+        std::move(triedBackends));
+    backend->_pool->forwardRequest(
+        upstreamReq,
+        [this,
+         req,
+         upstreamReq,
+         &route,
+         callback,
+         upstream,
+         backend,
+         tried,
+         activeRequest](ReqResult result, const HttpResponsePtr &resp) {
+            if (result != ReqResult::Ok)
+            {
+                LOG_ERROR << "Failed to forward " << req->path() << " to "
+                          << backend->_host;
+                upstream->onResult(backend, true);
+                // The request hasn't been sent if the connection failed.
+                if (result == ReqResult::BadServerAddress &&
+                    tried->size() < upstream->_backends.size())
+                {
+                    sendToBackend(req,
+                                  upstreamReq,
+                                  route,
+                                  callback,
+                                  std::move(*tried));
+                    return;
+                }
+                auto errorResp = HttpResponse::newHttpResponse();
+                errorResp->setStatusCode(result == ReqResult::Timeout
+                                             ? k504GatewayTimeout
+                                             : k502BadGateway);
+                (*callback)(errorResp);
+                return;
+            }
+            upstream->onResult(backend, false);
+            for (auto &field : route._removeResponseHeaders)
+            {
+                resp->removeHeader(field);
+            }
+            for (auto &header : route._setResponseHeaders)
+            {
+                resp->removeHeader(header.first);
+                resp->addHeader(header.first, header.second);
+            }
+            (*callback)(resp);
+        },
+        [activeRequest](ReqResult) {},
+        upstream->_timeout);
+}
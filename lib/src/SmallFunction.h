@@ -0,0 +1,175 @@
+/**
+ *
+ *  SmallFunction.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace drogon
+{
+template <typename Signature, size_t BufferSize = 64>
+class SmallFunction;
+
+/// A move-only std::function with a larger inline buffer
+/**
+ * A callable which fits in the buffer and is nothrow movable is stored in
+ * place, so a lambda capturing a few pointers and shared_ptrs doesn't
+ * allocate, while the std::function of libstdc++ only keeps two pointers in
+ * place. Larger callables are stored on the heap.
+ */
+template <typename R, typename... Args, size_t BufferSize>
+class SmallFunction<R(Args...), BufferSize>
+{
+  public:
+    SmallFunction() = default;
+    SmallFunction(std::nullptr_t)
+    {
+    }
+    template <typename F,
+              typename = typename std::enable_if<
+                  !std::is_same<typename std::decay<F>::type,
+                                SmallFunction>::value>::type>
+    SmallFunction(F &&f)
+    {
+        typedef typename std::decay<F>::type Functor;
+        init(std::forward<F>(f),
+             std::integral_constant<
+                 bool,
+                 sizeof(Functor) <= BufferSize &&
+                     alignof(Functor) <= alignof(Storage) &&
+                     std::is_nothrow_move_constructible<Functor>::value>());
+    }
+    SmallFunction(SmallFunction &&that) noexcept
+    {
+        moveFrom(that);
+    }
+    SmallFunction &operator=(SmallFunction &&that) noexcept
+    {
+        if (this != &that)
+        {
+            reset();
+            moveFrom(that);
+        }
+        return *this;
+    }
+    SmallFunction(const SmallFunction &) = delete;
+    SmallFunction &operator=(const SmallFunction &) = delete;
+    ~SmallFunction()
+    {
+        reset();
+    }
+
+    explicit operator bool() const
+    {
+        return _ops != nullptr;
+    }
+    R operator()(Args... args)
+    {
+        return _ops->invoke(&_storage, std::forward<Args>(args)...);
+    }
+    void reset()
+    {
+        if (_ops)
+        {
+            _ops->destroy(&_storage);
+            _ops = nullptr;
+        }
+    }
+
+  private:
+    typedef typename std::aligned_storage<BufferSize>::type Storage;
+    struct Ops
+    {
+        R (*invoke)(void *, Args &&...);
+        // Move the callable to the new storage and destroy the old one
+        void (*move)(void *, void *);
+        void (*destroy)(void *);
+    };
+    template <typename F>
+    struct InlineOps
+    {
+        static R invoke(void *p, Args &&... args)
+        {
+            return (*static_cast<F *>(p))(std::forward<Args>(args)...);
+        }
+        static void move(void *from, void *to)
+        {
+            new (to) F(std::move(*static_cast<F *>(from)));
+            static_cast<F *>(from)->~F();
+        }
+        static void destroy(void *p)
+        {
+            static_cast<F *>(p)->~F();
+        }
+        static const Ops *ops()
+        {
+            static const Ops operations = {&invoke, &move, &destroy};
+            return &operations;
+        }
+    };
+    template <typename F>
+    struct HeapOps
+    {
+        static R invoke(void *p, Args &&... args)
+        {
+            return (**static_cast<F **>(p))(std::forward<Args>(args)...);
+        }
+        static void move(void *from, void *to)
+        {
+            *static_cast<F **>(to) = *static_cast<F **>(from);
+        }
+        static void destroy(void *p)
+        {
+            delete *static_cast<F **>(p);
+        }
+        static const Ops *ops()
+        {
+            static const Ops operations = {&invoke, &move, &destroy};
+            return &operations;
+        }
+    };
+
+    template <typename F>
+    void init(F &&f, std::true_type)
+    {
+        typedef typename std::decay<F>::type Functor;
+        new (&_storage) Functor(std::forward<F>(f));
+        _ops = InlineOps<Functor>::ops();
+    }
+    template <typename F>
+    void init(F &&f, std::false_type)
+    {
+        typedef typename std::decay<F>::type Functor;
+        *reinterpret_cast<Functor **>(&_storage) =
+            new Functor(std::forward<F>(f));
+        _ops = HeapOps<Functor>::ops();
+    }
+    void moveFrom(SmallFunction &that)
+    {
+        _ops = that._ops;
+        if (_ops)
+        {
+            _ops->move(&that._storage, &_storage);
+            that._ops = nullptr;
+        }
+    }
+
+    Storage _storage;
+    const Ops *_ops = nullptr;
+};
+
+}  // namespace drogon
@@ -13,11 +13,11 @@
  */
 
 #include "StaticFileRouter.h"
+#include "AsyncFileReader.h"
 #include "HttpAppFrameworkImpl.h"
 #include "HttpRequestImpl.h"
 #include "HttpResponseImpl.h"
 
-#include <fstream>
 #include <iostream>
 
 #include <fcntl.h>
@@ -133,52 +133,64 @@ void StaticFileRouter::route(
                                                               callback);
                 return;
             }
-            HttpResponsePtr resp;
+            // Find compressed file first.
+            std::string fileToSend = filePath;
+            bool compressed = false;
+            struct stat fileStat;
             if (_gzipStaticFlag &&
                 req->getHeaderBy("accept-encoding").find("gzip") !=
-                    std::string::npos)
+                    std::string::npos &&
+                stat((filePath + ".gz").c_str(), &fileStat) == 0 &&
+                S_ISREG(fileStat.st_mode))
             {
-                // Find compressed file first.
-                auto gzipFileName = filePath + ".gz";
-                std::ifstream infile(gzipFileName, std::ifstream::binary);
-                if (infile)
-                {
-                    resp = HttpResponse::newFileResponse(
-                        gzipFileName, "", drogon::getContentType(filePath));
-                    resp->addHeader("Content-Encoding", "gzip");
-                }
+                fileToSend = filePath + ".gz";
+                compressed = true;
             }
-            if (!resp)
-                resp = HttpResponse::newFileResponse(filePath);
-            if (resp->statusCode() != k404NotFound)
+            else if (stat(filePath.c_str(), &fileStat) != 0 ||
+                     !S_ISREG(fileStat.st_mode))
             {
-                if (!timeStr.empty())
-                {
-                    resp->addHeader("Last-Modified", timeStr);
-                    resp->addHeader("Expires", "Thu, 01 Jan 1970 00:00:00 GMT");
-                }
-                // cache the response for 5 seconds by default
-                if (_staticFilesCacheTime >= 0)
-                {
-                    resp->setExpiredTime(_staticFilesCacheTime);
-                    _responseCachingMap->insert(
-                        filePath, resp, resp->expiredTime(), [=]() {
-                            std::lock_guard<std::mutex> guard(
-                                _staticFilesCacheMutex);
-                            _staticFilesCache.erase(filePath);
-                        });
-                    {
-                        std::lock_guard<std::mutex> guard(
-                            _staticFilesCacheMutex);
-                        _staticFilesCache[filePath] = resp;
-                    }
-                }
-                HttpAppFrameworkImpl::instance().callCallback(req,
-                                                              resp,
-                                                              callback);
+                callback(HttpResponse::newNotFoundResponse());
+                return;
+            }
+            auto fileSize = static_cast<size_t>(fileStat.st_size);
+            auto reader = AsyncFileReader::instance();
+            // The large files are sent by sendfile(), see
+            // HttpResponse::newFileResponse()
+            if (reader && !(HttpAppFrameworkImpl::instance().useSendfile() &&
+                            fileSize > 1024 * 200))
+            {
+                reader->read(
+                    fileToSend,
+                    fileSize,
+                    [this, req, callback, filePath, timeStr, compressed](
+                        int error, std::string &&content) {
+                        if (error)
+                        {
+                            callback(HttpResponse::newNotFoundResponse());
+                            return;
+                        }
+                        auto resp = std::make_shared<HttpResponseImpl>();
+                        resp->setStatusCode(k200OK);
+                        resp->setBody(std::move(content));
+                        resp->setContentTypeCode(
+                            drogon::getContentType(filePath));
+                        if (compressed)
+                            resp->addHeader("Content-Encoding", "gzip");
+                        sendStaticFileResponse(
+                            req, filePath, timeStr, resp, callback);
+                    });
                 return;
             }
-            callback(resp);
+            auto resp = HttpResponse::newFileResponse(
+                fileToSend, "", drogon::getContentType(filePath));
+            if (resp->statusCode() == k404NotFound)
+            {
+                callback(resp);
+                return;
+            }
+            if (compressed)
+                resp->addHeader("Content-Encoding", "gzip");
+            sendStaticFileResponse(req, filePath, timeStr, resp, callback);
             return;
         }
     }
@@ -186,6 +198,35 @@ void StaticFileRouter::route(
     callback(HttpResponse::newNotFoundResponse());
 }
 
+void StaticFileRouter::sendStaticFileResponse(
+    const HttpRequestImplPtr &req,
+    const std::string &filePath,
+    const std::string &timeStr,
+    const HttpResponsePtr &resp,
+    const std::function<void(const HttpResponsePtr &)> &callback)
+{
+    if (!timeStr.empty())
+    {
+        resp->addHeader("Last-Modified", timeStr);
+        resp->addHeader("Expires", "Thu, 01 Jan 1970 00:00:00 GMT");
+    }
+    // cache the response for 5 seconds by default
+    if (_staticFilesCacheTime >= 0)
+    {
+        resp->setExpiredTime(_staticFilesCacheTime);
+        _responseCachingMap->insert(
+            filePath, resp, resp->expiredTime(), [=]() {
+                std::lock_guard<std::mutex> guard(_staticFilesCacheMutex);
+                _staticFilesCache.erase(filePath);
+            });
+        {
+            std::lock_guard<std::mutex> guard(_staticFilesCacheMutex);
+            _staticFilesCache[filePath] = resp;
+        }
+    }
+    HttpAppFrameworkImpl::instance().callCallback(req, resp, callback);
+}
+
 void StaticFileRouter::setFileTypes(const std::vector<std::string> &types)
 {
     _fileTypeSet.clear();
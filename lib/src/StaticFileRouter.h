@@ -44,6 +44,13 @@ class StaticFileRouter
     void init();
 
   private:
+    void sendStaticFileResponse(
+        const HttpRequestImplPtr &req,
+        const std::string &filePath,
+        const std::string &timeStr,
+        const HttpResponsePtr &resp,
+        const std::function<void(const HttpResponsePtr &)> &callback);
+
     std::set<std::string> _fileTypeSet = {"html",
                                           "js",
                                           "css",
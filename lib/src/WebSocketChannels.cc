@@ -0,0 +1,137 @@
+/**
+ *
+ *  WebSocketChannels.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "WebSocketConnectionImpl.h"
+#include <drogon/WebSocketChannels.h>
+#include <trantor/net/EventLoop.h>
+#include <atomic>
+#include <unordered_map>
+
+using namespace drogon;
+
+namespace drogon
+{
+/// The subscriptions of the connections in one IO loop, only accessed in the
+/// loop.
+struct WebSocketChannels::LoopChannels
+{
+    std::unordered_map<
+        std::string,
+        std::unordered_map<WebSocketConnectionImpl *,
+                           std::weak_ptr<WebSocketConnectionImpl>>>
+        _channels;
+};
+}  // namespace drogon
+
+WebSocketChannels::WebSocketChannels() : _loops(std::make_shared<LoopList>())
+{
+}
+
+WebSocketChannels::~WebSocketChannels()
+{
+}
+
+std::shared_ptr<WebSocketChannels::LoopChannels>
+WebSocketChannels::loopChannels(trantor::EventLoop *loop)
+{
+    auto loops = std::atomic_load(&_loops);
+    for (auto &item : *loops)
+    {
+        if (item.first == loop)
+            return item.second;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    loops = std::atomic_load(&_loops);
+    for (auto &item : *loops)
+    {
+        if (item.first == loop)
+            return item.second;
+    }
+    auto newLoops = std::make_shared<LoopList>(*loops);
+    auto channels = std::make_shared<LoopChannels>();
+    newLoops->emplace_back(loop, channels);
+    std::atomic_store(&_loops, std::shared_ptr<const LoopList>(newLoops));
+    return channels;
+}
+
+void WebSocketChannels::subscribe(const std::string &channel,
+                                  const WebSocketConnectionPtr &connection)
+{
+    auto connPtr =
+        std::dynamic_pointer_cast<WebSocketConnectionImpl>(connection);
+    assert(connPtr);
+    auto loop = connPtr->getLoop();
+    auto channels = loopChannels(loop);
+    // Queued, so that the subscriptions are never changed while a message is
+    // being published in the loop.
+    loop->queueInLoop([channels, channel, connPtr]() {
+        channels->_channels[channel][connPtr.get()] = connPtr;
+    });
+}
+
+void WebSocketChannels::unsubscribe(const std::string &channel,
+                                    const WebSocketConnectionPtr &connection)
+{
+    auto connPtr =
+        std::dynamic_pointer_cast<WebSocketConnectionImpl>(connection);
+    assert(connPtr);
+    auto loop = connPtr->getLoop();
+    auto channels = loopChannels(loop);
+    loop->queueInLoop([channels, channel, connPtr]() {
+        auto iter = channels->_channels.find(channel);
+        if (iter == channels->_channels.end())
+            return;
+        iter->second.erase(connPtr.get());
+        if (iter->second.empty())
+            channels->_channels.erase(iter);
+    });
+}
+
+void WebSocketChannels::publish(const std::string &channel,
+                                const std::string &message,
+                                const WebSocketMessageType &type)
+{
+    assert(type == WebSocketMessageType::Text ||
+           type == WebSocketMessageType::Binary);
+    auto loops = std::atomic_load(&_loops);
+    if (loops->empty())
+        return;
+    auto broadcast = std::make_shared<const BroadcastMessage>(
+        message, type == WebSocketMessageType::Binary ? 2 : 1);
+    for (auto &item : *loops)
+    {
+        auto &channels = item.second;
+        item.first->runInLoop([channels, channel, broadcast]() {
+            auto iter = channels->_channels.find(channel);
+            if (iter == channels->_channels.end())
+                return;
+            BroadcastFrames frames(broadcast);
+            auto &connections = iter->second;
+            for (auto connIter = connections.begin();
+                 connIter != connections.end();)
+            {
+                auto connPtr = connIter->second.lock();
+                if (!connPtr || connPtr->disconnected())
+                {
+                    connIter = connections.erase(connIter);
+                    continue;
+                }
+                connPtr->sendBroadcast(frames);
+                ++connIter;
+            }
+            if (connections.empty())
+                channels->_channels.erase(iter);
+        });
+    }
+}
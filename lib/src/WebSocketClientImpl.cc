@@ -88,6 +88,12 @@ void WebSocketClientImpl::createTcpClient()
                 thisPtr->onRecvMessage(connPtr, msg);
             }
         });
+    _tcpClient->setWriteCompleteCallback(
+        [weakPtr](const trantor::TcpConnectionPtr &) {
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr && thisPtr->_websockConnPtr)
+                thisPtr->_websockConnPtr->onWriteComplete();
+        });
     _tcpClient->connect();
 }
 void WebSocketClientImpl::connectToServerInLoop()
@@ -126,37 +132,28 @@ void WebSocketClientImpl::connectToServerInLoop()
         }
     }
 
-    if (_server.ipNetEndian() == 0 && !hasIpv6Address && !_domain.empty() &&
-        _server.portNetEndian() != 0)
+    // The host name is resolved for every connection, so that the cached
+    // addresses are used in turn and changes are seen after the TTL.
+    if (_isDomainName && _server.portNetEndian() != 0)
     {
-        if (!_resolver)
-        {
-            _resolver = trantor::Resolver::newResolver(_loop);
-        }
-        _resolver->resolve(
+        HttpAppFrameworkImpl::instance().getDnsCache().resolve(
             _domain,
-            [thisPtr = shared_from_this(),
-             hasIpv6Address](const trantor::InetAddress &addr) {
-                thisPtr->_loop->runInLoop([thisPtr, addr, hasIpv6Address]() {
-                    struct sockaddr_in ad;
-                    auto port = thisPtr->_server.portNetEndian();
-                    thisPtr->_server = addr;
-                    thisPtr->_server.setPortNetEndian(port);
-                    LOG_TRACE << "dns:domain=" << thisPtr->_domain
-                              << ";ip=" << thisPtr->_server.toIp();
-                    if ((thisPtr->_server.ipNetEndian() != 0 ||
-                         hasIpv6Address) &&
-                        thisPtr->_server.portNetEndian() != 0)
-                    {
-                        thisPtr->createTcpClient();
-                    }
-                    else
+            [thisPtr = shared_from_this()](bool found,
+                                           const trantor::InetAddress &addr) {
+                thisPtr->_loop->runInLoop([thisPtr, found, addr]() {
+                    if (!found)
                     {
                         thisPtr->_requestCallback(ReqResult::BadServerAddress,
                                                   nullptr,
                                                   thisPtr);
                         return;
                     }
+                    auto port = thisPtr->_server.portNetEndian();
+                    thisPtr->_server = addr;
+                    thisPtr->_server.setPortNetEndian(port);
+                    LOG_TRACE << "dns:domain=" << thisPtr->_domain
+                              << ";ip=" << thisPtr->_server.toIp();
+                    thisPtr->createTcpClient();
                 });
             });
         return;
@@ -362,6 +359,7 @@ WebSocketClientImpl::WebSocketClientImpl(trantor::EventLoop *loop,
             }
         }
     }
+    _isDomainName = !_domain.empty() && DnsCache::isUnspecified(_server);
     LOG_TRACE << "userSSL=" << _useSSL << " domain=" << _domain;
 }
 
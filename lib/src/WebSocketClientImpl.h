@@ -95,7 +95,7 @@ class WebSocketClientImpl
                          trantor::MsgBuffer *);
     void reconnect();
     void createTcpClient();
-    std::shared_ptr<trantor::Resolver> _resolver;
+    bool _isDomainName = false;
 };
 
 }  // namespace drogon
@@ -14,10 +14,51 @@
 
 #include "WebSocketConnectionImpl.h"
 #include "HttpAppFrameworkImpl.h"
+#include <limits>
+#include <string.h>
 #include <thread>
 #include <trantor/net/inner/TcpConnectionImpl.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using namespace drogon;
+
+namespace
+{
+/// XOR the data with the masking key (rfc6455-5.3), dest may be equal to src.
+void maskData(char *dest,
+              const char *src,
+              size_t length,
+              const unsigned char *mask)
+{
+    // A word of the key repeated, the words start at multiples of 4 bytes so
+    // the key is never rotated.
+    uint32_t mask32;
+    memcpy(&mask32, mask, 4);
+    uint64_t mask64 = ((uint64_t)mask32 << 32) | mask32;
+    size_t i = 0;
+#ifdef __SSE2__
+    auto mask128 = _mm_set1_epi32((int)mask32);
+    for (; i + 16 <= length; i += 16)
+    {
+        auto data = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dest + i), _mm_xor_si128(data, mask128));
+    }
+#endif
+    for (; i + 8 <= length; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, src + i, 8);
+        word ^= mask64;
+        memcpy(dest + i, &word, 8);
+    }
+    for (; i < length; ++i)
+    {
+        dest[i] = src[i] ^ mask[i % 4];
+    }
+}
+}  // namespace
 WebSocketConnectionImpl::WebSocketConnectionImpl(
     const trantor::TcpConnectionPtr &conn,
     bool isServer)
@@ -66,12 +107,87 @@ void WebSocketConnectionImpl::sendWsData(const char *msg,
 {
     LOG_TRACE << "send " << len << " bytes";
 
+    if (opcode == 1 || opcode == 2)
+    {
+        auto loop = _tcpConn->getLoop();
+        if (((_deflate && _deflate->hasOwnDeflater()) ||
+             _sendQueueOptions._highWaterMark > 0) &&
+            !loop->isInLoopThread())
+        {
+            // The context of the connection and the send queue must be
+            // updated in the same order as the messages are sent.
+            loop->queueInLoop([thisPtr = shared_from_this(),
+                               data = std::string(msg, len),
+                               opcode]() {
+                thisPtr->sendWsData(data.data(), data.length(), opcode);
+            });
+            return;
+        }
+        if (_isCongested)
+        {
+            // Encoded when it is sent, so that a message dropped from the
+            // queue never updates the compression context.
+            queueMessage({nullptr, std::string(msg, len), opcode});
+            return;
+        }
+    }
+    sendFrame(msg, len, opcode);
+}
+
+void WebSocketConnectionImpl::sendFrame(const char *msg,
+                                        uint64_t len,
+                                        unsigned char opcode)
+{
+    std::string compressedData;
+    bool isCompressed = false;
+    if (_deflate && (opcode == 1 || opcode == 2))
+    {
+        if (_deflate->compress(msg, len, compressedData))
+        {
+            msg = compressedData.data();
+            len = compressedData.length();
+            isCompressed = true;
+        }
+    }
+
     // Format the frame
     std::string bytesFormatted;
+    auto indexStartRawData =
+        formatFrameHeader(bytesFormatted, len, opcode, isCompressed);
+    if (!_isServer)
+    {
+        // Add masking key;
+        static std::once_flag once;
+        std::call_once(once, []() { std::srand(time(nullptr)); });
+        int random = std::rand();
+
+        bytesFormatted[1] = (bytesFormatted[1] | 0x80);
+        bytesFormatted.resize(indexStartRawData + 4 + len);
+        *((int *)&bytesFormatted[indexStartRawData]) = random;
+        maskData(&bytesFormatted[indexStartRawData + 4],
+                 msg,
+                 len,
+                 (const unsigned char *)&bytesFormatted[indexStartRawData]);
+    }
+    else
+    {
+        bytesFormatted.resize(indexStartRawData);
+        bytesFormatted.append(msg, len);
+    }
+    _tcpConn->send(std::move(bytesFormatted));
+}
+
+size_t WebSocketConnectionImpl::formatFrameHeader(std::string &bytesFormatted,
+                                                  uint64_t len,
+                                                  unsigned char opcode,
+                                                  bool isCompressed)
+{
     bytesFormatted.resize(len + 10);
-    bytesFormatted[0] = char(0x80 | (opcode & 0x0f));
+    // rfc7692-6, the RSV1 bit of a compressed message is set
+    bytesFormatted[0] =
+        char(0x80 | (isCompressed ? 0x40 : 0) | (opcode & 0x0f));
 
-    int indexStartRawData = -1;
+    size_t indexStartRawData;
 
     if (len <= 125)
     {
@@ -101,28 +217,175 @@ void WebSocketConnectionImpl::sendWsData(const char *msg,
 
         indexStartRawData = 10;
     }
-    if (!_isServer)
+    return indexStartRawData;
+}
+
+std::shared_ptr<std::string> WebSocketConnectionImpl::makeServerFrame(
+    const char *msg,
+    uint64_t len,
+    unsigned char opcode,
+    bool isCompressed)
+{
+    auto frame = std::make_shared<std::string>();
+    auto indexStartRawData =
+        formatFrameHeader(*frame, len, opcode, isCompressed);
+    frame->resize(indexStartRawData);
+    frame->append(msg, len);
+    return frame;
+}
+
+BroadcastMessage::BroadcastMessage(const std::string &message,
+                                   unsigned char opcode)
+    : _opcode(opcode),
+      _frame(WebSocketConnectionImpl::makeServerFrame(message.data(),
+                                                      message.length(),
+                                                      opcode,
+                                                      false)),
+      _payloadOffset(_frame->length() - message.length())
+{
+}
+
+void WebSocketConnectionImpl::sendBroadcast(BroadcastFrames &frames)
+{
+    _tcpConn->getLoop()->assertInLoopThread();
+    auto &message = *frames._message;
+    if (!_isServer || (_deflate && _deflate->hasOwnDeflater()))
     {
-        // Add masking key;
-        static std::once_flag once;
-        std::call_once(once, []() { std::srand(time(nullptr)); });
-        int random = std::rand();
+        // The frame is masked or compressed for this connection only
+        sendWsData(message.payload(),
+                   message.payloadLength(),
+                   message._opcode);
+        return;
+    }
+    if (!_deflate)
+    {
+        sendEncodedFrame(message._frame, message._opcode);
+        return;
+    }
+    // Connections which share the compression context of the loop share the
+    // compressed frame too.
+    auto &frame = frames._compressedFrames[_deflate->sendWindowBits()];
+    if (!frame)
+    {
+        std::string compressedData;
+        if (_deflate->compress(message.payload(),
+                               message.payloadLength(),
+                               compressedData))
+            frame = makeServerFrame(compressedData.data(),
+                                    compressedData.length(),
+                                    message._opcode,
+                                    true);
+        else
+            frame = message._frame;
+    }
+    sendEncodedFrame(frame, message._opcode);
+}
 
-        bytesFormatted[1] = (bytesFormatted[1] | 0x80);
-        bytesFormatted.resize(indexStartRawData + 4 + len);
-        *((int *)&bytesFormatted[indexStartRawData]) = random;
-        for (size_t i = 0; i < len; i++)
+void WebSocketConnectionImpl::sendEncodedFrame(
+    const std::shared_ptr<std::string> &frame,
+    unsigned char opcode)
+{
+    if (_isCongested)
+        queueMessage({frame, std::string(), opcode});
+    else
+        _tcpConn->send(frame);
+}
+
+void WebSocketConnectionImpl::setSendQueueOptions(
+    const WebSocketSendQueueOptions &options)
+{
+    _sendQueueOptions = options;
+    if (options._highWaterMark == 0)
+        return;
+    std::weak_ptr<WebSocketConnectionImpl> weakPtr = shared_from_this();
+    _tcpConn->setHighWaterMarkCallback(
+        [weakPtr](const trantor::TcpConnectionPtr &, const size_t size) {
+            auto thisPtr = weakPtr.lock();
+            if (!thisPtr)
+                return;
+            thisPtr->_isCongested = true;
+            if (thisPtr->_highWaterMarkCallback)
+                thisPtr->_highWaterMarkCallback(thisPtr, size);
+        },
+        options._highWaterMark);
+}
+
+void WebSocketConnectionImpl::queueMessage(QueuedMessage &&message)
+{
+    if (!_tcpConn->connected())
+        return;
+    auto length = message.length();
+    auto maxSize = _sendQueueOptions._maxQueueSize;
+    while (maxSize > 0 && _sendQueueBytes + length > maxSize)
+    {
+        switch (_sendQueueOptions._policy)
         {
-            bytesFormatted[indexStartRawData + 4 + i] =
-                (msg[i] ^ bytesFormatted[indexStartRawData + (i % 4)]);
+            case WebSocketSendQueuePolicy::DropOldest:
+                if (_sendQueue.empty())
+                {
+                    LOG_DEBUG << "Drop a WebSocket message of " << length
+                              << " bytes larger than the send queue";
+                    return;
+                }
+                _sendQueueBytes -= _sendQueue.front().length();
+                _sendQueue.pop_front();
+                LOG_DEBUG << "Drop the oldest message in the send queue";
+                break;
+            case WebSocketSendQueuePolicy::DropNewest:
+                LOG_DEBUG << "Drop a WebSocket message, the send queue is full";
+                return;
+            case WebSocketSendQueuePolicy::CloseWithPolicyViolation:
+                closeWithStatus(1008);
+                return;
+            case WebSocketSendQueuePolicy::CloseWithTryAgainLater:
+                closeWithStatus(1013);
+                return;
         }
     }
-    else
+    _sendQueueBytes += length;
+    _sendQueue.push_back(std::move(message));
+}
+
+void WebSocketConnectionImpl::onWriteComplete()
+{
+    if (!_isCongested)
+        return;
+    // Move at most one high water mark of messages into the drained output
+    // buffer, the rest waits for the next completion.
+    _isCongested = false;
+    size_t sentBytes = 0;
+    while (!_sendQueue.empty())
     {
-        bytesFormatted.resize(indexStartRawData);
-        bytesFormatted.append(msg, len);
+        if (sentBytes >= _sendQueueOptions._highWaterMark)
+        {
+            _isCongested = true;
+            break;
+        }
+        auto message = std::move(_sendQueue.front());
+        _sendQueue.pop_front();
+        auto length = message.length();
+        _sendQueueBytes -= length;
+        sentBytes += length;
+        if (message._frame)
+            _tcpConn->send(message._frame);
+        else
+            sendFrame(message._message.data(),
+                      message._message.length(),
+                      message._opcode);
     }
-    _tcpConn->send(std::move(bytesFormatted));
+}
+
+void WebSocketConnectionImpl::closeWithStatus(unsigned short code)
+{
+    LOG_WARN << "The send queue of the WebSocket connection to "
+             << _peerAddr.toIpPort() << " is full, close it with status "
+             << code;
+    _sendQueue.clear();
+    _sendQueueBytes = 0;
+    // rfc6455-5.5.1, the body of a close frame starts with the status code
+    char body[2] = {char(code >> 8), char(code & 0xff)};
+    sendFrame(body, 2, 8);
+    _tcpConn->shutdown();
 }
 void WebSocketConnectionImpl::send(const std::string &msg,
                                    const WebSocketMessageType &type)
@@ -207,6 +470,17 @@ bool WebSocketMessageParser::parse(trantor::MsgBuffer *buffer)
                 break;
         }
 
+        bool isRsv1 = (((*buffer)[0] & 0x40) == 0x40);
+        if (isRsv1 && (!_deflate || isControlFrame || opcode == 0))
+        {
+            // rfc7692-6.1, only the first frame of a compressed message has
+            // the RSV1 bit
+            LOG_ERROR << "Bad frame: unexpected RSV1 bit";
+            return false;
+        }
+        if (opcode == 1 || opcode == 2)
+            _isCompressed = isRsv1;
+
         bool isFin = (((*buffer)[0] & 0x80) == 0x80);
         if (!isFin && isControlFrame)
         {
@@ -279,15 +553,25 @@ bool WebSocketMessageParser::parse(trantor::MsgBuffer *buffer)
             {
                 auto masks = buffer->peek() + indexFirstMask;
                 int indexFirstDataByte = indexFirstMask + 4;
-                auto rawData = buffer->peek() + indexFirstDataByte;
-                auto oldLen = _message.length();
-                _message.resize(oldLen + length);
-                for (size_t i = 0; i < length; i++)
-                {
-                    _message[oldLen + i] = (rawData[i] ^ masks[i % 4]);
-                }
+                // Unmask the payload in the buffer, which is consumed below,
+                // then copy it once.
+                auto rawData =
+                    const_cast<char *>(buffer->peek()) + indexFirstDataByte;
+                maskData(rawData,
+                         rawData,
+                         length,
+                         (const unsigned char *)masks);
+                _message.append(rawData, length);
                 if (isFin)
+                {
+                    if (!isControlFrame && _isCompressed &&
+                        !_deflate->decompress(
+                            _message,
+                            HttpAppFrameworkImpl::instance()
+                                .getClientMaxWebSocketMessageSize()))
+                        return false;
                     _gotAll = true;
+                }
                 buffer->retrieve(indexFirstMask + 4 + length);
                 return true;
             }
@@ -299,7 +583,13 @@ bool WebSocketMessageParser::parse(trantor::MsgBuffer *buffer)
                 auto rawData = buffer->peek() + indexFirstMask;
                 _message.append(rawData, length);
                 if (isFin)
+                {
+                    if (!isControlFrame && _isCompressed &&
+                        !_deflate->decompress(
+                            _message, std::numeric_limits<size_t>::max()))
+                        return false;
                     _gotAll = true;
+                }
                 buffer->retrieve(indexFirstMask + length);
                 return true;
             }
@@ -15,9 +15,12 @@
 #pragma once
 
 #include "impl_forwards.h"
+#include "WebSocketDeflate.h"
 #include <drogon/WebSocketConnection.h>
 #include <trantor/utils/NonCopyable.h>
 #include <trantor/net/TcpConnection.h>
+#include <atomic>
+#include <deque>
 
 namespace drogon
 {
@@ -28,6 +31,12 @@ class WebSocketMessageParser
 {
   public:
     bool parse(trantor::MsgBuffer *buffer);
+    /// Messages with the RSV1 bit set are decompressed by the deflate object
+    /// if it is not null, or rejected otherwise.
+    void setDeflate(WebSocketDeflate *deflate)
+    {
+        _deflate = deflate;
+    }
     bool gotAll(std::string &message, WebSocketMessageType &type)
     {
         assert(message.empty());
@@ -42,6 +51,45 @@ class WebSocketMessageParser
     std::string _message;
     WebSocketMessageType _type;
     bool _gotAll = false;
+    bool _isCompressed = false;
+    WebSocketDeflate *_deflate = nullptr;
+};
+
+/// A data message sent to many connections by a server
+/**
+ * The uncompressed frame is encoded once and shared by all connections. The
+ * message is only kept in the frame, the connections which encode their own
+ * frames read it from there.
+ */
+struct BroadcastMessage
+{
+    BroadcastMessage(const std::string &message, unsigned char opcode);
+    const char *payload() const
+    {
+        return _frame->data() + _payloadOffset;
+    }
+    size_t payloadLength() const
+    {
+        return _frame->length() - _payloadOffset;
+    }
+    const unsigned char _opcode;
+    const std::shared_ptr<std::string> _frame;
+    // The length of the frame header
+    const size_t _payloadOffset;
+};
+
+/// The frames of a broadcast message sent in one IO loop
+struct BroadcastFrames
+{
+    explicit BroadcastFrames(
+        const std::shared_ptr<const BroadcastMessage> &message)
+        : _message(message)
+    {
+    }
+    std::shared_ptr<const BroadcastMessage> _message;
+    /// The compressed frames for each window size, built by the first
+    /// connection which needs them.
+    std::shared_ptr<std::string> _compressedFrames[16];
 };
 
 class WebSocketConnectionImpl
@@ -74,6 +122,25 @@ class WebSocketConnectionImpl
         const std::string &message,
         const std::chrono::duration<long double> &interval) override;
 
+    virtual void setSendQueueOptions(
+        const WebSocketSendQueueOptions &options) override;
+
+    virtual void setHighWaterMarkCallback(
+        const WebSocketHighWaterMarkCallback &callback) override
+    {
+        _highWaterMarkCallback = callback;
+    }
+
+    virtual size_t sendQueueSize() const override
+    {
+        return _sendQueueBytes;
+    }
+
+    /// Called by the owner of the TCP connection (the HttpServer or the
+    /// WebSocketClientImpl) from the write complete callback of its
+    /// TcpServer or TcpClient, the queued messages are sent then.
+    void onWriteComplete();
+
     void setMessageCallback(
         const std::function<void(std::string &&,
                                  const WebSocketConnectionImplPtr &,
@@ -88,6 +155,29 @@ class WebSocketConnectionImpl
         _closeCallback = callback;
     }
 
+    /// Enable the permessage-deflate extension negotiated in the handshake.
+    void enableDeflate(const PerMessageDeflateParams &params, size_t threshold)
+    {
+        _deflate =
+            std::make_unique<WebSocketDeflate>(params, _isServer, threshold);
+        _parser.setDeflate(_deflate.get());
+    }
+
+    /// Send a broadcast message, must be called in the loop of the
+    /// connection.
+    void sendBroadcast(BroadcastFrames &frames);
+
+    trantor::EventLoop *getLoop()
+    {
+        return _tcpConn->getLoop();
+    }
+
+    /// Encode an unmasked frame.
+    static std::shared_ptr<std::string> makeServerFrame(const char *msg,
+                                                        uint64_t len,
+                                                        unsigned char opcode,
+                                                        bool isCompressed);
+
     void onNewMessage(const trantor::TcpConnectionPtr &connPtr,
                       trantor::MsgBuffer *buffer);
 
@@ -95,6 +185,8 @@ class WebSocketConnectionImpl
     {
         if (_pingTimerId != trantor::InvalidTimerId)
             _tcpConn->getLoop()->invalidateTimer(_pingTimerId);
+        _sendQueue.clear();
+        _sendQueueBytes = 0;
         _closeCallback(shared_from_this());
     }
 
@@ -103,9 +195,30 @@ class WebSocketConnectionImpl
     trantor::InetAddress _localAddr;
     trantor::InetAddress _peerAddr;
     bool _isServer = true;
+    std::unique_ptr<WebSocketDeflate> _deflate;
     WebSocketMessageParser _parser;
     trantor::TimerId _pingTimerId = trantor::InvalidTimerId;
 
+    /// A message held in the send queue, either an encoded frame or a
+    /// message encoded when it is sent.
+    struct QueuedMessage
+    {
+        std::shared_ptr<std::string> _frame;
+        std::string _message;
+        unsigned char _opcode;
+        size_t length() const
+        {
+            return _frame ? _frame->length() : _message.length();
+        }
+    };
+    WebSocketSendQueueOptions _sendQueueOptions;
+    WebSocketHighWaterMarkCallback _highWaterMarkCallback;
+    /// True from the moment the output buffer reaches the high water mark
+    /// until it is drained, only accessed in the loop.
+    bool _isCongested = false;
+    std::deque<QueuedMessage> _sendQueue;
+    std::atomic<size_t> _sendQueueBytes{0};
+
     std::function<void(std::string &&,
                        const WebSocketConnectionImplPtr &,
                        const WebSocketMessageType &)>
@@ -115,6 +228,20 @@ class WebSocketConnectionImpl
     std::function<void(const WebSocketConnectionImplPtr &)> _closeCallback =
         [](const WebSocketConnectionImplPtr &) {};
     void sendWsData(const char *msg, uint64_t len, unsigned char opcode);
+    /// Compress, mask and send a frame without checking the send queue.
+    void sendFrame(const char *msg, uint64_t len, unsigned char opcode);
+    /// Send an encoded data frame or queue it if the connection is
+    /// congested.
+    void sendEncodedFrame(const std::shared_ptr<std::string> &frame,
+                          unsigned char opcode);
+    void queueMessage(QueuedMessage &&message);
+    void closeWithStatus(unsigned short code);
+    /// Format the header of a frame without masking key, return the length
+    /// of the header.
+    static size_t formatFrameHeader(std::string &bytesFormatted,
+                                    uint64_t len,
+                                    unsigned char opcode,
+                                    bool isCompressed);
 };
 
 }  // namespace drogon
@@ -0,0 +1,323 @@
+/**
+ *
+ *  WebSocketDeflate.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "WebSocketDeflate.h"
+#include <drogon/utils/Utilities.h>
+#include <trantor/utils/Logger.h>
+#include <algorithm>
+#include <assert.h>
+#include <zlib.h>
+
+namespace drogon
+{
+struct DeflateStream : public trantor::NonCopyable
+{
+    explicit DeflateStream(int windowBits)
+    {
+        // Negative window bits produce raw deflate data without headers
+        _ok = (deflateInit2(&_strm,
+                            Z_DEFAULT_COMPRESSION,
+                            Z_DEFLATED,
+                            -windowBits,
+                            8,
+                            Z_DEFAULT_STRATEGY) == Z_OK);
+    }
+    ~DeflateStream()
+    {
+        if (_ok)
+            deflateEnd(&_strm);
+    }
+    z_stream _strm = {0};
+    bool _ok;
+};
+
+struct InflateStream : public trantor::NonCopyable
+{
+    InflateStream()
+    {
+        // A window of 15 bits can inflate data compressed with any window
+        _ok = (inflateInit2(&_strm, -15) == Z_OK);
+    }
+    ~InflateStream()
+    {
+        if (_ok)
+            inflateEnd(&_strm);
+    }
+    z_stream _strm = {0};
+    bool _ok;
+};
+}  // namespace drogon
+
+using namespace drogon;
+
+namespace
+{
+// The contexts shared by the connections which reset them after every
+// message, one deflater for every window size.
+thread_local std::unique_ptr<DeflateStream> sharedDeflaters[16];
+thread_local std::unique_ptr<InflateStream> sharedInflater;
+
+std::string trim(const std::string &str)
+{
+    auto begin = str.find_first_not_of(" \t");
+    if (begin == std::string::npos)
+        return std::string();
+    auto end = str.find_last_not_of(" \t");
+    return str.substr(begin, end - begin + 1);
+}
+
+/// Parse the value of a window bits parameter, return 0 if it is invalid.
+int windowBits(std::string value)
+{
+    if (value.length() >= 2 && value.front() == '"' && value.back() == '"')
+        value = value.substr(1, value.length() - 2);
+    if (value.length() == 1 && value[0] >= '8' && value[0] <= '9')
+        return value[0] - '0';
+    if (value.length() == 2 && value[0] == '1' && value[1] >= '0' &&
+        value[1] <= '5')
+        return 10 + value[1] - '0';
+    return 0;
+}
+
+/// Parse one offer of the extension, return false if it can't be accepted.
+bool parseOffer(const std::vector<std::string> &items,
+                bool contextTakeover,
+                PerMessageDeflateParams &params)
+{
+    params = PerMessageDeflateParams();
+    bool hasServerBits = false;
+    bool hasClientBits = false;
+    for (size_t i = 1; i < items.size(); ++i)
+    {
+        auto item = trim(items[i]);
+        std::string name, value;
+        auto pos = item.find('=');
+        if (pos == std::string::npos)
+        {
+            name = item;
+        }
+        else
+        {
+            name = trim(item.substr(0, pos));
+            value = trim(item.substr(pos + 1));
+        }
+        std::transform(name.begin(), name.end(), name.begin(), tolower);
+        if (name == "server_no_context_takeover")
+        {
+            if (params._serverNoContextTakeover || !value.empty())
+                return false;
+            params._serverNoContextTakeover = true;
+        }
+        else if (name == "client_no_context_takeover")
+        {
+            if (params._clientNoContextTakeover || !value.empty())
+                return false;
+            params._clientNoContextTakeover = true;
+        }
+        else if (name == "server_max_window_bits")
+        {
+            if (hasServerBits)
+                return false;
+            hasServerBits = true;
+            params._serverMaxWindowBits = windowBits(value);
+            // zlib doesn't support a raw deflate window of 8 bits
+            if (params._serverMaxWindowBits < 9)
+                return false;
+        }
+        else if (name == "client_max_window_bits")
+        {
+            if (hasClientBits)
+                return false;
+            hasClientBits = true;
+            if (!value.empty() && windowBits(value) == 0)
+                return false;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    if (!contextTakeover)
+    {
+        params._serverNoContextTakeover = true;
+        params._clientNoContextTakeover = true;
+    }
+    return true;
+}
+}  // namespace
+
+bool PerMessageDeflateParams::negotiate(const std::string &extensions,
+                                        bool contextTakeover,
+                                        PerMessageDeflateParams &params)
+{
+    for (auto &extension : utils::splitString(extensions, ","))
+    {
+        auto items = utils::splitString(extension, ";");
+        if (items.empty() || trim(items[0]) != "permessage-deflate")
+            continue;
+        if (parseOffer(items, contextTakeover, params))
+            return true;
+    }
+    return false;
+}
+
+std::string PerMessageDeflateParams::toString() const
+{
+    std::string extension("permessage-deflate");
+    if (_serverNoContextTakeover)
+        extension.append("; server_no_context_takeover");
+    if (_clientNoContextTakeover)
+        extension.append("; client_no_context_takeover");
+    if (_serverMaxWindowBits < 15)
+    {
+        extension.append("; server_max_window_bits=");
+        extension.append(std::to_string(_serverMaxWindowBits));
+    }
+    return extension;
+}
+
+WebSocketDeflate::WebSocketDeflate(const PerMessageDeflateParams &params,
+                                   bool isServer,
+                                   size_t threshold)
+    : _threshold(threshold)
+{
+    if (isServer)
+    {
+        _sendContextTakeover = !params._serverNoContextTakeover;
+        _receiveContextTakeover = !params._clientNoContextTakeover;
+        _sendWindowBits = params._serverMaxWindowBits;
+    }
+    else
+    {
+        _sendContextTakeover = !params._clientNoContextTakeover;
+        _receiveContextTakeover = !params._serverNoContextTakeover;
+        _sendWindowBits = params._clientMaxWindowBits;
+    }
+    _sendWindowBits = (std::max)(9, (std::min)(15, _sendWindowBits));
+}
+
+WebSocketDeflate::~WebSocketDeflate()
+{
+}
+
+bool WebSocketDeflate::compress(const char *data,
+                                size_t length,
+                                std::string &output)
+{
+    if (length < _threshold)
+        return false;
+    DeflateStream *deflater;
+    if (_sendContextTakeover)
+    {
+        if (!_deflater)
+            _deflater = std::make_unique<DeflateStream>(_sendWindowBits);
+        deflater = _deflater.get();
+    }
+    else
+    {
+        auto &shared = sharedDeflaters[_sendWindowBits];
+        if (!shared)
+            shared = std::make_unique<DeflateStream>(_sendWindowBits);
+        deflater = shared.get();
+    }
+    if (!deflater->_ok)
+        return false;
+    if (!_sendContextTakeover)
+        deflateReset(&deflater->_strm);
+    auto &strm = deflater->_strm;
+    strm.next_in = (Bytef *)data;
+    strm.avail_in = length;
+    output.resize(length / 2 + 64);
+    size_t outLength = 0;
+    do
+    {
+        if (outLength == output.length())
+            output.resize(output.length() * 2);
+        strm.next_out = (Bytef *)&output[outLength];
+        strm.avail_out = output.length() - outLength;
+        auto ret = deflate(&strm, Z_SYNC_FLUSH);
+        if (ret != Z_OK && ret != Z_BUF_ERROR)
+        {
+            LOG_ERROR << "Failed to compress a WebSocket message";
+            return false;
+        }
+        outLength = output.length() - strm.avail_out;
+    } while (strm.avail_out == 0);
+    // rfc7692-7.2.1, remove the 0x00 0x00 0xff 0xff at the tail
+    assert(outLength >= 4);
+    output.resize(outLength - 4);
+    // A message which doesn't shrink is sent as it is, unless the peer has
+    // seen the data in its context.
+    if (!_sendContextTakeover && output.length() >= length)
+        return false;
+    return true;
+}
+
+bool WebSocketDeflate::decompress(std::string &message, size_t maxLength)
+{
+    InflateStream *inflater;
+    if (_receiveContextTakeover)
+    {
+        if (!_inflater)
+            _inflater = std::make_unique<InflateStream>();
+        inflater = _inflater.get();
+    }
+    else
+    {
+        if (!sharedInflater)
+            sharedInflater = std::make_unique<InflateStream>();
+        inflater = sharedInflater.get();
+    }
+    if (!inflater->_ok)
+        return false;
+    if (!_receiveContextTakeover)
+        inflateReset(&inflater->_strm);
+    message.append("\x00\x00\xff\xff", 4);
+    auto &strm = inflater->_strm;
+    strm.next_in = (Bytef *)message.data();
+    strm.avail_in = message.length();
+    std::string output;
+    output.resize((std::min)(message.length() * 4, maxLength) + 64);
+    size_t outLength = 0;
+    while (true)
+    {
+        if (outLength == output.length())
+            output.resize(output.length() * 2);
+        strm.next_out = (Bytef *)&output[outLength];
+        strm.avail_out = output.length() - outLength;
+        auto ret = inflate(&strm, Z_SYNC_FLUSH);
+        outLength = output.length() - strm.avail_out;
+        if (outLength > maxLength)
+        {
+            LOG_ERROR << "The size of the WebSocket message is too large!";
+            return false;
+        }
+        if (ret == Z_STREAM_END)
+        {
+            // The peer finished the deflate stream, start a new one
+            inflateReset(&strm);
+            break;
+        }
+        if (ret != Z_OK && ret != Z_BUF_ERROR)
+        {
+            LOG_ERROR << "Failed to decompress a WebSocket message";
+            return false;
+        }
+        if (strm.avail_out != 0)
+            break;
+    }
+    output.resize(outLength);
+    message.swap(output);
+    return true;
+}
@@ -0,0 +1,95 @@
+/**
+ *
+ *  WebSocketDeflate.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <trantor/utils/NonCopyable.h>
+#include <memory>
+#include <string>
+
+namespace drogon
+{
+/// The parameters of the permessage-deflate extension (RFC 7692)
+struct PerMessageDeflateParams
+{
+    bool _serverNoContextTakeover = false;
+    bool _clientNoContextTakeover = false;
+    int _serverMaxWindowBits = 15;
+    int _clientMaxWindowBits = 15;
+
+    /// Choose the parameters accepted by a server.
+    /**
+     * @param extensions The Sec-WebSocket-Extensions header of the handshake
+     * request.
+     * @param contextTakeover If false, both endpoints are asked to reset their
+     * compression context after every message, so that the contexts can be
+     * shared by all connections in an IO loop.
+     * @return false if there isn't any acceptable offer.
+     */
+    static bool negotiate(const std::string &extensions,
+                          bool contextTakeover,
+                          PerMessageDeflateParams &params);
+
+    /// The value of the Sec-WebSocket-Extensions header of the handshake
+    /// response.
+    std::string toString() const;
+};
+
+struct DeflateStream;
+struct InflateStream;
+
+/// Compress and decompress the messages of a WebSocket connection
+/**
+ * An endpoint which resets its context after every message uses the context
+ * shared by all connections in the current thread instead of its own one.
+ */
+class WebSocketDeflate : public trantor::NonCopyable
+{
+  public:
+    WebSocketDeflate(const PerMessageDeflateParams &params,
+                     bool isServer,
+                     size_t threshold);
+    ~WebSocketDeflate();
+
+    /// Compress a message, return false if it should be sent uncompressed.
+    bool compress(const char *data, size_t length, std::string &output);
+
+    /// Decompress a message in place.
+    /**
+     * Return false if the message is corrupted or longer than maxLength after
+     * decompression.
+     */
+    bool decompress(std::string &message, size_t maxLength);
+
+    /// Return true if the connection owns its compression context, then
+    /// messages must be compressed in the order they are sent.
+    bool hasOwnDeflater() const
+    {
+        return _sendContextTakeover;
+    }
+    int sendWindowBits() const
+    {
+        return _sendWindowBits;
+    }
+
+  private:
+    const size_t _threshold;
+    bool _sendContextTakeover;
+    bool _receiveContextTakeover;
+    int _sendWindowBits;
+    std::unique_ptr<DeflateStream> _deflater;
+    std::unique_ptr<InflateStream> _inflater;
+};
+
+}  // namespace drogon
@@ -13,6 +13,7 @@
  */
 
 #include "WebsocketControllersRouter.h"
+#include "HttpAppFrameworkImpl.h"
 #include "HttpRequestImpl.h"
 #include "HttpResponseImpl.h"
 #include "WebSocketConnectionImpl.h"
@@ -69,15 +70,16 @@ void WebsocketControllersRouter::route(
             {
                 if (!filters.empty())
                 {
-                    auto callbackPtr = std::make_shared<
-                        std::function<void(const HttpResponsePtr &)>>(
-                        std::move(callback));
                     filters_function::doFilters(
-                        filters, req, callbackPtr, [=]() mutable {
+                        filters,
+                        req,
+                        std::move(callback),
+                        [=](std::function<void(const HttpResponsePtr &)>
+                                &&callback) mutable {
                             doControllerHandler(ctrlPtr,
                                                 wsKey,
                                                 req,
-                                                std::move(*callbackPtr),
+                                                std::move(callback),
                                                 wsConnPtr);
                         });
                 }
@@ -129,7 +131,24 @@ void WebsocketControllersRouter::doControllerHandler(
     resp->addHeader("Upgrade", "websocket");
     resp->addHeader("Connection", "Upgrade");
     resp->addHeader("Sec-WebSocket-Accept", base64Key);
+    auto &app = HttpAppFrameworkImpl::instance();
+    if (app.isWebSocketCompressionEnabled())
+    {
+        auto &extensions = req->getHeaderBy("sec-websocket-extensions");
+        PerMessageDeflateParams params;
+        if (!extensions.empty() &&
+            PerMessageDeflateParams::negotiate(
+                extensions, app.getWebSocketContextTakeover(), params))
+        {
+            resp->addHeader("Sec-WebSocket-Extensions", params.toString());
+            wsConnPtr->enableDeflate(params,
+                                     app.getWebSocketCompressionThreshold());
+        }
+    }
     callback(resp);
+    auto sendQueueOptions = app.getWebSocketSendQueueOptions();
+    ctrlPtr->setupSendQueue(sendQueueOptions);
+    wsConnPtr->setSendQueueOptions(sendQueueOptions);
     wsConnPtr->setMessageCallback(
         [ctrlPtr](std::string &&message,
                   const WebSocketConnectionImplPtr &connPtr,
@@ -26,6 +26,7 @@ typedef std::shared_ptr<HttpResponseImpl> HttpResponseImplPtr;
 class WebSocketConnectionImpl;
 typedef std::shared_ptr<WebSocketConnectionImpl> WebSocketConnectionImplPtr;
 class HttpRequestParser;
+class HttpResponseParser;
 class StaticFileRouter;
 class HttpControllersRouter;
 class WebsocketControllersRouter;
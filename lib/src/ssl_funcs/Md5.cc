@@ -13,6 +13,7 @@
  */
 
 #include "Md5.h"
+#include <algorithm>
 #include <iostream>
 #include <math.h>
 #include <string.h>
@@ -39,51 +40,6 @@ uint32_t Md5Encode::cycleMoveLeft(uint32_t srcNum, int bitNumToMove)
     return ((srcNum1 << bitNumToMove) | (srcNum2 >> (32 - bitNumToMove)));
 }
 
-// function: FillData
-// @param inDataPtr:    input data
-// @param dataByteLen:  length of input data
-// @param outDataPtr:   output data
-// return : length of output data
-uint32_t Md5Encode::fillData(const char *inDataPtr,
-                             int dataByteLen,
-                             char **outDataPtr)
-{
-    int bitNum = dataByteLen * BIT_OF_BYTE;
-    // int grop_num = bitNum / BIT_OF_GROUP;
-    int modBitNum = bitNum % BIT_OF_GROUP;
-    int bitNeedFill = 0;
-    if (modBitNum > (BIT_OF_GROUP - SRC_DATA_LEN))
-    {
-        bitNeedFill = (BIT_OF_GROUP - modBitNum);
-        bitNeedFill += (BIT_OF_GROUP - SRC_DATA_LEN);
-    }
-    else
-    {
-        bitNeedFill = (BIT_OF_GROUP - SRC_DATA_LEN) - modBitNum;
-    }
-    int allBit = bitNum + bitNeedFill;
-    if (0 < bitNeedFill)
-    {
-        *outDataPtr =
-            new char[allBit / BIT_OF_BYTE + SRC_DATA_LEN / BIT_OF_BYTE];
-        memset(*outDataPtr,
-               0,
-               allBit / BIT_OF_BYTE + SRC_DATA_LEN / BIT_OF_BYTE);
-        // copy data
-        memcpy(*outDataPtr, inDataPtr, dataByteLen);
-        // fill rest data
-        unsigned char *tmp = reinterpret_cast<unsigned char *>(*outDataPtr);
-        tmp += dataByteLen;
-        // fill 1 and 0
-        *tmp = 0x80;
-        // fill origin data len
-        unsigned long long *originNum =
-            (unsigned long long *)((*outDataPtr) + ((allBit / BIT_OF_BYTE)));
-        *originNum = dataByteLen * BIT_OF_BYTE;
-    }
-    return (allBit / BIT_OF_BYTE + SRC_DATA_LEN / BIT_OF_BYTE);
-}
-
 void Md5Encode::roundF(char *data512Ptr, ParamDynamic &param)
 {
     uint32_t *M = reinterpret_cast<uint32_t *>(data512Ptr);
@@ -322,30 +278,75 @@ std::string Md5Encode::getHexStr(unsigned int numStr)
 // return : the string after encoding
 std::string Md5Encode::encode(const std::string &srcInfo)
 {
-    ParamDynamic param;
-    param.ua_ = kA;
-    param.ub_ = kB;
-    param.uc_ = kC;
-    param.ud_ = kD;
-    param.va_last_ = kA;
-    param.vb_last_ = kB;
-    param.vc_last_ = kC;
-    param.vd_last_ = kD;
+    Context context;
+    init(context);
+    update(context, srcInfo.data(), srcInfo.length());
+    return final(context);
+}
 
-    std::string result;
-    char *outDataPtr = NULL;
-    int totalByte = fillData(srcInfo.c_str(), srcInfo.length(), &outDataPtr);
-    // char * dataBitOfGroup = outDataPtr;
-    for (int i = 0; i < totalByte / (BIT_OF_GROUP / BIT_OF_BYTE); ++i)
+void Md5Encode::init(Context &context)
+{
+    context.param.ua_ = kA;
+    context.param.ub_ = kB;
+    context.param.uc_ = kC;
+    context.param.ud_ = kD;
+    context.param.va_last_ = kA;
+    context.param.vb_last_ = kB;
+    context.param.vc_last_ = kC;
+    context.param.vd_last_ = kD;
+    context.bufferLength = 0;
+    context.totalLength = 0;
+}
+
+void Md5Encode::update(Context &context, const char *data, size_t length)
+{
+    const size_t groupLength = sizeof(context.buffer);
+    context.totalLength += length;
+    while (length > 0)
+    {
+        auto len = std::min(length, groupLength - context.bufferLength);
+        memcpy(context.buffer + context.bufferLength, data, len);
+        context.bufferLength += len;
+        data += len;
+        length -= len;
+        if (context.bufferLength == groupLength)
+        {
+            rotationCalculate(context.buffer, context.param);
+            context.bufferLength = 0;
+        }
+    }
+}
+
+std::string Md5Encode::final(Context &context)
+{
+    const size_t groupLength = sizeof(context.buffer);
+    const size_t lengthPos = groupLength - SRC_DATA_LEN / BIT_OF_BYTE;
+    uint64_t bitNum = context.totalLength * BIT_OF_BYTE;
+    // fill 1 and 0
+    context.buffer[context.bufferLength++] = (char)0x80;
+    if (context.bufferLength > lengthPos)
     {
-        char *dataBitOfGroup = outDataPtr;
-        dataBitOfGroup += i * (BIT_OF_GROUP / BIT_OF_BYTE);
-        rotationCalculate(dataBitOfGroup, param);
+        memset(context.buffer + context.bufferLength,
+               0,
+               groupLength - context.bufferLength);
+        rotationCalculate(context.buffer, context.param);
+        context.bufferLength = 0;
     }
-    delete[] outDataPtr, outDataPtr = NULL;
-    result.append(getHexStr(param.ua_));
-    result.append(getHexStr(param.ub_));
-    result.append(getHexStr(param.uc_));
-    result.append(getHexStr(param.ud_));
+    memset(context.buffer + context.bufferLength,
+           0,
+           lengthPos - context.bufferLength);
+    // fill origin data len
+    for (size_t i = 0; i < SRC_DATA_LEN / BIT_OF_BYTE; ++i)
+    {
+        context.buffer[lengthPos + i] = (char)(bitNum >> (i * BIT_OF_BYTE));
+    }
+    rotationCalculate(context.buffer, context.param);
+    context.bufferLength = 0;
+
+    std::string result;
+    result.append(getHexStr(context.param.ua_));
+    result.append(getHexStr(context.param.ub_));
+    result.append(getHexStr(context.param.uc_));
+    result.append(getHexStr(context.param.ud_));
     return result;
 }
@@ -23,6 +23,7 @@
 
 #include <string>
 #include <cstdint>
+#include <stddef.h>
 
 #define BIT_OF_BYTE 8
 #define BIT_OF_GROUP 512
@@ -57,9 +58,24 @@ class Md5Encode
         uint32_t vd_last_;
     };
 
+    /// The state of the incremental encoding
+    struct Context
+    {
+        ParamDynamic param;
+        char buffer[BIT_OF_GROUP / BIT_OF_BYTE];
+        size_t bufferLength;
+        uint64_t totalLength;
+    };
+
   public:
     static std::string encode(const std::string &srcInfo);
 
+    /// Encode the data given by several calls of update(), for the data
+    /// which is not in memory at once, such as an uploaded file.
+    static void init(Context &context);
+    static void update(Context &context, const char *data, size_t length);
+    static std::string final(Context &context);
+
   protected:
     static uint32_t cycleMoveLeft(uint32_t srcNum, int bitNumToMove);
     static void roundF(char *data512Ptr, ParamDynamic &param);
@@ -68,9 +84,6 @@ class Md5Encode
     static void roundI(char *data512Ptr, ParamDynamic &param);
     static void rotationCalculate(char *data512Ptr, ParamDynamic &param);
     static std::string getHexStr(unsigned int numStr);
-    static uint32_t fillData(const char *inDataPtr,
-                             int dataByteLen,
-                             char **outDataPtr);
 
   private:
     static const int kA;
@@ -0,0 +1,59 @@
+#include <drogon/utils/Arena.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace drogon;
+
+static int destroyed = 0;
+struct Counter
+{
+    ~Counter()
+    {
+        ++destroyed;
+    }
+};
+
+int main()
+{
+    Arena arena(1024);
+    auto first = arena.allocate(10);
+    auto aligned = arena.allocate(8, 64);
+    if (reinterpret_cast<size_t>(aligned) % 64 != 0)
+    {
+        std::cout << "wrong alignment" << std::endl;
+        return 1;
+    }
+    // Larger than the block
+    auto large = static_cast<char *>(arena.allocate(10000));
+    large[9999] = 1;
+    auto str = arena.copy("drogon");
+    arena.create<Counter>();
+    arena.create<Counter>();
+    std::vector<int, ArenaAllocator<int>> numbers{ArenaAllocator<int>(arena)};
+    for (int i = 0; i < 1000; ++i)
+        numbers.push_back(i);
+    if (str != "drogon" || numbers[999] != 999)
+    {
+        std::cout << "wrong data" << std::endl;
+        return 1;
+    }
+    arena.reset();
+    if (destroyed != 2)
+    {
+        std::cout << "objects are not destroyed" << std::endl;
+        return 1;
+    }
+    // The first block was enlarged, so the same data fit in it now
+    auto newFirst = arena.allocate(10);
+    arena.allocate(10000);
+    arena.reset();
+    if (arena.allocate(10) != newFirst || newFirst == nullptr)
+    {
+        std::cout << "the first block is not reused" << std::endl;
+        return 1;
+    }
+    (void)first;
+    std::cout << "OK" << std::endl;
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include "../src/AsyncFileReader.h"
+#include <drogon/utils/Utilities.h>
+#include <trantor/net/EventLoopThread.h>
+#include <errno.h>
+#include <fstream>
+#include <future>
+#include <iostream>
+
+using namespace drogon;
+
+static const std::string kDir = "./async_file_reader_test";
+
+struct ReadResult
+{
+    int _error = -1;
+    std::string _content;
+    bool _inLoop = false;
+    bool _afterRead = false;
+};
+
+/// Read the file in the loop and wait for the callback
+static ReadResult readFile(trantor::EventLoop *loop,
+                           const std::string &path,
+                           size_t size)
+{
+    std::promise<ReadResult> pro;
+    loop->runInLoop([loop, &path, size, &pro]() {
+        auto returned = std::make_shared<bool>(false);
+        AsyncFileReader::instance()->read(
+            path,
+            size,
+            [loop, returned, &pro](int error, std::string &&content) {
+                ReadResult result;
+                result._error = error;
+                result._content = std::move(content);
+                result._inLoop = loop->isInLoopThread();
+                result._afterRead = *returned;
+                pro.set_value(std::move(result));
+            });
+        *returned = true;
+    });
+    return pro.get_future().get();
+}
+
+static void writeFile(const std::string &path, const std::string &content)
+{
+    std::ofstream file(path, std::ios::binary);
+    file << content;
+}
+
+static bool check(const char *name,
+                  const ReadResult &result,
+                  int error,
+                  const std::string &content)
+{
+    if (!result._inLoop || !result._afterRead)
+    {
+        std::cout << name << ": the callback is not queued to the loop"
+                  << std::endl;
+        return false;
+    }
+    if (result._error != error || result._content != content)
+    {
+        std::cout << name << ": error " << result._error << ", "
+                  << result._content.length() << " bytes" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main()
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    auto loop = loopThread.getLoop();
+    utils::createPath(kDir);
+
+    // A file larger than a single read may return
+    std::string large;
+    large.reserve(8 * 1024 * 1024);
+    while (large.length() < 8 * 1024 * 1024)
+        large.append("drogon async file reader ");
+    writeFile(kDir + "/large", large);
+    if (!check("large file",
+               readFile(loop, kDir + "/large", large.length()),
+               0,
+               large))
+        return 1;
+
+    // The file is shorter than its size got before, e.g. truncated
+    writeFile(kDir + "/truncated", "short");
+    if (!check("truncated file",
+               readFile(loop, kDir + "/truncated", 100),
+               0,
+               "short"))
+        return 1;
+
+    // The file has grown, only the known size is read
+    if (!check("grown file",
+               readFile(loop, kDir + "/truncated", 3),
+               0,
+               "sho"))
+        return 1;
+
+    // An empty file
+    writeFile(kDir + "/empty", "");
+    if (!check("empty file", readFile(loop, kDir + "/empty", 0), 0, ""))
+        return 1;
+
+    // Errors of opening and reading the file
+    if (!check("missing file",
+               readFile(loop, kDir + "/missing", 10),
+               ENOENT,
+               "") ||
+        !check("directory", readFile(loop, kDir, 10), EISDIR, ""))
+        return 1;
+
+    std::cout << "ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,233 @@
+#include "../src/CacheFile.h"
+#include "../src/HttpServer.h"
+#include "../src/HttpRequestImpl.h"
+#include <drogon/HttpAppFramework.h>
+#include <drogon/HttpClient.h>
+#include <drogon/utils/Utilities.h>
+#include <trantor/net/EventLoopThread.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace drogon;
+
+static const uint16_t kPort = 18853;
+static const std::string kDir = "./cache_file_test";
+
+static std::string readFile(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+static bool exists(const std::string &path)
+{
+    return access(path.c_str(), F_OK) == 0;
+}
+
+/// Return true if the file system of the directory supports O_TMPFILE
+static bool supportsTmpFile(const std::string &dir)
+{
+#ifdef O_TMPFILE
+    int fd = open(dir.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0666);
+    if (fd >= 0)
+    {
+        close(fd);
+        return true;
+    }
+#endif
+    return false;
+}
+
+static size_t countFiles(const std::string &dir)
+{
+    size_t count = 0;
+    auto dp = opendir(dir.c_str());
+    if (!dp)
+        return 0;
+    while (auto entry = readdir(dp))
+    {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+            ++count;
+    }
+    closedir(dp);
+    return count;
+}
+
+static std::string makeData(size_t length)
+{
+    std::string data;
+    data.reserve(length);
+    for (size_t i = 0; i < length; ++i)
+        data.push_back((char)('a' + i % 26));
+    return data;
+}
+
+static int testCacheFile()
+{
+    // The data span several blocks and end in the middle of one
+    auto data = makeData(3 * 64 * 1024 + 100);
+    auto path = kDir + "/cache";
+    auto linkedPath = kDir + "/link/linked";
+    auto dirPath = kDir + "/link/dir";
+    utils::createPath(dirPath);
+    std::ofstream(dirPath + "/file") << "kept";
+    // The file at the path is replaced
+    std::ofstream(linkedPath) << "old";
+    {
+        CacheFile file(path, data.length());
+        if (exists(path) == supportsTmpFile(kDir))
+        {
+            std::cout << "the cache file is "
+                      << (exists(path) ? "named" : "not created") << std::endl;
+            return 1;
+        }
+        for (size_t pos = 0; pos < data.length(); pos += 1000)
+        {
+            if (!file.append(data.data() + pos,
+                             std::min<size_t>(1000, data.length() - pos)))
+            {
+                std::cout << "can't append data" << std::endl;
+                return 1;
+            }
+        }
+        int fd = file.fd();
+        std::string readData(data.length(), '\0');
+        if (fd < 0 || pread(fd, &readData[0], readData.length(), 0) !=
+                          (ssize_t)data.length() ||
+            readData != data)
+        {
+            std::cout << "wrong data read from the descriptor" << std::endl;
+            return 1;
+        }
+        if (file.getStringView() != data)
+        {
+            std::cout << "wrong mapped data" << std::endl;
+            return 1;
+        }
+        if (file.linkTo(linkedPath) != 0)
+        {
+            std::cout << "can't link the cache file" << std::endl;
+            return 1;
+        }
+        // A directory isn't replaced, and no temporary file is left
+        if (file.linkTo(dirPath) == 0 ||
+            readFile(dirPath + "/file") != "kept" ||
+            countFiles(kDir + "/link") != 2)
+        {
+            std::cout << "the failed link changes the directory" << std::endl;
+            return 1;
+        }
+    }
+    if (exists(path) || readFile(linkedPath) != data)
+    {
+        std::cout << "the linked file doesn't outlive the cache file"
+                  << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+static int testInMemoryBody()
+{
+    auto req = std::make_shared<HttpRequestImpl>(nullptr);
+    req->setBody("in memory");
+    if (req->bodyFileDescriptor() != -1)
+    {
+        std::cout << "an in-memory body has a descriptor" << std::endl;
+        return 1;
+    }
+    // A relative path and a path in the upload directory
+    if (req->saveBodyAs(kDir + "/saved/body") != 0 ||
+        readFile(kDir + "/saved/body") != "in memory")
+    {
+        std::cout << "the body is not saved to the path" << std::endl;
+        return 1;
+    }
+    if (req->saveBodyAs("sub/body") != 0 ||
+        readFile(kDir + "/uploads/sub/body") != "in memory")
+    {
+        std::cout << "the body is not saved to the upload path" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/// A body larger than the client max memory body size is received in a
+/// cache file and linked to the saved file.
+static int testSpilledBody()
+{
+    app().setClientMaxMemoryBodySize(1024);
+    for (int i = 0; i < 256; i++)
+    {
+        char dirName[4];
+        snprintf(dirName, sizeof(dirName), "%02X", i);
+        utils::createPath(kDir + "/uploads/tmp/" + dirName);
+    }
+    auto data = makeData(200 * 1024);
+
+    trantor::EventLoopThread serverLoopThread;
+    serverLoopThread.run();
+    HttpServer server(serverLoopThread.getLoop(),
+                      trantor::InetAddress("127.0.0.1", kPort),
+                      "CacheFileTest",
+                      {});
+    server.setHttpAsyncCallback(
+        [](const HttpRequestImplPtr &req,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            auto resp = HttpResponse::newHttpResponse();
+            if (req->bodyFileDescriptor() < 0)
+                resp->setBody("in memory");
+            else if (req->saveBodyAs("spilled") != 0)
+                resp->setBody("not saved");
+            else
+                resp->setBody(std::to_string(req->bodyLength()));
+            callback(resp);
+        });
+    server.start();
+
+    trantor::EventLoopThread clientLoopThread;
+    clientLoopThread.run();
+    auto client = HttpClient::newHttpClient("127.0.0.1",
+                                            kPort,
+                                            false,
+                                            clientLoopThread.getLoop());
+    auto req = HttpRequest::newHttpRequest();
+    req->setMethod(Post);
+    req->setPath("/upload");
+    req->setBody(data);
+    std::promise<std::string> pro;
+    client->sendRequest(req,
+                        [&pro](ReqResult result, const HttpResponsePtr &resp) {
+                            pro.set_value(result == ReqResult::Ok
+                                              ? std::string(resp->getBody())
+                                              : std::string("no response"));
+                        });
+    auto body = pro.get_future().get();
+    if (body != std::to_string(data.length()) ||
+        readFile(kDir + "/uploads/spilled") != data)
+    {
+        std::cout << "the spilled body is not saved: " << body << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main()
+{
+    utils::createPath(kDir);
+    app().setUploadPath(kDir + "/uploads");
+    if (testCacheFile() != 0 || testInMemoryBody() != 0 ||
+        testSpilledBody() != 0)
+        return 1;
+    std::cout << "ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include "../src/ChainState.h"
+#include "../src/FiltersFunction.h"
+#include "../src/HttpRequestImpl.h"
+#include <drogon/HttpFilter.h>
+#include <trantor/net/EventLoopThread.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <vector>
+
+using namespace drogon;
+
+static const size_t kChains = 1000;
+
+static trantor::EventLoop *workerLoop = nullptr;
+
+/// A filter which passes or rejects the request in the worker thread, and
+/// calls the callback twice.
+class WorkerFilter : public HttpFilter<WorkerFilter>
+{
+  public:
+    virtual void doFilter(const HttpRequestPtr &req,
+                          FilterCallback &&fcb,
+                          FilterChainCallback &&fccb) override
+    {
+        if (req->path() == "/reject")
+        {
+            workerLoop->queueInLoop([fcb = std::move(fcb)]() {
+                fcb(HttpResponse::newNotFoundResponse());
+                fcb(HttpResponse::newNotFoundResponse());
+            });
+        }
+        else
+        {
+            workerLoop->queueInLoop([fccb = std::move(fccb)]() {
+                fccb();
+                fccb();
+            });
+        }
+    }
+};
+
+template <typename Func>
+static void runInLoopAndWait(trantor::EventLoop *loop, Func &&func)
+{
+    std::promise<void> pro;
+    loop->runInLoop([&func, &pro]() {
+        func();
+        pro.set_value();
+    });
+    pro.get_future().wait();
+}
+
+int main()
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    auto loop = loopThread.getLoop();
+    trantor::EventLoopThread workerThread;
+    workerThread.run();
+    workerLoop = workerThread.getLoop();
+
+    std::vector<std::shared_ptr<HttpFilterBase>> filters{
+        std::make_shared<WorkerFilter>(), std::make_shared<WorkerFilter>()};
+    std::atomic<size_t> passed{0};
+    std::atomic<size_t> rejected{0};
+    std::promise<void> done;
+    auto finish = [&passed, &rejected, &done]() {
+        if (passed + rejected == 2 * kChains)
+            done.set_value();
+    };
+    for (size_t i = 0; i < 2 * kChains; ++i)
+    {
+        loop->queueInLoop([&, i]() {
+            auto req = std::make_shared<HttpRequestImpl>(loop);
+            req->setPath(i % 2 ? "/reject" : "/pass");
+            filters_function::doFilters(
+                filters,
+                req,
+                [&rejected, &finish](const HttpResponsePtr &) {
+                    ++rejected;
+                    finish();
+                },
+                [&passed, &finish](
+                    std::function<void(const HttpResponsePtr &)> &&) {
+                    ++passed;
+                    finish();
+                });
+        });
+    }
+    if (done.get_future().wait_for(std::chrono::seconds(10)) !=
+        std::future_status::ready)
+    {
+        std::cout << "the chains are not finished" << std::endl;
+        return 1;
+    }
+    // Let the callbacks called twice finish
+    runInLoopAndWait(workerLoop, []() {});
+    if (passed != kChains || rejected != kChains)
+    {
+        std::cout << "passed " << passed << ", rejected " << rejected
+                  << std::endl;
+        return 1;
+    }
+
+    // The states finished in the worker thread are returned to the loop
+    size_t loopPoolSize = 0;
+    size_t workerPoolSize = 0;
+    runInLoopAndWait(loop, [&loopPoolSize]() {
+        loopPoolSize = ChainState::poolSize();
+    });
+    runInLoopAndWait(workerLoop, [&workerPoolSize]() {
+        workerPoolSize = ChainState::poolSize();
+    });
+    if (loopPoolSize == 0 || workerPoolSize != 0)
+    {
+        std::cout << "states pooled in the loop " << loopPoolSize
+                  << ", in the worker " << workerPoolSize << std::endl;
+        return 1;
+    }
+    std::cout << "ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,200 @@
+#include <drogon/HttpBinder.h>
+#include <drogon/HttpRequest.h>
+#include <drogon/utils/coroutine.h>
+#include <chrono>
+#include <iostream>
+#include <new>
+#include <stdlib.h>
+
+#ifdef DROGON_HAS_COROUTINE
+
+using namespace drogon;
+
+static size_t allocations = 0;
+
+void *operator new(size_t size)
+{
+    ++allocations;
+    if (void *p = malloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+/// A fake asynchronous query, the callback is called when runLoop() is
+/// called. The slots are reserved, so the fake itself doesn't allocate.
+static std::vector<std::pair<std::function<void(int)>, int>> pendingQueries;
+static void fakeQuery(int value, std::function<void(int)> &&callback)
+{
+    pendingQueries.emplace_back(std::move(callback), value + 1);
+}
+static void runLoop()
+{
+    while (!pendingQueries.empty())
+    {
+        auto query = std::move(pendingQueries.back());
+        pendingQueries.pop_back();
+        query.first(query.second);
+    }
+}
+
+class FakeQueryAwaiter : public CallbackAwaiter<int>
+{
+  public:
+    explicit FakeQueryAwaiter(int value) : _value(value)
+    {
+    }
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        setHandle(handle);
+        fakeQuery(_value, [this](int result) { setValue(result); });
+        return suspend();
+    }
+
+  private:
+    int _value;
+};
+
+/// A query completing synchronously, the coroutine is not suspended
+class SyncQueryAwaiter : public CallbackAwaiter<int>
+{
+  public:
+    explicit SyncQueryAwaiter(int value) : _value(value)
+    {
+    }
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        setHandle(handle);
+        setValue(_value + 1);
+        return suspend();
+    }
+
+  private:
+    int _value;
+};
+
+static size_t sum = 0;
+
+// Three queries and a request to another service, one after another
+static void callbackHandler(
+    const HttpRequestPtr &req,
+    std::function<void(const HttpResponsePtr &)> &&callback,
+    int id)
+{
+    fakeQuery(id, [callback = std::move(callback)](int user) mutable {
+        fakeQuery(user,
+                  [callback = std::move(callback), user](int orders) mutable {
+                      fakeQuery(orders,
+                                [callback = std::move(callback),
+                                 user,
+                                 orders](int items) mutable {
+                                    fakeQuery(items,
+                                              [callback = std::move(callback),
+                                               user,
+                                               orders,
+                                               items](int rate) {
+                                                  sum += user + orders +
+                                                         items + rate;
+                                                  callback(nullptr);
+                                              });
+                                });
+                  });
+    });
+}
+
+static Task<HttpResponsePtr> coroutineHandler(HttpRequestPtr req, int id)
+{
+    auto user = co_await FakeQueryAwaiter(id);
+    auto orders = co_await FakeQueryAwaiter(user);
+    auto items = co_await FakeQueryAwaiter(orders);
+    auto rate = co_await FakeQueryAwaiter(items);
+    sum += user + orders + items + rate;
+    co_return nullptr;
+}
+
+// Many synchronous queries in a row don't nest on the stack
+static Task<HttpResponsePtr> syncHandler(HttpRequestPtr req, int id)
+{
+    int value = id;
+    for (int i = 0; i < 1000 * 1000; ++i)
+        value = co_await SyncQueryAwaiter(value);
+    sum += value;
+    co_return nullptr;
+}
+
+template <typename Handler>
+static bool run(const char *name, Handler handler)
+{
+    const size_t count = 1000 * 1000;
+    internal::HttpBinder<Handler> binder(std::move(handler));
+    auto req = HttpRequest::newHttpRequest();
+    std::vector<std::string> params;
+    size_t responses = 0;
+    sum = 0;
+    pendingQueries.reserve(16);
+    size_t allocationsBefore = allocations;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        params.clear();
+        binder.handleHttpRequest(params,
+                                 req,
+                                 [&responses](const HttpResponsePtr &) {
+                                     ++responses;
+                                 });
+        runLoop();
+    }
+    auto seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    // The id is 0, so the results are 1, 2, 3 and 4.
+    if (responses != count || sum != count * 10)
+    {
+        std::cout << name << ": wrong result" << std::endl;
+        return false;
+    }
+    std::cout << name << ": " << (double)(allocations - allocationsBefore) /
+                                     count
+              << " allocations/request, " << count / seconds << " requests/s"
+              << std::endl;
+    return true;
+}
+
+int main()
+{
+    if (!run("callbacks", &callbackHandler) ||
+        !run("coroutine", &coroutineHandler))
+        return 1;
+    internal::HttpBinder<decltype(&syncHandler)> binder(&syncHandler);
+    std::vector<std::string> params;
+    bool responded = false;
+    sum = 0;
+    binder.handleHttpRequest(params,
+                             HttpRequest::newHttpRequest(),
+                             [&responded](const HttpResponsePtr &) {
+                                 responded = true;
+                             });
+    if (!responded || sum != 1000 * 1000)
+    {
+        std::cout << "synchronous queries: wrong result" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+#else
+
+int main()
+{
+    std::cout << "Coroutines are not supported by the compiler" << std::endl;
+    return 0;
+}
+
+#endif
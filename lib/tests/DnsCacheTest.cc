@@ -0,0 +1,96 @@
+#include "../src/DnsCache.h"
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <string>
+
+using namespace drogon;
+
+static bool resolve(DnsCache &cache, const std::string &host)
+{
+    std::promise<bool> pro;
+    cache.resolve(host,
+                  [&pro, &host](bool found, const trantor::InetAddress &addr) {
+                      std::cout << host << ": " << addr.toIp() << std::endl;
+                      pro.set_value(found);
+                  });
+    return pro.get_future().get();
+}
+
+int main()
+{
+    // The TTLs are measured with a fake clock, so the test doesn't depend on
+    // how fast the machine is.
+    std::atomic<int64_t> now{trantor::Date::date().microSecondsSinceEpoch()};
+    DnsCache cache(4);
+    cache.setTtl(2.0, 2.0);
+    cache.setClock([&now]() { return trantor::Date(now.load()); });
+    if (!resolve(cache, "localhost"))
+    {
+        std::cout << "failed to resolve localhost" << std::endl;
+        return 1;
+    }
+    // The second lookup is answered from the cache in the current thread
+    bool cached = false;
+    cache.resolve("localhost",
+                  [&cached](bool found, const trantor::InetAddress &) {
+                      cached = found;
+                  });
+    if (!cached)
+    {
+        std::cout << "localhost is not cached" << std::endl;
+        return 1;
+    }
+
+    // In the last tenth of the TTL, the entry is refreshed in the background
+    // and the cached address is still returned while it is resolved.
+    now += 1900 * 1000;
+    for (int i = 0; i < 2; ++i)
+    {
+        cached = false;
+        cache.resolve("localhost",
+                      [&cached](bool found, const trantor::InetAddress &) {
+                          cached = found;
+                      });
+        if (!cached)
+        {
+            std::cout << "localhost is not cached while it is refreshed"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    // An expired entry is resolved again, the callback isn't called before
+    // resolve() returns
+    now += 10 * 1000 * 1000;
+    std::atomic<bool> returned{false};
+    std::promise<bool> pro;
+    cache.resolve("localhost",
+                  [&returned, &pro](bool found, const trantor::InetAddress &) {
+                      pro.set_value(found && returned);
+                  });
+    returned = true;
+    if (!pro.get_future().get())
+    {
+        std::cout << "the expired entry of localhost is used" << std::endl;
+        return 1;
+    }
+
+    // The number of cached hosts is limited
+    for (int i = 1; i <= 10; ++i)
+    {
+        auto host = "127.0.0." + std::to_string(i);
+        if (!resolve(cache, host))
+        {
+            std::cout << "failed to resolve " << host << std::endl;
+            return 1;
+        }
+        if (cache.size() > 4)
+        {
+            std::cout << cache.size() << " hosts are cached" << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include <drogon/FragmentCache.h>
+#include <iostream>
+#include <string>
+
+using namespace drogon;
+
+int main()
+{
+    FragmentCache::setMaxSize(100);
+    // Fragments which never expire are limited too
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto key = "key" + std::to_string(i);
+        FragmentCache::insert(key, "fragment" + std::to_string(i), 0);
+        auto fragment = FragmentCache::find(key);
+        if (!fragment || *fragment != "fragment" + std::to_string(i))
+        {
+            std::cout << key << " is not cached" << std::endl;
+            return 1;
+        }
+    }
+    int cached = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        if (FragmentCache::find("key" + std::to_string(i)))
+            ++cached;
+    }
+    if (cached > 100)
+    {
+        std::cout << cached << " fragments are cached" << std::endl;
+        return 1;
+    }
+    // Replacing a fragment doesn't evict others
+    FragmentCache::clear();
+    FragmentCache::insert("a", "1", 0);
+    FragmentCache::insert("a", "2", 60);
+    auto fragment = FragmentCache::find("a");
+    if (!fragment || *fragment != "2")
+    {
+        std::cout << "the fragment is not replaced" << std::endl;
+        return 1;
+    }
+    std::cout << "ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <drogon/HttpAppFramework.h>
+#include <drogon/HttpBinder.h>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+
+using namespace drogon;
+
+struct Point
+{
+    int x = 0;
+    int y = 0;
+};
+
+namespace drogon
+{
+template <>
+struct ArgumentConverter<Point>
+{
+    static bool convert(const std::string &str, Point &value)
+    {
+        auto pos = str.find(',');
+        if (pos == std::string::npos)
+            return false;
+        return ArgumentConverter<int>::convert(str.substr(0, pos), value.x) &&
+               ArgumentConverter<int>::convert(str.substr(pos + 1), value.y);
+    }
+};
+}  // namespace drogon
+
+static size_t sum = 0;
+
+static void handler(const HttpRequestPtr &req,
+                    std::function<void(const HttpResponsePtr &)> &&callback,
+                    int id,
+                    long long offset,
+                    double ratio,
+                    bool verbose,
+                    string_view name,
+                    Point point)
+{
+    sum += id + offset + (size_t)ratio + verbose + name.length() + point.x +
+           point.y;
+}
+
+/// The conversions made by the binder before, for comparison
+template <typename T>
+static void streamConvert(T &value, const std::string &str)
+{
+    std::stringstream ss(str);
+    ss >> value;
+}
+
+int main()
+{
+    const std::vector<std::string> arguments = {
+        "12345", "9876543210", "0.75", "1", "drogon", "3,4"};
+    // Check the conversions
+    {
+        internal::HttpBinder<decltype(&handler)> binder(&handler);
+        auto params = arguments;
+        binder.handleHttpRequest(params,
+                                 HttpRequest::newHttpRequest(),
+                                 [](const HttpResponsePtr &) {});
+        if (sum != 12345 + 9876543210 + 0 + 1 + 6 + 3 + 4)
+        {
+            std::cout << "wrong arguments: " << sum << std::endl;
+            return 1;
+        }
+    }
+    const size_t count = 2 * 1000 * 1000;
+    auto req = HttpRequest::newHttpRequest();
+    {
+        internal::HttpBinder<decltype(&handler)> binder(&handler);
+        std::vector<std::string> params;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i)
+        {
+            params = arguments;
+            binder.handleHttpRequest(params,
+                                     req,
+                                     [](const HttpResponsePtr &) {});
+        }
+        auto seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+        std::cout << "binder: " << count / seconds << " calls/s" << std::endl;
+    }
+    {
+        std::vector<std::string> params;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i)
+        {
+            params = arguments;
+            int id;
+            long long offset;
+            double ratio;
+            bool verbose;
+            std::string name;
+            Point point;
+            streamConvert(id, params[0]);
+            streamConvert(offset, params[1]);
+            streamConvert(ratio, params[2]);
+            streamConvert(verbose, params[3]);
+            name = std::move(params[4]);
+            auto pos = params[5].find(',');
+            streamConvert(point.x, params[5].substr(0, pos));
+            streamConvert(point.y, params[5].substr(pos + 1));
+            handler(req,
+                    [](const HttpResponsePtr &) {},
+                    id,
+                    offset,
+                    ratio,
+                    verbose,
+                    name,
+                    point);
+        }
+        auto seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+        std::cout << "stringstream: " << count / seconds << " calls/s"
+                  << std::endl;
+    }
+    return 0;
+}
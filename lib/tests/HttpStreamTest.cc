@@ -0,0 +1,243 @@
+#include "../src/HttpServer.h"
+#include "../src/HttpRequestImpl.h"
+#include "TestHelpers.h"
+#include <drogon/HttpClient.h>
+#include <drogon/HttpResponse.h>
+#include <drogon/utils/Utilities.h>
+#include <trantor/net/EventLoopThread.h>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace drogon;
+
+static const uint16_t kPort = 18852;
+
+struct StreamResult
+{
+    ReqResult _result = ReqResult::BadResponse;
+    HttpResponsePtr _response;
+    std::string _body;
+};
+
+/// Receive a response in parts and wait for the whole body
+static StreamResult streamRequest(const HttpClientPtr &client,
+                                  const std::string &path,
+                                  bool decompress)
+{
+    auto req = HttpRequest::newHttpRequest();
+    req->setPath(path);
+    auto result = std::make_shared<StreamResult>();
+    std::promise<void> pro;
+    client->sendStreamRequest(
+        req,
+        [result, &pro](ReqResult res, const HttpResponsePtr &response) {
+            result->_result = res;
+            result->_response = response;
+            if (res != ReqResult::Ok)
+                pro.set_value();
+        },
+        [result](const char *data, size_t length) {
+            result->_body.append(data, length);
+            return true;
+        },
+        [result, &pro](ReqResult res) {
+            result->_result = res;
+            pro.set_value();
+        },
+        decompress);
+    pro.get_future().wait();
+    return *result;
+}
+
+int main()
+{
+    std::string text;
+    for (int i = 0; i < 1000; ++i)
+        text.append("drogon stream ");
+    auto gzipped = utils::gzipCompress(text.data(), text.length());
+    std::promise<void> streamAborted;
+
+    trantor::EventLoopThread serverLoopThread;
+    serverLoopThread.run();
+    auto serverLoop = serverLoopThread.getLoop();
+    auto upstream =
+        HttpClient::newHttpClient("127.0.0.1", kPort, false, serverLoop);
+    HttpServer server(serverLoop,
+                      trantor::InetAddress("127.0.0.1", kPort),
+                      "HttpStreamTest",
+                      {});
+    server.setHttpAsyncCallback(
+        [&](const HttpRequestImplPtr &req,
+            std::function<void(const HttpResponsePtr &)> &&callback) {
+            auto &path = req->path();
+            if (path == "/gzip")
+            {
+                auto resp = HttpResponse::newHttpResponse();
+                resp->setBody(gzipped);
+                resp->addHeader("Content-Encoding", "gzip");
+                callback(resp);
+            }
+            else if (path == "/stream")
+            {
+                // The end of the body is sent in another thread
+                callback(HttpResponse::newStreamResponse(
+                    [](const ResponseStreamPtr &stream) {
+                        stream->send("<p>Hello, ");
+                        std::thread([stream]() {
+                            std::this_thread::sleep_for(
+                                std::chrono::milliseconds(50));
+                            stream->send("world!</p>");
+                            stream->close();
+                        }).detach();
+                    }));
+            }
+            else if (path == "/endless")
+            {
+                // Sent until the client goes away
+                callback(HttpResponse::newStreamResponse(
+                    [&streamAborted](const ResponseStreamPtr &stream) {
+                        std::thread([stream, &streamAborted]() {
+                            std::string part(4096, 'e');
+                            while (stream->send(part))
+                                std::this_thread::sleep_for(
+                                    std::chrono::milliseconds(1));
+                            streamAborted.set_value();
+                        }).detach();
+                    }));
+            }
+            else if (path == "/forward")
+            {
+                auto forwardedReq = HttpRequest::newHttpRequest();
+                forwardedReq->setPath("/stream");
+                upstream->forwardRequest(
+                    forwardedReq,
+                    [callback](ReqResult result,
+                               const HttpResponsePtr &resp) {
+                        if (result == ReqResult::Ok)
+                            callback(resp);
+                        else
+                            callback(HttpResponse::newNotFoundResponse());
+                    });
+            }
+            else
+            {
+                auto resp = HttpResponse::newHttpResponse();
+                resp->setBody("plain");
+                callback(resp);
+            }
+        });
+    server.start();
+
+    trantor::EventLoopThread clientLoopThread;
+    clientLoopThread.run();
+    auto client = HttpClient::newHttpClient("127.0.0.1",
+                                            kPort,
+                                            false,
+                                            clientLoopThread.getLoop());
+
+    // A gzip body is inflated part by part, or passed on as it is
+    auto result = streamRequest(client, "/gzip", true);
+    if (result._result != ReqResult::Ok || result._body != text ||
+        !result._response->getHeader("content-encoding").empty())
+    {
+        std::cout << "the gzip body is not inflated" << std::endl;
+        return 1;
+    }
+    result = streamRequest(client, "/gzip", false);
+    if (result._result != ReqResult::Ok || result._body != gzipped ||
+        result._response->getHeader("content-encoding") != "gzip")
+    {
+        std::cout << "the gzip body is altered" << std::endl;
+        return 1;
+    }
+
+    // The body of a streaming response is sent from another thread
+    result = streamRequest(client, "/stream", true);
+    if (result._result != ReqResult::Ok ||
+        result._body != "<p>Hello, world!</p>")
+    {
+        std::cout << "wrong streaming body: " << result._body << std::endl;
+        return 1;
+    }
+
+    // A streaming response is forwarded as it is received
+    result = streamRequest(client, "/forward", true);
+    if (result._result != ReqResult::Ok ||
+        result._body != "<p>Hello, world!</p>")
+    {
+        std::cout << "wrong forwarded body: " << result._body << std::endl;
+        return 1;
+    }
+
+    // A response pipelined behind a stream is held until the stream is
+    // closed
+    auto pipelinedClient = HttpClient::newHttpClient(
+        "127.0.0.1", kPort, false, clientLoopThread.getLoop());
+    pipelinedClient->setPipeliningDepth(4);
+    std::mutex bodiesMutex;
+    std::vector<std::string> bodies;
+    std::promise<void> pipelined;
+    for (auto path : {"/stream", "/plain"})
+    {
+        auto req = HttpRequest::newHttpRequest();
+        req->setPath(path);
+        pipelinedClient->sendRequest(
+            req,
+            [&bodiesMutex, &bodies, &pipelined](ReqResult result,
+                                                const HttpResponsePtr &resp) {
+                std::lock_guard<std::mutex> lock(bodiesMutex);
+                bodies.push_back(result == ReqResult::Ok
+                                     ? std::string(resp->getBody())
+                                     : std::string("error"));
+                if (bodies.size() == 2)
+                    pipelined.set_value();
+            });
+    }
+    pipelined.get_future().wait();
+    if (bodies[0] != "<p>Hello, world!</p>" || bodies[1] != "plain")
+    {
+        std::cout << "wrong pipelined responses: " << bodies[0] << ", "
+                  << bodies[1] << std::endl;
+        return 1;
+    }
+
+    // Returning false from the body callback drops the connection, the
+    // stream on the server reports it
+    std::promise<void> aborted;
+    bool completed = false;
+    auto req = HttpRequest::newHttpRequest();
+    req->setPath("/endless");
+    client->sendStreamRequest(
+        req,
+        [](ReqResult, const HttpResponsePtr &) {},
+        [&aborted](const char *, size_t) {
+            aborted.set_value();
+            return false;
+        },
+        [&completed](ReqResult) { completed = true; });
+    aborted.get_future().wait();
+    if (streamAborted.get_future().wait_for(std::chrono::seconds(5)) !=
+            std::future_status::ready ||
+        completed)
+    {
+        std::cout << "the stream is not aborted" << std::endl;
+        return 1;
+    }
+
+    // HTTP/1.0 clients receive the body until the connection is closed
+    auto response = test::rawRequest(kPort, "GET /stream HTTP/1.0\r\n\r\n");
+    auto pos = response.find("\r\n\r\n");
+    if (pos == std::string::npos ||
+        response.find("chunked") != std::string::npos ||
+        response.substr(pos + 4) != "<p>Hello, world!</p>")
+    {
+        std::cout << "wrong HTTP/1.0 response: " << response << std::endl;
+        return 1;
+    }
+    std::cout << "ok" << std::endl;
+    return 0;
+}
@@ -8,4 +8,12 @@ int main()
                      "1234567890")
               << std::endl;
     // The output shoud be '49CB3608E2B33FAD6B65DF8CB8F49668'
+    Md5Encode::Context context;
+    Md5Encode::init(context);
+    for (int i = 0; i < 10; ++i)
+    {
+        Md5Encode::update(context, "1234567890", 10);
+    }
+    std::cout << Md5Encode::final(context) << std::endl;
+    // The output shoud be the same as above
 }
\ No newline at end of file
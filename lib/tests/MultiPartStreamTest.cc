@@ -0,0 +1,97 @@
+#include "../src/MultiPartStreamParser.h"
+#include <drogon/HttpAppFramework.h>
+#include <drogon/utils/Utilities.h>
+#include <iostream>
+#include <stdio.h>
+
+using namespace drogon;
+
+int main()
+{
+    // The directories of the temporary files are created when the app runs
+    app().setUploadPath("./uploads");
+    for (int i = 0; i < 256; i++)
+    {
+        char dirName[4];
+        sprintf(dirName, "%02X", i);
+        utils::createPath(app().getUploadPath() + "/tmp/" + dirName);
+    }
+
+    std::string content;
+    for (int i = 0; i < 100000; ++i)
+        content.append(std::to_string(i));
+    std::string body =
+        "--XyZ\r\n"
+        "Content-Disposition: form-data; name=\"title\"\r\n\r\n"
+        "drogon\r\n"
+        "--XyZ\r\n"
+        "Content-Disposition: form-data; name=\"file\"; filename=\"n.txt\"\r\n"
+        "Content-Type: text/plain\r\n\r\n" +
+        content +
+        "\r\n"
+        "--XyZ--\r\n";
+
+    // The delimiters are split at every position by the pieces
+    for (size_t pieceSize : {1, 2, 7, 64 * 1024})
+    {
+        MultiPartStreamParser parser("XyZ", 1024, false);
+        for (size_t pos = 0; pos < body.length(); pos += pieceSize)
+        {
+            if (!parser.parse(body.data() + pos,
+                              std::min(pieceSize, body.length() - pos)))
+            {
+                std::cout << "malformed body in pieces of " << pieceSize
+                          << " bytes" << std::endl;
+                return 1;
+            }
+        }
+        if (!parser.finished() || parser.files().size() != 1 ||
+            parser.files()[0].fileLength() != (int64_t)content.length())
+        {
+            std::cout << "wrong parts in pieces of " << pieceSize << " bytes"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    // The fields kept in memory are limited in total
+    std::string fields =
+        "--XyZ\r\n"
+        "Content-Disposition: form-data; name=\"a\"\r\n\r\n"
+        "abc\r\n"
+        "--XyZ\r\n"
+        "Content-Disposition: form-data; name=\"b\"\r\n\r\n"
+        "abc\r\n"
+        "--XyZ--\r\n";
+    MultiPartStreamParser fieldsParser("XyZ", 5, false);
+    if (fieldsParser.parse(fields.data(), fields.length()))
+    {
+        std::cout << "the fields are not limited" << std::endl;
+        return 1;
+    }
+
+    // Feed the body in small pieces as the request parser does
+    MultiPartStreamParser parser("XyZ", 1024, true);
+    for (size_t pos = 0; pos < body.length(); pos += 1000)
+    {
+        if (!parser.parse(body.data() + pos,
+                          std::min<size_t>(1000, body.length() - pos)))
+        {
+            std::cout << "malformed body" << std::endl;
+            return 1;
+        }
+    }
+    std::cout << parser.finished() << std::endl;
+    std::cout << parser.parameters().at("title") << std::endl;
+    auto &file = parser.files()[0];
+    std::cout << file.getFileName() << " " << file.fileLength() << std::endl;
+    std::cout << file.getMd5() << std::endl;
+    HttpFile memFile;
+    memFile.setFile(content);
+    std::cout << memFile.getMd5() << std::endl;
+    // The output should be:
+    // 1
+    // drogon
+    // n.txt 488890
+    // and the same MD5 string twice.
+}
@@ -0,0 +1,64 @@
+#include <drogon/utils/OStringStream.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace drogon;
+
+struct Point
+{
+    int _x;
+    int _y;
+};
+
+static std::ostream &operator<<(std::ostream &os, const Point &point)
+{
+    return os << "(" << point._x << ", " << point._y << ")";
+}
+
+/// A function of a view which takes a std::ostream
+static void writeTo(std::ostream &os)
+{
+    os << "written to " << std::setw(4) << 42;
+}
+
+/// Write the same values to an OStringStream and a std::ostringstream
+template <typename Stream>
+static std::string write(Stream &stream)
+{
+    stream << "text " << std::string("string ") << 'c' << -12 << 34u << ' '
+           << 1.5 << ' ' << true << ' ' << Point{1, 2} << std::endl;
+    stream << std::hex << 255 << ' ' << std::dec << 255 << std::setw(6)
+           << std::setfill('*') << 7 << std::setfill(' ') << ' '
+           << std::setprecision(3) << 3.14159 << ' ' << std::fixed << 2.5
+           << std::defaultfloat << std::setprecision(6) << ' '
+           << std::boolalpha << false << std::noboolalpha << ' ';
+    writeTo(stream);
+    stream << " " << 1.0 / 3;
+    return stream.str();
+}
+
+int main()
+{
+    OStringStream stream;
+    std::ostringstream expectedStream;
+    auto text = write(stream);
+    auto expected = write(expectedStream);
+    if (text != expected)
+    {
+        std::cout << "expected \"" << expected << "\", written \"" << text
+                  << "\"" << std::endl;
+        return 1;
+    }
+    // The text is still appended after the stream is used
+    stream << "end";
+    if (stream.str() != expected + "end" ||
+        stream.length() != expected.length() + 3)
+    {
+        std::cout << "wrong text at the end: " << stream.str() << std::endl;
+        return 1;
+    }
+    std::cout << "ok" << std::endl;
+    return 0;
+}
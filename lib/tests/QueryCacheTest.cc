@@ -0,0 +1,65 @@
+#include <drogon/orm/QueryCache.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace drogon::orm;
+
+static bool expect(const std::string &sql,
+                   const std::vector<std::string> &tables)
+{
+    auto result = QueryCache::tablesOfSql(sql);
+    if (result == tables)
+        return true;
+    std::cout << sql << ":";
+    for (auto &table : result)
+        std::cout << " " << table;
+    std::cout << std::endl;
+    return false;
+}
+
+int main()
+{
+    // The names are sorted, lower case and without schemas or quotes
+    if (!expect("select * from users", {"users"}) ||
+        !expect("SELECT * FROM Users u WHERE u.id = $1", {"users"}) ||
+        !expect("select * from users as u, orgs o where u.org = o.id",
+                {"orgs", "users"}))
+        return 1;
+
+    // Joins
+    if (!expect("select * from users u join orgs o on u.org = o.id "
+                "left join roles r on r.id = u.role "
+                "inner join perms using (role)",
+                {"orgs", "perms", "roles", "users"}) ||
+        !expect("select * from a natural join b cross join c",
+                {"a", "b", "c"}))
+        return 1;
+
+    // Schema-qualified and quoted names
+    if (!expect("select * from public.users", {"users"}) ||
+        !expect("select * from \"Users\" join \"public\".\"Orgs\" "
+                "on true",
+                {"orgs", "users"}) ||
+        !expect("select * from `shop`.`Items` where id = 1", {"items"}))
+        return 1;
+
+    // Sub-queries and string literals
+    if (!expect("select * from (select * from users) u join orgs o "
+                "on u.org = o.id",
+                {"orgs", "users"}) ||
+        !expect("select * from users where org in "
+                "(select id from orgs where name = 'from roles')",
+                {"orgs", "users"}) ||
+        !expect("select * from users where name = 'it''s from x' "
+                "union select * from admins",
+                {"admins", "users"}))
+        return 1;
+
+    // No table
+    if (!expect("select 1", {}) || !expect("select now()", {}))
+        return 1;
+
+    std::cout << "ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "../../orm_lib/src/ReplicatedDbClient.h"
+#include <iostream>
+#include <string>
+
+using namespace drogon::orm;
+
+int main()
+{
+    // The statements which may be sent to a read replica
+    const char *readOnly[] = {
+        "select * from users",
+        "SELECT id FROM users WHERE name = $1;",
+        "  \n\tselect 1",
+        "(select id from a) union (select id from b)",
+        "-- a comment\nselect * from users",
+        "/* a comment */ select * from users",
+        "/* one */ -- two\n  /* three */select count(*) from users;  ",
+    };
+    // The statements which must be sent to the primary server
+    const char *writes[] = {
+        "insert into users values(1)",
+        "with deleted as (delete from users returning *) select * from deleted",
+        "WITH moved AS (UPDATE users SET org = 2 RETURNING id) SELECT 1",
+        "select * from users where id = 1 for update",
+        "SELECT * FROM users FOR NO KEY UPDATE",
+        "select * from users for share",
+        "select * from users lock in share mode",
+        "select * into backup from users",
+        "select nextval('users_id_seq')",
+        "select 1; delete from users",
+        "select 1;delete from users;",
+        "-- select 1\ndelete from users",
+        "/* select 1 */ update users set name = 'a'",
+        "/* an unterminated comment select 1",
+        "selection",
+        "",
+        "   ",
+    };
+    for (auto sql : readOnly)
+    {
+        if (!ReplicatedDbClient::isReadOnlySql(sql))
+        {
+            std::cout << "not read-only: " << sql << std::endl;
+            return 1;
+        }
+    }
+    for (auto sql : writes)
+    {
+        if (ReplicatedDbClient::isReadOnlySql(sql))
+        {
+            std::cout << "read-only: " << sql << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,239 @@
+#include "../src/HttpServer.h"
+#include "../src/HttpRequestImpl.h"
+#include "TestHelpers.h"
+#include <drogon/drogon.h>
+#include <trantor/net/EventLoopThread.h>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace drogon;
+
+static const uint16_t kProxyPort = 18860;
+// The first two backends answer with their port and the path they receive,
+// the third one is slow and streams endless bodies.
+static const uint16_t kBackendPorts[] = {18861, 18862, 18863};
+
+static const char *kConfig = R"({
+    "listeners": [{"address": "127.0.0.1", "port": 18860}],
+    "plugins": [{
+        "name": "drogon::plugin::ReverseProxy",
+        "config": {
+            "upstreams": {
+                "pair": {
+                    "backends": ["http://127.0.0.1:18861",
+                                 "http://127.0.0.1:18862"]
+                },
+                "hash": {
+                    "backends": ["http://127.0.0.1:18861",
+                                 "http://127.0.0.1:18862"],
+                    "balance": "consistent_hash",
+                    "hash_key": "path"
+                },
+                "slow": {
+                    "backends": ["http://127.0.0.1:18863"],
+                    "timeout": 0.5
+                }
+            },
+            "routes": [
+                {"path_prefix": "/api", "upstream": "pair",
+                 "rewrite_prefix": "/v1"},
+                {"path_prefix": "/hash/", "upstream": "hash"},
+                {"path_prefix": "/slow", "upstream": "slow"},
+                {"path_prefix": "/endless", "upstream": "slow"}
+            ]
+        }
+    }]
+})";
+
+static std::promise<void> backendStreamAborted;
+
+static void backendCallback(
+    uint16_t port,
+    const HttpRequestImplPtr &req,
+    std::function<void(const HttpResponsePtr &)> &&callback)
+{
+    auto &path = req->path();
+    if (path == "/slow")
+    {
+        // Answered after the timeout of the upstream
+        auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+        loop->runAfter(2.0, [callback = std::move(callback)]() {
+            callback(HttpResponse::newHttpResponse());
+        });
+        return;
+    }
+    if (path == "/endless")
+    {
+        // Sent until the proxy drops the connection
+        callback(HttpResponse::newStreamResponse(
+            [](const ResponseStreamPtr &stream) {
+                std::thread([stream]() {
+                    std::string part(4096, 'e');
+                    while (stream->send(part))
+                        std::this_thread::sleep_for(
+                            std::chrono::milliseconds(1));
+                    backendStreamAborted.set_value();
+                }).detach();
+            }));
+        return;
+    }
+    auto resp = HttpResponse::newHttpResponse();
+    resp->setBody(std::to_string(port) + " " + path);
+    callback(resp);
+}
+
+static HttpResponsePtr get(const HttpClientPtr &client, const std::string &path)
+{
+    auto req = HttpRequest::newHttpRequest();
+    req->setPath(path);
+    std::promise<HttpResponsePtr> pro;
+    client->sendRequest(req,
+                        [&pro](ReqResult result, const HttpResponsePtr &resp) {
+                            pro.set_value(result == ReqResult::Ok ? resp
+                                                                  : nullptr);
+                        });
+    return pro.get_future().get();
+}
+
+static std::string body(const HttpResponsePtr &resp)
+{
+    return resp ? std::string(resp->getBody()) : std::string("no response");
+}
+
+/// Read a part of an endless body and close the connection
+static bool readAndClose(const std::string &path)
+{
+    int fd = test::connectLoopback(kProxyPort);
+    if (fd < 0)
+        return false;
+    auto request = "GET " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+    send(fd, request.data(), request.length(), 0);
+    char buf[65536];
+    auto n = recv(fd, buf, sizeof(buf), 0);
+    close(fd);
+    return n > 0;
+}
+
+static int runTests()
+{
+    trantor::EventLoopThread clientLoopThread;
+    clientLoopThread.run();
+    auto client = HttpClient::newHttpClient("127.0.0.1",
+                                            kProxyPort,
+                                            false,
+                                            clientLoopThread.getLoop());
+
+    // Only the prefix and the paths below it are forwarded, the prefix is
+    // rewritten
+    std::set<std::string> bodies;
+    for (int i = 0; i < 2; ++i)
+        bodies.insert(body(get(client, "/api/users")));
+    if (bodies != std::set<std::string>{"18861 /v1/users", "18862 /v1/users"})
+    {
+        std::cout << "/api/users is not balanced in turn:";
+        for (auto &b : bodies)
+            std::cout << " " << b;
+        std::cout << std::endl;
+        return 1;
+    }
+    auto resp = get(client, "/api");
+    if (body(resp).find(" /v1") == std::string::npos)
+    {
+        std::cout << "/api is not forwarded: " << body(resp) << std::endl;
+        return 1;
+    }
+    resp = get(client, "/apiary");
+    if (body(resp) != "app")
+    {
+        std::cout << "/apiary is forwarded: " << body(resp) << std::endl;
+        return 1;
+    }
+
+    // Consistent hashing sends a path to the same backend every time
+    auto first = body(get(client, "/hash/key"));
+    for (int i = 0; i < 4; ++i)
+    {
+        auto next = body(get(client, "/hash/key"));
+        if (next != first || next.find("/hash/key") == std::string::npos)
+        {
+            std::cout << "/hash/key is sent to different backends: " << first
+                      << ", " << next << std::endl;
+            return 1;
+        }
+    }
+
+    // A backend which doesn't answer in time
+    auto start = std::chrono::steady_clock::now();
+    resp = get(client, "/slow");
+    if (!resp || resp->statusCode() != k504GatewayTimeout ||
+        std::chrono::steady_clock::now() - start > std::chrono::seconds(2))
+    {
+        std::cout << "/slow is not answered with 504 in time" << std::endl;
+        return 1;
+    }
+
+    // The request to the backend is aborted when the client goes away
+    if (!readAndClose("/endless") ||
+        backendStreamAborted.get_future().wait_for(std::chrono::seconds(5)) !=
+            std::future_status::ready)
+    {
+        std::cout << "the backend stream is not aborted" << std::endl;
+        return 1;
+    }
+    std::cout << "ok" << std::endl;
+    return 0;
+}
+
+int main()
+{
+    {
+        std::ofstream configFile("ReverseProxyTest.json");
+        configFile << kConfig;
+    }
+
+    std::vector<std::unique_ptr<trantor::EventLoopThread>> backendLoops;
+    std::vector<std::unique_ptr<HttpServer>> backends;
+    for (auto port : kBackendPorts)
+    {
+        backendLoops.emplace_back(new trantor::EventLoopThread);
+        backendLoops.back()->run();
+        backends.emplace_back(
+            new HttpServer(backendLoops.back()->getLoop(),
+                           trantor::InetAddress("127.0.0.1", port),
+                           "Backend",
+                           {}));
+        backends.back()->setHttpAsyncCallback(
+            [port](const HttpRequestImplPtr &req,
+                   std::function<void(const HttpResponsePtr &)> &&callback) {
+                backendCallback(port, req, std::move(callback));
+            });
+        backends.back()->start();
+    }
+
+    app().registerHandler(
+        "/apiary",
+        [](const HttpRequestPtr &,
+           std::function<void(const HttpResponsePtr &)> &&callback) {
+            auto resp = HttpResponse::newHttpResponse();
+            resp->setBody("app");
+            callback(resp);
+        });
+    int result = 1;
+    std::thread testThread;
+    app().getLoop()->queueInLoop([&result, &testThread]() {
+        testThread = std::thread([&result]() {
+            result = runTests();
+            app().quit();
+        });
+    });
+    app().loadConfigFile("ReverseProxyTest.json");
+    app().run();
+    testThread.join();
+    return result;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "../src/WebSocketConnectionImpl.h"
+#include <trantor/utils/MsgBuffer.h>
+#include <arpa/inet.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <netinet/in.h>
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <vector>
+
+namespace drogon
+{
+namespace test
+{
+/// Connect to the port of the loopback address, the receiving operations
+/// time out after the seconds. Return -1 on failure.
+inline int connectLoopback(uint16_t port, long timeoutSeconds = 5)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    struct timeval timeout = {timeoutSeconds, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+/// Send a request with a raw socket and read until the server closes it
+inline std::string rawRequest(uint16_t port, const std::string &request)
+{
+    int fd = connectLoopback(port);
+    if (fd < 0)
+        return std::string();
+    send(fd, request.data(), request.length(), 0);
+    std::string response;
+    char buf[4096];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0)
+        response.append(buf, n);
+    close(fd);
+    return response;
+}
+
+/// The server side WebSocket connections in the order the clients connect
+class WebSocketServerConnections
+{
+  public:
+    void add(const WebSocketConnectionImplPtr &conn)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _conns.push_back(conn);
+        _cond.notify_all();
+    }
+    /// Wait for the connection, return nullptr if it isn't accepted in time.
+    WebSocketConnectionImplPtr get(size_t index)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cond.wait_for(lock, std::chrono::seconds(5), [this, index]() {
+            return _conns.size() > index;
+        });
+        return _conns.size() > index ? _conns[index] : nullptr;
+    }
+
+  private:
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::vector<WebSocketConnectionImplPtr> _conns;
+};
+
+/// A WebSocket client reading the frames sent by a server with a raw socket
+struct WebSocketTestClient
+{
+    int _fd = -1;
+    trantor::MsgBuffer _buffer;
+    WebSocketMessageParser _parser;
+
+    /// Return false if no message is received in time.
+    bool receive(std::string &message, WebSocketMessageType &type)
+    {
+        message.clear();
+        while (true)
+        {
+            if (!_parser.parse(&_buffer))
+                return false;
+            if (_parser.gotAll(message, type))
+                return true;
+            char buf[65536];
+            auto n = recv(_fd, buf, sizeof(buf), 0);
+            if (n <= 0)
+                return false;
+            _buffer.append(buf, n);
+        }
+    }
+    /// Return an empty string if no message is received in time.
+    std::string receive()
+    {
+        std::string message;
+        WebSocketMessageType type;
+        if (!receive(message, type))
+            return std::string();
+        return message;
+    }
+};
+
+}  // namespace test
+}  // namespace drogon
@@ -0,0 +1,47 @@
+#include "BenchmarkView.h"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace drogon;
+
+int main()
+{
+    const size_t rowsNumbers[] = {10, 100, 1000};
+    for (auto rowsNumber : rowsNumbers)
+    {
+        std::vector<std::pair<std::string, int>> rows;
+        for (size_t i = 0; i < rowsNumber; ++i)
+        {
+            rows.emplace_back("item" + std::to_string(i), (int)i * 7);
+        }
+        HttpViewData data;
+        data.insert("title", std::string("View render benchmark"));
+        data.insert("footer", "Drogon");
+        data.insert("rows", rows);
+        BenchmarkView view;
+        auto text = view.genText(data);
+        if (text.find("<td>item1</td>") == std::string::npos ||
+            text.find("<title>View render benchmark</title>") ==
+                std::string::npos)
+        {
+            std::cout << "wrong text:" << std::endl << text << std::endl;
+            return 1;
+        }
+        // About 1GB of text for every size
+        size_t count = 1024 * 1024 * 1024 / text.length();
+        size_t length = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i)
+        {
+            length += view.genText(data).length();
+        }
+        auto seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+        std::cout << "rows=" << rowsNumber << " " << count / seconds
+                  << " renders/s " << length / seconds / 1024 / 1024
+                  << " MB/s" << std::endl;
+    }
+    return 0;
+}
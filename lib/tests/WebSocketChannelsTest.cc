@@ -0,0 +1,120 @@
+#include "TestHelpers.h"
+#include <drogon/WebSocketChannels.h>
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/net/TcpServer.h>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace drogon;
+using namespace drogon::test;
+
+static const uint16_t kPort = 18850;
+
+static bool expect(WebSocketTestClient &client, const std::string &message)
+{
+    auto received = client.receive();
+    if (received == message)
+        return true;
+    std::cout << "expected \"" << message << "\", received \"" << received
+              << "\"" << std::endl;
+    return false;
+}
+
+int main()
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    auto loop = loopThread.getLoop();
+    trantor::TcpServer server(loop,
+                              trantor::InetAddress("127.0.0.1", kPort),
+                              "WebSocketChannelsTest");
+    WebSocketServerConnections serverConns;
+    server.setConnectionCallback([&serverConns](
+                                     const trantor::TcpConnectionPtr &conn) {
+        if (conn->connected())
+        {
+            auto wsConn = std::make_shared<WebSocketConnectionImpl>(conn);
+            conn->setContext(wsConn);
+            serverConns.add(wsConn);
+        }
+        else if (conn->hasContext())
+        {
+            conn->getContext<WebSocketConnectionImpl>()->onClose();
+        }
+    });
+    server.setRecvMessageCallback(
+        [](const trantor::TcpConnectionPtr &, trantor::MsgBuffer *buffer) {
+            buffer->retrieveAll();
+        });
+    server.start();
+
+    // Connect the clients one by one, so the connections are in order
+    WebSocketTestClient clients[3];
+    WebSocketConnectionImplPtr conns[3];
+    for (int i = 0; i < 3; ++i)
+    {
+        clients[i]._fd = connectLoopback(kPort, 2);
+        conns[i] = serverConns.get(i);
+        if (clients[i]._fd < 0 || !conns[i])
+        {
+            std::cout << "failed to connect client " << i << std::endl;
+            return 1;
+        }
+    }
+
+    // Every client reads a message published to the "sync" channel after the
+    // messages it may receive, so a missing message is found out without
+    // waiting for a timeout.
+    WebSocketChannels channels;
+    for (auto &conn : conns)
+        channels.subscribe("sync", conn);
+    channels.subscribe("news", conns[0]);
+    channels.subscribe("news", conns[1]);
+    channels.subscribe("other", conns[2]);
+
+    channels.publish("news", "hello");
+    channels.publish("other", "world");
+    channels.publish("sync", "1");
+    if (!expect(clients[0], "hello") || !expect(clients[0], "1") ||
+        !expect(clients[1], "hello") || !expect(clients[1], "1") ||
+        !expect(clients[2], "world") || !expect(clients[2], "1"))
+        return 1;
+
+    // Unsubscribing is as ordered as subscribing
+    channels.unsubscribe("news", conns[1]);
+    channels.publish("news", "after unsubscribing");
+    channels.publish("sync", "2");
+    if (!expect(clients[0], "after unsubscribing") ||
+        !expect(clients[0], "2") || !expect(clients[1], "2") ||
+        !expect(clients[2], "2"))
+        return 1;
+
+    // A connection closed while it is subscribed is dropped by the next
+    // message, the other subscribers still receive it.
+    close(clients[0]._fd);
+    for (int i = 0; i < 500 && !conns[0]->disconnected(); ++i)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (!conns[0]->disconnected())
+    {
+        std::cout << "the closed connection is not disconnected" << std::endl;
+        return 1;
+    }
+    channels.subscribe("news", conns[2]);
+    channels.publish("news", "after closing");
+    channels.publish("sync", "3");
+    if (!expect(clients[1], "3") || !expect(clients[2], "after closing") ||
+        !expect(clients[2], "3"))
+        return 1;
+
+    // A channel without subscribers is ignored
+    channels.publish("nobody", "lost");
+    channels.publish("sync", "4");
+    if (!expect(clients[1], "4") || !expect(clients[2], "4"))
+        return 1;
+
+    close(clients[1]._fd);
+    close(clients[2]._fd);
+    std::cout << "ok" << std::endl;
+    return 0;
+}
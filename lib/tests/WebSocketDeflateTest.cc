@@ -0,0 +1,54 @@
+#include "../src/WebSocketDeflate.h"
+#include <iostream>
+
+using namespace drogon;
+
+int main()
+{
+    PerMessageDeflateParams params;
+    if (!PerMessageDeflateParams::negotiate(
+            "x-webkit-deflate-frame, permessage-deflate; "
+            "client_max_window_bits; server_max_window_bits=10",
+            true,
+            params))
+    {
+        std::cout << "negotiation failed" << std::endl;
+        return 1;
+    }
+    /// permessage-deflate; server_max_window_bits=10
+    std::cout << params.toString() << std::endl;
+
+    std::string message;
+    for (int i = 0; i < 100; i++)
+        message.append("{\"symbol\":\"ABC\",\"price\":" + std::to_string(i) +
+                       "}");
+    WebSocketDeflate server(params, true, 128);
+    WebSocketDeflate client(params, false, 128);
+    for (int i = 0; i < 2; i++)
+    {
+        // The second message is compressed with the context of the first one
+        std::string compressed;
+        if (!server.compress(message.data(), message.length(), compressed))
+        {
+            std::cout << "compression failed" << std::endl;
+            return 1;
+        }
+        std::cout << "origin length=" << message.length()
+                  << " compressing length=" << compressed.length()
+                  << std::endl;
+        if (!client.decompress(compressed, message.length()) ||
+            compressed != message)
+        {
+            std::cout << "decompression failed" << std::endl;
+            return 1;
+        }
+    }
+    std::string compressed;
+    if (server.compress("short", 5, compressed))
+    {
+        std::cout << "short messages should be sent uncompressed" << std::endl;
+        return 1;
+    }
+    std::cout << "ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "../src/WebSocketConnectionImpl.h"
+#include <trantor/utils/MsgBuffer.h>
+#include <chrono>
+#include <iostream>
+
+using namespace drogon;
+
+/// Encode a masked binary frame as a client does.
+static std::string clientFrame(const std::string &payload)
+{
+    std::string frame;
+    frame.push_back((char)0x82);
+    auto len = payload.length();
+    if (len <= 125)
+    {
+        frame.push_back((char)(0x80 | len));
+    }
+    else if (len <= 65535)
+    {
+        frame.push_back((char)(0x80 | 126));
+        frame.push_back((char)((len >> 8) & 0xff));
+        frame.push_back((char)(len & 0xff));
+    }
+    else
+    {
+        frame.push_back((char)(0x80 | 127));
+        for (int i = 7; i >= 0; --i)
+            frame.push_back((char)((len >> (i * 8)) & 0xff));
+    }
+    const char mask[4] = {0x12, 0x34, 0x56, 0x78};
+    frame.append(mask, 4);
+    for (size_t i = 0; i < len; ++i)
+        frame.push_back(payload[i] ^ mask[i % 4]);
+    return frame;
+}
+
+int main()
+{
+    const size_t sizes[] = {16, 1024, 64 * 1024};
+    for (auto size : sizes)
+    {
+        std::string payload(size, 'a');
+        for (size_t i = 0; i < size; ++i)
+            payload[i] = (char)(i * 7);
+        auto frame = clientFrame(payload);
+        // About 256MB of payload for every size
+        size_t count = 256 * 1024 * 1024 / size;
+        WebSocketMessageParser parser;
+        trantor::MsgBuffer buffer;
+        std::string message;
+        WebSocketMessageType type;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i)
+        {
+            buffer.append(frame);
+            message.clear();
+            if (!parser.parse(&buffer) || !parser.gotAll(message, type))
+            {
+                std::cout << "failed to parse the frame" << std::endl;
+                return 1;
+            }
+        }
+        auto seconds = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+        if (message != payload)
+        {
+            std::cout << "wrong payload" << std::endl;
+            return 1;
+        }
+        std::cout << "frame size=" << size << " " << count / seconds
+                  << " frames/s " << count * size / seconds / 1024 / 1024
+                  << " MB/s" << std::endl;
+    }
+    return 0;
+}
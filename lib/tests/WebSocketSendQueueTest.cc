@@ -0,0 +1,187 @@
+#include "TestHelpers.h"
+#include <trantor/net/EventLoopThread.h>
+#include <trantor/net/TcpServer.h>
+#include <future>
+#include <iostream>
+
+using namespace drogon;
+using namespace drogon::test;
+
+static const uint16_t kPort = 18851;
+// Much more than the socket buffers take, so the rest stays in the output
+// buffer of the connection while the client doesn't read.
+static const size_t kLargeMessageSize = 16 * 1024 * 1024;
+
+/// The client only reads when it's asked to, so the server connection stays
+/// congested until then.
+static bool expect(WebSocketTestClient &client, const std::string &expected)
+{
+    std::string message;
+    WebSocketMessageType type;
+    if (client.receive(message, type) && message == expected)
+        return true;
+    std::cout << "expected a message of " << expected.length()
+              << " bytes, received " << message.length() << " bytes"
+              << std::endl;
+    return false;
+}
+
+template <typename Func>
+static void runInLoopAndWait(trantor::EventLoop *loop, Func &&func)
+{
+    std::promise<void> pro;
+    loop->runInLoop([&func, &pro]() {
+        func();
+        pro.set_value();
+    });
+    pro.get_future().wait();
+}
+
+static std::string message(char c, size_t size)
+{
+    return std::string(size, c);
+}
+
+int main()
+{
+    trantor::EventLoopThread loopThread;
+    loopThread.run();
+    auto loop = loopThread.getLoop();
+    trantor::TcpServer server(loop,
+                              trantor::InetAddress("127.0.0.1", kPort),
+                              "WebSocketSendQueueTest");
+    WebSocketServerConnections serverConns;
+    server.setConnectionCallback([&serverConns](
+                                     const trantor::TcpConnectionPtr &conn) {
+        if (conn->connected())
+        {
+            auto wsConn = std::make_shared<WebSocketConnectionImpl>(conn);
+            conn->setContext(wsConn);
+            serverConns.add(wsConn);
+        }
+        else if (conn->hasContext())
+        {
+            conn->getContext<WebSocketConnectionImpl>()->onClose();
+        }
+    });
+    server.setRecvMessageCallback(
+        [](const trantor::TcpConnectionPtr &, trantor::MsgBuffer *buffer) {
+            buffer->retrieveAll();
+        });
+    server.setWriteCompleteCallback([](const trantor::TcpConnectionPtr &conn) {
+        if (conn->hasContext())
+            conn->getContext<WebSocketConnectionImpl>()->onWriteComplete();
+    });
+    server.start();
+
+    WebSocketTestClient client;
+    client._fd = connectLoopback(kPort);
+    auto conn = serverConns.get(0);
+    if (client._fd < 0 || !conn)
+    {
+        std::cout << "failed to connect" << std::endl;
+        return 1;
+    }
+
+    // DropOldest: the queue keeps the newest 3000 bytes
+    size_t highWaterMarkCalls = 0;
+    auto large = message('L', kLargeMessageSize);
+    runInLoopAndWait(loop, [&]() {
+        WebSocketSendQueueOptions options;
+        options._highWaterMark = 64 * 1024;
+        options._maxQueueSize = 3000;
+        options._policy = WebSocketSendQueuePolicy::DropOldest;
+        conn->setSendQueueOptions(options);
+        conn->setHighWaterMarkCallback(
+            [&highWaterMarkCalls](const WebSocketConnectionPtr &, size_t) {
+                ++highWaterMarkCalls;
+            });
+        conn->send(large, WebSocketMessageType::Binary);
+    });
+    size_t queueSize = 0;
+    runInLoopAndWait(loop, [&]() {
+        for (char c = '1'; c <= '5'; ++c)
+            conn->send(message(c, 1000));
+        queueSize = conn->sendQueueSize();
+    });
+    if (highWaterMarkCalls == 0 || queueSize != 3000)
+    {
+        std::cout << "DropOldest: high water mark callbacks "
+                  << highWaterMarkCalls << ", queue size " << queueSize
+                  << std::endl;
+        return 1;
+    }
+
+    // DropNewest: a message which doesn't fit is dropped
+    runInLoopAndWait(loop, [&]() {
+        WebSocketSendQueueOptions options;
+        options._highWaterMark = 64 * 1024;
+        options._maxQueueSize = 3000;
+        options._policy = WebSocketSendQueuePolicy::DropNewest;
+        conn->setSendQueueOptions(options);
+        conn->send(message('6', 1000));
+        queueSize = conn->sendQueueSize();
+    });
+    if (queueSize != 3000)
+    {
+        std::cout << "DropNewest: queue size " << queueSize << std::endl;
+        return 1;
+    }
+
+    // The queue is sent in order when the client reads the output buffer
+    if (!expect(client, large) || !expect(client, message('3', 1000)) ||
+        !expect(client, message('4', 1000)) ||
+        !expect(client, message('5', 1000)))
+        return 1;
+    runInLoopAndWait(loop, [&]() {
+        queueSize = conn->sendQueueSize();
+        conn->send(message('7', 10));
+    });
+    if (queueSize != 0 || !expect(client, message('7', 10)))
+    {
+        std::cout << "the queue is not drained, size " << queueSize
+                  << std::endl;
+        return 1;
+    }
+
+    // CloseWithPolicyViolation: the queue is dropped and the connection is
+    // closed with the status code 1008
+    runInLoopAndWait(loop, [&]() {
+        WebSocketSendQueueOptions options;
+        options._highWaterMark = 64 * 1024;
+        options._maxQueueSize = 1000;
+        options._policy = WebSocketSendQueuePolicy::CloseWithPolicyViolation;
+        conn->setSendQueueOptions(options);
+        conn->send(large, WebSocketMessageType::Binary);
+    });
+    runInLoopAndWait(loop, [&]() {
+        conn->send(message('8', 600));
+        conn->send(message('9', 600));
+        queueSize = conn->sendQueueSize();
+    });
+    if (queueSize != 0 || !expect(client, large))
+    {
+        std::cout << "CloseWithPolicyViolation: queue size " << queueSize
+                  << std::endl;
+        return 1;
+    }
+    std::string closeMessage;
+    WebSocketMessageType type;
+    if (!client.receive(closeMessage, type) ||
+        type != WebSocketMessageType::Close || closeMessage.length() != 2 ||
+        (unsigned char)closeMessage[0] != 0x03 ||
+        (unsigned char)closeMessage[1] != 0xf0)
+    {
+        std::cout << "no close frame with the status code 1008" << std::endl;
+        return 1;
+    }
+    char buf[16];
+    if (recv(client._fd, buf, sizeof(buf), 0) != 0)
+    {
+        std::cout << "the connection is not shut down" << std::endl;
+        return 1;
+    }
+    close(client._fd);
+    std::cout << "ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,175 @@
+/**
+ *
+ *  BulkRows.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <assert.h>
+#include <limits>
+#include <memory>
+#include <stdio.h>
+#include <string>
+#include <string.h>
+#include <type_traits>
+#include <vector>
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+// Only defined when the floating point types are supported too
+#ifdef __cpp_lib_to_chars
+#define DROGON_HAS_FLOAT_TO_CHARS
+#endif
+#endif
+#endif
+
+namespace drogon
+{
+namespace orm
+{
+/// The rows loaded into a table by DbClient::bulkLoadAsync()
+/**
+ * Values are appended row by row in the text format of the database, and
+ * are stored in one contiguous buffer. The rows don't carry the types of the
+ * columns, so PostgreSQL loads them with the text format of COPY rather than
+ * the binary one, which would need every value encoded by the type of its
+ * column. For example:
+ * @code
+   BulkRows rows(3);
+   for (auto &user : users)
+   {
+       rows << user.id << user.name << nullptr;
+   }
+   @endcode
+ */
+class BulkRows
+{
+  public:
+    explicit BulkRows(size_t columnNum) : _columnNum(columnNum)
+    {
+        assert(columnNum > 0);
+    }
+
+    BulkRows &operator<<(const std::string &value)
+    {
+        return append(value.data(), value.length());
+    }
+    BulkRows &operator<<(const char *value)
+    {
+        if (!value)
+            return *this << nullptr;
+        return append(value, strlen(value));
+    }
+    /// Append a NULL value
+    BulkRows &operator<<(std::nullptr_t)
+    {
+        _cells.push_back({0, 0, true});
+        return *this;
+    }
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, BulkRows &>::type
+    operator<<(T value)
+    {
+        return *this << std::to_string(value);
+    }
+    /// Floating point values are written with enough digits to be read back
+    /// as the same values.
+    template <typename T>
+    typename std::enable_if<std::is_floating_point<T>::value, BulkRows &>::type
+    operator<<(T value)
+    {
+        char buf[64];
+#ifdef DROGON_HAS_FLOAT_TO_CHARS
+        auto result = std::to_chars(buf, buf + sizeof(buf), value);
+        return append(buf, result.ptr - buf);
+#else
+        auto length = snprintf(buf,
+                               sizeof(buf),
+                               "%.*Lg",
+                               std::numeric_limits<T>::max_digits10,
+                               static_cast<long double>(value));
+        return append(buf, length);
+#endif
+    }
+    /// Append a nullable value, e.g. a field of a model.
+    template <typename T>
+    BulkRows &operator<<(const std::shared_ptr<T> &value)
+    {
+        if (!value)
+            return *this << nullptr;
+        return *this << *value;
+    }
+
+    /// Reserve space for the rows and the bytes of all the values.
+    void reserve(size_t rows, size_t bytes)
+    {
+        _cells.reserve(rows * _columnNum);
+        _buffer.reserve(bytes + rows * _columnNum);
+    }
+
+    size_t columns() const
+    {
+        return _columnNum;
+    }
+    /// The number of complete rows
+    size_t rows() const
+    {
+        return _cells.size() / _columnNum;
+    }
+    bool isNull(size_t row, size_t column) const
+    {
+        return cell(row, column)._isNull;
+    }
+    /// The value is zero-terminated.
+    const char *value(size_t row, size_t column) const
+    {
+        auto &c = cell(row, column);
+        return c._isNull ? nullptr : _buffer.data() + c._offset;
+    }
+    size_t length(size_t row, size_t column) const
+    {
+        return cell(row, column)._length;
+    }
+    /// The number of bytes of all the values
+    size_t bytes() const
+    {
+        return _buffer.length();
+    }
+
+  private:
+    struct Cell
+    {
+        size_t _offset;
+        size_t _length;
+        bool _isNull;
+    };
+    const Cell &cell(size_t row, size_t column) const
+    {
+        assert(column < _columnNum);
+        assert(row * _columnNum + column < _cells.size());
+        return _cells[row * _columnNum + column];
+    }
+    BulkRows &append(const char *value, size_t length)
+    {
+        _cells.push_back({_buffer.length(), length, false});
+        _buffer.append(value, length);
+        _buffer.push_back('\0');
+        return *this;
+    }
+
+    const size_t _columnNum;
+    std::vector<Cell> _cells;
+    std::string _buffer;
+};
+
+}  // namespace orm
+}  // namespace drogon
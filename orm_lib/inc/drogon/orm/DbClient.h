@@ -13,17 +13,22 @@
  */
 
 #pragma once
+#include <drogon/orm/BulkRows.h>
+#include <drogon/orm/DbPoolOptions.h>
 #include <drogon/orm/Exception.h>
 #include <drogon/orm/Field.h>
+#include <drogon/orm/QueryCache.h>
 #include <drogon/orm/Result.h>
 #include <drogon/orm/ResultIterator.h>
 #include <drogon/orm/Row.h>
 #include <drogon/orm/RowIterator.h>
 #include <drogon/orm/SqlBinder.h>
+#include <drogon/utils/coroutine.h>
 #include <exception>
 #include <functional>
 #include <future>
 #include <string>
+#include <tuple>
 #include <trantor/utils/Logger.h>
 #include <trantor/utils/NonCopyable.h>
 
@@ -35,6 +40,14 @@ typedef std::function<void(const Result &)> ResultCallback;
 typedef std::function<void(const DrogonDbException &)> ExceptionCallback;
 
 class Transaction;
+#ifdef DROGON_HAS_COROUTINE
+namespace internal
+{
+template <typename... Arguments>
+class SqlAwaiter;
+class TransactionAwaiter;
+}  // namespace internal
+#endif
 
 /// Database client abstract class
 class DbClient : public trantor::NonCopyable
@@ -148,6 +161,56 @@ class DbClient : public trantor::NonCopyable
         return r;
     }
 
+#ifdef DROGON_HAS_COROUTINE
+    /// Awaitable method for coroutines
+    /**
+     * The coroutine awaiting the returned object is resumed with the result,
+     * or the DrogonDbException is thrown in it. It's resumed in the event
+     * loop where it's suspended.
+     * @code
+       auto result = co_await client->execSqlCoro(
+           "select * from users where org_name=$1", orgName);
+       @endcode
+     */
+    template <typename... Arguments>
+    internal::SqlAwaiter<typename std::decay<Arguments>::type...> execSqlCoro(
+        const std::string &sql,
+        Arguments &&... args)
+    {
+        return internal::SqlAwaiter<typename std::decay<Arguments>::type...>(
+            *this, sql, std::forward<Arguments>(args)...);
+    }
+#endif
+
+    /// Load rows into a table in bulk.
+    /**
+     * @param tableName The table into which the rows are loaded.
+     * @param columns The names of the columns, in the order of the values of
+     * each row.
+     * @param rows The values in the text format of the database.
+     * @param rcb is called with the number of loaded rows after they are
+     * committed.
+     * @param ecb is called when an error occurs, no row is loaded in this
+     * case.
+     *
+     * PostgreSQL loads all the rows with one 'COPY ... FROM STDIN' statement
+     * in the text format (see BulkRows), MySQL with multi-row INSERT
+     * statements, and Sqlite3 executes one prepared INSERT statement for
+     * every row. All the statements are executed in one transaction, or in
+     * the transaction on which this method is called (rcb is called after
+     * the last statement in this case).
+     */
+    void bulkLoadAsync(const std::string &tableName,
+                       const std::vector<std::string> &columns,
+                       BulkRows &&rows,
+                       const std::function<void(size_t)> &rcb,
+                       const ExceptionCallback &ecb) noexcept;
+
+    /// Load rows into a table in bulk, see bulkLoadAsync().
+    std::future<size_t> bulkLoadFuture(const std::string &tableName,
+                                       const std::vector<std::string> &columns,
+                                       BulkRows &&rows) noexcept;
+
     /// Streaming-like method for sql execution. For more information, see the
     /// wiki page.
     internal::SqlBinder operator<<(const std::string &sql);
@@ -173,6 +236,90 @@ class DbClient : public trantor::NonCopyable
         const std::function<void(const std::shared_ptr<Transaction> &)>
             &callback) = 0;
 
+#ifdef DROGON_HAS_COROUTINE
+    /// Create a transaction object in coroutines, e.g.
+    /// auto transaction = co_await client->newTransactionCoro();
+    internal::TransactionAwaiter newTransactionCoro();
+#endif
+
+    /// Create a transaction object which only executes read-only statements.
+    /**
+     * A client with read replicas runs the transaction on one of the
+     * replicas, other clients run it like a normal transaction.
+     */
+    virtual std::shared_ptr<Transaction> newReadOnlyTransaction(
+        const std::function<void(bool)> &commitCallback = nullptr)
+    {
+        return newTransaction(commitCallback);
+    }
+
+    /// Create a read-only transaction object in asynchronous mode.
+    virtual void newReadOnlyTransactionAsync(
+        const std::function<void(const std::shared_ptr<Transaction> &)>
+            &callback)
+    {
+        newTransactionAsync(callback);
+    }
+
+    /// Get a client bound to a session, e.g. the HTTP session ID or user ID.
+    /**
+     * For a client with read replicas, reads made through the returned client
+     * are sent to the primary server for a while (the 'sticky_window' option)
+     * after a write made through a client bound to the same session, so that
+     * the session always reads its own writes. Other clients return
+     * themselves.
+     *
+     * The default implementation returns a pointer which doesn't own this
+     * client, so the returned pointer must not outlive the client. The
+     * subclasses managed by shared pointers should override it.
+     */
+    virtual std::shared_ptr<DbClient> sessionClient(const std::string &)
+    {
+        return std::shared_ptr<DbClient>(std::shared_ptr<DbClient>(), this);
+    }
+
+    /// Set the result cache of read-only statements.
+    /**
+     * See QueryCache for details, a nullptr disables the cache. Clients
+     * created for the same configuration (e.g. one client per IO loop in fast
+     * mode) should share one cache so that invalidating a table affects all of
+     * them.
+     */
+    virtual void setQueryCache(const std::shared_ptr<QueryCache> &cache)
+    {
+        _queryCache = cache;
+    }
+    const std::shared_ptr<QueryCache> &queryCache() const
+    {
+        return _queryCache;
+    }
+
+    /// Invalidate the cached results which read the table.
+    /**
+     * Mapper<T> calls this method after every insertion, update and deletion.
+     * Call it after other writes to the table when the query cache is
+     * enabled.
+     */
+    virtual void invalidateQueryCache(const std::string &tableName)
+    {
+        if (_queryCache)
+            _queryCache->invalidate(tableName);
+    }
+
+    /// Set the sizing and timeout options of the connection pool.
+    /**
+     * Only the clients created in normal mode have a connection pool, other
+     * clients ignore the options. See DbPoolOptions for details.
+     */
+    virtual void setPoolOptions(const DbPoolOptions &)
+    {
+    }
+    /// Get the current state of the connection pool.
+    virtual DbPoolMetrics poolMetrics() const
+    {
+        return DbPoolMetrics();
+    }
+
     ClientType type() const
     {
         return _type;
@@ -184,6 +331,7 @@ class DbClient : public trantor::NonCopyable
 
   private:
     friend internal::SqlBinder;
+    friend class ReplicatedDbClient;
     virtual void execSql(
         std::string &&sql,
         size_t paraNum,
@@ -192,10 +340,16 @@ class DbClient : public trantor::NonCopyable
         std::vector<int> &&format,
         ResultCallback &&rcb,
         std::function<void(const std::exception_ptr &)> &&exceptCallback) = 0;
+    void bulkLoad(const std::string &tableName,
+                  const std::vector<std::string> &columns,
+                  const std::shared_ptr<BulkRows> &rows,
+                  std::function<void(size_t)> &&rcb,
+                  std::function<void(const std::exception_ptr &)> &&ecb);
 
   protected:
     ClientType _type;
     std::string _connInfo;
+    std::shared_ptr<QueryCache> _queryCache;
 };
 typedef std::shared_ptr<DbClient> DbClientPtr;
 
@@ -208,5 +362,72 @@ class Transaction : public DbClient
         const std::function<void(bool)> &commitCallback) = 0;
 };
 
+#ifdef DROGON_HAS_COROUTINE
+namespace internal
+{
+template <typename... Arguments>
+class SqlAwaiter : public CallbackAwaiter<Result>
+{
+  public:
+    template <typename... Values>
+    SqlAwaiter(DbClient &client, const std::string &sql, Values &&... values)
+        : _client(client),
+          _sql(sql),
+          _arguments(std::forward<Values>(values)...)
+    {
+    }
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        setHandle(handle);
+        {
+            // The query is executed when the binder is destroyed
+            auto binder = _client << std::move(_sql);
+            std::apply(
+                [&binder](Arguments &... args) {
+                    (void)std::initializer_list<int>{
+                        (binder << std::move(args), 0)...};
+                },
+                _arguments);
+            binder >> [this](const Result &result) { setValue(result); };
+            binder >> [this](const std::exception_ptr &exception) {
+                setException(exception);
+            };
+        }
+        return suspend();
+    }
+
+  private:
+    DbClient &_client;
+    std::string _sql;
+    std::tuple<Arguments...> _arguments;
+};
+
+class TransactionAwaiter : public CallbackAwaiter<std::shared_ptr<Transaction>>
+{
+  public:
+    explicit TransactionAwaiter(DbClient &client) : _client(client)
+    {
+    }
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        setHandle(handle);
+        _client.newTransactionAsync(
+            [this](const std::shared_ptr<Transaction> &transaction) {
+                setValue(transaction);
+            });
+        return suspend();
+    }
+
+  private:
+    DbClient &_client;
+};
+}  // namespace internal
+
+inline internal::TransactionAwaiter DbClient::newTransactionCoro()
+{
+    return internal::TransactionAwaiter(*this);
+}
+#endif
+
 }  // namespace orm
 }  // namespace drogon
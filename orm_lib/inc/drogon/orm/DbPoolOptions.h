@@ -0,0 +1,79 @@
+/**
+ *
+ *  DbPoolOptions.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace drogon
+{
+namespace orm
+{
+/// The sizing and timeout options of the connection pool of a DbClient
+/**
+ * The pool opens the 'connection_number' connections at startup and keeps
+ * them, it opens more connections (up to _maxConnections) when statements
+ * have to wait in the queue, and closes the extra connections after they have
+ * been idle for _idleTimeout seconds.
+ *
+ * A timeout of 0 means no timeout. Statements which time out fail with the
+ * TimeoutError exception.
+ */
+struct DbPoolOptions
+{
+    /// The maximum number of connections, 0 means the connection number of
+    /// the client, i.e. the pool never grows.
+    size_t _maxConnections = 0;
+    /// The number of seconds an extra connection stays idle before it is
+    /// closed.
+    double _idleTimeout = 60.0;
+    /// The number of seconds a statement may wait for a connection.
+    double _queueTimeout = 0.0;
+    /// The number of seconds a statement may wait for its result after it is
+    /// sent to the server.
+    double _queryTimeout = 0.0;
+    /// The interval in seconds of the lightweight query ("select 1") sent on
+    /// the idle connections to find out broken ones, 0 means no health check.
+    double _healthCheckInterval = 0.0;
+    /// The maximum number of statements waiting for a connection.
+    size_t _maxQueueSize = 200000;
+};
+
+/// A snapshot of the state of the connection pool of a DbClient
+struct DbPoolMetrics
+{
+    /// The upper bounds in seconds of the buckets of _waitTimeHistogram, the
+    /// last bucket holds everything above the last bound.
+    static const std::vector<double> &waitTimeBuckets()
+    {
+        static const std::vector<double> buckets{
+            0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1.0, 5.0};
+        return buckets;
+    }
+
+    size_t _connectionNumber = 0;
+    size_t _busyConnectionNumber = 0;
+    /// The number of statements and transactions waiting for a connection.
+    size_t _queueDepth = 0;
+    /// The number of statements which failed with TimeoutError.
+    uint64_t _timeoutNumber = 0;
+    /// The number of statements by the time they waited for a connection, it
+    /// has waitTimeBuckets().size() + 1 elements.
+    std::vector<uint64_t> _waitTimeHistogram;
+};
+
+}  // namespace orm
+}  // namespace drogon
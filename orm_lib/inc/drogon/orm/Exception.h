@@ -158,6 +158,17 @@ class InDoubtError : public Failure
     explicit InDoubtError(const std::string &);
 };
 
+/// A statement waited too long for a connection or for its result.
+/** Thrown when the 'queue_timeout' or the 'query_timeout' of a connection pool
+ * expires (see DbPoolOptions). The statement may still be executed by the
+ * server if the query timeout expired.
+ */
+class TimeoutError : public Failure
+{
+  public:
+    explicit TimeoutError(const std::string &);
+};
+
 /// The backend saw itself forced to roll back the ongoing transaction.
 class TransactionRollback : public Failure
 {
@@ -16,6 +16,8 @@
 #include <drogon/orm/Criteria.h>
 #include <drogon/orm/DbClient.h>
 #include <drogon/utils/Utilities.h>
+#include <algorithm>
+#include <atomic>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -310,6 +312,40 @@ class Mapper
      */
     std::future<T> insertFuture(const T &) noexcept;
 
+    /**
+     * @brief Insert rows into the table in batches.
+     *
+     * Every statement inserts as many rows as the limit of bound parameters
+     * of the database allows (65535 for PostgreSQL and MySQL, 999 for
+     * Sqlite3), instead of one row per statement.
+     *
+     * @param objs The objects to be inserted. With PostgreSQL they are
+     * updated with the inserted rows (e.g. the auto-increased primary keys),
+     * with MySQL and Sqlite3 they are left unchanged.
+     * @return size_t The number of inserted rows.
+     */
+    size_t insertBatch(std::vector<T> &objs) noexcept(false);
+
+    /**
+     * @brief Asynchronously insert rows into the table in batches.
+     *
+     * @param objs The objects to be inserted.
+     * @param rcb is called with the number of inserted rows.
+     * @param ecb is called when an error occurs, the statements of other
+     * batches may have succeeded, use a transaction if necessary.
+     */
+    void insertBatch(const std::vector<T> &objs,
+                     const CountCallback &rcb,
+                     const ExceptionCallback &ecb) noexcept;
+
+    /**
+     * @brief Asynchronously insert rows into the table in batches.
+     *
+     * @return std::future<size_t> The future object with which user can get
+     * the number of inserted rows.
+     */
+    std::future<size_t> insertBatchFuture(const std::vector<T> &objs) noexcept;
+
     /**
      * @brief Update a record.
      *
@@ -475,6 +511,20 @@ class Mapper
 
     std::string replaceSqlPlaceHolder(const std::string &sqlStr,
                                       const std::string &holderStr) const;
+    /// The number of rows inserted by one statement of insertBatch()
+    size_t batchRowNumber() const
+    {
+        size_t maxParameters =
+            _client->type() == ClientType::Sqlite3 ? 999 : 65535;
+        return (std::max)((size_t)1,
+                          maxParameters / T::insertColumns().size());
+    }
+    std::string insertBatchSql(size_t rowNum) const;
+    /// The common part of the asynchronous insertBatch() methods
+    void insertBatchAsync(
+        const std::vector<T> &objs,
+        std::function<void(size_t)> &&rcb,
+        std::function<void(const std::exception_ptr &)> &&ecb);
 };
 
 template <typename T>
@@ -1059,6 +1109,7 @@ inline void Mapper<T>::insert(T &obj) noexcept(false)
         binder >> [&r](const Result &result) { r = result; };
         binder.exec();  // Maybe throw exception;
     }
+    _client->invalidateQueryCache(T::tableName);
     if (_client->type() == ClientType::PostgreSQL)
     {
         assert(r.size() == 1);
@@ -1100,6 +1151,7 @@ inline void Mapper<T>::insert(const T &obj,
     obj.outputArgs(binder);
     auto client = _client;
     binder >> [client, rcb, obj](const Result &r) {
+        client->invalidateQueryCache(T::tableName);
         if (client->type() == ClientType::PostgreSQL)
         {
             assert(r.size() == 1);
@@ -1145,6 +1197,7 @@ inline std::future<T> Mapper<T>::insertFuture(const T &obj) noexcept
     std::shared_ptr<std::promise<T>> prom = std::make_shared<std::promise<T>>();
     auto client = _client;
     binder >> [client, prom, obj](const Result &r) {
+        client->invalidateQueryCache(T::tableName);
         if (client->type() == ClientType::PostgreSQL)
         {
             assert(r.size() == 1);
@@ -1163,6 +1216,161 @@ inline std::future<T> Mapper<T>::insertFuture(const T &obj) noexcept
     return prom->get_future();
 }
 template <typename T>
+inline std::string Mapper<T>::insertBatchSql(size_t rowNum) const
+{
+    std::string sql = "insert into ";
+    sql += T::tableName;
+    sql += " (";
+    for (auto const &colName : T::insertColumns())
+    {
+        sql += colName;
+        sql += ",";
+    }
+    sql[sql.length() - 1] = ')';  // Replace the last ','
+    sql += " values ";
+    std::string row = "(";
+    for (size_t i = 0; i < T::insertColumns().size(); i++)
+    {
+        row += "$?,";
+    }
+    row[row.length() - 1] = ')';  // Replace the last ','
+    sql.reserve(sql.length() + rowNum * (row.length() + 1) + 12);
+    for (size_t i = 0; i < rowNum; i++)
+    {
+        sql += row;
+        sql += ",";
+    }
+    sql.resize(sql.length() - 1);  // Remove the last ','
+    if (_client->type() == ClientType::PostgreSQL)
+    {
+        sql += " returning *";
+    }
+    return replaceSqlPlaceHolder(sql, "$?");
+}
+template <typename T>
+inline size_t Mapper<T>::insertBatch(std::vector<T> &objs) noexcept(false)
+{
+    clear();
+    size_t insertedRows = 0;
+    auto batchRows = batchRowNumber();
+    for (size_t begin = 0; begin < objs.size(); begin += batchRows)
+    {
+        auto end = (std::min)(objs.size(), begin + batchRows);
+        Result r(nullptr);
+        {
+            auto binder = *_client << insertBatchSql(end - begin);
+            for (size_t i = begin; i < end; i++)
+            {
+                objs[i].outputArgs(binder);
+            }
+            binder << Mode::Blocking;
+            binder >> [&r](const Result &result) { r = result; };
+            binder.exec();  // Maybe throw exception;
+        }
+        _client->invalidateQueryCache(T::tableName);
+        if (_client->type() == ClientType::PostgreSQL)
+        {
+            assert(r.size() == end - begin);
+            for (size_t i = 0; i < r.size(); i++)
+            {
+                objs[begin + i] = T(r[i]);
+            }
+            insertedRows += r.size();
+        }
+        else  // Mysql or Sqlite3
+        {
+            insertedRows += r.affectedRows();
+        }
+    }
+    return insertedRows;
+}
+template <typename T>
+inline void Mapper<T>::insertBatch(const std::vector<T> &objs,
+                                   const CountCallback &rcb,
+                                   const ExceptionCallback &ecb) noexcept
+{
+    insertBatchAsync(objs,
+                     [rcb](size_t count) { rcb(count); },
+                     [ecb](const std::exception_ptr &exception) {
+                         try
+                         {
+                             std::rethrow_exception(exception);
+                         }
+                         catch (const DrogonDbException &e)
+                         {
+                             ecb(e);
+                         }
+                     });
+}
+template <typename T>
+inline std::future<size_t> Mapper<T>::insertBatchFuture(
+    const std::vector<T> &objs) noexcept
+{
+    std::shared_ptr<std::promise<size_t>> prom =
+        std::make_shared<std::promise<size_t>>();
+    insertBatchAsync(objs,
+                     [prom](size_t count) { prom->set_value(count); },
+                     [prom](const std::exception_ptr &e) {
+                         prom->set_exception(e);
+                     });
+    return prom->get_future();
+}
+template <typename T>
+inline void Mapper<T>::insertBatchAsync(
+    const std::vector<T> &objs,
+    std::function<void(size_t)> &&rcb,
+    std::function<void(const std::exception_ptr &)> &&ecb)
+{
+    clear();
+    if (objs.empty())
+    {
+        rcb(0);
+        return;
+    }
+    struct BatchState
+    {
+        std::atomic<size_t> _pendingBatches{0};
+        std::atomic<size_t> _insertedRows{0};
+        std::atomic<bool> _failed{false};
+        std::function<void(size_t)> _rcb;
+        std::function<void(const std::exception_ptr &)> _ecb;
+    };
+    auto state = std::make_shared<BatchState>();
+    state->_rcb = std::move(rcb);
+    state->_ecb = std::move(ecb);
+    auto batchRows = batchRowNumber();
+    state->_pendingBatches = (objs.size() + batchRows - 1) / batchRows;
+    auto client = _client;
+    for (size_t begin = 0; begin < objs.size(); begin += batchRows)
+    {
+        auto end = (std::min)(objs.size(), begin + batchRows);
+        auto binder = *_client << insertBatchSql(end - begin);
+        for (size_t i = begin; i < end; i++)
+        {
+            objs[i].outputArgs(binder);
+        }
+        binder >> [client, state](const Result &r) {
+            client->invalidateQueryCache(T::tableName);
+            auto rows = client->type() == ClientType::PostgreSQL
+                            ? r.size()
+                            : r.affectedRows();
+            state->_insertedRows += rows;
+            if (--state->_pendingBatches == 0 && !state->_failed)
+            {
+                state->_rcb(state->_insertedRows);
+            }
+        };
+        binder >> [state](const std::exception_ptr &e) {
+            --state->_pendingBatches;
+            // Only the first error is reported
+            if (!state->_failed.exchange(true))
+            {
+                state->_ecb(e);
+            }
+        };
+    }
+}
+template <typename T>
 inline size_t Mapper<T>::update(const T &obj) noexcept(false)
 {
     clear();
@@ -1190,6 +1398,7 @@ inline size_t Mapper<T>::update(const T &obj) noexcept(false)
         binder >> [&r](const Result &result) { r = result; };
         binder.exec();  // Maybe throw exception;
     }
+    _client->invalidateQueryCache(T::tableName);
     return r.affectedRows();
 }
 template <typename T>
@@ -1216,7 +1425,11 @@ inline void Mapper<T>::update(const T &obj,
     auto binder = *_client << std::move(sql);
     obj.updateArgs(binder);
     outputPrimeryKeyToBinder(obj.getPrimaryKey(), binder);
-    binder >> [=](const Result &r) { rcb(r.affectedRows()); };
+    auto client = _client;
+    binder >> [=](const Result &r) {
+        client->invalidateQueryCache(T::tableName);
+        rcb(r.affectedRows());
+    };
     binder >> ecb;
 }
 template <typename T>
@@ -1244,7 +1457,11 @@ inline std::future<size_t> Mapper<T>::updateFuture(const T &obj) noexcept
 
     std::shared_ptr<std::promise<size_t>> prom =
         std::make_shared<std::promise<size_t>>();
-    binder >> [=](const Result &r) { prom->set_value(r.affectedRows()); };
+    auto client = _client;
+    binder >> [=](const Result &r) {
+        client->invalidateQueryCache(T::tableName);
+        prom->set_value(r.affectedRows());
+    };
     binder >> [=](const std::exception_ptr &e) { prom->set_exception(e); };
     binder.exec();
     return prom->get_future();
@@ -1272,6 +1489,7 @@ inline size_t Mapper<T>::deleteOne(const T &obj) noexcept(false)
         binder >> [&r](const Result &result) { r = result; };
         binder.exec();  // Maybe throw exception;
     }
+    _client->invalidateQueryCache(T::tableName);
     return r.affectedRows();
 }
 template <typename T>
@@ -1291,7 +1509,11 @@ inline void Mapper<T>::deleteOne(const T &obj,
     sql = replaceSqlPlaceHolder(sql, "$?");
     auto binder = *_client << std::move(sql);
     outputPrimeryKeyToBinder(obj.getPrimaryKey(), binder);
-    binder >> [=](const Result &r) { rcb(r.affectedRows()); };
+    auto client = _client;
+    binder >> [=](const Result &r) {
+        client->invalidateQueryCache(T::tableName);
+        rcb(r.affectedRows());
+    };
     binder >> ecb;
 }
 template <typename T>
@@ -1312,7 +1534,11 @@ inline std::future<size_t> Mapper<T>::deleteFutureOne(const T &obj) noexcept
 
     std::shared_ptr<std::promise<size_t>> prom =
         std::make_shared<std::promise<size_t>>();
-    binder >> [=](const Result &r) { prom->set_value(r.affectedRows()); };
+    auto client = _client;
+    binder >> [=](const Result &r) {
+        client->invalidateQueryCache(T::tableName);
+        prom->set_value(r.affectedRows());
+    };
     binder >> [=](const std::exception_ptr &e) { prom->set_exception(e); };
     binder.exec();
     return prom->get_future();
@@ -1345,6 +1571,7 @@ inline size_t Mapper<T>::deleteBy(const Criteria &criteria) noexcept(false)
         binder >> [&r](const Result &result) { r = result; };
         binder.exec();  // Maybe throw exception;
     }
+    _client->invalidateQueryCache(T::tableName);
     return r.affectedRows();
 }
 template <typename T>
@@ -1370,7 +1597,11 @@ inline void Mapper<T>::deleteBy(const Criteria &criteria,
     {
         criteria.outputArgs(binder);
     }
-    binder >> [=](const Result &r) { rcb(r.affectedRows()); };
+    auto client = _client;
+    binder >> [=](const Result &r) {
+        client->invalidateQueryCache(T::tableName);
+        rcb(r.affectedRows());
+    };
     binder >> ecb;
 }
 template <typename T>
@@ -1396,7 +1627,11 @@ inline std::future<size_t> Mapper<T>::deleteFutureBy(
 
     std::shared_ptr<std::promise<size_t>> prom =
         std::make_shared<std::promise<size_t>>();
-    binder >> [=](const Result &r) { prom->set_value(r.affectedRows()); };
+    auto client = _client;
+    binder >> [=](const Result &r) {
+        client->invalidateQueryCache(T::tableName);
+        prom->set_value(r.affectedRows());
+    };
     binder >> [=](const std::exception_ptr &e) { prom->set_exception(e); };
     binder.exec();
     return prom->get_future();
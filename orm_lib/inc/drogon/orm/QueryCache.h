@@ -0,0 +1,111 @@
+/**
+ *
+ *  QueryCache.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/orm/Result.h>
+#include <trantor/utils/NonCopyable.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace trantor
+{
+class EventLoop;
+}
+
+namespace drogon
+{
+namespace orm
+{
+namespace internal
+{
+class SqlBinder;
+}
+
+/// The result cache of read-only statements
+/**
+ * A DbClient with a query cache (see DbClient::setQueryCache()) serves the
+ * results of read-only statements executed in IO loops from the cache. The
+ * key of an entry is the SQL statement and all the bound parameters.
+ *
+ * Entries are stored per IO loop so looking them up needs no locking. An entry
+ * expires after the timeout or when one of the tables it reads is invalidated
+ * by the invalidate() method. Mapper<T> invalidates the table of T after every
+ * insertion, update and deletion, other writes must call the
+ * DbClient::invalidateQueryCache() method.
+ *
+ * Statements whose tables can't be found out (e.g. "select now()") are never
+ * cached.
+ */
+class QueryCache : public trantor::NonCopyable,
+                   public std::enable_shared_from_this<QueryCache>
+{
+  public:
+    /**
+     * @param timeout The number of seconds an entry stays valid.
+     * @param maxEntries The maximum number of entries in one IO loop.
+     */
+    explicit QueryCache(double timeout, size_t maxEntries = 10000);
+
+    /// Invalidate all cached results which read the table.
+    void invalidate(const std::string &tableName);
+
+    double timeout() const
+    {
+        return _timeout;
+    }
+    size_t maxEntries() const
+    {
+        return _maxEntries;
+    }
+
+    /// Return the names of the tables read by a SELECT statement.
+    static std::vector<std::string> tablesOfSql(const std::string &sql);
+
+  private:
+    friend internal::SqlBinder;
+    typedef std::shared_ptr<std::atomic<uint64_t>> GenerationPtr;
+    typedef std::vector<std::pair<GenerationPtr, uint64_t>> Generations;
+    struct Query
+    {
+        std::string _key;
+        Generations _generations;
+        trantor::EventLoop *_loop = nullptr;
+    };
+    /// Return false if the statement can't be cached in the current thread,
+    /// otherwise the key of the query starts with the statement.
+    bool prepare(const std::string &sql, Query &query);
+    bool find(const Query &query, Result &result);
+    void store(Query &&query, const Result &result);
+    GenerationPtr generationOf(const std::string &tableName);
+    struct LoopCache;
+    /// Return the entries of the current thread.
+    LoopCache &loopCache();
+
+    const double _timeout;
+    const size_t _maxEntries;
+    const uint64_t _id;
+    std::mutex _mutex;
+    std::unordered_map<std::string, GenerationPtr> _generations;
+    // The entries of every thread, they are freed with the cache
+    std::vector<std::shared_ptr<LoopCache>> _loopCaches;
+};
+
+}  // namespace orm
+}  // namespace drogon
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <memory>
+#include <stdint.h>
 #include <string>
 #ifdef _WIN32
 #define noexcept _NOEXCEPT
@@ -140,6 +141,8 @@ class Result
     const char *getValue(size_type row, row_size_type column) const;
     bool isNull(size_type row, row_size_type column) const;
     field_size_type getLength(size_type row, row_size_type column) const;
+    bool getInt64(size_type row, row_size_type column, int64_t &value) const;
+    bool getDouble(size_type row, row_size_type column, double &value) const;
 
   protected:
     Result()
@@ -391,6 +391,9 @@ class SqlBinder
 
   private:
     int getMysqlTypeBySize(size_t size);
+    /// Append the types and values of the parameters to the key of the query
+    /// cache.
+    void appendParametersToKey(std::string &key) const;
     std::string _sql;
     DbClient &_client;
     size_t _paraNum = 0;
@@ -15,9 +15,71 @@
 #include "DbClientImpl.h"
 #include <drogon/config.h>
 #include <drogon/orm/DbClient.h>
+#include <drogon/orm/Exception.h>
+#include <algorithm>
+#if USE_MYSQL
+#include <mysql.h>
+#endif
 using namespace drogon::orm;
 using namespace drogon;
 
+namespace
+{
+struct BulkLoadState
+{
+    size_t _pendingStatements = 0;
+    size_t _loadedRows = 0;
+    bool _failed = false;
+    std::function<void(size_t)> _rcb;
+    std::function<void(const std::exception_ptr &)> _ecb;
+};
+
+/// Rows in the text format of COPY, see the PostgreSQL documentation.
+std::string copyData(const BulkRows &rows)
+{
+    std::string data;
+    data.reserve(rows.bytes() + rows.bytes() / 8 + rows.rows());
+    for (size_t row = 0; row < rows.rows(); ++row)
+    {
+        for (size_t column = 0; column < rows.columns(); ++column)
+        {
+            if (column > 0)
+                data.push_back('\t');
+            if (rows.isNull(row, column))
+            {
+                data.append("\\N");
+                continue;
+            }
+            auto value = rows.value(row, column);
+            auto length = rows.length(row, column);
+            for (size_t i = 0; i < length; ++i)
+            {
+                switch (value[i])
+                {
+                    case '\\':
+                        data.append("\\\\");
+                        break;
+                    case '\t':
+                        data.append("\\t");
+                        break;
+                    case '\n':
+                        data.append("\\n");
+                        break;
+                    case '\r':
+                        data.append("\\r");
+                        break;
+                    default:
+                        data.push_back(value[i]);
+                        break;
+                }
+            }
+        }
+        data.push_back('\n');
+    }
+    return data;
+}
+}  // namespace
+
 internal::SqlBinder DbClient::operator<<(const std::string &sql)
 {
     return internal::SqlBinder(sql, *this, _type);
@@ -65,3 +127,247 @@ std::shared_ptr<DbClient> DbClient::newSqlite3Client(
     exit(1);
 #endif
 }
+
+void DbClient::bulkLoadAsync(const std::string &tableName,
+                             const std::vector<std::string> &columns,
+                             BulkRows &&rows,
+                             const std::function<void(size_t)> &rcb,
+                             const ExceptionCallback &ecb) noexcept
+{
+    bulkLoad(tableName,
+             columns,
+             std::make_shared<BulkRows>(std::move(rows)),
+             [rcb](size_t count) { rcb(count); },
+             [ecb](const std::exception_ptr &exception) {
+                 try
+                 {
+                     std::rethrow_exception(exception);
+                 }
+                 catch (const DrogonDbException &e)
+                 {
+                     ecb(e);
+                 }
+             });
+}
+
+std::future<size_t> DbClient::bulkLoadFuture(
+    const std::string &tableName,
+    const std::vector<std::string> &columns,
+    BulkRows &&rows) noexcept
+{
+    auto prom = std::make_shared<std::promise<size_t>>();
+    bulkLoad(tableName,
+             columns,
+             std::make_shared<BulkRows>(std::move(rows)),
+             [prom](size_t count) { prom->set_value(count); },
+             [prom](const std::exception_ptr &e) { prom->set_exception(e); });
+    return prom->get_future();
+}
+
+void DbClient::bulkLoad(const std::string &tableName,
+                        const std::vector<std::string> &columns,
+                        const std::shared_ptr<BulkRows> &rows,
+                        std::function<void(size_t)> &&rcb,
+                        std::function<void(const std::exception_ptr &)> &&ecb)
+{
+    assert(!columns.empty());
+    assert(columns.size() == rows->columns());
+    if (rows->rows() == 0)
+    {
+        rcb(0);
+        return;
+    }
+    // libpq doesn't allow COPY in batch mode, so the batch connections
+    // insert the rows by multi-row INSERT statements like MySQL.
+    bool useCopy =
+        _type == ClientType::PostgreSQL && !LIBPQ_SUPPORTS_BATCH_MODE;
+    std::string sql;
+    if (useCopy)
+        sql = "copy ";
+    else
+        sql = "insert into ";
+    sql += tableName;
+    sql += " (";
+    for (auto &column : columns)
+    {
+        sql += column;
+        sql += ",";
+    }
+    sql[sql.length() - 1] = ')';  // Replace the last ','
+    if (useCopy)
+        sql += " from stdin";
+    else
+        sql += " values ";
+
+    auto state = std::make_shared<BulkLoadState>();
+    state->_rcb = std::move(rcb);
+    state->_ecb = std::move(ecb);
+    // A transaction creates no new transaction, it is committed by the user.
+    bool inTransaction = dynamic_cast<Transaction *>(this) != nullptr;
+    auto type = _type;
+    newTransactionAsync([sql = std::move(sql),
+                         type,
+                         useCopy,
+                         tableName,
+                         rows,
+                         state,
+                         inTransaction](
+                            const std::shared_ptr<Transaction> &trans) {
+        if (!inTransaction)
+        {
+            trans->setCommitCallback([state](bool committed) {
+                if (committed)
+                {
+                    state->_rcb(state->_loadedRows);
+                    return;
+                }
+                try
+                {
+                    throw Failure("Failed to commit the bulk load");
+                }
+                catch (...)
+                {
+                    state->_ecb(std::current_exception());
+                }
+            });
+        }
+        auto rowNum = rows->rows();
+        auto columnNum = rows->columns();
+        struct Statement
+        {
+            std::string _sql;
+            std::vector<const char *> _parameters;
+            std::vector<int> _length;
+            std::vector<int> _format;
+        };
+        std::vector<Statement> statements;
+        std::shared_ptr<std::string> copyBuffer;
+        if (useCopy)
+        {
+            copyBuffer = std::make_shared<std::string>(copyData(*rows));
+            Statement statement;
+            statement._sql = sql;
+            statement._parameters.push_back(copyBuffer->data());
+            statement._length.push_back((int)copyBuffer->length());
+            statement._format.push_back(0);
+            statements.push_back(std::move(statement));
+        }
+        else
+        {
+            int textFormat = 0, nullFormat = 0;
+            size_t maxRows = 1;
+            if (type == ClientType::Mysql)
+            {
+#if USE_MYSQL
+                textFormat = MYSQL_TYPE_STRING;
+                nullFormat = MYSQL_TYPE_NULL;
+#endif
+                // MySQL allows 65535 parameters in one statement
+                maxRows = (std::max)((size_t)1, 65535 / columnNum);
+            }
+            else if (type == ClientType::PostgreSQL)
+            {
+                // The same limit as MySQL, NULL is a null pointer in the text
+                // format.
+                maxRows = (std::max)((size_t)1, 65535 / columnNum);
+            }
+            else
+            {
+                // One statement is prepared for all the rows of Sqlite3
+                textFormat = Sqlite3TypeText;
+                nullFormat = Sqlite3TypeNull;
+            }
+            std::string rowPlaceholders = "(";
+            for (size_t column = 0; column < columnNum; ++column)
+                rowPlaceholders += "?,";
+            rowPlaceholders[rowPlaceholders.length() - 1] = ')';
+            for (size_t begin = 0; begin < rowNum;)
+            {
+                // Keep a MySQL statement far below the default
+                // max_allowed_packet
+                size_t end = begin;
+                size_t bytes = 0;
+                while (end < rowNum && end - begin < maxRows &&
+                       (end == begin || bytes < 1024 * 1024))
+                {
+                    for (size_t column = 0; column < columnNum; ++column)
+                        bytes += rows->length(end, column);
+                    ++end;
+                }
+                Statement statement;
+                statement._sql = sql;
+                auto paraNum = (end - begin) * columnNum;
+                statement._parameters.reserve(paraNum);
+                statement._length.reserve(paraNum);
+                statement._format.reserve(paraNum);
+                for (size_t row = begin; row < end; ++row)
+                {
+                    if (row > begin)
+                        statement._sql += ",";
+                    if (type == ClientType::PostgreSQL)
+                    {
+                        // Numbered placeholders, i.e. ($1,$2),($3,$4)...
+                        statement._sql += "(";
+                        for (size_t column = 0; column < columnNum; ++column)
+                        {
+                            if (column > 0)
+                                statement._sql += ",";
+                            statement._sql += "$";
+                            statement._sql += std::to_string(
+                                (row - begin) * columnNum + column + 1);
+                        }
+                        statement._sql += ")";
+                    }
+                    else
+                    {
+                        statement._sql += rowPlaceholders;
+                    }
+                    for (size_t column = 0; column < columnNum; ++column)
+                    {
+                        statement._parameters.push_back(
+                            rows->value(row, column));
+                        statement._length.push_back(
+                            (int)rows->length(row, column));
+                        statement._format.push_back(rows->isNull(row, column)
+                                                        ? nullFormat
+                                                        : textFormat);
+                    }
+                }
+                statements.push_back(std::move(statement));
+                begin = end;
+            }
+        }
+        // All the statements are counted before executing any of them, the
+        // callbacks are called in the event loop of the transaction.
+        state->_pendingStatements = statements.size();
+        for (auto &statement : statements)
+        {
+            auto paraNum = statement._parameters.size();
+            // The parameters point to the values, so the callback keeps the
+            // rows alive.
+            trans->execSql(
+                std::move(statement._sql),
+                paraNum,
+                std::move(statement._parameters),
+                std::move(statement._length),
+                std::move(statement._format),
+                [trans, tableName, rows, copyBuffer, state, inTransaction](
+                    const Result &r) {
+                    state->_loadedRows += r.affectedRows();
+                    if (--state->_pendingStatements > 0 || state->_failed)
+                        return;
+                    trans->invalidateQueryCache(tableName);
+                    if (inTransaction)
+                        state->_rcb(state->_loadedRows);
+                },
+                [state](const std::exception_ptr &e) {
+                    // The transaction is rolled back automatically
+                    --state->_pendingStatements;
+                    if (state->_failed)
+                        return;
+                    state->_failed = true;
+                    state->_ecb(e);
+                });
+        }
+    });
+}
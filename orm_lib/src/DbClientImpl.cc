@@ -51,13 +51,15 @@ DbClientImpl::DbClientImpl(const std::string &connInfo,
                  : (connNum < std::thread::hardware_concurrency()
                         ? connNum
                         : std::thread::hardware_concurrency()),
-             "DbLoop")
+             "DbLoop"),
+      _waitTimeHistogram(DbPoolMetrics::waitTimeBuckets().size() + 1)
 {
     _type = type;
     _connInfo = connInfo;
     LOG_TRACE << "type=" << (int)type;
     // LOG_DEBUG << _loops.getLoopNum();
     assert(connNum > 0);
+    _pendingConnectNum = connNum;
     _loops.start();
     if (type == ClientType::PostgreSQL)
     {
@@ -67,6 +69,7 @@ DbClientImpl::DbClientImpl(const std::string &connInfo,
                 auto loop = _loops.getNextLoop();
                 loop->runInLoop([this, loop]() {
                     std::lock_guard<std::mutex> lock(_connectionsMutex);
+                    --_pendingConnectNum;
                     _connections.insert(newConnection(loop));
                 });
             }
@@ -80,6 +83,7 @@ DbClientImpl::DbClientImpl(const std::string &connInfo,
                 auto loop = _loops.getNextLoop();
                 loop->runAfter(0.1 * (i + 1), [this, loop]() {
                     std::lock_guard<std::mutex> lock(_connectionsMutex);
+                    --_pendingConnectNum;
                     _connections.insert(newConnection(loop));
                 });
             }
@@ -96,6 +100,7 @@ DbClientImpl::DbClientImpl(const std::string &connInfo,
             {
                 _connections.insert(newConnection(nullptr));
             }
+            _pendingConnectNum = 0;
         });
     }
 }
@@ -110,6 +115,7 @@ DbClientImpl::~DbClientImpl() noexcept
     _connections.clear();
     _readyConnections.clear();
     _busyConnections.clear();
+    _idleSince.clear();
 }
 
 void DbClientImpl::execSql(
@@ -120,7 +126,8 @@ void DbClientImpl::execSql(
     std::vector<int> &&length,
     std::vector<int> &&format,
     ResultCallback &&rcb,
-    std::function<void(const std::exception_ptr &)> &&exceptCallback)
+    std::function<void(const std::exception_ptr &)> &&exceptCallback,
+    double queryTimeout)
 {
     if (!conn)
     {
@@ -134,6 +141,48 @@ void DbClientImpl::execSql(
         }
         return;
     }
+    if (queryTimeout > 0)
+    {
+        // The result is ignored if it arrives after the timeout, the
+        // connection stays busy until then.
+        auto loop = conn->loop() ? conn->loop() : _loops.getLoop(0);
+        auto done = std::make_shared<std::atomic<bool>>(false);
+        auto sharedExceptCallback =
+            std::make_shared<std::function<void(const std::exception_ptr &)>>(
+                std::move(exceptCallback));
+        std::weak_ptr<DbClientImpl> weakPtr = shared_from_this();
+        auto timerId = loop->runAfter(
+            queryTimeout, [weakPtr, done, sharedExceptCallback]() {
+                if (done->exchange(true))
+                    return;
+                auto thisPtr = weakPtr.lock();
+                if (thisPtr)
+                    ++thisPtr->_timeoutNumber;
+                try
+                {
+                    throw TimeoutError(
+                        "Timed out while waiting for the result");
+                }
+                catch (...)
+                {
+                    (*sharedExceptCallback)(std::current_exception());
+                }
+            });
+        rcb = [loop, timerId, done, callback = std::move(rcb)](
+                  const Result &r) {
+            if (done->exchange(true))
+                return;
+            loop->invalidateTimer(timerId);
+            callback(r);
+        };
+        exceptCallback = [loop, timerId, done, sharedExceptCallback](
+                             const std::exception_ptr &exception) {
+            if (done->exchange(true))
+                return;
+            loop->invalidateTimer(timerId);
+            (*sharedExceptCallback)(exception);
+        };
+    }
     conn->execSql(std::move(sql),
                   paraNum,
                   std::move(parameters),
@@ -156,8 +205,12 @@ void DbClientImpl::execSql(
     assert(paraNum == format.size());
     assert(rcb);
     DbConnectionPtr conn;
+    double queryTimeout;
+    size_t maxQueueSize;
     {
         std::lock_guard<std::mutex> guard(_connectionsMutex);
+        queryTimeout = _options._queryTimeout;
+        maxQueueSize = _options._maxQueueSize;
 
         if (_readyConnections.size() == 0)
         {
@@ -180,10 +233,12 @@ void DbClientImpl::execSql(
             _busyConnections.insert(*iter);
             conn = *iter;
             _readyConnections.erase(iter);
+            _idleSince.erase(conn);
         }
     }
     if (conn)
     {
+        _waitTimeHistogram[0].fetch_add(1, std::memory_order_relaxed);
         execSql(conn,
                 std::move(sql),
                 paraNum,
@@ -191,17 +246,34 @@ void DbClientImpl::execSql(
                 std::move(length),
                 std::move(format),
                 std::move(rcb),
-                std::move(exceptCallback));
+                std::move(exceptCallback),
+                queryTimeout);
         return;
     }
+    // LOG_TRACE << "Push query to buffer";
+    std::shared_ptr<SqlCmd> cmd =
+        std::make_shared<SqlCmd>(std::move(sql),
+                                 paraNum,
+                                 std::move(parameters),
+                                 std::move(length),
+                                 std::move(format),
+                                 std::move(rcb),
+                                 std::move(exceptCallback));
+    cmd->_enqueueTime = trantor::Date::date();
     bool busy = false;
+    size_t queueDepth = 0;
     {
         std::lock_guard<std::mutex> guard(_bufferMutex);
-        if (_sqlCmdBuffer.size() > 200000)
+        if (_sqlCmdBuffer.size() >= maxQueueSize)
         {
             // too many queries in buffer;
             busy = true;
         }
+        else
+        {
+            _sqlCmdBuffer.push_back(cmd);
+            queueDepth = _sqlCmdBuffer.size();
+        }
     }
     if (busy)
     {
@@ -211,23 +283,11 @@ void DbClientImpl::execSql(
         }
         catch (...)
         {
-            exceptCallback(std::current_exception());
+            cmd->_exceptCb(std::current_exception());
         }
         return;
     }
-    // LOG_TRACE << "Push query to buffer";
-    std::shared_ptr<SqlCmd> cmd =
-        std::make_shared<SqlCmd>(std::move(sql),
-                                 paraNum,
-                                 std::move(parameters),
-                                 std::move(length),
-                                 std::move(format),
-                                 std::move(rcb),
-                                 std::move(exceptCallback));
-    {
-        std::lock_guard<std::mutex> guard(_bufferMutex);
-        _sqlCmdBuffer.push_back(std::move(cmd));
-    }
+    growIfNeeded(queueDepth);
 }
 void DbClientImpl::newTransactionAsync(
     const std::function<void(const std::shared_ptr<Transaction> &)> &callback)
@@ -241,6 +301,7 @@ void DbClientImpl::newTransactionAsync(
             _busyConnections.insert(*iter);
             conn = *iter;
             _readyConnections.erase(iter);
+            _idleSince.erase(conn);
         }
     }
     if (conn)
@@ -297,6 +358,7 @@ void DbClientImpl::makeTrans(
                 thisPtr->handleNewTask(conn);
             });
         }));
+    trans->_parentQueryCache = _queryCache;
     trans->doBegin();
     conn->loop()->queueInLoop(
         [callback = std::move(callback), trans]() { callback(trans); });
@@ -327,21 +389,47 @@ void DbClientImpl::handleNewTask(const DbConnectionPtr &connPtr)
     }
     if (transCallback)
     {
+        {
+            std::lock_guard<std::mutex> guard(_connectionsMutex);
+            _idleSince.erase(connPtr);
+        }
         makeTrans(connPtr, std::move(transCallback));
         return;
     }
+    double queueTimeout, queryTimeout;
+    {
+        std::lock_guard<std::mutex> guard(_connectionsMutex);
+        queueTimeout = _options._queueTimeout;
+        queryTimeout = _options._queryTimeout;
+    }
     // Then check if there are some sql queries in the buffer
     std::shared_ptr<SqlCmd> cmd;
+    std::vector<std::shared_ptr<SqlCmd>> timedOutCommands;
+    trantor::Date now;
     {
         std::lock_guard<std::mutex> guard(_bufferMutex);
         if (!_sqlCmdBuffer.empty())
+            now = trantor::Date::date();
+        while (!_sqlCmdBuffer.empty())
         {
             cmd = std::move(_sqlCmdBuffer.front());
             _sqlCmdBuffer.pop_front();
+            if (queueTimeout <= 0 ||
+                now < cmd->_enqueueTime.after(queueTimeout))
+                break;
+            timedOutCommands.push_back(std::move(cmd));
         }
     }
+    failTimedOutCommands(std::move(timedOutCommands));
     if (cmd)
     {
+        {
+            std::lock_guard<std::mutex> guard(_connectionsMutex);
+            _idleSince.erase(connPtr);
+        }
+        recordWaitTime((now.microSecondsSinceEpoch() -
+                        cmd->_enqueueTime.microSecondsSinceEpoch()) /
+                       1000000.0);
         execSql(connPtr,
                 std::move(cmd->_sql),
                 cmd->_paraNum,
@@ -349,7 +437,8 @@ void DbClientImpl::handleNewTask(const DbConnectionPtr &connPtr)
                 std::move(cmd->_length),
                 std::move(cmd->_format),
                 std::move(cmd->_cb),
-                std::move(cmd->_exceptCb));
+                std::move(cmd->_exceptCb),
+                queryTimeout);
         return;
     }
     // Connection is idle, put it into the _readyConnections set;
@@ -357,6 +446,8 @@ void DbClientImpl::handleNewTask(const DbConnectionPtr &connPtr)
         std::lock_guard<std::mutex> guard(_connectionsMutex);
         _busyConnections.erase(connPtr);
         _readyConnections.insert(connPtr);
+        // A connection back from a health check keeps its idle time
+        _idleSince.emplace(connPtr, trantor::Date::date());
     }
 }
 
@@ -400,14 +491,24 @@ DbConnectionPtr DbClientImpl::newConnection(trantor::EventLoop *loop)
         auto thisPtr = weakPtr.lock();
         if (!thisPtr)
             return;
+        bool reconnect;
         {
             std::lock_guard<std::mutex> guard(thisPtr->_connectionsMutex);
             thisPtr->_readyConnections.erase(closeConnPtr);
             thisPtr->_busyConnections.erase(closeConnPtr);
+            thisPtr->_idleSince.erase(closeConnPtr);
             assert(thisPtr->_connections.find(closeConnPtr) !=
                    thisPtr->_connections.end());
             thisPtr->_connections.erase(closeConnPtr);
+            // Extra connections opened under load are not reopened
+            reconnect = thisPtr->_connections.size() +
+                            thisPtr->_pendingConnectNum <
+                        thisPtr->_connectNum;
+            if (reconnect)
+                ++thisPtr->_pendingConnectNum;
         }
+        if (!reconnect)
+            return;
         // Reconnect after 1 second
         auto loop = closeConnPtr->loop();
         loop->runAfter(1, [weakPtr, loop] {
@@ -415,6 +516,7 @@ DbConnectionPtr DbClientImpl::newConnection(trantor::EventLoop *loop)
             if (!thisPtr)
                 return;
             std::lock_guard<std::mutex> guard(thisPtr->_connectionsMutex);
+            --thisPtr->_pendingConnectNum;
             thisPtr->_connections.insert(thisPtr->newConnection(loop));
         });
     });
@@ -443,3 +545,207 @@ DbConnectionPtr DbClientImpl::newConnection(trantor::EventLoop *loop)
     // std::cout<<"newConn end"<<connPtr<<std::endl;
     return connPtr;
 }
+
+void DbClientImpl::growIfNeeded(size_t queueDepth)
+{
+    if (_type == ClientType::Sqlite3)
+        return;
+    {
+        std::lock_guard<std::mutex> guard(_connectionsMutex);
+        auto maxConnections = (std::max)(_options._maxConnections, _connectNum);
+        // Connections which are neither ready nor busy are connecting
+        auto connectingNum = _connections.size() - _readyConnections.size() -
+                             _busyConnections.size() + _pendingConnectNum;
+        if (_connections.size() + _pendingConnectNum >= maxConnections ||
+            connectingNum >= queueDepth)
+            return;
+        ++_pendingConnectNum;
+    }
+    auto loop = _loops.getNextLoop();
+    std::weak_ptr<DbClientImpl> weakPtr = shared_from_this();
+    loop->runInLoop([weakPtr, loop]() {
+        auto thisPtr = weakPtr.lock();
+        if (!thisPtr)
+            return;
+        std::lock_guard<std::mutex> guard(thisPtr->_connectionsMutex);
+        --thisPtr->_pendingConnectNum;
+        thisPtr->_connections.insert(thisPtr->newConnection(loop));
+    });
+}
+
+void DbClientImpl::failTimedOutCommands(
+    std::vector<std::shared_ptr<SqlCmd>> &&commands)
+{
+    if (commands.empty())
+        return;
+    _timeoutNumber += commands.size();
+    for (auto &cmd : commands)
+    {
+        try
+        {
+            throw TimeoutError("Timed out while waiting for a connection");
+        }
+        catch (...)
+        {
+            cmd->_exceptCb(std::current_exception());
+        }
+    }
+}
+
+void DbClientImpl::recordWaitTime(double seconds)
+{
+    auto &buckets = DbPoolMetrics::waitTimeBuckets();
+    size_t i = 0;
+    while (i < buckets.size() && seconds > buckets[i])
+        ++i;
+    _waitTimeHistogram[i].fetch_add(1, std::memory_order_relaxed);
+}
+
+void DbClientImpl::sweep()
+{
+    auto now = trantor::Date::date();
+    DbPoolOptions options;
+    std::vector<DbConnectionPtr> idleConnections;
+    std::vector<DbConnectionPtr> checkedConnections;
+    {
+        std::lock_guard<std::mutex> guard(_connectionsMutex);
+        options = _options;
+        bool healthCheck = false;
+        if (_type != ClientType::Sqlite3 && options._healthCheckInterval > 0 &&
+            _lastHealthCheck.after(options._healthCheckInterval) < now)
+        {
+            healthCheck = true;
+            _lastHealthCheck = now;
+        }
+        for (auto iter = _readyConnections.begin();
+             iter != _readyConnections.end();)
+        {
+            auto conn = *iter;
+            auto idleIter = _idleSince.emplace(conn, now).first;
+            auto idleSince = idleIter->second;
+            if (_type != ClientType::Sqlite3 &&
+                _connections.size() > _connectNum &&
+                idleSince.after(options._idleTimeout) < now)
+            {
+                _idleSince.erase(idleIter);
+                _connections.erase(conn);
+                iter = _readyConnections.erase(iter);
+                idleConnections.push_back(std::move(conn));
+                continue;
+            }
+            if (healthCheck &&
+                idleSince.after(options._healthCheckInterval) < now)
+            {
+                // Connections used recently don't need the check
+                _busyConnections.insert(conn);
+                iter = _readyConnections.erase(iter);
+                checkedConnections.push_back(std::move(conn));
+                continue;
+            }
+            ++iter;
+        }
+    }
+    if (options._queueTimeout > 0)
+    {
+        std::vector<std::shared_ptr<SqlCmd>> timedOutCommands;
+        {
+            std::lock_guard<std::mutex> guard(_bufferMutex);
+            while (!_sqlCmdBuffer.empty() &&
+                   _sqlCmdBuffer.front()->_enqueueTime.after(
+                       options._queueTimeout) < now)
+            {
+                timedOutCommands.push_back(std::move(_sqlCmdBuffer.front()));
+                _sqlCmdBuffer.pop_front();
+            }
+        }
+        failTimedOutCommands(std::move(timedOutCommands));
+    }
+    for (auto &conn : idleConnections)
+    {
+        LOG_TRACE << "Close an idle connection";
+        conn->loop()->queueInLoop([conn]() { conn->disconnect(); });
+    }
+    for (auto &conn : checkedConnections)
+    {
+        // The idle callback of the connection puts it back into the pool,
+        // a broken connection is closed and reopened.
+        conn->execSql(
+            "select 1",
+            0,
+            {},
+            {},
+            {},
+            [](const Result &) {},
+            [](const std::exception_ptr &exception) {
+                try
+                {
+                    std::rethrow_exception(exception);
+                }
+                catch (const std::exception &e)
+                {
+                    LOG_WARN << "Health check failed: " << e.what();
+                }
+            });
+    }
+}
+
+void DbClientImpl::setPoolOptions(const DbPoolOptions &options)
+{
+    {
+        std::lock_guard<std::mutex> guard(_connectionsMutex);
+        _options = options;
+    }
+    bool needSweep = options._queueTimeout > 0 ||
+                     options._healthCheckInterval > 0 ||
+                     options._maxConnections > _connectNum;
+    double interval = 1.0;
+    if (options._queueTimeout > 0)
+        interval = (std::min)(interval,
+                              (std::max)(options._queueTimeout / 4, 0.01));
+    if (options._healthCheckInterval > 0)
+        interval = (std::min)(interval, options._healthCheckInterval);
+    // The timer is only accessed in the first loop
+    auto loop = _loops.getLoop(0);
+    std::weak_ptr<DbClientImpl> weakPtr = shared_from_this();
+    loop->runInLoop([weakPtr, loop, needSweep, interval]() {
+        auto thisPtr = weakPtr.lock();
+        if (!thisPtr)
+            return;
+        if (thisPtr->_sweepTimerId != trantor::InvalidTimerId)
+        {
+            loop->invalidateTimer(thisPtr->_sweepTimerId);
+            thisPtr->_sweepTimerId = trantor::InvalidTimerId;
+        }
+        if (!needSweep)
+            return;
+        thisPtr->_sweepTimerId = loop->runEvery(interval, [weakPtr]() {
+            auto thisPtr = weakPtr.lock();
+            if (thisPtr)
+                thisPtr->sweep();
+        });
+    });
+}
+
+DbPoolMetrics DbClientImpl::poolMetrics() const
+{
+    DbPoolMetrics metrics;
+    {
+        std::lock_guard<std::mutex> guard(_connectionsMutex);
+        metrics._connectionNumber = _connections.size();
+        metrics._busyConnectionNumber = _busyConnections.size();
+    }
+    {
+        std::lock_guard<std::mutex> guard(_bufferMutex);
+        metrics._queueDepth = _sqlCmdBuffer.size();
+    }
+    {
+        std::lock_guard<std::mutex> guard(_transMutex);
+        metrics._queueDepth += _transCallbacks.size();
+    }
+    metrics._timeoutNumber = _timeoutNumber.load();
+    metrics._waitTimeHistogram.reserve(_waitTimeHistogram.size());
+    for (auto &count : _waitTimeHistogram)
+        metrics._waitTimeHistogram.push_back(
+            count.load(std::memory_order_relaxed));
+    return metrics;
+}
@@ -16,12 +16,16 @@
 
 #include "DbConnection.h"
 #include <drogon/orm/DbClient.h>
+#include <trantor/net/EventLoop.h>
 #include <trantor/net/EventLoopThreadPool.h>
+#include <trantor/utils/Date.h>
+#include <atomic>
 #include <functional>
 #include <list>
 #include <memory>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace drogon
@@ -49,6 +53,13 @@ class DbClientImpl : public DbClient,
     virtual void newTransactionAsync(
         const std::function<void(const std::shared_ptr<Transaction> &)>
             &callback) override;
+    virtual std::shared_ptr<DbClient> sessionClient(
+        const std::string &) override
+    {
+        return shared_from_this();
+    }
+    virtual void setPoolOptions(const DbPoolOptions &options) override;
+    virtual DbPoolMetrics poolMetrics() const override;
 
   private:
     size_t _connectNum;
@@ -63,25 +74,45 @@ class DbClientImpl : public DbClient,
         std::vector<int> &&length,
         std::vector<int> &&format,
         ResultCallback &&rcb,
-        std::function<void(const std::exception_ptr &)> &&exceptCallback);
+        std::function<void(const std::exception_ptr &)> &&exceptCallback,
+        double queryTimeout);
 
     DbConnectionPtr newConnection(trantor::EventLoop *loop);
+    /// Open a new connection if statements are waiting and the pool isn't
+    /// full.
+    void growIfNeeded(size_t queueDepth);
+    /// Fail the timed out statements in the queue, close the idle extra
+    /// connections and check the health of the idle connections.
+    void sweep();
+    void failTimedOutCommands(std::vector<std::shared_ptr<SqlCmd>> &&commands);
+    void recordWaitTime(double seconds);
 
     void makeTrans(
         const DbConnectionPtr &conn,
         std::function<void(const std::shared_ptr<Transaction> &)> &&callback);
 
-    std::mutex _connectionsMutex;
+    mutable std::mutex _connectionsMutex;
     std::unordered_set<DbConnectionPtr> _connections;
     std::unordered_set<DbConnectionPtr> _readyConnections;
     std::unordered_set<DbConnectionPtr> _busyConnections;
+    /// When the ready connections became idle
+    std::unordered_map<DbConnectionPtr, trantor::Date> _idleSince;
+    /// The number of connections which will be opened soon
+    size_t _pendingConnectNum = 0;
+    /// Guarded by _connectionsMutex
+    DbPoolOptions _options;
+    trantor::Date _lastHealthCheck;
+    trantor::TimerId _sweepTimerId = trantor::InvalidTimerId;
 
-    std::mutex _transMutex;
+    mutable std::mutex _transMutex;
     std::queue<std::function<void(const std::shared_ptr<Transaction> &)>>
         _transCallbacks;
 
     std::deque<std::shared_ptr<SqlCmd>> _sqlCmdBuffer;
-    std::mutex _bufferMutex;
+    mutable std::mutex _bufferMutex;
+
+    std::atomic<uint64_t> _timeoutNumber{0};
+    std::vector<std::atomic<uint64_t>> _waitTimeHistogram;
 
     void handleNewTask(const DbConnectionPtr &connPtr);
 };
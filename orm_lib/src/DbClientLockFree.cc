@@ -295,6 +295,7 @@ void DbClientLockFree::makeTrans(
                 }
             }
         }));
+    trans->_parentQueryCache = _queryCache;
     _transSet.insert(conn);
     trans->doBegin();
     conn->loop()->queueInLoop(
@@ -50,6 +50,11 @@ class DbClientLockFree : public DbClient,
     virtual void newTransactionAsync(
         const std::function<void(const std::shared_ptr<Transaction> &)>
             &callback) override;
+    virtual std::shared_ptr<DbClient> sessionClient(
+        const std::string &) override
+    {
+        return shared_from_this();
+    }
 
   private:
     std::string _connInfo;
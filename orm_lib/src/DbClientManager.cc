@@ -14,6 +14,7 @@
 
 #include "../../lib/src/DbClientManager.h"
 #include "DbClientLockFree.h"
+#include "ReplicatedDbClient.h"
 #include <drogon/config.h>
 #include <drogon/utils/Utilities.h>
 #include <algorithm>
@@ -21,6 +22,33 @@
 using namespace drogon::orm;
 using namespace drogon;
 
+static DbClientPtr newDbClient(ClientType type,
+                               const std::string &connInfo,
+                               size_t connectionNumber)
+{
+    if (type == drogon::orm::ClientType::PostgreSQL)
+    {
+#if USE_POSTGRESQL
+        return drogon::orm::DbClient::newPgClient(connInfo, connectionNumber);
+#endif
+    }
+    else if (type == drogon::orm::ClientType::Mysql)
+    {
+#if USE_MYSQL
+        return drogon::orm::DbClient::newMysqlClient(connInfo,
+                                                     connectionNumber);
+#endif
+    }
+    else if (type == drogon::orm::ClientType::Sqlite3)
+    {
+#if USE_SQLITE3
+        return drogon::orm::DbClient::newSqlite3Client(connInfo,
+                                                       connectionNumber);
+#endif
+    }
+    return nullptr;
+}
+
 void DbClientManager::createDbClients(
     const std::vector<trantor::EventLoop *> &ioloops)
 {
@@ -28,6 +56,26 @@ void DbClientManager::createDbClients(
     assert(_dbFastClientsMap.empty());
     for (auto &dbInfo : _dbInfos)
     {
+        std::shared_ptr<SessionWriteTracker> tracker;
+        if (!dbInfo._replicas.empty())
+        {
+            if (dbInfo._dbType == drogon::orm::ClientType::Sqlite3)
+            {
+                LOG_ERROR << "Sqlite3 don't support read replicas";
+                abort();
+            }
+            tracker =
+                std::make_shared<SessionWriteTracker>(dbInfo._stickyWindow);
+        }
+        // All the clients of a fast client share one cache, so a table
+        // invalidated in one IO loop is invalidated in all of them.
+        std::shared_ptr<QueryCache> queryCache;
+        if (dbInfo._queryCacheTimeout > 0)
+        {
+            queryCache =
+                std::make_shared<QueryCache>(dbInfo._queryCacheTimeout,
+                                             dbInfo._queryCacheMaxEntries);
+        }
         if (dbInfo._isFast)
         {
             for (auto *loop : ioloops)
@@ -40,41 +88,59 @@ void DbClientManager::createDbClients(
                 if (dbInfo._dbType == drogon::orm::ClientType::PostgreSQL ||
                     dbInfo._dbType == drogon::orm::ClientType::Mysql)
                 {
-                    _dbFastClientsMap[dbInfo._name][loop] =
-                        std::shared_ptr<drogon::orm::DbClient>(
-                            new drogon::orm::DbClientLockFree(
-                                dbInfo._connectionInfo,
-                                loop,
-                                dbInfo._dbType,
-                                dbInfo._connectionNumber));
+                    auto client = std::shared_ptr<drogon::orm::DbClient>(
+                        new drogon::orm::DbClientLockFree(
+                            dbInfo._connectionInfo,
+                            loop,
+                            dbInfo._dbType,
+                            dbInfo._connectionNumber));
+                    if (tracker)
+                    {
+                        std::vector<DbClientPtr> replicas;
+                        for (auto &replica : dbInfo._replicas)
+                        {
+                            replicas.push_back(
+                                std::shared_ptr<drogon::orm::DbClient>(
+                                    new drogon::orm::DbClientLockFree(
+                                        replica._connectionInfo,
+                                        loop,
+                                        dbInfo._dbType,
+                                        replica._connectionNumber)));
+                        }
+                        client = std::make_shared<ReplicatedDbClient>(
+                            client, replicas, tracker);
+                    }
+                    if (queryCache)
+                        client->setQueryCache(queryCache);
+                    _dbFastClientsMap[dbInfo._name][loop] = client;
                 }
             }
         }
         else
         {
-            if (dbInfo._dbType == drogon::orm::ClientType::PostgreSQL)
+            auto client = newDbClient(dbInfo._dbType,
+                                      dbInfo._connectionInfo,
+                                      dbInfo._connectionNumber);
+            if (client && tracker)
             {
-#if USE_POSTGRESQL
-                _dbClientsMap[dbInfo._name] =
-                    drogon::orm::DbClient::newPgClient(
-                        dbInfo._connectionInfo, dbInfo._connectionNumber);
-#endif
+                std::vector<DbClientPtr> replicas;
+                for (auto &replica : dbInfo._replicas)
+                {
+                    replicas.push_back(newDbClient(dbInfo._dbType,
+                                                   replica._connectionInfo,
+                                                   replica._connectionNumber));
+                }
+                client =
+                    std::make_shared<ReplicatedDbClient>(client,
+                                                         replicas,
+                                                         tracker);
             }
-            else if (dbInfo._dbType == drogon::orm::ClientType::Mysql)
+            if (client)
             {
-#if USE_MYSQL
-                _dbClientsMap[dbInfo._name] =
-                    drogon::orm::DbClient::newMysqlClient(
-                        dbInfo._connectionInfo, dbInfo._connectionNumber);
-#endif
-            }
-            else if (dbInfo._dbType == drogon::orm::ClientType::Sqlite3)
-            {
-#if USE_SQLITE3
-                _dbClientsMap[dbInfo._name] =
-                    drogon::orm::DbClient::newSqlite3Client(
-                        dbInfo._connectionInfo, dbInfo._connectionNumber);
-#endif
+                client->setPoolOptions(dbInfo._poolOptions);
+                if (queryCache)
+                    client->setQueryCache(queryCache);
+                _dbClientsMap[dbInfo._name] = client;
             }
         }
     }
@@ -149,4 +215,61 @@ void DbClientManager::createDbClient(const std::string &dbType,
         exit(1);
 #endif
     }
-}
\ No newline at end of file
+}
+
+DbClientManager::DbInfo &DbClientManager::findDbInfo(const std::string &name)
+{
+    for (auto &info : _dbInfos)
+    {
+        if (info._name == name)
+            return info;
+    }
+    LOG_FATAL << "The database client " << name
+              << " must be created before configuring it";
+    abort();
+}
+
+void DbClientManager::addDbClientReplica(const std::string &name,
+                                         const std::string &host,
+                                         const u_short port,
+                                         const std::string &databaseName,
+                                         const std::string &userName,
+                                         const std::string &password,
+                                         const size_t connectionNum)
+{
+    auto connStr = utils::formattedString("host=%s port=%u dbname=%s user=%s",
+                                          host.c_str(),
+                                          port,
+                                          databaseName.c_str(),
+                                          userName.c_str());
+    if (!password.empty())
+    {
+        connStr += " password=";
+        connStr += password;
+    }
+    DbInfo::ReplicaInfo replica;
+    replica._connectionInfo = connStr;
+    replica._connectionNumber = connectionNum;
+    findDbInfo(name)._replicas.push_back(std::move(replica));
+}
+
+void DbClientManager::setDbClientStickyWindow(const std::string &name,
+                                              double seconds)
+{
+    findDbInfo(name)._stickyWindow = seconds;
+}
+
+void DbClientManager::setDbClientQueryCache(const std::string &name,
+                                            double timeout,
+                                            size_t maxEntries)
+{
+    auto &info = findDbInfo(name);
+    info._queryCacheTimeout = timeout;
+    info._queryCacheMaxEntries = maxEntries;
+}
+
+void DbClientManager::setDbClientPoolOptions(const std::string &name,
+                                             const DbPoolOptions &options)
+{
+    findDbInfo(name)._poolOptions = options;
+}
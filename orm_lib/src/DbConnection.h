@@ -18,6 +18,7 @@
 #include <drogon/orm/DbClient.h>
 #include <trantor/net/EventLoop.h>
 #include <trantor/net/inner/Channel.h>
+#include <trantor/utils/Date.h>
 #include <trantor/utils/NonCopyable.h>
 #include <functional>
 #include <iostream>
@@ -54,6 +55,8 @@ struct SqlCmd
     QueryCallback _cb;
     ExceptPtrCallback _exceptCb;
     std::string _preparingStatement;
+    /// When the command was put into the queue of a connection pool
+    trantor::Date _enqueueTime;
     SqlCmd(std::string &&sql,
            const size_t paraNum,
            std::vector<const char *> &&parameters,
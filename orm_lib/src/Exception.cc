@@ -68,6 +68,10 @@ InDoubtError::InDoubtError(const std::string &whatarg) : Failure(whatarg)
 {
 }
 
+TimeoutError::TimeoutError(const std::string &whatarg) : Failure(whatarg)
+{
+}
+
 TransactionRollback::TransactionRollback(const std::string &whatarg)
     : Failure(whatarg)
 {
@@ -90,6 +90,9 @@ int Field::as<int>() const
 {
     if (isNull())
         return 0;
+    int64_t value;
+    if (_result.getInt64(_row, _column, value))
+        return static_cast<int>(value);
     return atoi(_result.getValue(_row, _column));
 }
 
@@ -98,6 +101,9 @@ long Field::as<long>() const
 {
     if (isNull())
         return 0;
+    int64_t value;
+    if (_result.getInt64(_row, _column, value))
+        return static_cast<long>(value);
     return atol(_result.getValue(_row, _column));
 }
 
@@ -106,6 +112,9 @@ long long Field::as<long long>() const
 {
     if (isNull())
         return 0;
+    int64_t value;
+    if (_result.getInt64(_row, _column, value))
+        return static_cast<long long>(value);
     return atoll(_result.getValue(_row, _column));
 }
 
@@ -114,6 +123,9 @@ float Field::as<float>() const
 {
     if (isNull())
         return 0.0;
+    double value;
+    if (_result.getDouble(_row, _column, value))
+        return static_cast<float>(value);
     return atof(_result.getValue(_row, _column));
 }
 
@@ -122,6 +134,9 @@ double Field::as<double>() const
 {
     if (isNull())
         return 0.0;
+    double value;
+    if (_result.getDouble(_row, _column, value))
+        return value;
     return std::stod(_result.getValue(_row, _column));
 }
 
@@ -0,0 +1,339 @@
+/**
+ *
+ *  QueryCache.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "ReplicatedDbClient.h"
+#include <drogon/orm/QueryCache.h>
+#include <trantor/net/EventLoop.h>
+#include <trantor/utils/Date.h>
+#include <algorithm>
+#include <assert.h>
+#include <cctype>
+#include <tuple>
+
+using namespace drogon::orm;
+
+namespace
+{
+typedef std::shared_ptr<std::atomic<uint64_t>> GenerationPtr;
+struct CacheEntry
+{
+    CacheEntry(const Result &result,
+               const trantor::Date &expiration,
+               std::vector<std::pair<GenerationPtr, uint64_t>> &&generations)
+        : _result(result),
+          _expiration(expiration),
+          _generations(std::move(generations))
+    {
+    }
+    Result _result;
+    trantor::Date _expiration;
+    std::vector<std::pair<GenerationPtr, uint64_t>> _generations;
+};
+std::atomic<uint64_t> cacheIdCounter{0};
+
+bool isValid(const std::vector<std::pair<GenerationPtr, uint64_t>> &gens)
+{
+    for (auto &gen : gens)
+    {
+        if (gen.first->load(std::memory_order_acquire) != gen.second)
+            return false;
+    }
+    return true;
+}
+
+bool isIdentifierChar(char c)
+{
+    return isalnum((unsigned char)c) || c == '_' || c == '$' || c == '.' ||
+           c == '"' || c == '`';
+}
+
+/// Strip quotes and the schema name, the result is in lower case.
+std::string normalizeTableName(const std::string &name)
+{
+    std::string tableName;
+    tableName.reserve(name.length());
+    for (auto c : name)
+    {
+        if (c == '"' || c == '`')
+            continue;
+        if (c == '.')
+        {
+            tableName.clear();
+            continue;
+        }
+        tableName.push_back(tolower((unsigned char)c));
+    }
+    return tableName;
+}
+
+/// Return true if the token after a table name is not an alias.
+bool isClauseKeyword(const std::string &token)
+{
+    static const char *keywords[] = {
+        "where", "group",  "order", "limit", "offset",    "join",
+        "inner", "left",   "right", "full",  "cross",     "natural",
+        "on",    "using",  "union", "having", "window",   "for",
+        "fetch", "lock",   "into",  "except", "intersect", "straight_join"};
+    for (auto keyword : keywords)
+    {
+        if (token == keyword)
+            return true;
+    }
+    return false;
+}
+}  // namespace
+
+struct QueryCache::LoopCache
+{
+    std::unordered_map<std::string, CacheEntry> _entries;
+    /// The generation counters of the tables read by each statement, an empty
+    /// vector means the statement is not cacheable.
+    std::unordered_map<std::string, std::vector<GenerationPtr>> _tablesOfSql;
+};
+
+QueryCache::QueryCache(double timeout, size_t maxEntries)
+    : _timeout(timeout), _maxEntries(maxEntries), _id(++cacheIdCounter)
+{
+}
+
+QueryCache::LoopCache &QueryCache::loopCache()
+{
+    // Only accessed in the thread which owns it, so no locking is needed to
+    // find the entries. The key is the id of the QueryCache object, the weak
+    // pointers find out the caches which have been destroyed.
+    thread_local std::unordered_map<
+        uint64_t,
+        std::pair<LoopCache *, std::weak_ptr<LoopCache>>>
+        loopCaches;
+    auto iter = loopCaches.find(_id);
+    if (iter != loopCaches.end())
+        return *iter->second.first;
+    for (auto it = loopCaches.begin(); it != loopCaches.end();)
+    {
+        if (it->second.second.expired())
+            it = loopCaches.erase(it);
+        else
+            ++it;
+    }
+    auto cache = std::shared_ptr<LoopCache>(new LoopCache);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _loopCaches.push_back(cache);
+    }
+    loopCaches.emplace(_id, std::make_pair(cache.get(), cache));
+    return *cache;
+}
+
+std::vector<std::string> QueryCache::tablesOfSql(const std::string &sql)
+{
+    std::vector<std::string> tables;
+    enum
+    {
+        None,
+        Table,
+        AfterTable,
+        AfterAs,
+        AfterAlias
+    } state = None;
+    size_t pos = 0;
+    while (pos < sql.length())
+    {
+        auto c = sql[pos];
+        if (isspace((unsigned char)c))
+        {
+            ++pos;
+            continue;
+        }
+        std::string token;
+        if (c == '\'')
+        {
+            // Skip string literals, a quote in them is escaped by doubling it
+            auto end = pos + 1;
+            while (end < sql.length())
+            {
+                if (sql[end] == '\'')
+                {
+                    if (end + 1 < sql.length() && sql[end + 1] == '\'')
+                    {
+                        end += 2;
+                        continue;
+                    }
+                    break;
+                }
+                ++end;
+            }
+            pos = end + 1;
+            state = None;
+            continue;
+        }
+        if (isIdentifierChar(c))
+        {
+            auto end = pos;
+            while (end < sql.length() && isIdentifierChar(sql[end]))
+                ++end;
+            token = sql.substr(pos, end - pos);
+            std::transform(token.begin(), token.end(), token.begin(), tolower);
+            pos = end;
+        }
+        else
+        {
+            token = std::string(1, c);
+            ++pos;
+        }
+        bool isIdentifier = isIdentifierChar(token[0]);
+        switch (state)
+        {
+            case Table:
+                if (isIdentifier)
+                {
+                    tables.push_back(normalizeTableName(token));
+                    state = AfterTable;
+                    continue;
+                }
+                // A sub-query
+                state = None;
+                break;
+            case AfterTable:
+            case AfterAs:
+            case AfterAlias:
+                if (token == ",")
+                {
+                    state = Table;
+                    continue;
+                }
+                if (state == AfterTable && token == "as")
+                {
+                    state = AfterAs;
+                    continue;
+                }
+                if (state != AfterAlias && isIdentifier &&
+                    !isClauseKeyword(token))
+                {
+                    state = AfterAlias;
+                    continue;
+                }
+                state = None;
+                break;
+            default:
+                break;
+        }
+        if (token == "from" || token == "join")
+            state = Table;
+    }
+    std::sort(tables.begin(), tables.end());
+    tables.erase(std::unique(tables.begin(), tables.end()), tables.end());
+    return tables;
+}
+
+QueryCache::GenerationPtr QueryCache::generationOf(
+    const std::string &tableName)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto &gen = _generations[tableName];
+    if (!gen)
+        gen = std::make_shared<std::atomic<uint64_t>>(0);
+    return gen;
+}
+
+void QueryCache::invalidate(const std::string &tableName)
+{
+    auto gen = generationOf(normalizeTableName(tableName));
+    gen->fetch_add(1, std::memory_order_acq_rel);
+}
+
+bool QueryCache::prepare(const std::string &sql, Query &query)
+{
+    auto loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    if (!loop)
+        return false;
+    auto &cache = loopCache();
+    auto iter = cache._tablesOfSql.find(sql);
+    if (iter == cache._tablesOfSql.end())
+    {
+        std::vector<GenerationPtr> gens;
+        if (ReplicatedDbClient::isReadOnlySql(sql))
+        {
+            for (auto &table : tablesOfSql(sql))
+                gens.push_back(generationOf(table));
+        }
+        if (cache._tablesOfSql.size() >= _maxEntries)
+            cache._tablesOfSql.clear();
+        iter = cache._tablesOfSql.emplace(sql, std::move(gens)).first;
+    }
+    if (iter->second.empty())
+        return false;
+    query._loop = loop;
+    // The generations are taken before executing the statement, so a result
+    // which is read before a concurrent write is invalidated by the write.
+    query._generations.reserve(iter->second.size());
+    for (auto &gen : iter->second)
+    {
+        query._generations.emplace_back(
+            gen, gen->load(std::memory_order_acquire));
+    }
+    query._key = sql;
+    query._key.push_back('\0');
+    return true;
+}
+
+bool QueryCache::find(const Query &query, Result &result)
+{
+    auto &entries = loopCache()._entries;
+    auto iter = entries.find(query._key);
+    if (iter == entries.end())
+        return false;
+    auto &entry = iter->second;
+    if (entry._expiration < trantor::Date::date() ||
+        !isValid(entry._generations))
+    {
+        entries.erase(iter);
+        return false;
+    }
+    result = entry._result;
+    return true;
+}
+
+void QueryCache::store(Query &&query, const Result &result)
+{
+    auto loop = query._loop;
+    assert(loop);
+    loop->queueInLoop([thisPtr = shared_from_this(),
+                       query = std::move(query),
+                       result]() mutable {
+        if (!isValid(query._generations))
+            return;
+        auto &entries = thisPtr->loopCache()._entries;
+        auto now = trantor::Date::date();
+        if (entries.size() >= thisPtr->_maxEntries)
+        {
+            for (auto iter = entries.begin(); iter != entries.end();)
+            {
+                if (iter->second._expiration < now ||
+                    !isValid(iter->second._generations))
+                    iter = entries.erase(iter);
+                else
+                    ++iter;
+            }
+            if (entries.size() >= thisPtr->_maxEntries)
+                return;
+        }
+        entries.erase(query._key);
+        entries.emplace(
+            std::piecewise_construct,
+            std::forward_as_tuple(std::move(query._key)),
+            std::forward_as_tuple(result,
+                                  now.after(thisPtr->_timeout),
+                                  std::move(query._generations)));
+    });
+}
@@ -0,0 +1,353 @@
+/**
+ *
+ *  ReplicatedDbClient.cc
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#include "ReplicatedDbClient.h"
+#include <algorithm>
+#include <assert.h>
+#include <cctype>
+
+using namespace drogon::orm;
+
+namespace drogon
+{
+namespace orm
+{
+/// The client returned by ReplicatedDbClient::sessionClient()
+class SessionDbClient : public DbClient,
+                        public std::enable_shared_from_this<SessionDbClient>
+{
+  public:
+    SessionDbClient(const std::shared_ptr<ReplicatedDbClient> &parent,
+                    const std::string &sessionKey)
+        : _parent(parent), _sessionKey(sessionKey)
+    {
+        _type = parent->type();
+        _connInfo = parent->connectionInfo();
+        _queryCache = parent->queryCache();
+    }
+    virtual std::shared_ptr<Transaction> newTransaction(
+        const std::function<void(bool)> &commitCallback = nullptr) override
+    {
+        _parent->_tracker->onWrite(_sessionKey);
+        return _parent->newTransaction(commitCallback);
+    }
+    virtual void newTransactionAsync(
+        const std::function<void(const std::shared_ptr<Transaction> &)>
+            &callback) override
+    {
+        _parent->_tracker->onWrite(_sessionKey);
+        _parent->newTransactionAsync(callback);
+    }
+    virtual std::shared_ptr<Transaction> newReadOnlyTransaction(
+        const std::function<void(bool)> &commitCallback = nullptr) override
+    {
+        if (_parent->_tracker->isSticky(_sessionKey))
+            return _parent->newTransaction(commitCallback);
+        return _parent->newReadOnlyTransaction(commitCallback);
+    }
+    virtual void newReadOnlyTransactionAsync(
+        const std::function<void(const std::shared_ptr<Transaction> &)>
+            &callback) override
+    {
+        if (_parent->_tracker->isSticky(_sessionKey))
+            _parent->newTransactionAsync(callback);
+        else
+            _parent->newReadOnlyTransactionAsync(callback);
+    }
+    virtual std::shared_ptr<DbClient> sessionClient(
+        const std::string &sessionKey) override
+    {
+        if (sessionKey == _sessionKey)
+            return shared_from_this();
+        return _parent->sessionClient(sessionKey);
+    }
+
+  private:
+    virtual void execSql(std::string &&sql,
+                         size_t paraNum,
+                         std::vector<const char *> &&parameters,
+                         std::vector<int> &&length,
+                         std::vector<int> &&format,
+                         ResultCallback &&rcb,
+                         std::function<void(const std::exception_ptr &)>
+                             &&exceptCallback) override
+    {
+        _parent->execSql(&_sessionKey,
+                         std::move(sql),
+                         paraNum,
+                         std::move(parameters),
+                         std::move(length),
+                         std::move(format),
+                         std::move(rcb),
+                         std::move(exceptCallback));
+    }
+    std::shared_ptr<ReplicatedDbClient> _parent;
+    const std::string _sessionKey;
+};
+}  // namespace orm
+}  // namespace drogon
+
+void SessionWriteTracker::onWrite(const std::string &sessionKey)
+{
+    if (!enabled())
+        return;
+    auto now = trantor::Date::date();
+    std::lock_guard<std::mutex> lock(_mutex);
+    _expirations[sessionKey] = now.after(_stickyWindow);
+    if (_expirations.size() > _sweepThreshold)
+    {
+        // Drop expired sessions so that the map doesn't grow without bound
+        for (auto iter = _expirations.begin(); iter != _expirations.end();)
+        {
+            if (iter->second < now)
+                iter = _expirations.erase(iter);
+            else
+                ++iter;
+        }
+        _sweepThreshold = (std::max)((size_t)1024, _expirations.size() * 2);
+    }
+}
+
+bool SessionWriteTracker::isSticky(const std::string &sessionKey)
+{
+    if (!enabled())
+        return false;
+    auto now = trantor::Date::date();
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto iter = _expirations.find(sessionKey);
+    if (iter == _expirations.end())
+        return false;
+    if (iter->second < now)
+    {
+        _expirations.erase(iter);
+        return false;
+    }
+    return true;
+}
+
+ReplicatedDbClient::ReplicatedDbClient(
+    const DbClientPtr &primary,
+    const std::vector<DbClientPtr> &replicas,
+    const std::shared_ptr<SessionWriteTracker> &tracker)
+    : _primary(primary), _tracker(tracker)
+{
+    assert(_primary);
+    assert(_tracker);
+    _type = primary->type();
+    _connInfo = primary->connectionInfo();
+    for (auto &client : replicas)
+    {
+        Replica replica;
+        replica._client = client;
+        replica._outstanding = std::make_shared<std::atomic<size_t>>(0);
+        _replicas.push_back(std::move(replica));
+    }
+}
+
+/// Return the position of the first token after the leading white spaces,
+/// comments and parentheses.
+static size_t skipLeadingComments(const std::string &sql)
+{
+    size_t pos = 0;
+    while (pos < sql.length())
+    {
+        if (isspace((unsigned char)sql[pos]) || sql[pos] == '(')
+        {
+            ++pos;
+        }
+        else if (sql.compare(pos, 2, "--") == 0)
+        {
+            pos = sql.find('\n', pos);
+        }
+        else if (sql.compare(pos, 2, "/*") == 0)
+        {
+            pos = sql.find("*/", pos + 2);
+            if (pos != std::string::npos)
+                pos += 2;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return pos;
+}
+
+bool ReplicatedDbClient::isReadOnlySql(const std::string &sql)
+{
+    auto pos = skipLeadingComments(sql);
+    if (pos == std::string::npos || sql.length() < pos + 6)
+        return false;
+    std::string lowerSql = sql.substr(pos);
+    std::transform(lowerSql.begin(),
+                   lowerSql.end(),
+                   lowerSql.begin(),
+                   tolower);
+    if (lowerSql.compare(0, 6, "select") != 0)
+        return false;
+    if (lowerSql.length() > 6 && !isspace((unsigned char)lowerSql[6]) &&
+        lowerSql[6] != '*')
+        return false;
+    static const char *writeMarkers[] = {"for update",
+                                         "for no key update",
+                                         "for share",
+                                         "for key share",
+                                         "lock in share mode",
+                                         " into ",
+                                         "nextval(",
+                                         "setval("};
+    for (auto marker : writeMarkers)
+    {
+        if (lowerSql.find(marker) != std::string::npos)
+            return false;
+    }
+    // Another statement may follow the SELECT one, only trailing semicolons
+    // are allowed.
+    auto semicolon = lowerSql.find(';');
+    if (semicolon != std::string::npos &&
+        lowerSql.find_first_not_of("; \t\r\n", semicolon) !=
+            std::string::npos)
+        return false;
+    return true;
+}
+
+const ReplicatedDbClient::Replica &ReplicatedDbClient::leastBusyReplica() const
+{
+    assert(!_replicas.empty());
+    auto *best = &_replicas[0];
+    for (size_t i = 1; i < _replicas.size(); i++)
+    {
+        if (*_replicas[i]._outstanding < *best->_outstanding)
+            best = &_replicas[i];
+    }
+    return *best;
+}
+
+void ReplicatedDbClient::execSql(
+    std::string &&sql,
+    size_t paraNum,
+    std::vector<const char *> &&parameters,
+    std::vector<int> &&length,
+    std::vector<int> &&format,
+    ResultCallback &&rcb,
+    std::function<void(const std::exception_ptr &)> &&exceptCallback)
+{
+    execSql(nullptr,
+            std::move(sql),
+            paraNum,
+            std::move(parameters),
+            std::move(length),
+            std::move(format),
+            std::move(rcb),
+            std::move(exceptCallback));
+}
+
+void ReplicatedDbClient::execSql(
+    const std::string *sessionKey,
+    std::string &&sql,
+    size_t paraNum,
+    std::vector<const char *> &&parameters,
+    std::vector<int> &&length,
+    std::vector<int> &&format,
+    ResultCallback &&rcb,
+    std::function<void(const std::exception_ptr &)> &&exceptCallback)
+{
+    bool toReplica = !_replicas.empty() && isReadOnlySql(sql);
+    if (sessionKey)
+    {
+        if (!toReplica)
+            _tracker->onWrite(*sessionKey);
+        else if (_tracker->isSticky(*sessionKey))
+            toReplica = false;
+    }
+    if (!toReplica)
+    {
+        _primary->execSql(std::move(sql),
+                          paraNum,
+                          std::move(parameters),
+                          std::move(length),
+                          std::move(format),
+                          std::move(rcb),
+                          std::move(exceptCallback));
+        return;
+    }
+    auto &replica = leastBusyReplica();
+    auto outstanding = replica._outstanding;
+    ++*outstanding;
+    replica._client->execSql(
+        std::move(sql),
+        paraNum,
+        std::move(parameters),
+        std::move(length),
+        std::move(format),
+        [outstanding, rcb = std::move(rcb)](const Result &r) {
+            --*outstanding;
+            rcb(r);
+        },
+        [outstanding, exceptCallback = std::move(exceptCallback)](
+            const std::exception_ptr &e) {
+            --*outstanding;
+            exceptCallback(e);
+        });
+}
+
+std::shared_ptr<Transaction> ReplicatedDbClient::newTransaction(
+    const std::function<void(bool)> &commitCallback)
+{
+    return _primary->newTransaction(commitCallback);
+}
+
+void ReplicatedDbClient::newTransactionAsync(
+    const std::function<void(const std::shared_ptr<Transaction> &)> &callback)
+{
+    _primary->newTransactionAsync(callback);
+}
+
+std::shared_ptr<Transaction> ReplicatedDbClient::newReadOnlyTransaction(
+    const std::function<void(bool)> &commitCallback)
+{
+    if (_replicas.empty())
+        return _primary->newTransaction(commitCallback);
+    return leastBusyReplica()._client->newTransaction(commitCallback);
+}
+
+void ReplicatedDbClient::newReadOnlyTransactionAsync(
+    const std::function<void(const std::shared_ptr<Transaction> &)> &callback)
+{
+    if (_replicas.empty())
+        _primary->newTransactionAsync(callback);
+    else
+        leastBusyReplica()._client->newTransactionAsync(callback);
+}
+
+std::shared_ptr<DbClient> ReplicatedDbClient::sessionClient(
+    const std::string &sessionKey)
+{
+    return std::make_shared<SessionDbClient>(shared_from_this(), sessionKey);
+}
+
+void ReplicatedDbClient::setQueryCache(const std::shared_ptr<QueryCache> &cache)
+{
+    _queryCache = cache;
+    _primary->setQueryCache(cache);
+    for (auto &replica : _replicas)
+        replica._client->setQueryCache(cache);
+}
+
+void ReplicatedDbClient::setPoolOptions(const DbPoolOptions &options)
+{
+    _primary->setPoolOptions(options);
+    for (auto &replica : _replicas)
+        replica._client->setPoolOptions(options);
+}
@@ -0,0 +1,137 @@
+/**
+ *
+ *  ReplicatedDbClient.h
+ *  An Tao
+ *
+ *  Copyright 2018, An Tao.  All rights reserved.
+ *  https://github.com/an-tao/drogon
+ *  Use of this source code is governed by a MIT license
+ *  that can be found in the License file.
+ *
+ *  Drogon
+ *
+ */
+
+#pragma once
+
+#include <drogon/orm/DbClient.h>
+#include <trantor/utils/Date.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace drogon
+{
+namespace orm
+{
+/// Remember when each session wrote to the primary server last time.
+/**
+ * One tracker is shared by all the clients created for the same
+ * configuration (e.g. one client per IO loop in fast mode).
+ */
+class SessionWriteTracker : public trantor::NonCopyable
+{
+  public:
+    explicit SessionWriteTracker(double stickyWindow)
+        : _stickyWindow(stickyWindow)
+    {
+    }
+    void onWrite(const std::string &sessionKey);
+    /// Return true if the session wrote something in the sticky window.
+    bool isSticky(const std::string &sessionKey);
+    bool enabled() const
+    {
+        return _stickyWindow > 0;
+    }
+
+  private:
+    const double _stickyWindow;
+    std::mutex _mutex;
+    std::unordered_map<std::string, trantor::Date> _expirations;
+    size_t _sweepThreshold = 1024;
+};
+
+/// A database client which consists of one primary server and some read
+/// replicas.
+/**
+ * Read-only statements (see isReadOnlySql()) and read-only transactions are
+ * sent to the replica with the least outstanding queries, everything else
+ * (including normal transactions) is sent to the primary server.
+ */
+class ReplicatedDbClient
+    : public DbClient,
+      public std::enable_shared_from_this<ReplicatedDbClient>
+{
+  public:
+    ReplicatedDbClient(const DbClientPtr &primary,
+                       const std::vector<DbClientPtr> &replicas,
+                       const std::shared_ptr<SessionWriteTracker> &tracker);
+    virtual std::shared_ptr<Transaction> newTransaction(
+        const std::function<void(bool)> &commitCallback = nullptr) override;
+    virtual void newTransactionAsync(
+        const std::function<void(const std::shared_ptr<Transaction> &)>
+            &callback) override;
+    virtual std::shared_ptr<Transaction> newReadOnlyTransaction(
+        const std::function<void(bool)> &commitCallback = nullptr) override;
+    virtual void newReadOnlyTransactionAsync(
+        const std::function<void(const std::shared_ptr<Transaction> &)>
+            &callback) override;
+    virtual std::shared_ptr<DbClient> sessionClient(
+        const std::string &sessionKey) override;
+    /// The cache is also set to the primary server and the replicas so that
+    /// their transactions invalidate it.
+    virtual void setQueryCache(
+        const std::shared_ptr<QueryCache> &cache) override;
+    /// The options are set to the primary server and the replicas.
+    virtual void setPoolOptions(const DbPoolOptions &options) override;
+    /// Return the metrics of the primary server.
+    virtual DbPoolMetrics poolMetrics() const override
+    {
+        return _primary->poolMetrics();
+    }
+
+    /// Return true if the statement can be executed on a read replica.
+    /**
+     * Only plain SELECT statements qualify, locking reads (FOR UPDATE/SHARE),
+     * SELECT INTO, sequence manipulation, CTEs (they may modify data) and
+     * strings of several statements are treated as writes. Leading comments
+     * are skipped.
+     */
+    static bool isReadOnlySql(const std::string &sql);
+
+  private:
+    friend class SessionDbClient;
+    virtual void execSql(std::string &&sql,
+                         size_t paraNum,
+                         std::vector<const char *> &&parameters,
+                         std::vector<int> &&length,
+                         std::vector<int> &&format,
+                         ResultCallback &&rcb,
+                         std::function<void(const std::exception_ptr &)>
+                             &&exceptCallback) override;
+    void execSql(const std::string *sessionKey,
+                 std::string &&sql,
+                 size_t paraNum,
+                 std::vector<const char *> &&parameters,
+                 std::vector<int> &&length,
+                 std::vector<int> &&format,
+                 ResultCallback &&rcb,
+                 std::function<void(const std::exception_ptr &)>
+                     &&exceptCallback);
+    struct Replica
+    {
+        DbClientPtr _client;
+        std::shared_ptr<std::atomic<size_t>> _outstanding;
+    };
+    const Replica &leastBusyReplica() const;
+
+    DbClientPtr _primary;
+    std::vector<Replica> _replicas;
+    std::shared_ptr<SessionWriteTracker> _tracker;
+};
+
+}  // namespace orm
+}  // namespace drogon
@@ -145,6 +145,18 @@ Result::field_size_type Result::getLength(Result::size_type row,
 {
     return _resultPtr->getLength(row, column);
 }
+bool Result::getInt64(Result::size_type row,
+                      Result::row_size_type column,
+                      int64_t &value) const
+{
+    return _resultPtr->getInt64(row, column, value);
+}
+bool Result::getDouble(Result::size_type row,
+                       Result::row_size_type column,
+                       double &value) const
+{
+    return _resultPtr->getDouble(row, column, value);
+}
 unsigned long long Result::insertId() const noexcept
 {
     return _resultPtr->insertId();
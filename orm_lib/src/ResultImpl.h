@@ -16,6 +16,7 @@
 
 #include <drogon/orm/Result.h>
 #include <trantor/utils/NonCopyable.h>
+#include <stdint.h>
 namespace drogon
 {
 namespace orm
@@ -43,10 +44,26 @@ class ResultImpl : public trantor::NonCopyable, public Result
     {
         return 0;
     }
-    virtual int oid(row_size_type column) const
+    virtual int oid(row_size_type) const
     {
         return 0;
     }
+    /// Get the value of an integer field without parsing its text form.
+    /**
+     * Backends that keep numeric values in native form override this and
+     * return true, otherwise the caller falls back to the text returned by
+     * getValue().
+     */
+    virtual bool getInt64(size_type, row_size_type, int64_t &) const
+    {
+        return false;
+    }
+    /// Get the value of a numeric field as a double without parsing its text
+    /// form, see getInt64().
+    virtual bool getDouble(size_type, row_size_type, double &) const
+    {
+        return false;
+    }
     virtual ~ResultImpl()
     {
     }
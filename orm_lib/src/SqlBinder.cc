@@ -15,6 +15,7 @@
 #include <drogon/config.h>
 #include <drogon/orm/DbClient.h>
 #include <drogon/orm/SqlBinder.h>
+#include <trantor/net/EventLoop.h>
 #include <future>
 #include <iostream>
 #include <stdio.h>
@@ -23,9 +24,101 @@
 #endif
 using namespace drogon::orm;
 using namespace drogon::orm::internal;
+
+/// The number of bytes a parameter occupies, numeric parameters of MySQL and
+/// Sqlite3 are bound without the length.
+static size_t parameterSize(ClientType type, int format, int length)
+{
+    if (type == ClientType::Sqlite3)
+    {
+        switch (format)
+        {
+            case Sqlite3TypeChar:
+                return 1;
+            case Sqlite3TypeShort:
+                return 2;
+            case Sqlite3TypeInt:
+                return 4;
+            case Sqlite3TypeInt64:
+                return 8;
+            case Sqlite3TypeDouble:
+                return sizeof(double);
+            default:
+                break;
+        }
+    }
+#if USE_MYSQL
+    else if (type == ClientType::Mysql)
+    {
+        switch (format)
+        {
+            case MYSQL_TYPE_TINY:
+                return 1;
+            case MYSQL_TYPE_SHORT:
+                return 2;
+            case MYSQL_TYPE_LONG:
+                return 4;
+            case MYSQL_TYPE_LONGLONG:
+                return 8;
+            default:
+                break;
+        }
+    }
+#endif
+    return length;
+}
+
+void SqlBinder::appendParametersToKey(std::string &key) const
+{
+    for (size_t i = 0; i < _parameters.size(); ++i)
+    {
+        int format = i < _format.size() ? _format[i] : 0;
+        key.append((const char *)&format, sizeof(format));
+        if (!_parameters[i])
+        {
+            key.push_back('\0');
+            continue;
+        }
+        auto size = parameterSize(_type, format, _length[i]);
+        key.push_back('\1');
+        key.append((const char *)&size, sizeof(size));
+        key.append(_parameters[i], size);
+    }
+}
+
 void SqlBinder::exec()
 {
     _execed = true;
+    auto cache = _client._queryCache;
+    QueryCache::Query query;
+    if (cache && cache->prepare(_sql, query))
+    {
+        appendParametersToKey(query._key);
+        Result r(nullptr);
+        if (cache->find(query, r))
+        {
+            if (!_callbackHolder)
+                return;
+            if (_mode == Mode::NonBlocking)
+            {
+                // Deliver the result after the caller returns, as if it was
+                // read from the database.
+                query._loop->queueInLoop(
+                    [holder = std::move(_callbackHolder), r]() {
+                        holder->execCallback(r);
+                    });
+            }
+            else
+            {
+                _callbackHolder->execCallback(r);
+            }
+            return;
+        }
+    }
+    else
+    {
+        cache.reset();
+    }
     if (_mode == Mode::NonBlocking)
     {
         // nonblocking mode,default mode
@@ -37,8 +130,14 @@ void SqlBinder::exec()
             std::move(_length),
             std::move(_format),
             [holder = std::move(_callbackHolder),
-             objs = std::move(_objs)](const Result &r) mutable {
+             objs = std::move(_objs),
+             cache = std::move(cache),
+             query = std::move(query)](const Result &r) mutable {
                 objs.clear();
+                if (cache)
+                {
+                    cache->store(std::move(query), r);
+                }
                 if (holder)
                 {
                     holder->execCallback(r);
@@ -81,7 +180,14 @@ void SqlBinder::exec()
             std::move(_parameters),
             std::move(_length),
             std::move(_format),
-            [pro](const Result &r) { pro->set_value(r); },
+            [pro, cache = std::move(cache), query = std::move(query)](
+                const Result &r) mutable {
+                if (cache)
+                {
+                    cache->store(std::move(query), r);
+                }
+                pro->set_value(r);
+            },
             [pro](const std::exception_ptr &exception) {
                 try
                 {
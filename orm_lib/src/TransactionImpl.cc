@@ -38,7 +38,9 @@ TransactionImpl::~TransactionImpl()
         auto loop = _connectionPtr->loop();
         loop->queueInLoop([conn = _connectionPtr,
                            ucb = std::move(_usedUpCallback),
-                           commitCb = std::move(_commitCallback)]() {
+                           commitCb = std::move(_commitCallback),
+                           cache = std::move(_parentQueryCache),
+                           tables = std::move(_invalidatedTables)]() {
             conn->setIdleCallback([ucb = std::move(ucb)]() {
                 if (ucb)
                     ucb();
@@ -49,8 +51,12 @@ TransactionImpl::~TransactionImpl()
                 std::vector<const char *>(),
                 std::vector<int>(),
                 std::vector<int>(),
-                [commitCb](const Result &r) {
+                [commitCb, cache, tables](const Result &r) {
                     LOG_TRACE << "Transaction commited!";
+                    for (auto &table : tables)
+                    {
+                        cache->invalidate(table);
+                    }
                     if (commitCb)
                     {
                         commitCb(true);
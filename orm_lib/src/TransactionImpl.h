@@ -38,6 +38,16 @@ class TransactionImpl : public Transaction,
     {
         _commitCallback = commitCallback;
     }
+    virtual void invalidateQueryCache(const std::string &tableName) override
+    {
+        // Invalidate the table again after committing, results read by other
+        // clients before that are stale.
+        if (_parentQueryCache)
+        {
+            _parentQueryCache->invalidate(tableName);
+            _invalidatedTables.push_back(tableName);
+        }
+    }
 
   private:
     DbConnectionPtr _connectionPtr;
@@ -102,6 +112,10 @@ class TransactionImpl : public Transaction,
     {
         callback(shared_from_this());
     }
+    virtual std::shared_ptr<DbClient> sessionClient(const std::string &) override
+    {
+        return shared_from_this();
+    }
     std::function<void()> _usedUpCallback;
     bool _isCommitedOrRolledback = false;
     bool _isWorking = false;
@@ -126,6 +140,10 @@ class TransactionImpl : public Transaction,
     trantor::EventLoop *_loop;
     std::function<void(bool)> _commitCallback;
     std::shared_ptr<TransactionImpl> _thisPtr;
+    // Results are never read from the cache of the client which creates the
+    // transaction, it is only invalidated.
+    std::shared_ptr<QueryCache> _parentQueryCache;
+    std::vector<std::string> _invalidatedTables;
 };
 }  // namespace orm
 }  // namespace drogon
@@ -198,6 +198,11 @@ void PgConnection::execSqlInLoop(
     std::function<void(const std::exception_ptr &)> &&exceptCallback)
 {
     LOG_TRACE << sql;
+    if (isCopyFromStdin(sql))
+    {
+        rejectCopy(exceptCallback);
+        return;
+    }
     _isWorking = true;
     _batchSqlCommands.emplace_back(
         std::make_shared<SqlCmd>(std::move(sql),
@@ -460,6 +465,33 @@ void PgConnection::handleFatalError()
 void PgConnection::batchSql(std::deque<std::shared_ptr<SqlCmd>> &&sqlCommands)
 {
     _loop->assertInLoopThread();
+    for (auto iter = sqlCommands.begin(); iter != sqlCommands.end();)
+    {
+        if (isCopyFromStdin((*iter)->_sql))
+        {
+            rejectCopy((*iter)->_exceptCb);
+            iter = sqlCommands.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
     _batchSqlCommands = std::move(sqlCommands);
     sendBatchedSql();
 }
+
+void PgConnection::rejectCopy(
+    const std::function<void(const std::exception_ptr &)> &exceptCallback)
+{
+    // libpq doesn't allow COPY in batch mode, DbClient::bulkLoadAsync() uses
+    // INSERT statements instead.
+    try
+    {
+        throw Failure("COPY FROM STDIN is not supported in batch mode");
+    }
+    catch (...)
+    {
+        exceptCallback(std::current_exception());
+    }
+}
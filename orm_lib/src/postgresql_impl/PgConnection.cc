@@ -16,6 +16,7 @@
 #include "PostgreSQLResultImpl.h"
 #include <drogon/orm/Exception.h>
 #include <drogon/utils/Utilities.h>
+#include <algorithm>
 #include <memory>
 #include <stdio.h>
 #include <trantor/utils/Logger.h>
@@ -36,6 +37,7 @@ Result makeResult(
 
 }  // namespace orm
 }  // namespace drogon
+
 int PgConnection::flush()
 {
     auto ret = PQflush(_connPtr.get());
@@ -83,6 +85,11 @@ PgConnection::PgConnection(trantor::EventLoop *loop,
     _channel.setWriteCallback([=]() {
         if (_status == ConnectStatus_Ok)
         {
+            if (_isCopying && !_copyEnded)
+            {
+                sendCopyData();
+                return;
+            }
             auto ret = PQflush(_connPtr.get());
             if (ret == 0)
             {
@@ -202,6 +209,18 @@ void PgConnection::execSqlInLoop(
     _cb = std::move(rcb);
     _isWorking = true;
     _exceptCb = std::move(exceptCallback);
+    _copyData = nullptr;
+    _isCopying = false;
+    _copyEnded = false;
+    if (paraNum == 1 && isCopyFromStdin(_sql))
+    {
+        // The only parameter of 'COPY ... FROM STDIN' is the data to copy,
+        // the callback keeps it alive until the statement is done.
+        _copyData = parameters[0];
+        _copyLength = length[0];
+        _copyOffset = 0;
+        paraNum = 0;
+    }
     if (paraNum == 0)
     {
         _isRreparingStatement = false;
@@ -304,6 +323,13 @@ void PgConnection::handleRead()
                                             [](PGresult *p) { PQclear(p); })))
     {
         auto type = PQresultStatus(res.get());
+        if (type == PGRES_COPY_IN)
+        {
+            // The result of the statement is read after sending the data.
+            _isCopying = true;
+            sendCopyData();
+            return;
+        }
         if (type == PGRES_BAD_RESPONSE || type == PGRES_FATAL_ERROR)
         {
             LOG_WARN << PQerrorMessage(_connPtr.get());
@@ -367,6 +393,58 @@ void PgConnection::doAfterPreparing()
     flush();
 }
 
+void PgConnection::sendCopyData()
+{
+    if (_copyEnded)
+        return;
+    if (!_copyData)
+    {
+        // Make the server fail the statement
+        if (PQputCopyEnd(_connPtr.get(), "No data for COPY FROM STDIN") == 0)
+        {
+            _channel.enableWriting();
+            return;
+        }
+        _copyEnded = true;
+        flush();
+        return;
+    }
+    while (_copyOffset < _copyLength)
+    {
+        auto size = (std::min)(_copyLength - _copyOffset, (size_t)65536);
+        auto ret =
+            PQputCopyData(_connPtr.get(), _copyData + _copyOffset, (int)size);
+        if (ret == 0)
+        {
+            // The buffer is full, continue when the socket is writable
+            if (!_channel.isWriting())
+                _channel.enableWriting();
+            return;
+        }
+        if (ret < 0)
+        {
+            LOG_ERROR << "PQputCopyData error:"
+                      << PQerrorMessage(_connPtr.get());
+            _copyEnded = true;
+            return;
+        }
+        _copyOffset += size;
+    }
+    auto ret = PQputCopyEnd(_connPtr.get(), nullptr);
+    if (ret == 0)
+    {
+        if (!_channel.isWriting())
+            _channel.enableWriting();
+        return;
+    }
+    if (ret < 0)
+    {
+        LOG_ERROR << "PQputCopyEnd error:" << PQerrorMessage(_connPtr.get());
+    }
+    _copyEnded = true;
+    flush();
+}
+
 void PgConnection::handleFatalError()
 {
     try
@@ -20,6 +20,8 @@
 #include <trantor/net/inner/Channel.h>
 #include <trantor/utils/NonCopyable.h>
 #include <libpq-fe.h>
+#include <strings.h>
+#include <algorithm>
 #include <unordered_map>
 #include <memory>
 #include <string>
@@ -87,6 +89,21 @@ class PgConnection : public DbConnection,
     virtual void disconnect() override;
 
   private:
+    /// Return true if the statement is 'COPY ... FROM STDIN'
+    static bool isCopyFromStdin(const std::string &sql)
+    {
+        auto pos = sql.find_first_not_of(" \t\r\n");
+        if (pos == std::string::npos ||
+            strncasecmp(sql.c_str() + pos, "copy", 4))
+            return false;
+        std::string lowerSql = sql;
+        std::transform(lowerSql.begin(),
+                       lowerSql.end(),
+                       lowerSql.begin(),
+                       tolower);
+        return lowerSql.find("from stdin") != std::string::npos;
+    }
+
     std::shared_ptr<PGconn> _connPtr;
     trantor::Channel _channel;
     std::unordered_map<std::string, std::string> _preparedStatementMap;
@@ -111,11 +128,20 @@ class PgConnection : public DbConnection,
     std::vector<int> _format;
     int flush();
     void handleFatalError();
+    /// The data of 'COPY ... FROM STDIN'
+    const char *_copyData = nullptr;
+    size_t _copyLength = 0;
+    size_t _copyOffset = 0;
+    bool _isCopying = false;
+    bool _copyEnded = false;
+    void sendCopyData();
 #if LIBPQ_SUPPORTS_BATCH_MODE
     std::list<std::shared_ptr<SqlCmd>> _batchCommandsForWaitingResults;
     std::deque<std::shared_ptr<SqlCmd>> _batchSqlCommands;
     void sendBatchedSql();
     int sendBatchEnd();
+    static void rejectCopy(
+        const std::function<void(const std::exception_ptr &)> &exceptCallback);
     bool _sendBatchEnd = false;
     unsigned int _batchCount = 0;
 #endif
@@ -220,6 +220,7 @@ void Sqlite3Connection::execSqlInQueue(
     int r;
     int columnNum = sqlite3_column_count(stmt);
     auto resultPtr = std::make_shared<Sqlite3ResultImpl>(sql);
+    resultPtr->_columnNum = columnNum;
     for (int i = 0; i < columnNum; i++)
     {
         auto name = std::string(sqlite3_column_name(stmt, i));
@@ -233,14 +234,14 @@ void Sqlite3Connection::execSqlInQueue(
     {
         // Readonly, hold read lock;
         std::shared_lock<SharedMutex> lock(*_sharedMutexPtr);
-        r = stmtStep(stmt, resultPtr, columnNum);
+        r = stmtStep(stmt, resultPtr);
         sqlite3_reset(stmt);
     }
     else
     {
         // Hold write lock
         std::unique_lock<SharedMutex> lock(*_sharedMutexPtr);
-        r = stmtStep(stmt, resultPtr, columnNum);
+        r = stmtStep(stmt, resultPtr);
         if (r == SQLITE_DONE)
         {
             resultPtr->_affectedRows = sqlite3_changes(_conn.get());
@@ -263,45 +264,12 @@ void Sqlite3Connection::execSqlInQueue(
 
 int Sqlite3Connection::stmtStep(
     sqlite3_stmt *stmt,
-    const std::shared_ptr<Sqlite3ResultImpl> &resultPtr,
-    int columnNum)
+    const std::shared_ptr<Sqlite3ResultImpl> &resultPtr)
 {
     int r;
     while ((r = sqlite3_step(stmt)) == SQLITE_ROW)
     {
-        std::vector<std::shared_ptr<std::string>> row;
-        for (int i = 0; i < columnNum; i++)
-        {
-            switch (sqlite3_column_type(stmt, i))
-            {
-                case SQLITE_INTEGER:
-                    row.push_back(std::make_shared<std::string>(
-                        std::to_string(sqlite3_column_int64(stmt, i))));
-                    break;
-                case SQLITE_FLOAT:
-                    row.push_back(std::make_shared<std::string>(
-                        std::to_string(sqlite3_column_double(stmt, i))));
-                    break;
-                case SQLITE_TEXT:
-                    row.push_back(std::make_shared<std::string>(
-                        (const char *)sqlite3_column_text(stmt, i),
-                        (size_t)sqlite3_column_bytes(stmt, i)));
-                    break;
-                case SQLITE_BLOB:
-                {
-                    const char *buf =
-                        (const char *)sqlite3_column_blob(stmt, i);
-                    size_t len = sqlite3_column_bytes(stmt, i);
-                    row.push_back(buf ? std::make_shared<std::string>(buf, len)
-                                      : std::make_shared<std::string>());
-                }
-                break;
-                case SQLITE_NULL:
-                    row.push_back(nullptr);
-                    break;
-            }
-        }
-        resultPtr->_result.push_back(std::move(row));
+        resultPtr->appendRow(stmt);
     }
     return r;
 }
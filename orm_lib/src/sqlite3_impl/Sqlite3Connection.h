@@ -72,8 +72,7 @@ class Sqlite3Connection : public DbConnection,
         const std::string &sql,
         const std::function<void(const std::exception_ptr &)> &exceptCallback);
     int stmtStep(sqlite3_stmt *stmt,
-                 const std::shared_ptr<Sqlite3ResultImpl> &resultPtr,
-                 int columnNum);
+                 const std::shared_ptr<Sqlite3ResultImpl> &resultPtr);
     trantor::EventLoopThread _loopThread;
     std::shared_ptr<sqlite3> _conn;
     std::shared_ptr<SharedMutex> _sharedMutexPtr;
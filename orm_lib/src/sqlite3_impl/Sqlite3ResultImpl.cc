@@ -15,16 +15,17 @@
 #include "Sqlite3ResultImpl.h"
 #include <algorithm>
 #include <assert.h>
+#include <stdio.h>
 
 using namespace drogon::orm;
 
 Result::size_type Sqlite3ResultImpl::size() const noexcept
 {
-    return _result.size();
+    return _rowsNum;
 }
 Result::row_size_type Sqlite3ResultImpl::columns() const noexcept
 {
-    return _result.empty() ? 0 : _result[0].size();
+    return _rowsNum == 0 ? 0 : _columnNum;
 }
 const char *Sqlite3ResultImpl::columnName(row_size_type number) const
 {
@@ -50,20 +51,137 @@ Result::row_size_type Sqlite3ResultImpl::columnNumber(
 const char *Sqlite3ResultImpl::getValue(size_type row,
                                         row_size_type column) const
 {
-    auto col = _result[row][column];
-    return col ? col->c_str() : nullptr;
+    auto &c = cell(row, column);
+    switch (c._type)
+    {
+        case SQLITE_NULL:
+            return nullptr;
+        case SQLITE_INTEGER:
+        case SQLITE_FLOAT:
+            return numberText(row, column).c_str();
+        default:
+            return _buffer.data() + c._offset;
+    }
 }
 bool Sqlite3ResultImpl::isNull(size_type row, row_size_type column) const
 {
-    return !_result[row][column];
+    return cell(row, column)._type == SQLITE_NULL;
 }
 Result::field_size_type Sqlite3ResultImpl::getLength(size_type row,
                                                      row_size_type column) const
 {
-    auto col = _result[row][column];
-    return col ? col->length() : 0;
+    auto &c = cell(row, column);
+    if (c._type == SQLITE_INTEGER || c._type == SQLITE_FLOAT)
+        return numberText(row, column).length();
+    return c._length;
 }
 unsigned long long Sqlite3ResultImpl::insertId() const noexcept
 {
     return _insertId;
 }
+bool Sqlite3ResultImpl::getInt64(size_type row,
+                                 row_size_type column,
+                                 int64_t &value) const
+{
+    auto &c = cell(row, column);
+    if (c._type != SQLITE_INTEGER)
+        return false;
+    value = c._int64;
+    return true;
+}
+bool Sqlite3ResultImpl::getDouble(size_type row,
+                                  row_size_type column,
+                                  double &value) const
+{
+    auto &c = cell(row, column);
+    if (c._type == SQLITE_FLOAT)
+    {
+        value = c._double;
+        return true;
+    }
+    if (c._type == SQLITE_INTEGER)
+    {
+        value = static_cast<double>(c._int64);
+        return true;
+    }
+    return false;
+}
+
+size_t Sqlite3ResultImpl::appendText(const char *data, size_t length)
+{
+    auto offset = _buffer.size();
+    if (length > 0)
+        _buffer.append(data, length);
+    _buffer.push_back('\0');
+    return offset;
+}
+
+const std::string &Sqlite3ResultImpl::numberText(size_type row,
+                                                row_size_type column) const
+{
+    std::lock_guard<std::mutex> lock(_numberTextsMutex);
+    auto &c = _cells[row * _columnNum + column];
+    if (c._offset != std::string::npos)
+        return _numberTexts[c._offset];
+    // Large enough for any double formatted by "%f"
+    char buf[512];
+    int len;
+    if (c._type == SQLITE_INTEGER)
+        len = snprintf(buf,
+                       sizeof(buf),
+                       "%lld",
+                       static_cast<long long>(c._int64));
+    else
+        // Same text form as std::to_string()
+        len = snprintf(buf, sizeof(buf), "%f", c._double);
+    assert(len >= 0 && static_cast<size_t>(len) < sizeof(buf));
+    c._offset = _numberTexts.size();
+    c._length = len;
+    // The elements of a deque are never moved by push_back()
+    _numberTexts.emplace_back(buf, len);
+    return _numberTexts.back();
+}
+
+void Sqlite3ResultImpl::appendRow(sqlite3_stmt *stmt)
+{
+    for (size_t i = 0; i < _columnNum; i++)
+    {
+        Cell c;
+        c._type = sqlite3_column_type(stmt, i);
+        c._int64 = 0;
+        switch (c._type)
+        {
+            case SQLITE_INTEGER:
+                c._int64 = sqlite3_column_int64(stmt, i);
+                c._offset = std::string::npos;
+                c._length = 0;
+                break;
+            case SQLITE_FLOAT:
+                c._double = sqlite3_column_double(stmt, i);
+                c._offset = std::string::npos;
+                c._length = 0;
+                break;
+            case SQLITE_TEXT:
+            case SQLITE_BLOB:
+            {
+                // The pointer must be fetched before the length, see the
+                // sqlite3_column_blob() documentation.
+                const char *buf =
+                    c._type == SQLITE_TEXT
+                        ? (const char *)sqlite3_column_text(stmt, i)
+                        : (const char *)sqlite3_column_blob(stmt, i);
+                c._length = buf ? (size_t)sqlite3_column_bytes(stmt, i) : 0;
+                c._offset = appendText(buf, c._length);
+            }
+            break;
+            case SQLITE_NULL:
+            default:
+                c._type = SQLITE_NULL;
+                c._offset = 0;
+                c._length = 0;
+                break;
+        }
+        _cells.push_back(c);
+    }
+    _rowsNum++;
+}
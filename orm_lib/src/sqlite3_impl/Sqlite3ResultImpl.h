@@ -17,7 +17,9 @@
 #include "../ResultImpl.h"
 
 #include <sqlite3.h>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -44,11 +46,50 @@ class Sqlite3ResultImpl : public ResultImpl
     virtual field_size_type getLength(size_type row,
                                       row_size_type column) const override;
     virtual unsigned long long insertId() const noexcept override;
+    virtual bool getInt64(size_type row,
+                          row_size_type column,
+                          int64_t &value) const override;
+    virtual bool getDouble(size_type row,
+                           row_size_type column,
+                           double &value) const override;
 
   private:
     friend class Sqlite3Connection;
-    std::vector<std::vector<std::shared_ptr<std::string>>> _result;
-    std::string _query;
+    /// Append the current row of the statement to the result set.
+    void appendRow(sqlite3_stmt *stmt);
+    /// Copy the text into the arena and return its offset, the text is
+    /// followed by a zero byte so that getValue() can hand out C strings.
+    size_t appendText(const char *data, size_t length);
+
+    /// Each cell of a text or a blob refers to a zero-terminated slice of the
+    /// _buffer arena. Integers and doubles are kept in native form, their
+    /// text forms are only made when getValue() or getLength() needs them.
+    struct Cell
+    {
+        size_t _offset;
+        size_t _length;
+        int _type;
+        union
+        {
+            int64_t _int64;
+            double _double;
+        };
+    };
+    const Cell &cell(size_type row, row_size_type column) const
+    {
+        return _cells[row * _columnNum + column];
+    }
+    /// Return the text form of a number cell, _offset of the cell is the
+    /// index of the text in _numberTexts once it's made.
+    const std::string &numberText(size_type row, row_size_type column) const;
+
+    // The texts of the numbers are made lazily by the const methods
+    mutable std::vector<Cell> _cells;
+    mutable std::deque<std::string> _numberTexts;
+    mutable std::mutex _numberTextsMutex;
+    std::string _buffer;
+    size_t _rowsNum = 0;
+    size_t _columnNum = 0;
     std::vector<std::string> _columnNames;
     std::unordered_map<std::string, size_t> _columnNameMap;
     size_t _affectedRows = 0;
@@ -26,7 +26,7 @@ using namespace drogon_model::postgres;
 #define RESET "\033[0m"
 #define RED "\033[31m"   /* Red */
 #define GREEN "\033[32m" /* Green */
-#define TEST_COUNT 34
+#define TEST_COUNT 37
 
 int counter = 0;
 std::promise<int> pro;
@@ -543,6 +543,51 @@ int main()
             std::cerr << e.base().what() << std::endl;
             testOutput(false, "ORM mapper asynchronous interface(1)");
         });
+    /// 5.3 insert in batches
+    std::vector<Users> users(2, user);
+    users[0].setUserId("pg2");
+    users[1].setUserId("pg3");
+    mapper.insertBatch(
+        users,
+        [](const size_t count) {
+            testOutput(count == 2, "ORM mapper asynchronous interface(2)");
+        },
+        [](const DrogonDbException &e) {
+            std::cerr << e.base().what() << std::endl;
+            testOutput(false, "ORM mapper asynchronous interface(2)");
+        });
+    /// Test bulk load
+    /// 6.1 copy from stdin
+    BulkRows rows(3);
+    rows << "pg4"
+         << "tab\tand\\backslash" << nullptr;
+    rows << "pg5"
+         << "postgres5"
+         << "default";
+    clientPtr->bulkLoadAsync(
+        "users",
+        {"user_id", "user_name", "org_name"},
+        std::move(rows),
+        [](size_t count) {
+            testOutput(count == 2, "DbClient bulk load interface(0)");
+        },
+        [](const DrogonDbException &e) {
+            std::cerr << e.base().what() << std::endl;
+            testOutput(false, "DbClient bulk load interface(0)");
+        });
+    /// Test connection pool options
+    /// 7.1 query timeout
+    auto poolClientPtr = DbClient::newPgClient(
+        "host=127.0.0.1 port=5432 dbname=postgres user=postgres", 1);
+    DbPoolOptions poolOptions;
+    poolOptions._queryTimeout = 0.1;
+    poolClientPtr->setPoolOptions(poolOptions);
+    *poolClientPtr << "select pg_sleep(1)" >> [](const Result &r) {
+        testOutput(false, "DbClient pool options(0)");
+    } >> [](const DrogonDbException &e) {
+        testOutput(dynamic_cast<const TimeoutError *>(&e.base()) != nullptr,
+                   "DbClient pool options(0)");
+    };
     globalf.get();
     sleep(1);
     return 0;